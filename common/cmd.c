@@ -43,6 +43,7 @@
 #include "include/os/os_page.h"
 #include "include/os/os_cmd.h"
 #include "include/os/plat.h"
+#include "include/os/damon.h"
 
 int g_sortkey;
 
@@ -51,7 +52,9 @@ static int s_rawnum_sortkey[] = {
 	SORT_KEY_LMA,
 	SORT_KEY_RL,
 	SORT_KEY_CPI,
-	SORT_KEY_CPU
+	SORT_KEY_CPU,
+	SORT_KEY_COST,
+	SORT_KEY_XSOCKET
 };
 
 static int s_topnproc_sortkey[] = {
@@ -59,7 +62,9 @@ static int s_topnproc_sortkey[] = {
 	SORT_KEY_LPI,
 	SORT_KEY_RL,
 	SORT_KEY_CPI,
-	SORT_KEY_CPU
+	SORT_KEY_CPU,
+	SORT_KEY_COST,
+	SORT_KEY_XSOCKET
 };
 
 static switch_t s_switch[WIN_TYPE_NUM][CMD_NUM];
@@ -124,6 +129,60 @@ preop_switch2accdst(cmd_t *cmd, boolean_t *smpl)
 	return (os_preop_switch2accdst(cmd, smpl));
 }
 
+static int
+preop_switch2heatmap(cmd_t *cmd, boolean_t *smpl)
+{
+	return (os_preop_switch2heatmap(cmd, smpl));
+}
+
+static int
+preop_switch2contend(cmd_t *cmd, boolean_t *smpl)
+{
+	return (os_preop_switch2contend(cmd, smpl));
+}
+
+static int
+preop_switch2damon(cmd_t *cmd, boolean_t *smpl)
+{
+	return (os_preop_switch2damon(cmd, smpl));
+}
+
+static int
+preop_switch2uncoreall(cmd_t *cmd, boolean_t *smpl)
+{
+	return (os_preop_switch2uncoreall(cmd, smpl));
+}
+
+static int
+preop_leaveuncore(cmd_t *cmd, boolean_t *smpl)
+{
+	return (os_preop_leaveuncore(cmd, smpl));
+}
+
+static int
+preop_switch2cgroup(cmd_t *cmd, boolean_t *smpl)
+{
+	return (os_preop_switch2cgroup(cmd, smpl));
+}
+
+static int
+preop_migrate(cmd_t *cmd, boolean_t *smpl)
+{
+	return (os_preop_migrate(cmd, smpl));
+}
+
+static int
+preop_switch2advisor(cmd_t *cmd, boolean_t *smpl)
+{
+	return (os_preop_switch2advisor(cmd, smpl));
+}
+
+static int
+preop_bind(cmd_t *cmd, boolean_t *smpl)
+{
+	return (os_preop_bind(cmd, smpl));
+}
+
 static int
 preop_switch2pqoscmt(cmd_t *cmd, boolean_t *smpl)
 {
@@ -227,7 +286,7 @@ sortkey_set(int cmd_id, page_t *page)
 		arr = s_topnproc_sortkey;
 	}
 
-	if ((cmd_id >= CMD_1_ID) && (cmd_id <= CMD_5_ID) && (arr != NULL)) {
+	if ((cmd_id >= CMD_1_ID) && (cmd_id <= CMD_7_ID) && (arr != NULL)) {
 		g_sortkey = arr[cmd_id - CMD_1_ID];
 	}
 }
@@ -249,6 +308,27 @@ op_sort(cmd_t *cmd,
 	return (0);
 }
 
+/*
+ * Roll the node overview up to sockets, down to LLC domains and back
+ * to nodes.
+ */
+/* ARGSUSED */
+static int
+op_topolevel(cmd_t *cmd,
+	boolean_t smpl __attribute__((unused)))
+{
+	page_t *cur;
+	dyn_nodeoverview_t *dyn;
+
+	if (((cur = page_current_get()) != NULL) &&
+	    ((dyn = DYN_NODEOVERVIEW(cur)) != NULL)) {
+		dyn->level = (dyn->level + 1) % TOPO_LEVEL_NUM;
+		(void) op_refresh(cmd, B_FALSE);
+	}
+
+	return (0);
+}
+
 static int
 op_home(cmd_t *cmd, boolean_t smpl)
 {
@@ -305,6 +385,13 @@ switch_table_init(void)
 	s_switch[WIN_TYPE_RAW_NUM][CMD_3_ID].op = op_sort;
 	s_switch[WIN_TYPE_RAW_NUM][CMD_4_ID].op = op_sort;
 	s_switch[WIN_TYPE_RAW_NUM][CMD_5_ID].op = op_sort;
+	s_switch[WIN_TYPE_RAW_NUM][CMD_6_ID].op = op_sort;
+	s_switch[WIN_TYPE_RAW_NUM][CMD_7_ID].op = op_sort;
+	s_switch[WIN_TYPE_RAW_NUM][CMD_UNCORE_ID].preop = preop_switch2uncoreall;
+	s_switch[WIN_TYPE_RAW_NUM][CMD_UNCORE_ID].op = op_page_next;
+	s_switch[WIN_TYPE_RAW_NUM][CMD_CGROUP_ID].preop = preop_switch2cgroup;
+	s_switch[WIN_TYPE_RAW_NUM][CMD_CGROUP_ID].op = op_page_next;
+	s_switch[WIN_TYPE_RAW_NUM][CMD_NUMASTAT_ID].op = op_page_next;
 
 	/*
 	 * Initialize for window type "WIN_TYPE_TOPNPROC"
@@ -315,6 +402,13 @@ switch_table_init(void)
 	s_switch[WIN_TYPE_TOPNPROC][CMD_3_ID].op = op_sort;
 	s_switch[WIN_TYPE_TOPNPROC][CMD_4_ID].op = op_sort;
 	s_switch[WIN_TYPE_TOPNPROC][CMD_5_ID].op = op_sort;
+	s_switch[WIN_TYPE_TOPNPROC][CMD_6_ID].op = op_sort;
+	s_switch[WIN_TYPE_TOPNPROC][CMD_7_ID].op = op_sort;
+	s_switch[WIN_TYPE_TOPNPROC][CMD_UNCORE_ID].preop = preop_switch2uncoreall;
+	s_switch[WIN_TYPE_TOPNPROC][CMD_UNCORE_ID].op = op_page_next;
+	s_switch[WIN_TYPE_TOPNPROC][CMD_CGROUP_ID].preop = preop_switch2cgroup;
+	s_switch[WIN_TYPE_TOPNPROC][CMD_CGROUP_ID].op = op_page_next;
+	s_switch[WIN_TYPE_TOPNPROC][CMD_NUMASTAT_ID].op = op_page_next;
 
 	/*
 	 * Initialize for window type "WIN_TYPE_MONIPROC"
@@ -329,11 +423,19 @@ switch_table_init(void)
 		preop_switch2pqoscmt;
 	s_switch[WIN_TYPE_MONIPROC][CMD_PQOS_CMT_ID].op =
 		op_page_next;
+	s_switch[WIN_TYPE_MONIPROC][CMD_DAMON_ID].preop = preop_switch2damon;
+	s_switch[WIN_TYPE_MONIPROC][CMD_DAMON_ID].op = op_page_next;
+	s_switch[WIN_TYPE_MONIPROC][CMD_UNCORE_ID].preop = preop_switch2uncoreall;
+	s_switch[WIN_TYPE_MONIPROC][CMD_UNCORE_ID].op = op_page_next;
 
 	/*
 	 * Initialize for window type "WIN_TYPE_TOPNLWP"
 	 */
 	s_switch[WIN_TYPE_TOPNLWP][CMD_MONITOR_ID].op = op_page_next;
+	s_switch[WIN_TYPE_TOPNLWP][CMD_ADVISOR_ID].preop = preop_switch2advisor;
+	s_switch[WIN_TYPE_TOPNLWP][CMD_ADVISOR_ID].op = op_page_next;
+	s_switch[WIN_TYPE_TOPNLWP][CMD_UNCORE_ID].preop = preop_switch2uncoreall;
+	s_switch[WIN_TYPE_TOPNLWP][CMD_UNCORE_ID].op = op_page_next;
 
 	/*
 	 * Initialize for window type "WIN_TYPE_MONILWP"
@@ -347,6 +449,8 @@ switch_table_init(void)
 		preop_switch2pqoscmt;
 	s_switch[WIN_TYPE_MONILWP][CMD_PQOS_CMT_ID].op =
 		op_page_next;
+	s_switch[WIN_TYPE_MONILWP][CMD_UNCORE_ID].preop = preop_switch2uncoreall;
+	s_switch[WIN_TYPE_MONILWP][CMD_UNCORE_ID].op = op_page_next;
 
 	/*
 	 * Initialize for window type "WIN_TYPE_LAT_PROC"
@@ -359,6 +463,10 @@ switch_table_init(void)
 	s_switch[WIN_TYPE_LAT_PROC][CMD_LATNODE_ID].op = op_page_next;
 	s_switch[WIN_TYPE_LAT_PROC][CMD_ACCDST_ID].preop = preop_switch2accdst;
 	s_switch[WIN_TYPE_LAT_PROC][CMD_ACCDST_ID].op = op_page_next;
+	s_switch[WIN_TYPE_LAT_PROC][CMD_HEATMAP_ID].preop = preop_switch2heatmap;
+	s_switch[WIN_TYPE_LAT_PROC][CMD_HEATMAP_ID].op = op_page_next;
+	s_switch[WIN_TYPE_LAT_PROC][CMD_CONTEND_ID].preop = preop_switch2contend;
+	s_switch[WIN_TYPE_LAT_PROC][CMD_CONTEND_ID].op = op_page_next;
 	s_switch[WIN_TYPE_LAT_PROC][CMD_MAP_GET_ID].preop = preop_llmap_get;
 	s_switch[WIN_TYPE_LAT_PROC][CMD_MAP_GET_ID].op = op_refresh;
 	s_switch[WIN_TYPE_LAT_PROC][CMD_MAP_STOP_ID].op = op_llmap_stop;
@@ -376,6 +484,10 @@ switch_table_init(void)
 	s_switch[WIN_TYPE_LAT_LWP][CMD_LATNODE_ID].op = op_page_next;
 	s_switch[WIN_TYPE_LAT_LWP][CMD_ACCDST_ID].preop = preop_switch2accdst;
 	s_switch[WIN_TYPE_LAT_LWP][CMD_ACCDST_ID].op = op_page_next;
+	s_switch[WIN_TYPE_LAT_LWP][CMD_HEATMAP_ID].preop = preop_switch2heatmap;
+	s_switch[WIN_TYPE_LAT_LWP][CMD_HEATMAP_ID].op = op_page_next;
+	s_switch[WIN_TYPE_LAT_LWP][CMD_CONTEND_ID].preop = preop_switch2contend;
+	s_switch[WIN_TYPE_LAT_LWP][CMD_CONTEND_ID].op = op_page_next;
 	s_switch[WIN_TYPE_LAT_LWP][CMD_MAP_GET_ID].preop = preop_llmap_get;
 	s_switch[WIN_TYPE_LAT_LWP][CMD_MAP_GET_ID].op = op_refresh;
 	s_switch[WIN_TYPE_LAT_LWP][CMD_MAP_STOP_ID].op = op_llmap_stop;
@@ -390,6 +502,8 @@ switch_table_init(void)
 	s_switch[WIN_TYPE_LATNODE_PROC][CMD_MAP_GET_ID].preop = preop_lnmap_get;
 	s_switch[WIN_TYPE_LATNODE_PROC][CMD_MAP_GET_ID].op = op_refresh;
 	s_switch[WIN_TYPE_LATNODE_PROC][CMD_MAP_STOP_ID].op = op_lnmap_stop;
+	s_switch[WIN_TYPE_LATNODE_PROC][CMD_MIGRATE_ID].preop = preop_migrate;
+	s_switch[WIN_TYPE_LATNODE_PROC][CMD_MIGRATE_ID].op = op_refresh;
 	s_switch[WIN_TYPE_LATNODE_PROC][CMD_NODE_OVERVIEW_ID].preop = NULL;
 	s_switch[WIN_TYPE_LATNODE_PROC][CMD_NODE_OVERVIEW_ID].op = NULL;
 
@@ -401,6 +515,8 @@ switch_table_init(void)
 	s_switch[WIN_TYPE_LATNODE_LWP][CMD_MAP_GET_ID].preop = preop_lnmap_get;
 	s_switch[WIN_TYPE_LATNODE_LWP][CMD_MAP_GET_ID].op = op_refresh;
 	s_switch[WIN_TYPE_LATNODE_LWP][CMD_MAP_STOP_ID].op = op_lnmap_stop;
+	s_switch[WIN_TYPE_LATNODE_LWP][CMD_MIGRATE_ID].preop = preop_migrate;
+	s_switch[WIN_TYPE_LATNODE_LWP][CMD_MIGRATE_ID].op = op_refresh;
 	s_switch[WIN_TYPE_LATNODE_LWP][CMD_NODE_OVERVIEW_ID].preop = NULL;
 	s_switch[WIN_TYPE_LATNODE_LWP][CMD_NODE_OVERVIEW_ID].op = NULL;
 
@@ -409,12 +525,49 @@ switch_table_init(void)
 	 */
 	s_switch[WIN_TYPE_ACCDST_PROC][CMD_NODE_OVERVIEW_ID].preop = NULL;
 	s_switch[WIN_TYPE_ACCDST_PROC][CMD_NODE_OVERVIEW_ID].op = NULL;
+	s_switch[WIN_TYPE_ACCDST_PROC][CMD_MIGRATE_ID].preop = preop_migrate;
+	s_switch[WIN_TYPE_ACCDST_PROC][CMD_MIGRATE_ID].op = op_refresh;
 
 	/*
 	 * Initialize for window type "WIN_TYPE_ACCDST_LWP"
 	 */
 	s_switch[WIN_TYPE_ACCDST_LWP][CMD_NODE_OVERVIEW_ID].preop = NULL;
 	s_switch[WIN_TYPE_ACCDST_LWP][CMD_NODE_OVERVIEW_ID].op = NULL;
+	s_switch[WIN_TYPE_ACCDST_LWP][CMD_MIGRATE_ID].preop = preop_migrate;
+	s_switch[WIN_TYPE_ACCDST_LWP][CMD_MIGRATE_ID].op = op_refresh;
+
+	/*
+	 * Initialize for window type "WIN_TYPE_HEATMAP_PROC"
+	 */
+	s_switch[WIN_TYPE_HEATMAP_PROC][CMD_NODE_OVERVIEW_ID].preop = NULL;
+	s_switch[WIN_TYPE_HEATMAP_PROC][CMD_NODE_OVERVIEW_ID].op = NULL;
+
+	/*
+	 * Initialize for window type "WIN_TYPE_HEATMAP_LWP"
+	 */
+	s_switch[WIN_TYPE_HEATMAP_LWP][CMD_NODE_OVERVIEW_ID].preop = NULL;
+	s_switch[WIN_TYPE_HEATMAP_LWP][CMD_NODE_OVERVIEW_ID].op = NULL;
+
+	/*
+	 * Initialize for window type "WIN_TYPE_CONTEND_PROC"
+	 */
+	s_switch[WIN_TYPE_CONTEND_PROC][CMD_NODE_OVERVIEW_ID].preop = NULL;
+	s_switch[WIN_TYPE_CONTEND_PROC][CMD_NODE_OVERVIEW_ID].op = NULL;
+
+	/*
+	 * Initialize for window type "WIN_TYPE_CONTEND_LWP"
+	 */
+	s_switch[WIN_TYPE_CONTEND_LWP][CMD_NODE_OVERVIEW_ID].preop = NULL;
+	s_switch[WIN_TYPE_CONTEND_LWP][CMD_NODE_OVERVIEW_ID].op = NULL;
+
+	/*
+	 * Initialize for window type "WIN_TYPE_ADVISOR"
+	 */
+	s_switch[WIN_TYPE_ADVISOR][CMD_BACK_ID].preop = preop_switch2profiling;
+	s_switch[WIN_TYPE_ADVISOR][CMD_BIND_ID].preop = preop_bind;
+	s_switch[WIN_TYPE_ADVISOR][CMD_BIND_ID].op = op_refresh;
+	s_switch[WIN_TYPE_ADVISOR][CMD_NODE_OVERVIEW_ID].preop = NULL;
+	s_switch[WIN_TYPE_ADVISOR][CMD_NODE_OVERVIEW_ID].op = NULL;
 
 	/*
 	 * Initialize for window type "WIN_TYPE_NODE_OVERVIEW"
@@ -425,6 +578,11 @@ switch_table_init(void)
 	s_switch[WIN_TYPE_NODE_OVERVIEW][CMD_NODE_DETAIL_ID].preop =
 		preop_switch2uncore;	
 	s_switch[WIN_TYPE_NODE_OVERVIEW][CMD_NODE_DETAIL_ID].op = op_page_next;
+	s_switch[WIN_TYPE_NODE_OVERVIEW][CMD_UNCORE_ID].preop =
+		preop_switch2uncoreall;
+	s_switch[WIN_TYPE_NODE_OVERVIEW][CMD_UNCORE_ID].op = op_page_next;
+	s_switch[WIN_TYPE_NODE_OVERVIEW][CMD_NUMASTAT_ID].op = op_page_next;
+	s_switch[WIN_TYPE_NODE_OVERVIEW][CMD_TOPOLEVEL_ID].op = op_topolevel;
 
 	/*
 	 * Initialize for window type "WIN_TYPE_NODE_DETAIL"
@@ -457,6 +615,10 @@ switch_table_init(void)
 	 */
 	s_switch[WIN_TYPE_PQOS_CMT_TOPNPROC][CMD_BACK_ID].preop =
 		preop_switch2profiling;
+	s_switch[WIN_TYPE_PQOS_CMT_TOPNPROC][CMD_PQOS_MBM_ID].preop =
+		preop_switch2pqosmbm;
+	s_switch[WIN_TYPE_PQOS_CMT_TOPNPROC][CMD_PQOS_MBM_ID].op =
+		op_page_next;
 
 	/*
 	 * Initialize for window type "WIN_TYPE_PQOS_CMT_MONIPROC"
@@ -489,6 +651,22 @@ switch_table_init(void)
 	 */
 	s_switch[WIN_TYPE_PQOS_MBM_MONILWP][CMD_BACK_ID].preop =
 		preop_switch2pqoscmt;
+
+	/*
+	 * Initialize for window type "WIN_TYPE_PQOS_MBM_TOPNPROC"
+	 */
+	s_switch[WIN_TYPE_PQOS_MBM_TOPNPROC][CMD_BACK_ID].preop =
+		preop_switch2pqoscmt;
+
+	/*
+	 * Initialize for window type "WIN_TYPE_UNCORE"
+	 */
+	s_switch[WIN_TYPE_UNCORE][CMD_BACK_ID].preop = preop_leaveuncore;
+
+	/*
+	 * Initialize for window type "WIN_TYPE_CGROUP"
+	 */
+	s_switch[WIN_TYPE_CGROUP][CMD_BACK_ID].preop = preop_switch2profiling;
 }
 
 static int
@@ -539,6 +717,21 @@ cmd_id_get(char ch)
 	case CMD_ACCDST_CHAR:
 		return (CMD_ACCDST_ID);
 
+	case CMD_HEATMAP_CHAR:
+		return (CMD_HEATMAP_ID);
+
+	case CMD_CONTEND_CHAR:
+		return (CMD_CONTEND_ID);
+
+	case CMD_MIGRATE_CHAR:
+		return (CMD_MIGRATE_ID);
+
+	case CMD_ADVISOR_CHAR:
+		return (CMD_ADVISOR_ID);
+
+	case CMD_BIND_CHAR:
+		return (CMD_BIND_ID);
+
 	case CMD_IR_NORMALIZE_CHAR:
 		return (CMD_IR_NORMALIZE_ID);
 
@@ -569,6 +762,12 @@ cmd_id_get(char ch)
 	case CMD_5_CHAR:
 		return (CMD_5_ID);
 
+	case CMD_6_CHAR:
+		return (CMD_6_ID);
+
+	case CMD_7_CHAR:
+		return (CMD_7_ID);
+
 	case CMD_PQOS_CMT_CHAR:
 		if (g_cmt_enabled)
 			return (CMD_PQOS_CMT_ID);
@@ -581,6 +780,27 @@ cmd_id_get(char ch)
 
 		return (CMD_INVALID_ID);
 
+	case CMD_DAMON_CHAR:
+		if (g_damon_enabled)
+			return (CMD_DAMON_ID);
+
+		return (CMD_INVALID_ID);
+
+	case CMD_UNCORE_CHAR:
+		return (CMD_UNCORE_ID);
+
+	case CMD_CGROUP_CHAR:
+		if (g_cmt_enabled)
+			return (CMD_CGROUP_ID);
+
+		return (CMD_INVALID_ID);
+
+	case CMD_NUMASTAT_CHAR:
+		return (CMD_NUMASTAT_ID);
+
+	case CMD_TOPOLEVEL_CHAR:
+		return (CMD_TOPOLEVEL_ID);
+
 	default:
 		return (CMD_INVALID_ID);
 	}
@@ -48,6 +48,7 @@
 #include "include/page.h"
 #include "include/cmd.h"
 #include "include/win.h"
+#include "include/perf.h"
 #include "include/os/node.h"
 
 int g_run_secs;
@@ -777,13 +778,15 @@ disp_dispthr_quit_start(void)
 }
 
 /*
- * Send the 'HOME' command to 'disp thread'.
+ * Send the 'HOME' command to 'disp thread'. The home window is the
+ * uncore window in uncore-only mode.
  */
 void
 disp_go_home(void)
 {
 	(void) pthread_mutex_lock(&s_disp_ctl.mutex);
-	CMD_ID_SET(&s_disp_ctl.cmd, CMD_HOME_ID);
+	CMD_ID_SET(&s_disp_ctl.cmd,
+		g_uncore_only ? CMD_UNCORE_ID : CMD_HOME_ID);
 	dispthr_flagset_nolock(DISP_FLAG_CMD);
 	(void) pthread_mutex_unlock(&s_disp_ctl.mutex);
 }
@@ -50,12 +50,24 @@ extern "C" {
 #define	CMD_3_CHAR		'3'
 #define	CMD_4_CHAR		'4'
 #define CMD_5_CHAR		'5'
+#define CMD_6_CHAR		'6'
+#define CMD_7_CHAR		'7'
 #define CMD_CALLCHAIN_CHAR	'c'
 #define CMD_ACCDST_CHAR	'd'
 #define CMD_MAP_GET_CHAR	'm'
 #define CMD_MAP_STOP_CHAR	's'
 #define CMD_PQOS_CMT_CHAR	'o'
 #define CMD_PQOS_MBM_CHAR	'p'
+#define CMD_HEATMAP_CHAR	'e'
+#define CMD_MIGRATE_CHAR	'g'
+#define CMD_ADVISOR_CHAR	'a'
+#define CMD_BIND_CHAR	'y'
+#define CMD_CONTEND_CHAR	'x'
+#define CMD_DAMON_CHAR	'k'
+#define CMD_UNCORE_CHAR	'u'
+#define CMD_CGROUP_CHAR	'w'
+#define CMD_NUMASTAT_CHAR	'v'
+#define CMD_TOPOLEVEL_CHAR	't'
 
 typedef enum {
 	CMD_INVALID_ID = 0,
@@ -77,15 +89,27 @@ typedef enum {
 	CMD_3_ID,
 	CMD_4_ID,
 	CMD_5_ID,
+	CMD_6_ID,
+	CMD_7_ID,
 	CMD_REFRESH_ID,
 	CMD_QUIT_ID,
 	CMD_BACK_ID,
 	CMD_RESIZE_ID,
 	CMD_PQOS_CMT_ID,
 	CMD_PQOS_MBM_ID,
+	CMD_HEATMAP_ID,
+	CMD_MIGRATE_ID,
+	CMD_ADVISOR_ID,
+	CMD_BIND_ID,
+	CMD_CONTEND_ID,
+	CMD_DAMON_ID,
+	CMD_UNCORE_ID,
+	CMD_CGROUP_ID,
+	CMD_NUMASTAT_ID,
+	CMD_TOPOLEVEL_ID,
 } cmd_id_t;
 
-#define CMD_NUM	25
+#define CMD_NUM	37
 
 typedef struct _cmd_home {
 	cmd_id_t id;
@@ -126,6 +150,40 @@ typedef struct _cmd_accdst {
 	int lwpid;
 } cmd_accdst_t;
 
+typedef struct _cmd_heatmap {
+	cmd_id_t id;
+	pid_t pid;
+	int lwpid;
+} cmd_heatmap_t;
+
+typedef struct _cmd_advisor {
+	cmd_id_t id;
+	pid_t pid;
+} cmd_advisor_t;
+
+typedef struct _cmd_contend {
+	cmd_id_t id;
+	pid_t pid;
+	int lwpid;
+} cmd_contend_t;
+
+typedef struct _cmd_damon {
+	cmd_id_t id;
+	pid_t pid;
+} cmd_damon_t;
+
+typedef struct _cmd_uncore {
+	cmd_id_t id;
+} cmd_uncore_t;
+
+typedef struct _cmd_cgroup {
+	cmd_id_t id;
+} cmd_cgroup_t;
+
+typedef struct _cmd_numastat {
+	cmd_id_t id;
+} cmd_numastat_t;
+
 typedef struct _cmd_node_overview {
 	cmd_id_t id;
 } cmd_node_overview_t;
@@ -176,6 +234,13 @@ typedef union _cmd {
 	cmd_callchain_t callchain;
 	cmd_llcallchain_t llcallchain;
 	cmd_accdst_t accdst;
+	cmd_heatmap_t heatmap;
+	cmd_advisor_t advisor;
+	cmd_contend_t contend;
+	cmd_damon_t damon;
+	cmd_uncore_t uncore;
+	cmd_cgroup_t cgroup;
+	cmd_numastat_t numastat;
 	cmd_pqos_cmt_t pqos_cmt;
 	cmd_pqos_mbm_t pqos_mbm;
 } cmd_t;
@@ -206,6 +271,18 @@ typedef struct _switch {
 #define	CMD_ACCDST(cmd) \
 	((cmd_accdst_t *)(cmd))
 
+#define	CMD_HEATMAP(cmd) \
+	((cmd_heatmap_t *)(cmd))
+
+#define	CMD_ADVISOR(cmd) \
+	((cmd_advisor_t *)(cmd))
+
+#define	CMD_CONTEND(cmd) \
+	((cmd_contend_t *)(cmd))
+
+#define	CMD_DAMON(cmd) \
+	((cmd_damon_t *)(cmd))
+
 #define	CMD_MONITOR(cmd) \
 	((cmd_monitor_t *)(cmd))
 
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2013, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Intel Corporation nor the names of its contributors
+ *     may be used to endorse or promote products derived from this software
+ *     without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _NUMATOP_CGROUP_H
+#define	_NUMATOP_CGROUP_H
+
+#include <sys/types.h>
+#include <inttypes.h>
+#include "../types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CGROUP_PATH_SIZE	256
+
+/*
+ * The resctrl counters of a cgroup on one node, the bandwidths are in
+ * bytes per second. The remote bandwidth is "totalbw - localbw".
+ * "valid" is B_FALSE if the node has no L3 domain of its own (SNC).
+ */
+typedef struct _cgroup_node {
+	boolean_t valid;
+	uint64_t llc_occupancy;
+	uint64_t totalbw;
+	uint64_t localbw;
+} cgroup_node_t;
+
+/*
+ * A cgroup which has tracked processes. "rank" follows the CPU
+ * utilization of its busiest process. "slot" is the resctrl monitor
+ * group which follows its threads, or -1.
+ */
+typedef struct _cgroup {
+	char path[CGROUP_PATH_SIZE];
+	int rank;
+	int nprocs;
+	int nlwps;
+	int slot;
+	int nsmpl;
+	uint64_t *last;
+	cgroup_node_t *nodes;
+	cgroup_node_t total;
+} cgroup_t;
+
+int cgroup_refresh(void);
+cgroup_t *cgroup_get(int *);
+void cgroup_fini(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _NUMATOP_CGROUP_H */
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2013, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Intel Corporation nor the names of its contributors
+ *     may be used to endorse or promote products derived from this software
+ *     without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _NUMATOP_DAMON_H
+#define	_NUMATOP_DAMON_H
+
+#include <sys/types.h>
+#include <limits.h>
+#include "../types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DAMON_ROOT_DEFAULT	"/sys/kernel/mm/damon/admin"
+#define DAMON_ROOT_SIZE		256
+#define DAMON_SAMPLE_US		5000
+#define DAMON_AGGR_US		100000
+#define DAMON_UPDATE_US		1000000
+#define DAMON_NREGIONS_MIN	10
+#define DAMON_NREGIONS_MAX	1000
+
+/*
+ * The upper bound of 'nr_accesses', one access check per sampling
+ * interval in an aggregation interval.
+ */
+#define DAMON_ACCESS_MAX	(DAMON_AGGR_US / DAMON_SAMPLE_US)
+
+/*
+ * A region reported by DAMON. 'age' is the number of aggregation
+ * intervals in which the access frequency stays the same.
+ */
+typedef struct _damon_region {
+	uint64_t start_addr;
+	uint64_t end_addr;
+	unsigned int nr_accesses;
+	unsigned int age;
+} damon_region_t;
+
+extern char g_damon_root[DAMON_ROOT_SIZE];
+extern boolean_t g_damon_enabled;
+
+boolean_t damon_init(void);
+int damon_start(pid_t);
+void damon_stop(void);
+int damon_regions_get(damon_region_t **, int *);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _NUMATOP_DAMON_H */
@@ -69,7 +69,15 @@ extern "C" {
 	((attr) |= 1)
 
 #define MAPFILE_LINE_SIZE (PATH_MAX + 1024)
+#define MAPFILE_READ_SIZE	(64 * 1024)
+#define THP_PMD_SIZE_PATH	\
+	"/sys/kernel/mm/transparent_hugepage/hpage_pmd_size"
 #define MAP_ENTRY_NUM	64
+#define MAP_EVENT_NUM	64
+#define MAP_EVENT_MAX	1024
+#define MAP_STR_HASHTBL_SIZE	1024
+#define MAP_HEAT_NUM	256
+#define MAP_HEAT_LINE_NUM	64
 
 typedef struct _numa_entry {
 	uint64_t start_addr;
@@ -81,45 +89,254 @@ typedef struct _numa_map {
 	numa_entry_t *arr;
 	int nentry_cur;
 	int nentry_max;
+	uint64_t *node_bytes;	/* resident bytes per node from numa_maps */
+	uint64_t granularity;	/* sampling stride, 0 if all pages queried */
+	int confidence;		/* percentage, -1 if unknown */
 } numa_map_t;
 
+/*
+ * The THP backing of mapping from /proc/<pid>/smaps, cached until the
+ * next refresh.
+ */
+typedef struct _map_thp {
+	uint64_t rss;
+	uint64_t anon_huge;
+	boolean_t valid;
+} map_thp_t;
+
 typedef struct _map_entry {
 	uint64_t start_addr;
 	uint64_t end_addr;
 	unsigned int attr;
 	boolean_t need_resolve;
 	numa_map_t numa_map;
-	char desc[PATH_MAX];
+	map_thp_t thp;
+	const char *desc;
 } map_entry_t;
 
+/*
+ * A mapping reported by PERF_RECORD_MMAP2. The events are queued by
+ * the perf thread and applied to the sorted map entries when the map
+ * is loaded.
+ */
+typedef struct _map_event {
+	uint64_t start_addr;
+	uint64_t end_addr;
+	unsigned int attr;
+	const char *desc;
+} map_event_t;
+
+typedef struct _map_eventq {
+	map_event_t *arr;
+	int nevent_cur;
+	int nevent_max;
+	boolean_t lost;
+} map_eventq_t;
+
+/*
+ * The path strings are interned in a string pool shared by all the
+ * processes, 'desc' in map entries and events points to 'str'.
+ */
+typedef struct _map_str {
+	struct _map_str *next;
+	int ref_count;
+	unsigned int hash;
+	char str[];
+} map_str_t;
+
+/*
+ * The cached node of a page which is hit by LL samples. 'gen' is the
+ * generation in which the node was looked up.
+ */
+typedef struct _map_page {
+	uint64_t page;
+	int nid;
+	unsigned int gen;
+} map_page_t;
+
+/*
+ * Open addressing hash table keyed by page-aligned address. The scratch
+ * buffers for numa_move_pages() are kept across refreshes.
+ */
+typedef struct _map_pagecache {
+	map_page_t *arr;
+	int npages_cur;
+	int npages_max;
+	unsigned int gen;
+	int revalidate_idx;
+	void **addr_buf;
+	int *status_buf;
+	int nbuf_max;
+} map_pagecache_t;
+
+/*
+ * The LL samples of a hot page. Only MAP_HEAT_NUM pages are tracked per
+ * process, a new page replaces the least accessed one and inherits its
+ * count (Space-Saving), so "naccess" may overestimate by the count of
+ * the replaced page.
+ */
+typedef struct _map_heat {
+	uint64_t page;
+	uint32_t naccess;
+	uint64_t total_lat;
+	lat_hist_t hist;
+	uint64_t node_mask;
+	uint32_t line_count[MAP_HEAT_LINE_NUM];
+	unsigned int ip_num;
+	uint64_t ips[IP_NUM];
+	int nid;
+} map_heat_t;
+
+/*
+ * There is one heatmap per process. "owner" tells which window started
+ * it, a window which finds another owner starts it again for itself.
+ */
+typedef struct _map_heatmap {
+	map_heat_t *arr;
+	int nheat_cur;
+	int lwpid;
+	unsigned int owner;
+	uint64_t nsamples;
+} map_heatmap_t;
+
+/*
+ * A line of /proc/<pid>/numa_maps. 'pagesize' is the kernelpagesize_kB
+ * in bytes, 'idx' is where the resident bytes per node of the line
+ * start in 'node_bytes' of map_numamaps_t.
+ */
+typedef struct _map_numaline {
+	uint64_t start_addr;
+	uint64_t pagesize;
+	int idx;
+} map_numaline_t;
+
+/*
+ * The numa_maps of process, read once per refresh for all the mappings
+ * and indexed by start address.
+ */
+typedef struct _map_numamaps {
+	map_numaline_t *arr;
+	uint64_t *node_bytes;
+	int nline_cur;
+	int nline_max;
+	boolean_t loaded;
+} map_numamaps_t;
+
 typedef struct _map_proc {
 	map_entry_t *arr;
 	int nentry_cur;
 	int nentry_max;
 	boolean_t loaded;
+	boolean_t thp_loaded;
+	map_numamaps_t numamaps;
+	map_eventq_t eventq;
+	map_pagecache_t pagecache;
+	map_heatmap_t heatmap;
 } map_proc_t;
 
+/*
+ * A sampled page and the node which accesses it most.
+ */
+typedef struct _map_migrate_page {
+	uint64_t page;
+	int nid;
+	int naccess;
+} map_migrate_page_t;
+
+typedef enum {
+	MIGRATE_NONE = 0,
+	MIGRATE_DRYRUN,
+	MIGRATE_RUNNING,
+	MIGRATE_DONE
+} migrate_state_t;
+
+/*
+ * The plan of moving the sampled pages of a memory range to the node
+ * which accesses them most, hottest page first. "rma_before" and
+ * "lat_before" are the LL metrics of the interval before migration
+ * started, "rma_cur" and "lat_cur" are refreshed on each interval.
+ */
+typedef struct _map_migrate {
+	migrate_state_t state;
+	void **addr_arr;
+	int *nid_arr;
+	int *status_arr;
+	int npages;
+	int next;
+	int nmoved;
+	int nfailed;
+	int nlocal;
+	uint64_t last_ms;
+	double rma_before;
+	uint64_t lat_before;
+	double rma_cur;
+	uint64_t lat_cur;
+} map_migrate_t;
+
+/*
+ * The LL samples of a thread broken down by the node of CPU which issues
+ * the access ("run_cnt") and the node where the page is allocated
+ * ("mem_cnt"). Both arrays have "nnodes_max" entries.
+ */
+typedef struct _map_place {
+	int naccess;
+	int nremote;
+	int *run_cnt;
+	int *mem_cnt;
+} map_place_t;
+
 typedef struct _map_nodedst {
 	int naccess;
 	unsigned int total_lat;
+	lat_hist_t hist;
+	memsrc_count_t memsrc;
 } map_nodedst_t;
 
 #define NUMA_MOVE_NPAGES	1024
 
+#define MAP_PAGECACHE_NUM	4096
+#define MAP_PAGECACHE_MAX	(1024 * 1024)
+#define MAP_PAGECACHE_TTL	10
+#define MAP_PAGECACHE_REVALIDATE	64
+#define MAP_NID_PENDING	(-0x7fffffff)
+
 struct _track_proc;
+struct _track_lwp;
+struct _os_perf_llrec;
+
+extern boolean_t g_map_incremental;
+extern uint64_t g_map_granularity;
+extern uint64_t g_migrate_rate;
 
 int map_init(void);
 void map_fini(void);
 int map_proc_load(struct _track_proc *);
 int map_proc_fini(struct _track_proc *);
 map_entry_t* map_entry_find(struct _track_proc *, uint64_t, uint64_t);
+void map_event_add(struct _track_proc *, uint64_t, uint64_t, unsigned int,
+	unsigned int, const char *);
+void map_event_lost(struct _track_proc *);
+int map_numamaps_load(struct _track_proc *);
+int map_thp_pct(map_entry_t *);
 int map_map2numa(struct _track_proc *, map_entry_t *);
-int map_addr2nodedst(pid_t pid, void **, int *, int, map_nodedst_t *,
-	int, int *);
+int map_addr2nodedst(struct _track_proc *, void **, int *, mem_src_t *,
+	int, map_nodedst_t *, int, int *);
+map_entry_t* map_entry_lookup(struct _track_proc *, uint64_t);
+int map_heatmap_start(struct _track_proc *, int, unsigned int *);
+void map_heatmap_stop(struct _track_proc *, unsigned int);
+boolean_t map_heatmap_owned(struct _track_proc *, unsigned int);
+void map_heatmap_add(struct _track_proc *, int, int, struct _os_perf_llrec *);
+int map_heatmap_get(struct _track_proc *, map_heat_t **, int *, uint64_t *);
+int map_migrate_plan(struct _track_proc *, struct _track_lwp *, uint64_t,
+	uint64_t, map_migrate_t *);
+int map_migrate_run(struct _track_proc *, map_migrate_t *, uint64_t);
+void map_migrate_free(map_migrate_t *);
+int map_lwp_place(struct _track_proc *, struct _track_lwp *, map_place_t *);
+void map_pagecache_refresh(struct _track_proc *);
 
 #ifdef __cplusplus
 }
 #endif
 
-#endif /* _NUMATOP_SYM_H */
+#endif /* _NUMATOP_MAP_H */
 
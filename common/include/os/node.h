@@ -44,8 +44,28 @@ extern "C" {
 #define INVALID_CPUID	-1
 #define	NODE_VALID(node) ((node)->nid != INVALID_NID)
 
-#define NODE_QPI_MAX	3
-#define NODE_IMC_MAX	8
+/*
+ * The SLIT distance of a local access, and the distance assumed for
+ * a remote one if the firmware doesn't provide the table.
+ */
+#define	NODE_DISTANCE_LOCAL	10
+#define	NODE_DISTANCE_REMOTE	20
+
+/*
+ * The levels of the topology tree. Without SNC or NPS it's
+ * socket -> node -> LLC domain -> CPU, with SNC the L3 is shared by
+ * the whole socket, so it's socket -> LLC domain -> node -> CPU.
+ */
+typedef enum {
+	TOPO_LEVEL_NODE = 0,
+	TOPO_LEVEL_SOCKET,
+	TOPO_LEVEL_LLC
+} topo_level_t;
+
+#define	TOPO_LEVEL_NUM	3
+
+/* Maximum number of events in the group of an uncore PMU box */
+#define UNCORE_GROUP_MAX	4
 
 /* Number of online CPUs */
 extern int g_ncpus;
@@ -60,6 +80,17 @@ typedef struct _node_meminfo {
 	uint64_t mapped;
 } node_meminfo_t;
 
+/*
+ * Bandwidth (bytes per second) of the uncore burst samples taken
+ * within one display interval.
+ */
+typedef struct _uncore_burst {
+	int nsamples;
+	double peak;
+	double p99;
+	double mean;
+} uncore_burst_t;
+
 typedef struct _qpi_info {
 	int id;
 	int type;
@@ -67,24 +98,38 @@ typedef struct _qpi_info {
 	unsigned int config;
 	uint64_t values[3];
 	uint64_t value_scaled;
+	uint64_t intval_ns;
 } qpi_info_t;
 
 typedef struct _node_qpi {
 	int qpi_num;
-	qpi_info_t qpi_info[NODE_QPI_MAX];
+	qpi_info_t *qpi_info;
+	uncore_burst_t burst;
 } node_qpi_t;
 
+/* The read and the write CAS are counted in one group per channel */
+#define IMC_CAS_RD	0
+#define IMC_CAS_WR	1
+#define IMC_CAS_NUM	2
+
 typedef struct _imc_info {
 	int id;
 	int type;
-	int fd;
-	uint64_t values[3];
+	int nevents;
+	unsigned int config[IMC_CAS_NUM];
+	int fds[IMC_CAS_NUM];
+	uint64_t values[IMC_CAS_NUM];
+	uint64_t time_enabled;
+	uint64_t time_running;
 	uint64_t value_scaled;
+	uint64_t cas_scaled[IMC_CAS_NUM];
+	uint64_t intval_ns;
 } imc_info_t;
 
 typedef struct _node_imc {
 	int imc_num;
-	imc_info_t imc_info[NODE_IMC_MAX];
+	imc_info_t *imc_info;
+	uncore_burst_t burst;
 } node_imc_t;
 
 typedef struct _node {
@@ -97,14 +142,34 @@ typedef struct _node {
 	node_imc_t imc;
 	boolean_t hotadd;
 	boolean_t hotremove;	
+	boolean_t memory_only;	/* memory without CPU, e.g. CXL memory */
+	int pkgid;		/* socket, the nearest one if memory only */
+	double remote_distance;	/* expected distance of a remote access */
+	double xsocket_ratio;	/* expected share of cross-socket remote */
 } node_t;
 
+/*
+ * A socket or an LLC domain with the perf data of its CPUs summed up.
+ * The memory is only known per node, so an LLC domain has none.
+ */
+typedef struct _topo_domain {
+	int id;
+	int nid;		/* node of an LLC domain, or INVALID_NID
+				 * if the LLC spans several nodes */
+	int nnodes;
+	int ncpus;
+	count_value_t countval;
+	uint64_t mem_total;
+	uint64_t mem_free;
+} topo_domain_t;
+
 typedef struct _node_group {
 	pthread_mutex_t mutex;
 	node_t *nodes;
 	int nnodes;
 	int cpuid_max;
 	int intval_ms;
+	int *distance;		/* nnodes_max x nnodes_max SLIT */
 	boolean_t inited;
 } node_group_t;
 
@@ -129,6 +194,11 @@ extern void node_intval_update(int);
 extern void node_profiling_clear(void);
 extern node_t* node_valid_get(int);
 extern int node_cpuid_max(void);
+extern int node_uncore_cpu(node_t *);
+extern int node_distance(int, int);
+extern double node_access_cost(count_value_t *, int);
+extern double node_xsocket_access(count_value_t *, int);
+extern int node_topo_domains(topo_level_t, topo_domain_t *, int);
 extern int node_qpi_init(void);
 extern int node_imc_init(void);
 
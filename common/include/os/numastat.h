@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2013, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Intel Corporation nor the names of its contributors
+ *     may be used to endorse or promote products derived from this software
+ *     without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _NUMATOP_NUMASTAT_H
+#define	_NUMATOP_NUMASTAT_H
+
+#include <sys/types.h>
+#include <inttypes.h>
+#include "../types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NUMASTAT_NPROCS_MAX	64
+#define NUMASTAT_NAME_SIZE	16
+
+/*
+ * The counters from '/proc/vmstat'.
+ */
+typedef enum {
+	NUMASTAT_PTE_UPDATES = 0,
+	NUMASTAT_HINT_FAULTS,
+	NUMASTAT_HINT_FAULTS_LOCAL,
+	NUMASTAT_PAGES_MIGRATED,
+	NUMASTAT_PROMOTE_SUCCESS,
+	NUMASTAT_PROMOTE_CANDIDATE,
+	NUMASTAT_DEMOTE_KSWAPD,
+	NUMASTAT_DEMOTE_DIRECT,
+	NUMASTAT_DEMOTE_KHUGEPAGED
+} numastat_vm_t;
+
+#define NUMASTAT_VM_NUM		9
+
+/*
+ * The counters of a node, from its 'numastat' and 'vmstat' in sysfs.
+ * NUMASTAT_NODE_DEMOTE is the sum of all the pgdemote_* counters.
+ */
+typedef enum {
+	NUMASTAT_NODE_HIT = 0,
+	NUMASTAT_NODE_MISS,
+	NUMASTAT_NODE_FOREIGN,
+	NUMASTAT_NODE_LOCAL,
+	NUMASTAT_NODE_OTHER,
+	NUMASTAT_NODE_PROMOTE,
+	NUMASTAT_NODE_DEMOTE
+} numastat_node_t;
+
+#define NUMASTAT_NODE_NUM	7
+
+/*
+ * The NUMA balancing state of a process from '/proc/<pid>/sched'. The
+ * rates are -1 if the kernel doesn't report the counter.
+ */
+typedef struct _numastat_proc {
+	pid_t pid;
+	char name[NUMASTAT_NAME_SIZE];
+	int cur_node;
+	int pref_node;
+	uint64_t faults;
+	uint64_t migrated;
+	double faults_rate;
+	double migrated_rate;
+} numastat_proc_t;
+
+/*
+ * All the rates are per second. "vm_valid" and "node_valid" tell which
+ * counters the kernel reports, "node_valid" is per node.
+ */
+typedef struct _numastat {
+	int balancing;
+	double vm[NUMASTAT_VM_NUM];
+	boolean_t vm_valid[NUMASTAT_VM_NUM];
+	double *node;
+	boolean_t *node_valid;
+	numastat_proc_t procs[NUMASTAT_NPROCS_MAX];
+	int nprocs;
+} numastat_t;
+
+#define NUMASTAT_NODE_RATE(stat, nid, i) \
+	((stat)->node[(nid) * NUMASTAT_NODE_NUM + (i)])
+
+#define NUMASTAT_NODE_VALID(stat, nid) \
+	(&(stat)->node_valid[(nid) * NUMASTAT_NODE_NUM])
+
+numastat_t *numastat_refresh(void);
+void numastat_fini(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _NUMATOP_NUMASTAT_H */
@@ -48,10 +48,19 @@ extern int os_preop_lnmap_get(cmd_t *, boolean_t *);
 extern int os_preop_back2ll(cmd_t *, boolean_t *);
 extern int os_preop_switch2callchain(cmd_t *, boolean_t *);
 extern int os_preop_switch2accdst(cmd_t *, boolean_t *);
+extern int os_preop_switch2heatmap(cmd_t *, boolean_t *);
+extern int os_preop_switch2contend(cmd_t *, boolean_t *);
+extern int os_preop_switch2damon(cmd_t *, boolean_t *);
+extern int os_preop_migrate(cmd_t *, boolean_t *);
+extern int os_preop_switch2advisor(cmd_t *, boolean_t *);
+extern int os_preop_bind(cmd_t *, boolean_t *);
 extern int os_preop_leavecallchain(cmd_t *, boolean_t *);
 extern int os_preop_switch2pqoscmt(cmd_t *, boolean_t *);
 extern int os_preop_switch2pqosmbm(cmd_t *, boolean_t *);
 extern int os_preop_switch2uncore(cmd_t *, boolean_t *);
+extern int os_preop_switch2uncoreall(cmd_t *, boolean_t *);
+extern int os_preop_leaveuncore(cmd_t *, boolean_t *);
+extern int os_preop_switch2cgroup(cmd_t *, boolean_t *);
 
 extern int os_op_llmap_stop(cmd_t *, boolean_t);
 extern int os_op_lnmap_stop(cmd_t *, boolean_t);
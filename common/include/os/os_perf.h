@@ -43,21 +43,31 @@ extern precise_type_t g_precise;
 #define PERF_REC_NUM	512
 #define PERF_FD_NUM		NCPUS_MAX * PERF_COUNT_NUM
 #define INVALID_CODE_UMASK	(uint64_t)(-1)
-#define PERF_PQOS_CMT_MAX	10
+#define PERF_PQOS_TOPN	256
+#define UNCORE_BURST_MS	5
+#define UNCORE_BURST_NUM	4096
 
 #define PERF_PQOS_FLAG_LLC	1
 #define PERF_PQOS_FLAG_TOTAL_BW	2
 #define PERF_PQOS_FLAG_LOCAL_BW	4
 
+/*
+ * "ips" is sized to "ip_num" when the record is allocated, so the
+ * callchain must be the last member of the record.
+ */
 typedef struct _os_perf_callchain {
 	unsigned int ip_num;
-	uint64_t ips[IP_NUM];
+	uint64_t ips[];
 } os_perf_callchain_t;
 
 typedef struct _os_perf_llrec {
+	int ref_count;
+	uint64_t seq;
 	uint64_t addr;
 	uint64_t cpu;
 	uint64_t latency;
+	mem_src_t mem_src;
+	boolean_t hitm;
 	os_perf_callchain_t callchain;
 } os_perf_llrec_t;
 
@@ -68,15 +78,29 @@ typedef struct _perf_cpu {
 	int map_len;
 	int map_mask;
 	void *map_base;
+	int ll_fd;
+	int ll_map_len;
+	int ll_map_mask;
+	void *ll_map_base;
 	boolean_t hit;
 	boolean_t hotadd;
 	boolean_t hotremove;
+	int pkgid;
+	int llcid;
+	count_value_t countval;
 	count_value_t countval_last;
 } perf_cpu_t;
 
+/*
+ * "task_id" is the monitor group from the resctrl pool plus 1, 0 if
+ * the task isn't monitored now. "seq" orders the tasks by the time
+ * they got the group and "nsmpl" is the number of samples since then.
+ */
 typedef struct _perf_pqos {
 	int task_id;
 	int flags;
+	uint64_t seq;
+	int nsmpl;
 	uint64_t occupancy_scaled;
 	uint64_t totalbw_scaled;
 	uint64_t localbw_scaled;
@@ -94,6 +118,7 @@ struct _perf_chainrec;
 struct _perf_llrecgrp;
 struct _track_proc;
 struct _track_lwp;
+struct _node;
 
 extern boolean_t os_profiling_started(struct _perf_ctl *);
 extern int os_profiling_start(struct _perf_ctl *, union _perf_task *);
@@ -118,6 +143,7 @@ extern int os_perf_callchain_smpl(void);
 extern int os_perf_ll_smpl(struct _perf_ctl *, pid_t, int);
 extern void os_perf_countchain_reset(struct _perf_countchain *);
 extern void os_allstop(void);
+extern void os_allfree(void);
 extern int os_perf_allstop(void);
 extern void* os_perf_priv_alloc(boolean_t *);
 extern void os_perf_priv_free(void *);
@@ -134,6 +160,9 @@ extern int os_pqos_cmt_start(struct _perf_ctl *, union _perf_task *);
 extern int os_perf_pqos_cmt_smpl(struct _perf_ctl *, pid_t, int);
 extern int os_pqos_cmt_smpl(struct _perf_ctl *, union _perf_task *, int *);
 extern void os_perf_pqos_free(perf_pqos_t *);
+extern void os_perf_pqos_release(perf_pqos_t *);
+extern int os_perf_pqos_nfree(void);
+extern int os_perf_pqos_size(void);
 extern int os_pqos_cmt_proc_smpl(struct _track_proc *, void *, boolean_t *);
 extern int os_pqos_cmt_lwp_smpl(struct _track_lwp *, void *, boolean_t *);
 extern int os_pqos_cmt_proc_free(struct _track_proc *, void *, boolean_t *);
@@ -144,6 +173,7 @@ extern int os_uncore_start(struct _perf_ctl *, union _perf_task *);
 extern int os_uncore_smpl(struct _perf_ctl *, union _perf_task *, int *);
 extern boolean_t os_perf_uncore_started(struct _perf_ctl *);
 extern int os_perf_uncore_smpl(struct _perf_ctl *, int);
+extern void os_uncore_burst_stop(struct _node *);
 
 #ifdef __cplusplus
 }
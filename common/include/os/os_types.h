@@ -39,6 +39,7 @@ typedef enum {
 } boolean_t;
 
 #define IP_NUM	32
+#define CACHELINE_SIZE	64
 #define INVALID_FD	-1
 #define INVALID_CONFIG	(uint64_t)(-1)
 
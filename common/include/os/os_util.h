@@ -50,6 +50,10 @@ extern "C" {
 	"/sys/devices/system/node/"
 #define NODE_NONLINE_PATH \
 	"/sys/devices/system/node/online"
+#define CPU_ONLINE_PATH \
+	"/sys/devices/system/cpu/online"
+#define CPU_INFO_ROOT \
+	"/sys/devices/system/cpu/"
 #define CPUINFO_PATH \
 	"/proc/cpuinfo"
 #define CQM_LLC_OCCUPANCY_SCALE_PATH \
@@ -66,23 +70,34 @@ extern int os_numatop_lock(boolean_t *);
 extern void os_numatop_unlock(void);
 extern int os_procfs_psinfo_get(pid_t, void *);
 extern int os_procfs_pname_get(pid_t, char *, int);
+extern int os_procfs_cgroup_get(pid_t, char *, int);
 extern int os_procfs_lwp_enum(pid_t, int **lwps, int *);
 extern boolean_t os_procfs_lwp_valid(pid_t, int);
 extern int processor_bind(int cpu);
 extern int processor_unbind(void);
+extern int os_lwp_node_bind(int, node_t *);
+extern int os_procfs_cpu_time(uint64_t *, uint64_t *, int);
 extern void os_calibrate(double *nsofclk, uint64_t *clkofsec);
 extern boolean_t os_sysfs_node_enum(int *, int, int *);
 extern boolean_t os_sysfs_cpu_enum(int, int *, int, int *);
 extern int sysfs_os_online_ncpus(void);
 extern boolean_t os_sysfs_meminfo(int, node_meminfo_t *);
+extern boolean_t os_sysfs_node_distance(int, int *, int, int *);
 extern int os_sysfs_online_ncpus(void);
+extern int os_sysfs_cpu_pkgid(int);
+extern int os_sysfs_cpu_llcid(int);
+extern boolean_t os_sysfs_topo_changed(void);
+extern void os_sysfs_topo_reset(void);
+extern void os_sysfs_fini(void);
 extern int os_sysfs_cqm_llc_scale(const char*, double *);
+extern int os_sysfs_uncore_num(const char *);
 extern int os_sysfs_uncore_qpi_init(qpi_info_t *, int);
 extern int os_sysfs_uncore_upi_init(qpi_info_t *, int);
 extern int os_sysfs_uncore_imc_init(imc_info_t *, int);
 extern boolean_t os_cmt_init(void);
 extern void os_cmt_fini(void);
 extern int os_sysfs_cmt_task_set(int, int, struct _perf_pqos *);
+extern void os_sysfs_cmt_task_free(struct _perf_pqos *);
 extern int os_sysfs_cmt_task_value(struct _perf_pqos *, int);
 
 #ifdef __cplusplus
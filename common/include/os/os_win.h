@@ -42,24 +42,51 @@ extern "C" {
 
 #define	NOTE_LAT \
 	"Q: Quit; H: Home; B: Back; R: Refresh; " \
-	"C: Call-Chain; D: Distribution"
+	"C: Call-Chain; D: Distribution; E: Heatmap; X: Contention"
 
 #define	NOTE_LATNODE \
-	"Q: Quit; H: Home; B: Back; R: Refresh"
+	"Q: Quit; H: Home; B: Back; R: Refresh; G: Migrate"
 
 #define NOTE_LLCALLCHAIN	\
 	"Q: Quit; H: Home; B: Back; R: Refresh"	
 
+#define	NOTE_HEATMAP \
+	"Q: Quit; H: Home; B: Back; R: Refresh"
+
+#define	NOTE_CONTEND \
+	"Q: Quit; H: Home; B: Back; R: Refresh"
+
+#define	NOTE_DAMON \
+	"Q: Quit; H: Home; B: Back; R: Refresh"
+
+#define	NOTE_UNCORE \
+	"Q: Quit; H: Home; B: Back; R: Refresh; N: Node"
+
+#define	NOTE_CGROUP \
+	"Q: Quit; H: Home; B: Back; R: Refresh; N: Node"
+
+#define	NOTE_NUMASTAT \
+	"Q: Quit; H: Home; B: Back; R: Refresh; N: Node"
+
+#define	NOTE_ADVISOR \
+	"Q: Quit; H: Home; B: Back; R: Refresh; Y: Bind"
+
+/*
+ * The lines of node detail besides the ones per link and per channel.
+ */
+#define	NODEDETAIL_LINES	20
+
 struct _nodeoverview_line;
 struct _dyn_nodedetail;
 struct _dyn_callchain;
 struct _dyn_win;
 struct _page;
 struct _lat_line;
+struct _dyn_advisor;
 
-extern void os_nodeoverview_caption_build(char *, int);
+extern void os_nodeoverview_caption_build(char *, int, topo_level_t);
 extern void os_nodeoverview_data_build(char *, int,
-    struct _nodeoverview_line *, node_t *);
+    struct _nodeoverview_line *);
 extern void os_nodedetail_data(struct _dyn_nodedetail *, win_reg_t *);
 extern int os_callchain_list_show(struct _dyn_callchain *, track_proc_t *,
     track_lwp_t *);
@@ -71,6 +98,39 @@ extern void os_llcallchain_win_destroy(struct _dyn_win *);
 extern boolean_t os_llcallchain_win_draw(struct _dyn_win *);
 extern void os_llcallchain_win_scroll(struct _dyn_win *, int);
 extern boolean_t os_latnode_win_draw(struct _dyn_win *);
+extern void* os_heatmap_dyn_create(struct _page *);
+extern void os_heatmap_win_destroy(struct _dyn_win *);
+extern boolean_t os_heatmap_win_draw(struct _dyn_win *);
+extern void os_heatmap_win_scroll(struct _dyn_win *, int);
+extern int os_migrate_start(map_migrate_t *, pid_t, int, uint64_t, uint64_t);
+extern void os_migrate_update(map_migrate_t *, track_proc_t *, uint64_t,
+	uint64_t, const memsrc_count_t *);
+extern void os_migrate_show(win_reg_t *, map_migrate_t *);
+extern void* os_advisor_dyn_create(struct _page *);
+extern void os_advisor_win_destroy(struct _dyn_win *);
+extern boolean_t os_advisor_win_draw(struct _dyn_win *);
+extern void os_advisor_win_scroll(struct _dyn_win *, int);
+extern int os_advisor_bind(struct _dyn_advisor *);
+extern void* os_contend_dyn_create(struct _page *);
+extern void os_contend_win_destroy(struct _dyn_win *);
+extern boolean_t os_contend_win_draw(struct _dyn_win *);
+extern void os_contend_win_scroll(struct _dyn_win *, int);
+extern void* os_damon_dyn_create(struct _page *);
+extern void os_damon_win_destroy(struct _dyn_win *);
+extern boolean_t os_damon_win_draw(struct _dyn_win *);
+extern void os_damon_win_scroll(struct _dyn_win *, int);
+extern void* os_uncore_dyn_create(struct _page *);
+extern void os_uncore_win_destroy(struct _dyn_win *);
+extern boolean_t os_uncore_win_draw(struct _dyn_win *);
+extern void os_uncore_win_scroll(struct _dyn_win *, int);
+extern void* os_cgroup_dyn_create(struct _page *);
+extern void os_cgroup_win_destroy(struct _dyn_win *);
+extern boolean_t os_cgroup_win_draw(struct _dyn_win *);
+extern void os_cgroup_win_scroll(struct _dyn_win *, int);
+extern void* os_numastat_dyn_create(struct _page *);
+extern void os_numastat_win_destroy(struct _dyn_win *);
+extern boolean_t os_numastat_win_draw(struct _dyn_win *);
+extern void os_numastat_win_scroll(struct _dyn_win *, int);
 
 #ifdef __cplusplus
 }
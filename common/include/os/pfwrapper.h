@@ -41,6 +41,7 @@ extern "C" {
 #define PF_MAP_NPAGES_MAX			1024
 #define PF_MAP_NPAGES_MIN			64
 #define PF_MAP_NPAGES_NORMAL		256
+#define PF_MMAP_REC_NUM			256
 
 #if defined(__i386__)
 #ifndef __NR_perf_event_open
@@ -79,6 +80,7 @@ typedef struct _pf_conf {
 	uint64_t config1;
 	uint64_t sample_period;
 	bool exclude_guest;
+	bool mmap_track;
 } pf_conf_t;
 
 typedef struct _pf_profiling_rec {
@@ -105,6 +107,8 @@ typedef struct _pf_ll_rec {
 	uint64_t addr;
 	uint64_t cpu;
 	uint64_t latency;
+	mem_src_t mem_src;
+	boolean_t hitm;
 	unsigned int ip_num;
 	uint64_t ips[IP_NUM];
 } pf_ll_rec_t;
@@ -118,6 +122,23 @@ typedef struct _pf_ll_rbrec {
 	unsigned int ip_num;
 } pf_ll_rbrec_t;
 
+typedef struct _pf_mmap_rec {
+	unsigned int pid;
+	unsigned int tid;
+	uint64_t addr;
+	uint64_t len;
+	uint32_t prot;
+	uint32_t flags;
+	char path[PATH_MAX];
+} pf_mmap_rec_t;
+
+typedef struct _pf_mmap_recbuf {
+	pf_mmap_rec_t *rec_arr;
+	int nrec_cur;
+	int nrec_max;
+	boolean_t lost;
+} pf_mmap_recbuf_t;
+
 struct _perf_cpu;
 struct _perf_pqos;
 struct _node;
@@ -134,8 +155,10 @@ void pf_profiling_record(struct _perf_cpu *, pf_profiling_rec_t *, int *);
 int pf_ll_setup(struct _perf_cpu *, pf_conf_t *);
 int pf_ll_start(struct _perf_cpu *);
 int pf_ll_stop(struct _perf_cpu *);
-void pf_ll_record(struct _perf_cpu *, pf_ll_rec_t *, int *);
+void pf_ll_record(struct _perf_cpu *, pf_ll_rec_t *, int *,
+	pf_mmap_recbuf_t *);
 void pf_resource_free(struct _perf_cpu *);
+void pf_ll_resource_free(struct _perf_cpu *);
 int pf_pqos_occupancy_setup(struct _perf_pqos *, int pid, int lwpid);
 int pf_pqos_totalbw_setup(struct _perf_pqos *, int pid, int lwpid);
 int pf_pqos_localbw_setup(struct _perf_pqos *, int pid, int lwpid);
@@ -151,6 +174,7 @@ void pf_uncoreimc_free(struct _node *);
 int pf_uncoreimc_setup(struct _node *);
 int pf_uncoreimc_start(struct _node *);
 int pf_uncoreimc_smpl(struct _node *);
+int pf_uncore_burst_read(struct _node *, uint64_t *, uint64_t *);
 
 #ifdef __cplusplus
 }
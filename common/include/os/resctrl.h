@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2013, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Intel Corporation nor the names of its contributors
+ *     may be used to endorse or promote products derived from this software
+ *     without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _NUMATOP_RESCTRL_H
+#define	_NUMATOP_RESCTRL_H
+
+#include <sys/types.h>
+#include <inttypes.h>
+#include "../types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RESCTRL_ROOT		"/sys/fs/resctrl"
+#define RESCTRL_GROUP_MAX	256
+
+typedef enum {
+	RESCTRL_LLC_OCCUPANCY = 0,
+	RESCTRL_MBM_TOTAL,
+	RESCTRL_MBM_LOCAL
+} resctrl_event_t;
+
+#define RESCTRL_EVENT_NUM	3
+
+int resctrl_pool_init(void);
+void resctrl_pool_fini(void);
+int resctrl_pool_size(void);
+int resctrl_pool_nfree(void);
+int resctrl_slot_alloc(pid_t);
+int resctrl_group_alloc(const char *);
+int resctrl_group_sync(int);
+void resctrl_slot_free(int);
+int resctrl_slot_read(int, int, uint64_t *);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _NUMATOP_RESCTRL_H */
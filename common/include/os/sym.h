@@ -134,6 +134,7 @@ void sym_init(void);
 void sym_fini(void);
 int sym_load(struct _track_proc *, sym_type_t);
 void sym_free(sym_t *);
+int sym_data_resolve(sym_t *, uint64_t, char *, int);
 int sym_callchain_add(sym_t *, uint64_t *, int, sym_chainlist_t *);
 void sym_callchain_resort(sym_chainlist_t *);
 sym_callchain_t* sym_callchain_detach(sym_chainlist_t *);
@@ -41,6 +41,11 @@ extern "C" {
 
 #define	PERF_WAIT_NSEC	60
 #define	PERF_INTVAL_MIN_MS	1000
+#define	PERF_REC_MAX_DEFAULT	16384
+
+extern int g_rec_max;
+extern boolean_t g_perf_concurrent;
+extern boolean_t g_uncore_only;
 
 typedef enum {
 	PERF_STATUS_IDLE = 0,
@@ -149,23 +154,32 @@ typedef union _perf_task {
 	task_uncore_t uncore;
 } perf_task_t;
 
+/*
+ * The records are shared by the process and the thread, the groups
+ * only keep the references. Each group is a reservoir of at most
+ * 'g_rec_max' records, 'nrec_seen' is the number of records offered
+ * to the group.
+ */
 typedef struct _perf_llrecgrp {
-	os_perf_llrec_t *rec_arr;
+	os_perf_llrec_t **rec_arr;
 	int nrec_cur;
 	int nrec_max;
 	int cursor;
+	uint64_t nrec_seen;
 } perf_llrecgrp_t;
 
 typedef struct _perf_chainrec {
+	int ref_count;
 	uint64_t count_value;
 	os_perf_callchain_t callchain;
 } perf_chainrec_t;
 
 typedef struct _perf_chainrecgrp {
-	perf_chainrec_t *rec_arr;
+	perf_chainrec_t **rec_arr;
 	int nrec_cur;
 	int nrec_max;
 	int cursor;
+	uint64_t nrec_seen;
 } perf_chainrecgrp_t;
 
 typedef struct _perf_countchain {
@@ -191,7 +205,9 @@ typedef struct _perf_ctl {
 	perf_task_t task;
 	boolean_t inited;
 	uint64_t last_ms;
+	uint64_t last_ms_ll;
 	uint64_t last_ms_pqos;
+	uint64_t last_ms_uncore;
 } perf_ctl_t;
 
 extern int perf_init(void);
@@ -208,6 +224,9 @@ extern int perf_callchain_smpl(void);
 extern boolean_t perf_ll_started(void);
 extern int perf_ll_start(pid_t);
 extern int perf_ll_smpl(pid_t, int);
+extern int perf_rec_slot(uint64_t *, int);
+extern void perf_llrec_put(os_perf_llrec_t *);
+extern void perf_chainrec_put(perf_chainrec_t *);
 extern void perf_llrecgrp_reset(perf_llrecgrp_t *);
 extern void perf_countchain_reset(perf_countchain_t *);
 extern void perf_status_set(perf_status_t);
@@ -118,6 +118,7 @@ extern int proc_intval_get(track_proc_t *);
 extern void proc_profiling_clear(void);
 extern void proc_callchain_clear(void);
 extern void proc_ll_clear(track_proc_t *);
+extern void proc_map_lost(void);
 extern void proc_pqos_func(track_proc_t *,
 	int (*func)(track_proc_t *, void *, boolean_t *));
 
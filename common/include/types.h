@@ -59,7 +59,9 @@ typedef enum {
 	SORT_KEY_CPI,
 	SORT_KEY_RMA,
 	SORT_KEY_LMA,
-	SORT_KEY_RL
+	SORT_KEY_RL,
+	SORT_KEY_COST,
+	SORT_KEY_XSOCKET
 } sort_key_t;
 
 #define	MAX_VALUE	4294967295U
@@ -130,6 +132,46 @@ typedef struct _bufaddr {
 	uint64_t size;
 } bufaddr_t;
 
+/*
+ * Log-linear latency histogram. Values below LAT_HIST_SUB_NUM get one
+ * bucket each, every following power of two is split into
+ * LAT_HIST_SUB_NUM linear buckets. Values beyond the last bucket are
+ * counted in it, "max" keeps the exact maximum.
+ */
+#define	LAT_HIST_SUB_BITS	2
+#define	LAT_HIST_SUB_NUM	(1 << LAT_HIST_SUB_BITS)
+#define	LAT_HIST_GRP_NUM	20
+#define	LAT_HIST_NUM		(LAT_HIST_GRP_NUM * LAT_HIST_SUB_NUM)
+
+/*
+ * Where the data of a sampled load came from, decoded from
+ * PERF_SAMPLE_DATA_SRC. The loads served by L1/L2/LFB or which have no
+ * data source are counted as MEM_SRC_OTHER. MEM_SRC_HITM is a load which
+ * hit a modified line in the cache of another core on the same node, a
+ * HITM on another node is counted as MEM_SRC_REM_CACHE.
+ */
+typedef enum {
+	MEM_SRC_OTHER = 0,
+	MEM_SRC_L3,
+	MEM_SRC_LOC_DRAM,
+	MEM_SRC_REM_DRAM,
+	MEM_SRC_REM_CACHE,
+	MEM_SRC_CXL,
+	MEM_SRC_HITM
+} mem_src_t;
+
+#define	MEM_SRC_NUM	7
+
+typedef struct _memsrc_count {
+	uint32_t count[MEM_SRC_NUM];
+} memsrc_count_t;
+
+typedef struct _lat_hist {
+	uint32_t nsamples;
+	uint32_t max;
+	uint32_t bucket[LAT_HIST_NUM];
+} lat_hist_t;
+
 #ifdef __cplusplus
 }
 #endif
@@ -96,6 +96,9 @@ extern void pagesize_init(void);
 extern uint64_t rdtsc(void);
 extern int arch__cpuinfo_freq(double *freq, char *unit);
 extern int is_userspace(uint64_t);
+extern void lat_hist_add(lat_hist_t *, uint64_t);
+extern void lat_hist_merge(lat_hist_t *, const lat_hist_t *);
+extern uint64_t lat_hist_percentile(const lat_hist_t *, int);
 
 #ifdef __cplusplus
 }
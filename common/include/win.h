@@ -36,6 +36,7 @@
 #include "types.h"
 #include "reg.h"
 #include "./os/os_win.h"
+#include "./os/damon.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -63,15 +64,17 @@ extern double g_llc_local_bw_scale;
 	"Q: Quit; H: Home; B: Back; R: Refresh; N: Node; O: LLC OCCUPANCY"
 
 #define	NOTE_TOPNPROC_RAW \
-	"Q: Quit; H: Home; R: Refresh; I: IR Normalize; N: Node"
+	"Q: Quit; H: Home; R: Refresh; I: IR Normalize; N: Node; U: Uncore"
 
 #define	NOTE_TOPNPROC_RAW_LLC \
-	"Q: Quit; H: Home; R: Refresh; I: IR Normalize; N: Node; O: LLC OCCUPANCY"
+	"Q: Quit; H: Home; R: Refresh; I: IR Normalize; N: Node; U: Uncore; " \
+	"O: LLC OCCUPANCY"
 
 #define NOTE_TOPNPROC	NOTE_DEFAULT
 #define	NOTE_TOPNPROC_LLC	NOTE_DEFAULT_LLC
 
-#define	NOTE_TOPNLWP	NOTE_DEFAULT
+#define	NOTE_TOPNLWP \
+	"Q: Quit; H: Home; B: Back; R: Refresh; N: Node; A: Advisor"
 
 #define	NOTE_MONIPROC \
 	"Q: Quit; H: Home; B: Back; R: Refresh; " \
@@ -88,13 +91,17 @@ extern double g_llc_local_bw_scale;
 #define	NOTE_NONODE \
 	"Q: Quit; H: Home; B: Back; R: Refresh"
 
-#define	NOTE_ACCDST	NOTE_NONODE
-#define	NOTE_NODEOVERVIEW NOTE_NONODE
+#define	NOTE_ACCDST \
+	"Q: Quit; H: Home; B: Back; R: Refresh; G: Migrate"
+#define	NOTE_NODEOVERVIEW \
+	"Q: Quit; H: Home; B: Back; R: Refresh; T: Socket/Node/LLC"
 #define	NOTE_NODEDETAIL NOTE_NONODE
 #define	NOTE_CALLCHAIN	NOTE_NONODE
-#define NOTE_PQOS_CMT_TOPNPROC	NOTE_NONODE
 #define NOTE_PQOS_MBM	NOTE_NONODE
 
+#define NOTE_PQOS_CMT_TOPNPROC	\
+	"Q: Quit; H: Home; B: Back; R: Refresh; P: Memory Bandwidth"
+
 #define NOTE_PQOS_CMT_MONI	\
 	"Q: Quit; H: Home; B: Back; R: Refresh; P: Memory Bandwidth"
 
@@ -123,14 +130,62 @@ extern double g_llc_local_bw_scale;
 #define	CAPTION_RMA			"RMA(K)"
 #define	CAPTION_LMA			"LMA(K)"
 #define	CAPTION_RL			"RMA/LMA"
+#define	CAPTION_COST		"COST(K)"
+#define	CAPTION_XSOCKET		"XSKT(K)"
+#define	CAPTION_SOCKET		"SOCK"
+#define	CAPTION_LLC		"LLC"
+#define	CAPTION_NCPUS		"CPUS"
 #define	CAPTION_DESC		"DESC"
 #define	CAPTION_BUFHIT		"ACCESS%%"
 #define	CAPTION_AVGLAT		"LAT(ns)"
+#define	CAPTION_P50LAT		"P50(ns)"
+#define	CAPTION_P90LAT		"P90(ns)"
+#define	CAPTION_P99LAT		"P99(ns)"
+#define	CAPTION_MAXLAT		"MAX(ns)"
+#define	CAPTION_L3		"L3%%"
+#define	CAPTION_LDRAM		"LDRAM%%"
+#define	CAPTION_RDRAM		"RDRAM%%"
+#define	CAPTION_RCACHE		"RCACHE%%"
+#define	CAPTION_CXL		"CXL%%"
+#define	CAPTION_HITM		"HITM%%"
+#define	CAPTION_ACCESS		"ACCESS"
+#define	CAPTION_ACCNODES	"ACC.NODES"
+#define	CAPTION_SAMPLES		"SAMPLES"
+#define	CAPTION_RUNNODE		"RUN.NODE"
+#define	CAPTION_MEMNODE		"MEM.NODE"
+#define	CAPTION_RMA_NOW		"RMA%%"
+#define	CAPTION_RMA_BIND	"RMA%%.BIND"
+#define	CAPTION_IDLECPU		"IDLE.CPU"
+#define	CAPTION_ADVICE		"ADVICE"
+#define	CAPTION_HITM		"HITM%%"
+#define	CAPTION_DATA		"DATA"
+#define	CAPTION_FREQ		"FREQ%%"
+#define	CAPTION_AGE		"AGE(s)"
+#define	CAPTION_REMOTE		"REMOTE%%"
 #define	CAPTION_MEM_ALL		"MEM.ALL"
 #define	CAPTION_MEM_FREE	"MEM.FREE"
+#define	CAPTION_MEM_RD		"MEM.RD(GB/s)"
+#define	CAPTION_MEM_WR		"MEM.WR(GB/s)"
+#define	CAPTION_LINK		"LINK(GB/s)"
 #define CAPTION_LLC_OCCUPANCY	"LLC.OCCUPANCY(MB)"
 #define CAPTION_TOTAL_BW	"MBAND.TOTAL"
 #define CAPTION_LOCAL_BW	"MBAND.LOCAL"
+#define	CAPTION_CGROUP		"CGROUP"
+#define	CAPTION_NPROC		"NPROC"
+#define	CAPTION_LLC_MB		"LLC(MB)"
+#define	CAPTION_MBAND_TOTAL	"TOTAL(MB/s)"
+#define	CAPTION_MBAND_LOCAL	"LOCAL(MB/s)"
+#define	CAPTION_MBAND_REMOTE	"REMOTE(MB/s)"
+#define	CAPTION_HIT		"HIT/s"
+#define	CAPTION_MISS		"MISS/s"
+#define	CAPTION_FOREIGN		"FOREIGN/s"
+#define	CAPTION_LOCAL		"LOCAL/s"
+#define	CAPTION_OTHER		"OTHER/s"
+#define	CAPTION_PROMOTE		"PROMOTE/s"
+#define	CAPTION_DEMOTE		"DEMOTE/s"
+#define	CAPTION_PREFNODE	"PREF.NODE"
+#define	CAPTION_FAULTS		"FAULTS/s"
+#define	CAPTION_MIGRATED	"MIGRATED/s"
 
 typedef enum {
 	WIN_TYPE_RAW_NUM = 0,
@@ -153,9 +208,19 @@ typedef enum {
 	WIN_TYPE_PQOS_CMT_MONILWP,
 	WIN_TYPE_PQOS_MBM_MONIPROC,
 	WIN_TYPE_PQOS_MBM_MONILWP,
+	WIN_TYPE_PQOS_MBM_TOPNPROC,
+	WIN_TYPE_HEATMAP_PROC,
+	WIN_TYPE_HEATMAP_LWP,
+	WIN_TYPE_ADVISOR,
+	WIN_TYPE_CONTEND_PROC,
+	WIN_TYPE_CONTEND_LWP,
+	WIN_TYPE_DAMON,
+	WIN_TYPE_UNCORE,
+	WIN_TYPE_CGROUP,
+	WIN_TYPE_NUMASTAT,
 } win_type_t;
 
-#define	WIN_TYPE_NUM		20
+#define	WIN_TYPE_NUM		30
 
 typedef enum {
 	WARN_INVALID = 0,
@@ -194,6 +259,8 @@ typedef struct _win_countvalue {
 	double rma;
 	double lma;
 	double rl;
+	double cost;	/* distance-weighted accesses (K) */
+	double xsocket;	/* cross-socket accesses (K) */
 } win_countvalue_t;
 
 typedef struct _dyn_topnproc {
@@ -264,6 +331,8 @@ typedef struct _dyn_latnode {
 	win_reg_t note;
 	win_reg_t caption;
 	win_reg_t data;
+	win_reg_t hint;
+	map_migrate_t migrate;
 } dyn_latnode_t;
 
 typedef struct _lat_line {
@@ -275,6 +344,8 @@ typedef struct _lat_line {
 	int lwpid;
 	int nid;
 	boolean_t nid_show;
+	lat_hist_t hist;
+	memsrc_count_t memsrc;
 	char desc[WIN_DESCBUF_SIZE];
 } lat_line_t;
 
@@ -285,12 +356,15 @@ typedef struct _dyn_accdst {
 	win_reg_t caption;
 	win_reg_t data;
 	win_reg_t hint;
+	map_migrate_t migrate;
 } dyn_accdst_t;
 
 typedef struct _accdst_line {
 	int nid;
 	double access_ratio;
 	int latency;
+	lat_hist_t hist;
+	memsrc_count_t memsrc;
 } accdst_line_t;
 
 typedef struct _dyn_nodeoverview {
@@ -298,15 +372,77 @@ typedef struct _dyn_nodeoverview {
 	win_reg_t caption_cur;
 	win_reg_t data_cur;
 	win_reg_t hint;
+	topo_level_t level;
+	topo_domain_t *domains;
+	int nlines_max;
 } dyn_nodeoverview_t;
 
+/*
+ * "id" is the node, socket or LLC domain id by the level of the
+ * window; "nid" is the node to show in detail, INVALID_NID for none.
+ */
 typedef struct _nodeoverview_line {
 	win_countvalue_t value;
 	double mem_all;
 	double mem_free;
+	topo_level_t level;
+	int id;
 	int nid;
+	int ncpus;
 } nodeoverview_line_t;
 
+typedef struct _dyn_uncore {
+	win_reg_t msg;
+	win_reg_t caption;
+	win_reg_t data;
+	win_reg_t total;
+} dyn_uncore_t;
+
+/*
+ * The traffic of one node from the uncore counters. "link" is what the
+ * node sends out over the QPI/UPI links and "remote" is its share of
+ * the node's whole memory and link traffic.
+ */
+typedef struct _uncore_line {
+	int nid;
+	double rd;
+	double wr;
+	double link;
+	double remote;
+	boolean_t split;
+} uncore_line_t;
+
+typedef struct _dyn_cgroup {
+	win_reg_t msg;
+	win_reg_t caption;
+	win_reg_t data;
+	win_reg_t hint;
+} dyn_cgroup_t;
+
+/*
+ * A cgroup, or one node of it if "nid" is not -1. The bandwidths are
+ * in MB/s.
+ */
+typedef struct _cgroup_line {
+	char name[27];
+	int nid;
+	int nprocs;
+	boolean_t monitored;
+	double llc;
+	double total;
+	double local;
+	double remote;
+} cgroup_line_t;
+
+typedef struct _dyn_numastat {
+	win_reg_t msg;
+	win_reg_t sys;
+	win_reg_t caption_node;
+	win_reg_t data_node;
+	win_reg_t caption_proc;
+	win_reg_t data_proc;
+} dyn_numastat_t;
+
 typedef struct _dyn_nodedetail {
 	int nid;
 	win_reg_t msg;
@@ -343,6 +479,100 @@ typedef struct _dyn_llcallchain {
 	win_reg_t chain_data;
 } dyn_llcallchain_t;
 
+typedef struct _dyn_heatmap {
+	pid_t pid;
+	int lwpid;
+	unsigned int owner;
+	win_reg_t msg;
+	win_reg_t caption;
+	win_reg_t data;
+	win_reg_t line_caption;
+	win_reg_t line_data;
+	win_reg_t chain_data;
+} dyn_heatmap_t;
+
+typedef struct _heat_line {
+	map_heat_t heat;
+	uint64_t nsamples;
+	char desc[WIN_DESCBUF_SIZE];
+} heat_line_t;
+
+typedef struct _dyn_advisor {
+	pid_t pid;
+	win_reg_t msg;
+	win_reg_t caption;
+	win_reg_t data;
+	win_reg_t hint;
+	uint64_t *cpu_busy;
+	uint64_t *cpu_total;
+	boolean_t cpu_valid;	/* cpu_busy/cpu_total are sampled */
+	char status[WIN_LINECHAR_MAX];
+} dyn_advisor_t;
+
+/*
+ * "rma" is the ratio of LL samples to the pages on other nodes than
+ * where the thread runs, "rma_bind" is the ratio if the thread is
+ * bound to "mem_nid".
+ */
+typedef struct _advisor_line {
+	int lwpid;
+	int naccess;
+	int run_nid;
+	int mem_nid;
+	double rma;
+	double rma_bind;
+	double idle_cpus;
+	boolean_t advise;
+} advisor_line_t;
+
+typedef struct _dyn_contend {
+	pid_t pid;
+	int lwpid;
+	win_reg_t msg;
+	win_reg_t caption;
+	win_reg_t data;
+	win_reg_t chain_caption;
+	win_reg_t chain_data;
+} dyn_contend_t;
+
+/*
+ * A cacheline which is accessed from more than one node, "ips" is
+ * the call-chain of the latest sampled access to it and "desc" is
+ * the data symbol (or the memory area if no symbol is found).
+ */
+typedef struct _contend_line {
+	uint64_t addr;
+	int naccess;
+	int nhitm;
+	uint64_t total_lat;
+	uint64_t max_lat;
+	uint64_t node_mask;
+	unsigned int ip_num;
+	uint64_t ips[IP_NUM];
+	char desc[WIN_DESCBUF_SIZE];
+} contend_line_t;
+
+typedef struct _dyn_damon {
+	pid_t pid;
+	boolean_t started;
+	win_reg_t msg;
+	win_reg_t caption;
+	win_reg_t data;
+} dyn_damon_t;
+
+/*
+ * A DAMON region with its node placement. "nid" is the node which
+ * holds most of the resident pages and "remote" is the ratio of the
+ * resident pages which are not on the node where the process runs.
+ */
+typedef struct _damon_line {
+	damon_region_t region;
+	uint64_t resident;
+	int nid;
+	double remote;
+	char desc[WIN_DESCBUF_SIZE];
+} damon_line_t;
+
 typedef struct _dyn_pqos_cmt_proc {
 	pid_t pid;
 	int lwpid;
@@ -358,7 +588,7 @@ typedef struct _pqos_cmt_proc_line {
 	int pid;
 	int lwpid;
 	int nlwp;
-	int fd;
+	boolean_t monitored;
 	char proc_name[WIN_PROCNAME_SIZE];
 } pqos_cmt_proc_line_t;
 
@@ -378,8 +608,7 @@ typedef struct _pqos_mbm_proc_line {
 	int pid;
 	int lwpid;
 	int nlwp;
-	int totalbw_fd;
-	int localbw_fd;
+	boolean_t monitored;
 	char proc_name[WIN_PROCNAME_SIZE];
 } pqos_mbm_proc_line_t;
 
@@ -421,6 +650,12 @@ typedef struct _dyn_warn {
 #define	DYN_PQOS_MBM_PROC(page) \
 	((dyn_pqos_mbm_proc_t *)((page)->dyn_win.dyn))
 
+#define	DYN_TOPNLWP(page) \
+	((dyn_topnlwp_t *)((page)->dyn_win.dyn))
+
+#define	DYN_ADVISOR(page) \
+	((dyn_advisor_t *)((page)->dyn_win.dyn))
+
 /* CPU unhalted cycles in a second */
 extern uint64_t g_clkofsec;
 
@@ -438,10 +673,13 @@ extern void win_title_show(void);
 extern boolean_t win_lat_data_show(track_proc_t *, dyn_lat_t *, boolean_t *);
 extern lat_line_t* win_lat_buf_create(track_proc_t *, int, int *);
 extern void win_lat_buf_fill(lat_line_t *, int, track_proc_t *,
-    track_lwp_t *, int *);
+    track_lwp_t *, int *, lat_hist_t *, memsrc_count_t *);
+extern void win_lathist_str_build(char *, int, const lat_hist_t *);
+extern void win_memsrc_str_build(char *, int, const memsrc_count_t *);
 extern int win_lat_cmp(const void *, const void *);
 extern void win_lat_str_build(char *, int, int, void *);
 extern void win_size2str(uint64_t, char *, int);
+extern void bufdesc_cut(char *, int, const char *);
 extern void win_callchain_line_get(win_reg_t *, int, char *, int);
 
 #ifdef __cplusplus
@@ -42,6 +42,7 @@
 #include <sys/stat.h>
 #include <signal.h>
 #include <libgen.h>
+#include <ctype.h>
 #include "include/types.h"
 #include "include/util.h"
 #include "include/proc.h"
@@ -50,11 +51,14 @@
 #include "include/util.h"
 #include "include/os/plat.h"
 #include "include/os/node.h"
+#include "include/os/map.h"
+#include "include/os/damon.h"
 #include "include/os/os_util.h"
 #include "include/os/os_perf.h"
 
 static void sigint_handler(int sig);
 static void print_usage(const char *exec_name);
+static uint64_t size_parse(const char *str);
 
 /*
  * The main function.
@@ -74,13 +78,19 @@ main(int argc, char *argv[])
 	g_sortkey = SORT_KEY_CPU;
 	g_precise = PRECISE_NORMAL;
 	g_run_secs = TIME_NSEC_MAX;
+	g_map_incremental = B_FALSE;
+	g_map_granularity = 0;
+	g_migrate_rate = 0;
+	g_rec_max = PERF_REC_MAX_DEFAULT;
+	g_perf_concurrent = B_FALSE;
+	g_uncore_only = B_FALSE;
 	optind = 1;
 	opterr = 0;
 
 	/*
 	 * Parse command line arguments.
 	 */
-	while ((c = getopt(argc, argv, "d:l:o:f:t:hf:s:")) != EOF) {
+	while ((c = getopt(argc, argv, "d:l:o:f:t:hf:s:mg:r:a:k:cu")) != EOF) {
 		switch (c) {
 		case 'h':
 			print_usage(argv[0]);
@@ -159,6 +169,51 @@ main(int argc, char *argv[])
 			}
 			break;
 
+		case 'm':
+			g_map_incremental = B_TRUE;
+			break;
+
+		case 'c':
+			g_perf_concurrent = B_TRUE;
+			break;
+
+		case 'u':
+			g_uncore_only = B_TRUE;
+			break;
+
+		case 'g':
+			if ((g_map_granularity = size_parse(optarg)) == 0) {
+				stderr_print("Invalid granularity '%s'.\n",
+				    optarg);
+				print_usage(argv[0]);
+				goto L_EXIT0;
+			}
+			break;
+
+		case 'r':
+			g_rec_max = atoi(optarg);
+			if (g_rec_max <= 0) {
+				stderr_print("Invalid record number %d.\n",
+				    g_rec_max);
+				print_usage(argv[0]);
+				goto L_EXIT0;
+			}
+			break;
+
+		case 'a':
+			if ((g_migrate_rate = size_parse(optarg)) == 0) {
+				stderr_print("Invalid migration rate '%s'.\n",
+				    optarg);
+				print_usage(argv[0]);
+				goto L_EXIT0;
+			}
+			break;
+
+		case 'k':
+			(void) strncpy(g_damon_root, optarg, DAMON_ROOT_SIZE);
+			g_damon_root[DAMON_ROOT_SIZE - 1] = 0;
+			break;
+
 		case 't':
 			g_run_secs = atoi(optarg);
 			if (g_run_secs <= 0) {
@@ -220,6 +275,11 @@ main(int argc, char *argv[])
 	 */
 	g_cmt_enabled = os_cmt_init();
 
+	/*
+	 * Detect if DAMON can be used to monitor the memory access.
+	 */
+	g_damon_enabled = damon_init();
+
 	if (map_init() != 0) {
 		goto L_EXIT3;
 	}
@@ -251,6 +311,8 @@ main(int argc, char *argv[])
 	debug_print(NULL, 2, "Detected %d online CPUs\n", g_ncpus);
 	debug_print(NULL, 2, "Enabled CQM/MBM: %s\n",
 		(g_cmt_enabled) ? "yes" : "no");
+	debug_print(NULL, 2, "Enabled DAMON: %s\n",
+		(g_damon_enabled) ? "yes" : "no");
 
 	stderr_print("NumaTOP is starting ...\n");
 
@@ -297,6 +359,7 @@ main(int argc, char *argv[])
 	disp_consthr_quit();
 
 	disp_fini();
+	damon_stop();
 	stderr_print("NumaTOP is exiting ...\n");
 	(void) fflush(stdout);
 	ret = 0;
@@ -398,5 +461,68 @@ print_usage(const char *exec_name)
 	    "        high  : high sampling precision\n"
 	    "                (high overhead, not recommended option)\n"
 	    "        low   : low sampling precision, suitable for high load system\n"
-	    "  -t    specify run time in seconds\n");
+	    "  -t    specify run time in seconds\n"
+	    "  -m    track process address space from perf mmap records\n"
+	    "        instead of rereading /proc/<pid>/maps on each refresh\n"
+	    "  -g    sample one page per granularity (e.g. 64M, 1G) in the\n"
+	    "        memory area node breakdown instead of querying every page\n"
+	    "  -r    maximum number of samples kept per process/thread\n"
+	    "        (default: 16384)\n"
+	    "  -a    allow 'G' to migrate the hot pages to the accessing node,\n"
+	    "        moving at most the given size per second (e.g. 64M)\n"
+	    "  -k    path of the DAMON sysfs directory\n"
+	    "        (default: /sys/kernel/mm/damon/admin)\n"
+	    "  -c    keep the profiling and the memory access sampling\n"
+	    "        running together, so switching windows is instant\n"
+	    "  -u    count the memory controller and interconnect traffic\n"
+	    "        only, without sampling; profiling starts on demand\n");
+}
+
+/*
+ * Parse the size string with optional K/M/G suffix, e.g. "64M".
+ * Return 0 if the string is invalid or negative.
+ */
+static uint64_t
+size_parse(const char *str)
+{
+	char *end;
+	uint64_t size;
+
+	/*
+	 * strtoull() takes the leading blanks and sign, "-1" would
+	 * wrap to a huge size.
+	 */
+	if (!isdigit((unsigned char)*str)) {
+		return (0);
+	}
+
+	size = strtoull(str, &end, 10);
+	switch (*end) {
+	case 'k':
+	case 'K':
+		size *= KB_BYTES;
+		end++;
+		break;
+
+	case 'm':
+	case 'M':
+		size *= KB_BYTES * KB_BYTES;
+		end++;
+		break;
+
+	case 'g':
+	case 'G':
+		size *= (uint64_t)GB_BYTES;
+		end++;
+		break;
+
+	default:
+		break;
+	}
+
+	if (*end != 0) {
+		return (0);
+	}
+
+	return (size);
 }
@@ -0,0 +1,394 @@
+/*
+ * Copyright (c) 2013, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Intel Corporation nor the names of its contributors
+ *     may be used to endorse or promote products derived from this software
+ *     without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * This file contains the routines to monitor the processes of a cgroup
+ * as a whole. Each cgroup gets a resctrl monitor group, whose tasks are
+ * kept the same as the threads of the cgroup at every refresh of the
+ * process table. Only the cgroup v2 hierarchy is supported.
+ */
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <limits.h>
+#include <sys/types.h>
+#include "../include/types.h"
+#include "../include/util.h"
+#include "../include/proc.h"
+#include "../include/os/os_util.h"
+#include "../include/os/resctrl.h"
+#include "../include/os/cgroup.h"
+
+/*
+ * The cgroup table is only accessed from the display thread.
+ */
+static cgroup_t *s_cgroups;
+static int s_ncgroups;
+static int s_size;
+static uint64_t s_last_ms;
+static const char *s_cgroup_root;
+
+/*
+ * The unified hierarchy is either the only one or is mounted beside
+ * the v1 controllers.
+ */
+static const char *
+cgroup_root(void)
+{
+	static const char *roots[] = {
+		"/sys/fs/cgroup",
+		"/sys/fs/cgroup/unified"
+	};
+	char path[PATH_MAX];
+	int i;
+
+	for (i = 0; i < (int)(sizeof (roots) / sizeof (roots[0])); i++) {
+		(void) snprintf(path, sizeof (path), "%s/cgroup.controllers",
+			roots[i]);
+		if (access(path, F_OK) == 0) {
+			return (roots[i]);
+		}
+	}
+
+	return (NULL);
+}
+
+static cgroup_t *
+cgroup_find(const char *path)
+{
+	int i;
+
+	for (i = 0; i < s_ncgroups; i++) {
+		if (strcmp(s_cgroups[i].path, path) == 0) {
+			return (&s_cgroups[i]);
+		}
+	}
+
+	return (NULL);
+}
+
+static cgroup_t *
+cgroup_add(const char *path)
+{
+	cgroup_t *arr, *cg;
+	int size;
+
+	if (s_ncgroups == s_size) {
+		size = (s_size == 0) ? 64 : s_size * 2;
+		if ((arr = realloc(s_cgroups, sizeof (cgroup_t) * size)) == NULL) {
+			return (NULL);
+		}
+
+		s_cgroups = arr;
+		s_size = size;
+	}
+
+	cg = &s_cgroups[s_ncgroups];
+	(void) memset(cg, 0, sizeof (cgroup_t));
+	if (((cg->last = zalloc(sizeof (uint64_t) * (nnodes_max + 1) *
+		RESCTRL_EVENT_NUM)) == NULL) ||
+	    ((cg->nodes = zalloc(sizeof (cgroup_node_t) * nnodes_max)) == NULL)) {
+		free(cg->last);
+		return (NULL);
+	}
+
+	(void) snprintf(cg->path, CGROUP_PATH_SIZE, "%s", path);
+	cg->rank = -1;
+	cg->slot = -1;
+	s_ncgroups++;
+	return (cg);
+}
+
+static void
+cgroup_free(cgroup_t *cg)
+{
+	if (cg->slot != -1) {
+		resctrl_slot_free(cg->slot);
+		cg->slot = -1;
+	}
+
+	free(cg->last);
+	free(cg->nodes);
+}
+
+static int
+cgroup_rank_cmp(const void *a, const void *b)
+{
+	const cgroup_t *cg1 = (const cgroup_t *)a;
+	const cgroup_t *cg2 = (const cgroup_t *)b;
+
+	return (cg1->rank - cg2->rank);
+}
+
+/*
+ * Group the tracked processes by their cgroups. The processes in the
+ * root cgroup are mostly kernel threads, they are skipped.
+ */
+static int
+cgroup_scan(void)
+{
+	char path[CGROUP_PATH_SIZE];
+	track_proc_t *proc;
+	pid_t *pids;
+	int *nlwps, nprocs, n, i, j, nrank = 0;
+	cgroup_t *cg;
+
+	proc_lwp_count(&nprocs, &n);
+	if (((pids = zalloc(sizeof (pid_t) * (nprocs + 1))) == NULL) ||
+	    ((nlwps = zalloc(sizeof (int) * (nprocs + 1))) == NULL)) {
+		free(pids);
+		return (-1);
+	}
+
+	/*
+	 * Don't hold the lock of the process table while reading '/proc'.
+	 */
+	proc_group_lock();
+	proc_resort(SORT_KEY_CPU);
+	for (n = 0; n < nprocs; n++) {
+		if ((proc = proc_sort_next()) == NULL) {
+			break;
+		}
+
+		pids[n] = proc->pid;
+		nlwps[n] = proc_nlwp(proc);
+	}
+
+	proc_group_unlock();
+
+	for (i = 0; i < s_ncgroups; i++) {
+		s_cgroups[i].rank = -1;
+		s_cgroups[i].nprocs = 0;
+		s_cgroups[i].nlwps = 0;
+	}
+
+	for (i = 0; i < n; i++) {
+		if ((os_procfs_cgroup_get(pids[i], path, sizeof (path)) != 0) ||
+		    (strcmp(path, "/") == 0)) {
+			continue;
+		}
+
+		if (((cg = cgroup_find(path)) == NULL) &&
+		    ((cg = cgroup_add(path)) == NULL)) {
+			continue;
+		}
+
+		if (cg->rank == -1) {
+			cg->rank = nrank++;
+		}
+
+		cg->nprocs++;
+		cg->nlwps += nlwps[i];
+	}
+
+	free(pids);
+	free(nlwps);
+
+	/*
+	 * Remove the cgroups which have no tracked process any more.
+	 */
+	for (i = 0, j = 0; i < s_ncgroups; i++) {
+		if (s_cgroups[i].rank == -1) {
+			cgroup_free(&s_cgroups[i]);
+			continue;
+		}
+
+		if (j != i) {
+			s_cgroups[j] = s_cgroups[i];
+		}
+
+		j++;
+	}
+
+	s_ncgroups = j;
+	if (s_ncgroups > 0) {
+		qsort(s_cgroups, s_ncgroups, sizeof (cgroup_t), cgroup_rank_cmp);
+	}
+
+	return (0);
+}
+
+/*
+ * The busiest cgroups get the monitor groups. A cgroup which drops
+ * out of them gives its group back.
+ */
+static void
+cgroup_monitor(void)
+{
+	char dir[PATH_MAX];
+	cgroup_t *cg;
+	int npool, i;
+
+	npool = MIN(resctrl_pool_size(), s_ncgroups);
+	for (i = npool; i < s_ncgroups; i++) {
+		if (s_cgroups[i].slot != -1) {
+			resctrl_slot_free(s_cgroups[i].slot);
+			s_cgroups[i].slot = -1;
+		}
+	}
+
+	for (i = 0; i < npool; i++) {
+		cg = &s_cgroups[i];
+		if (cg->slot != -1) {
+			if (resctrl_group_sync(cg->slot) == 0) {
+				continue;
+			}
+
+			/* The cgroup has been removed. */
+			resctrl_slot_free(cg->slot);
+			cg->slot = -1;
+			continue;
+		}
+
+		(void) snprintf(dir, sizeof (dir), "%s%s", s_cgroup_root,
+			cg->path);
+		cg->slot = resctrl_group_alloc(dir);
+		cg->nsmpl = 0;
+	}
+}
+
+static uint64_t
+counter_delta(uint64_t cur, uint64_t last, uint64_t intval_ms)
+{
+	if ((cur < last) || (intval_ms == 0)) {
+		return (0);
+	}
+
+	return ((cur - last) * MS_SEC / intval_ms);
+}
+
+/*
+ * Read the counters of node "nid", or of all the nodes if it's -1. The
+ * baseline of the total is kept after the per-node ones in "last".
+ */
+static void
+cgroup_node_read(cgroup_t *cg, int nid, cgroup_node_t *node,
+	uint64_t intval_ms)
+{
+	uint64_t values[RESCTRL_EVENT_NUM], *last;
+
+	last = &cg->last[((nid == -1) ? nnodes_max : nid) * RESCTRL_EVENT_NUM];
+	if (resctrl_slot_read(cg->slot, nid, values) != 0) {
+		node->valid = B_FALSE;
+		return;
+	}
+
+	node->valid = B_TRUE;
+	node->llc_occupancy = values[RESCTRL_LLC_OCCUPANCY];
+
+	/*
+	 * The first reading is the baseline, the RMID may be
+	 * recycled from another group.
+	 */
+	if (cg->nsmpl > 0) {
+		node->totalbw = counter_delta(values[RESCTRL_MBM_TOTAL],
+			last[RESCTRL_MBM_TOTAL], intval_ms);
+		node->localbw = counter_delta(values[RESCTRL_MBM_LOCAL],
+			last[RESCTRL_MBM_LOCAL], intval_ms);
+	}
+
+	(void) memcpy(last, values, sizeof (values));
+}
+
+/*
+ * The total is read on its own, the L3 domains which span several
+ * nodes (SNC) are only counted in it.
+ */
+static void
+cgroup_read(cgroup_t *cg, uint64_t intval_ms)
+{
+	int nid;
+
+	for (nid = 0; nid < nnodes_max; nid++) {
+		cgroup_node_read(cg, nid, &cg->nodes[nid], intval_ms);
+	}
+
+	cgroup_node_read(cg, -1, &cg->total, intval_ms);
+	cg->nsmpl++;
+}
+
+/*
+ * Refresh the cgroups from the process table, keep their monitor groups
+ * in sync and read the counters.
+ */
+int
+cgroup_refresh(void)
+{
+	uint64_t cur_ms;
+	int i;
+
+	if ((s_cgroup_root == NULL) &&
+	    ((s_cgroup_root = cgroup_root()) == NULL)) {
+		debug_print(NULL, 2, "cgroup: no cgroup v2 hierarchy\n");
+		return (-1);
+	}
+
+	if (cgroup_scan() != 0) {
+		return (-1);
+	}
+
+	cgroup_monitor();
+
+	cur_ms = current_ms(&g_tvbase);
+	for (i = 0; i < s_ncgroups; i++) {
+		if (s_cgroups[i].slot != -1) {
+			cgroup_read(&s_cgroups[i], cur_ms - s_last_ms);
+		}
+	}
+
+	s_last_ms = cur_ms;
+	return (0);
+}
+
+cgroup_t *
+cgroup_get(int *num)
+{
+	*num = s_ncgroups;
+	return (s_cgroups);
+}
+
+/*
+ * Give all the monitor groups back to the pool.
+ */
+void
+cgroup_fini(void)
+{
+	int i;
+
+	for (i = 0; i < s_ncgroups; i++) {
+		cgroup_free(&s_cgroups[i]);
+	}
+
+	free(s_cgroups);
+	s_cgroups = NULL;
+	s_ncgroups = 0;
+	s_size = 0;
+}
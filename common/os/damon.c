@@ -0,0 +1,319 @@
+/*
+ * Copyright (c) 2013, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Intel Corporation nor the names of its contributors
+ *     may be used to endorse or promote products derived from this software
+ *     without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * This file contains the routines to monitor the access frequency of the
+ * address space of a process by the kernel's DAMON (sysfs interface).
+ * Only kdamond 0 with one context, one target and one "stat" scheme is
+ * used, the regions are read from the tried regions of the scheme.
+ */
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <errno.h>
+#include <sys/types.h>
+#include "../include/types.h"
+#include "../include/util.h"
+#include "../include/os/damon.h"
+
+#define DAMON_CTX	"kdamonds/0/contexts/0"
+#define DAMON_REGIONS	DAMON_CTX "/schemes/0/tried_regions"
+
+char g_damon_root[DAMON_ROOT_SIZE] = DAMON_ROOT_DEFAULT;
+boolean_t g_damon_enabled;
+
+static pid_t s_damon_pid;
+
+/*
+ * Write a value to the file which is relative to the DAMON root.
+ */
+static int
+damon_write(const char *file, const char *val)
+{
+	char path[PATH_MAX];
+	int fd, ret = 0;
+
+	(void) snprintf(path, sizeof (path), "%s/%s", g_damon_root, file);
+	if ((fd = open(path, O_WRONLY | O_TRUNC)) < 0) {
+		debug_print(NULL, 2, "damon_write: open %s failed, errno=%d\n",
+			path, errno);
+		return (-1);
+	}
+
+	if (write(fd, val, strlen(val)) < 0) {
+		debug_print(NULL, 2, "damon_write: write '%s' to %s failed, "
+			"errno=%d\n", val, path, errno);
+		ret = -1;
+	}
+
+	(void) close(fd);
+	return (ret);
+}
+
+static int
+damon_read(const char *path, char *buf, int size)
+{
+	FILE *fp;
+	int ret = -1;
+
+	if ((fp = fopen(path, "r")) == NULL) {
+		return (-1);
+	}
+
+	if (fgets(buf, size, fp) != NULL) {
+		buf[strcspn(buf, "\n")] = 0;
+		ret = 0;
+	}
+
+	(void) fclose(fp);
+	return (ret);
+}
+
+static int
+damon_read_u64(const char *dir, const char *file, uint64_t *val)
+{
+	char path[PATH_MAX], buf[32];
+
+	(void) snprintf(path, sizeof (path), "%s/%s", dir, file);
+	if (damon_read(path, buf, sizeof (buf)) != 0) {
+		return (-1);
+	}
+
+	*val = strtoull(buf, NULL, 10);
+	return (0);
+}
+
+/*
+ * DAMON is usable if the sysfs interface is there.
+ */
+boolean_t
+damon_init(void)
+{
+	char path[PATH_MAX], buf[32];
+
+	(void) snprintf(path, sizeof (path), "%s/kdamonds/nr_kdamonds",
+		g_damon_root);
+	if (damon_read(path, buf, sizeof (buf)) != 0) {
+		debug_print(NULL, 2, "DAMON is not available at %s\n",
+			g_damon_root);
+		return (B_FALSE);
+	}
+
+	return (B_TRUE);
+}
+
+/*
+ * Set up kdamond 0 to monitor the virtual address space of process and
+ * turn it on. Writing "nr_kdamonds" rebuilds all the kdamond directories,
+ * so it fails if any kdamond is already configured by someone else.
+ */
+int
+damon_start(pid_t pid)
+{
+	char path[PATH_MAX], buf[32];
+
+	damon_stop();
+
+	(void) snprintf(path, sizeof (path), "%s/kdamonds/nr_kdamonds",
+		g_damon_root);
+	if (damon_read(path, buf, sizeof (buf)) != 0) {
+		return (-1);
+	}
+
+	if (strcmp(buf, "0") != 0) {
+		debug_print(NULL, 2, "damon_start: %s kdamonds are in use\n",
+			buf);
+		return (-1);
+	}
+
+	if ((damon_write("kdamonds/nr_kdamonds", "1") != 0) ||
+		(damon_write("kdamonds/0/contexts/nr_contexts", "1") != 0) ||
+		(damon_write(DAMON_CTX "/operations", "vaddr") != 0)) {
+		goto L_EXIT;
+	}
+
+	(void) snprintf(buf, sizeof (buf), "%d", DAMON_SAMPLE_US);
+	if (damon_write(DAMON_CTX "/monitoring_attrs/intervals/sample_us",
+		buf) != 0) {
+		goto L_EXIT;
+	}
+
+	(void) snprintf(buf, sizeof (buf), "%d", DAMON_AGGR_US);
+	if (damon_write(DAMON_CTX "/monitoring_attrs/intervals/aggr_us",
+		buf) != 0) {
+		goto L_EXIT;
+	}
+
+	(void) snprintf(buf, sizeof (buf), "%d", DAMON_UPDATE_US);
+	if (damon_write(DAMON_CTX "/monitoring_attrs/intervals/update_us",
+		buf) != 0) {
+		goto L_EXIT;
+	}
+
+	(void) snprintf(buf, sizeof (buf), "%d", DAMON_NREGIONS_MIN);
+	if (damon_write(DAMON_CTX "/monitoring_attrs/nr_regions/min",
+		buf) != 0) {
+		goto L_EXIT;
+	}
+
+	(void) snprintf(buf, sizeof (buf), "%d", DAMON_NREGIONS_MAX);
+	if (damon_write(DAMON_CTX "/monitoring_attrs/nr_regions/max",
+		buf) != 0) {
+		goto L_EXIT;
+	}
+
+	(void) snprintf(buf, sizeof (buf), "%d", pid);
+	if ((damon_write(DAMON_CTX "/targets/nr_targets", "1") != 0) ||
+		(damon_write(DAMON_CTX "/targets/0/pid_target", buf) != 0)) {
+		goto L_EXIT;
+	}
+
+	/*
+	 * The "stat" scheme with the default access pattern matches all
+	 * the regions and doesn't change the memory.
+	 */
+	if ((damon_write(DAMON_CTX "/schemes/nr_schemes", "1") != 0) ||
+		(damon_write(DAMON_CTX "/schemes/0/action", "stat") != 0)) {
+		goto L_EXIT;
+	}
+
+	if (damon_write("kdamonds/0/state", "on") != 0) {
+		goto L_EXIT;
+	}
+
+	s_damon_pid = pid;
+	return (0);
+
+L_EXIT:
+	/*
+	 * Restore the state before start, no kdamond at all.
+	 */
+	(void) damon_write("kdamonds/nr_kdamonds", "0");
+	return (-1);
+}
+
+/*
+ * Remove the kdamond which is created by damon_start(), nothing else
+ * was there before.
+ */
+void
+damon_stop(void)
+{
+	if (s_damon_pid == 0) {
+		return;
+	}
+
+	(void) damon_write("kdamonds/0/state", "off");
+	(void) damon_write("kdamonds/nr_kdamonds", "0");
+	s_damon_pid = 0;
+}
+
+static int
+region_cmp(const void *p1, const void *p2)
+{
+	const damon_region_t *r1 = (const damon_region_t *)p1;
+	const damon_region_t *r2 = (const damon_region_t *)p2;
+
+	if (r1->start_addr < r2->start_addr) {
+		return (-1);
+	}
+
+	return ((r1->start_addr > r2->start_addr) ? 1 : 0);
+}
+
+/*
+ * Ask kdamond to update the tried regions of the scheme and read them.
+ * The regions are sorted by start address, the caller frees the array.
+ */
+int
+damon_regions_get(damon_region_t **arr, int *num)
+{
+	char dir[DAMON_ROOT_SIZE + 64], path[PATH_MAX];
+	damon_region_t *regions = NULL, *r;
+	struct dirent *ent;
+	uint64_t start, end, nr_accesses, age;
+	int ncur = 0, nmax = 0;
+	DIR *dp;
+
+	*arr = NULL;
+	*num = 0;
+
+	if ((s_damon_pid == 0) ||
+		(damon_write("kdamonds/0/state",
+		"update_schemes_tried_regions") != 0)) {
+		return (-1);
+	}
+
+	(void) snprintf(dir, sizeof (dir), "%s/%s", g_damon_root,
+		DAMON_REGIONS);
+	if ((dp = opendir(dir)) == NULL) {
+		return (-1);
+	}
+
+	while ((ent = readdir(dp)) != NULL) {
+		if ((ent->d_name[0] < '0') || (ent->d_name[0] > '9')) {
+			continue;
+		}
+
+		(void) snprintf(path, sizeof (path), "%s/%s", dir, ent->d_name);
+		if ((damon_read_u64(path, "start", &start) != 0) ||
+			(damon_read_u64(path, "end", &end) != 0) ||
+			(damon_read_u64(path, "nr_accesses", &nr_accesses) != 0) ||
+			(damon_read_u64(path, "age", &age) != 0) ||
+			(end <= start)) {
+			continue;
+		}
+
+		if (array_alloc((void **)&regions, &ncur, &nmax,
+			sizeof (damon_region_t), DAMON_NREGIONS_MIN) != 0) {
+			(void) closedir(dp);
+			return (-1);
+		}
+
+		r = &regions[ncur++];
+		r->start_addr = start;
+		r->end_addr = end;
+		r->nr_accesses = (unsigned int)nr_accesses;
+		r->age = (unsigned int)age;
+	}
+
+	(void) closedir(dp);
+
+	if (ncur > 0) {
+		qsort(regions, ncur, sizeof (damon_region_t), region_cmp);
+	}
+
+	*arr = regions;
+	*num = ncur;
+	return (0);
+}
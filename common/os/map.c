@@ -28,22 +28,62 @@
 
 /* This file contains the routines to process address mapping in running process. */
 
+#include <inttypes.h>
 #include <link.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <strings.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <sys/types.h>
+#include <sys/mman.h>
+#include <pthread.h>
 #include <numa.h>
+#include <numaif.h>
 #include "../include/util.h"
 #include "../include/proc.h"
 #include "../include/os/os_util.h"
 #include "../include/os/map.h"
 
+boolean_t g_map_incremental;
+uint64_t g_map_granularity;
+uint64_t g_migrate_rate;
+
+static map_str_t *s_str_hashtbl[MAP_STR_HASHTBL_SIZE];
+static pthread_mutex_t s_str_mutex = PTHREAD_MUTEX_INITIALIZER;
+static const char s_str_empty[] = "";
+static uint64_t s_thp_size;
+static unsigned int s_heatmap_owner;
+
+/*
+ * The size of transparent huge page, 0 if THP is not supported.
+ */
+static uint64_t
+thp_size_get(void)
+{
+	FILE *fp;
+	uint64_t size = 0;
+
+	if ((fp = fopen(THP_PMD_SIZE_PATH, "r")) == NULL) {
+		return (0);
+	}
+
+	if (fscanf(fp, "%" SCNu64, &size) != 1) {
+		size = 0;
+	}
+
+	fclose(fp);
+	return (size);
+}
+
 int
 map_init(void)
 {
 	pagesize_init();
+
+	s_thp_size = thp_size_get();
 	return (0);
 }
 
@@ -54,7 +94,119 @@ map_fini(void)
 }
 
 static unsigned int
-attr_bitmap(char *attr_str)
+str_hash(const char *str, int len)
+{
+	unsigned int hash = 5381;
+	int i;
+
+	for (i = 0; i < len; i++) {
+		hash = (hash * 33) ^ (unsigned char)str[i];
+	}
+
+	return (hash);
+}
+
+/*
+ * Look up the path in the string pool and take a reference, the path is
+ * added to the pool if it's not there. The mapped files are usually
+ * shared by a lot of entries and processes (e.g. libc), so only one copy
+ * is kept for each of them.
+ */
+static const char *
+map_str_get(const char *str, int len)
+{
+	map_str_t *p;
+	unsigned int hash;
+	int idx;
+
+	if (len <= 0) {
+		return (s_str_empty);
+	}
+
+	hash = str_hash(str, len);
+	idx = hash % MAP_STR_HASHTBL_SIZE;
+
+	(void) pthread_mutex_lock(&s_str_mutex);
+
+	for (p = s_str_hashtbl[idx]; p != NULL; p = p->next) {
+		if ((p->hash == hash) && (strncmp(p->str, str, len) == 0) &&
+			(p->str[len] == 0)) {
+			p->ref_count++;
+			(void) pthread_mutex_unlock(&s_str_mutex);
+			return (p->str);
+		}
+	}
+
+	if ((p = malloc(sizeof (map_str_t) + len + 1)) == NULL) {
+		(void) pthread_mutex_unlock(&s_str_mutex);
+		return (NULL);
+	}
+
+	p->ref_count = 1;
+	p->hash = hash;
+	memcpy(p->str, str, len);
+	p->str[len] = 0;
+	p->next = s_str_hashtbl[idx];
+	s_str_hashtbl[idx] = p;
+
+	(void) pthread_mutex_unlock(&s_str_mutex);
+	return (p->str);
+}
+
+/*
+ * Take one more reference on a string which is already in the pool.
+ */
+static const char *
+map_str_dup(const char *str)
+{
+	map_str_t *p;
+
+	if (str == s_str_empty) {
+		return (str);
+	}
+
+	p = (map_str_t *)(str - offsetof(map_str_t, str));
+	(void) pthread_mutex_lock(&s_str_mutex);
+	p->ref_count++;
+	(void) pthread_mutex_unlock(&s_str_mutex);
+	return (str);
+}
+
+/*
+ * Drop the reference, the string is removed from the pool when it's
+ * no longer used.
+ */
+static void
+map_str_put(const char *str)
+{
+	map_str_t *p, **pp;
+	int idx;
+
+	if ((str == NULL) || (str == s_str_empty)) {
+		return;
+	}
+
+	p = (map_str_t *)(str - offsetof(map_str_t, str));
+	idx = p->hash % MAP_STR_HASHTBL_SIZE;
+
+	(void) pthread_mutex_lock(&s_str_mutex);
+
+	if (--p->ref_count == 0) {
+		for (pp = &s_str_hashtbl[idx]; *pp != NULL; pp = &(*pp)->next) {
+			if (*pp == p) {
+				*pp = p->next;
+				break;
+			}
+		}
+
+		free(p);
+	}
+
+	(void) pthread_mutex_unlock(&s_str_mutex);
+}
+
+static unsigned int
+attr_bitmap(const char *attr_str)
 {
 	unsigned int bitmap = 0;
 	
@@ -81,28 +233,28 @@ attr_bitmap(char *attr_str)
 
 static int
 map_entry_add(map_proc_t *map, uint64_t start_addr, uint64_t end_addr,
-	unsigned int attr, char *path)
+	unsigned int attr, const char *path, int path_len)
 {
 	map_entry_t *entry;
+	const char *desc;
 
 	if (array_alloc((void **)(&map->arr), &map->nentry_cur,
 		&map->nentry_max, sizeof (map_entry_t), MAP_ENTRY_NUM) != 0) {
 		return (-1);
 	}
-	
+
+	if ((desc = map_str_get(path, path_len)) == NULL) {
+		return (-1);
+	}
+
 	entry = &(map->arr[map->nentry_cur]);
 	entry->start_addr = start_addr;
 	entry->end_addr = end_addr;
 	entry->attr = attr;
 	entry->need_resolve = B_TRUE;
 	memset(&entry->numa_map, 0, sizeof (numa_map_t));
-
-	if (strlen(path) > 0) {
-		strncpy(entry->desc, path, PATH_MAX);
-		entry->desc[PATH_MAX - 1] = 0;
-	} else {
-		entry->desc[0] = 0;
-	}
+	memset(&entry->thp, 0, sizeof (map_thp_t));
+	entry->desc = desc;
 
 	map->nentry_cur++;
 	return (0);
@@ -117,6 +269,10 @@ numa_map_fini(map_entry_t *entry)
 	if (numa->arr != NULL) {
 		free(numa->arr);
 	}
+
+	if (numa->node_bytes != NULL) {
+		free(numa->node_bytes);
+	}
 		
 	memset(numa, 0, sizeof (numa_map_t));
 }
@@ -132,72 +288,218 @@ map_free(map_proc_t *map)
 	
 	for (i = 0; i < map->nentry_cur; i++) {
 		numa_map_fini(&map->arr[i]);
+		map_str_put(map->arr[i].desc);
 	}
 
 	free(map->arr);
-	memset(map, 0, sizeof (map_proc_t));
+	map->arr = NULL;
+	map->nentry_cur = 0;
+	map->nentry_max = 0;
+	map->loaded = B_FALSE;
+}
+
+static void
+numamaps_free(map_numamaps_t *numamaps)
+{
+	free(numamaps->arr);
+	free(numamaps->node_bytes);
+	memset(numamaps, 0, sizeof (map_numamaps_t));
+}
+
+static void
+map_eventq_free(map_eventq_t *eventq)
+{
+	int i;
+
+	if (eventq->arr != NULL) {
+		for (i = 0; i < eventq->nevent_cur; i++) {
+			map_str_put(eventq->arr[i].desc);
+		}
+
+		free(eventq->arr);
+	}
+
+	memset(eventq, 0, sizeof (map_eventq_t));
+}
+
+static void
+pagecache_free(map_pagecache_t *cache)
+{
+	if (cache->arr != NULL) {
+		free(cache->arr);
+	}
+
+	if (cache->addr_buf != NULL) {
+		free(cache->addr_buf);
+	}
+
+	if (cache->status_buf != NULL) {
+		free(cache->status_buf);
+	}
+
+	memset(cache, 0, sizeof (map_pagecache_t));
+}
+
+static void
+heatmap_free(map_heatmap_t *heatmap)
+{
+	if (heatmap->arr != NULL) {
+		free(heatmap->arr);
+	}
+
+	memset(heatmap, 0, sizeof (map_heatmap_t));
+}
+
+/*
+ * Read the whole maps file. The procfs file has no size so the buffer
+ * grows until EOF.
+ */
+static char *
+mapfile_read(pid_t pid, int *len)
+{
+	char path[PATH_MAX], *buf, *p;
+	int fd, size = MAPFILE_READ_SIZE, n;
+
+	*len = 0;
+	snprintf(path, sizeof (path), "/proc/%d/maps", pid);
+	if ((fd = open(path, O_RDONLY)) < 0) {
+		return (NULL);
+	}
+
+	if ((buf = malloc(size)) == NULL) {
+		(void) close(fd);
+		return (NULL);
+	}
+
+	for (;;) {
+		if (*len == size) {
+			size <<= 1;
+			if ((p = realloc(buf, size)) == NULL) {
+				goto L_ERROR;
+			}
+
+			buf = p;
+		}
+
+		if ((n = read(fd, buf + *len, size - *len)) < 0) {
+			goto L_ERROR;
+		}
+
+		if (n == 0) {
+			break;
+		}
+
+		*len += n;
+	}
+
+	(void) close(fd);
+	return (buf);
+
+L_ERROR:
+	free(buf);
+	(void) close(fd);
+	*len = 0;
+	return (NULL);
+}
+
+static uint64_t
+hex_parse(const char **pp, const char *end)
+{
+	const char *p = *pp;
+	uint64_t value = 0;
+	int c;
+
+	while (p < end) {
+		c = *p;
+		if ((c >= '0') && (c <= '9')) {
+			value = (value << 4) | (c - '0');
+		} else if ((c >= 'a') && (c <= 'f')) {
+			value = (value << 4) | (c - 'a' + 10);
+		} else if ((c >= 'A') && (c <= 'F')) {
+			value = (value << 4) | (c - 'A' + 10);
+		} else {
+			break;
+		}
+
+		p++;
+	}
+
+	*pp = p;
+	return (value);
+}
+
+static const char *
+field_skip(const char *p, const char *end)
+{
+	while ((p < end) && (*p != ' ') && (*p != '\n')) {
+		p++;
+	}
+
+	while ((p < end) && (*p == ' ')) {
+		p++;
+	}
+
+	return (p);
 }
 
 static int
 map_read(pid_t pid, map_proc_t *map)
 {
-	char path[PATH_MAX];
-	char line[MAPFILE_LINE_SIZE];
-	char addr_str[128], attr_str[128], off_str[128];
-	char fd_str[128], inode_str[128], path_str[PATH_MAX*2];
-	char s1[64], s2[64];
+	char *buf;
+	const char *p, *end, *attr_str, *path;
 	uint64_t start_addr, end_addr;
-	unsigned int attr;
-	int nargs, nadded = 0, ret = -1;
-	FILE *fp;
-	
+	int len, path_len, nadded = 0, ret = -1;
+
 	memset(map, 0, sizeof (map_proc_t));
-	snprintf(path, sizeof (path), "/proc/%d/maps", pid);
-	if ((fp = fopen(path, "r")) == NULL) {
+	if ((buf = mapfile_read(pid, &len)) == NULL) {
 		return (-1);
-	}	
-	
-	while (1) {
-		if (fgets(line, sizeof (line), fp) == NULL) {
-			break;
-		}
+	}
 
-		/* 
+	p = buf;
+	end = buf + len;
+
+	while (p < end) {
+		/*
 		 * e.g. 00400000-00405000 r-xp 00000000 fd:00 678793	/usr/bin/vmstat
 		 */
-		if ((nargs = sscanf(line, "%127[^ ] %127[^ ] %127[^ ] %127[^ ] %127[^ ] %2047[^\n]",
-		    addr_str, attr_str, off_str, fd_str, inode_str, path_str)) < 0) {
-		    goto L_EXIT;
+		start_addr = hex_parse(&p, end);
+		if ((p >= end) || (*p != '-')) {
+			goto L_EXIT;
 		}
-				
-		/*
-		 * split to start_addr and end_addr.
-		 * e.g. 00400000-00405000 -> start_addr = 00400000, end_addr = 00405000.
-		 */
-    	if (sscanf(addr_str, "%63[^-]", s1) <= 0) {
-    		goto L_EXIT;
-    	}
-		
-		if (sscanf(addr_str, "%*[^-]-%63s", s2) <= 0) {
-    		goto L_EXIT;
+
+		p++;
+		end_addr = hex_parse(&p, end);
+		if ((p >= end) || (*p != ' ')) {
+			goto L_EXIT;
 		}
 
-		start_addr = strtoull(s1, NULL, 16);
-		end_addr = strtoull(s2, NULL, 16);
+		p++;
+		attr_str = p;
+		if (end - attr_str < 4) {
+			goto L_EXIT;
+		}
 
 		/*
-		 * Convert to the attribute bitmap
+		 * Skip the attribute, offset, device and inode fields.
 		 */
-		attr = attr_bitmap(attr_str);
+		p = field_skip(p, end);
+		p = field_skip(p, end);
+		p = field_skip(p, end);
+		p = field_skip(p, end);
 
 		/*
 		 * Path could be null, need to check here.
 		 */	
-		if (nargs != 6) {
-			path_str[0] = 0;
+		path = p;
+		while ((p < end) && (*p != '\n')) {
+			p++;
 		}
-		
-		if (map_entry_add(map, start_addr, end_addr, attr, path_str) != 0) {
+
+		path_len = p - path;
+		p++;
+
+		if (map_entry_add(map, start_addr, end_addr, attr_bitmap(attr_str),
+			path, path_len) != 0) {
 			goto L_EXIT;	
 		}
 		
@@ -210,7 +512,7 @@ map_read(pid_t pid, map_proc_t *map)
 	}
 
 L_EXIT:
-	fclose(fp);
+	free(buf);
 	if ((ret != 0) && (nadded > 0)) {
 		map_free(map);
 	}
@@ -218,125 +520,380 @@ L_EXIT:
 	return (ret);
 }
 
-int
-map_proc_load(track_proc_t *proc)
+/*
+ * Make sure the map has room for 'n' more entries.
+ */
+static int
+map_entry_reserve(map_proc_t *map, int n)
 {
-	map_proc_t *map = &proc->map;
-	map_proc_t new_map;
-	map_entry_t *old_entry;
-	int i;
-
-	if (!map->loaded) {
-		if (map_read(proc->pid, map) != 0) {
-			return (-1);
-		}
+	map_entry_t *arr;
+	int nmax = map->nentry_max;
 
+	if (map->nentry_cur + n <= nmax) {
 		return (0);
 	}
 
-	if (map_read(proc->pid, &new_map) != 0) {
-		return (-1);
+	if (nmax == 0) {
+		nmax = MAP_ENTRY_NUM;
 	}
 
-	for (i = 0; i < new_map.nentry_cur; i++) {
-		if ((old_entry = map_entry_find(proc, new_map.arr[i].start_addr, 
-			new_map.arr[i].end_addr - new_map.arr[i].start_addr)) == NULL) {
-			new_map.arr[i].need_resolve = B_TRUE;
-		} else {
-			new_map.arr[i].need_resolve = old_entry->need_resolve;
-		}
+	while (map->nentry_cur + n > nmax) {
+		nmax <<= 1;
 	}
-	
-	map_free(&proc->map);
-	memcpy(&proc->map, &new_map, sizeof (map_proc_t));
-	return (0);	
-}
 
-int
-map_proc_fini(track_proc_t *proc)
-{
-	map_free(&proc->map);
+	if ((arr = realloc(map->arr, nmax * sizeof (map_entry_t))) == NULL) {
+		return (-1);
+	}
+
+	map->arr = arr;
+	map->nentry_max = nmax;
 	return (0);
 }
 
 /*
- * The callback function used in bsearch() to compare the buffer address.
+ * Apply one mapping event to the sorted map entries. The kernel doesn't
+ * report munmap, but a new mapping always replaces whatever it overlaps,
+ * so the overlapped entries are removed or trimmed and the new entry is
+ * inserted at its sorted position.
  */
 static int
-entryaddr_cmp(const void *p1, const void *p2)
+map_event_apply(map_proc_t *map, map_event_t *event)
 {
-	const uint64_t addr = *(const uint64_t *)p1;
-	const map_entry_t *entry = (const map_entry_t *)p2;
-		
-	if (addr < entry->start_addr) {
+	map_entry_t left, right, *entry;
+	boolean_t has_left, has_right;
+	int lo, hi, mid, nnew, i;
+
+	lo = 0;
+	hi = map->nentry_cur;
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (map->arr[mid].end_addr <= event->start_addr) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	hi = lo;
+	while ((hi < map->nentry_cur) &&
+		(map->arr[hi].start_addr < event->end_addr)) {
+		hi++;
+	}
+
+	has_left = (lo < hi) && (map->arr[lo].start_addr < event->start_addr);
+	has_right = (lo < hi) && (map->arr[hi - 1].end_addr > event->end_addr);
+	nnew = 1 + (has_left ? 1 : 0) + (has_right ? 1 : 0);
+
+	if ((nnew > hi - lo) && (map_entry_reserve(map, nnew - (hi - lo)) != 0)) {
 		return (-1);
 	}
 
-	if (addr >= entry->end_addr) {
-		return (1);
+	if (has_left) {
+		memcpy(&left, &map->arr[lo], sizeof (map_entry_t));
+		left.end_addr = event->start_addr;
+		left.desc = map_str_dup(left.desc);
+		memset(&left.numa_map, 0, sizeof (numa_map_t));
+		memset(&left.thp, 0, sizeof (map_thp_t));
 	}
 
-	return (0);
-}
+	if (has_right) {
+		memcpy(&right, &map->arr[hi - 1], sizeof (map_entry_t));
+		right.start_addr = event->end_addr;
+		right.desc = map_str_dup(right.desc);
+		memset(&right.numa_map, 0, sizeof (numa_map_t));
+		memset(&right.thp, 0, sizeof (map_thp_t));
+	}
 
-map_entry_t *
-map_entry_find(track_proc_t *proc, uint64_t addr, uint64_t size)
-{
-	map_entry_t *entry;
+	for (i = lo; i < hi; i++) {
+		numa_map_fini(&map->arr[i]);
+		map_str_put(map->arr[i].desc);
+	}
 
-	entry = bsearch(&addr, proc->map.arr, proc->map.nentry_cur,
-		sizeof (map_entry_t), entryaddr_cmp);
+	if (lo + nnew != hi) {
+		memmove(&map->arr[lo + nnew], &map->arr[hi],
+			(map->nentry_cur - hi) * sizeof (map_entry_t));
+	}
 
-	if (entry != NULL) {
-		if ((entry->start_addr == addr) && (entry->end_addr == addr + size)) {
-			return (entry);
-		}
+	i = lo;
+	if (has_left) {
+		memcpy(&map->arr[i++], &left, sizeof (map_entry_t));
 	}
 
-	return (NULL);
-}
+	entry = &map->arr[i++];
+	entry->start_addr = event->start_addr;
+	entry->end_addr = event->end_addr;
+	entry->attr = event->attr;
+	entry->need_resolve = B_TRUE;
+	memset(&entry->numa_map, 0, sizeof (numa_map_t));
+	memset(&entry->thp, 0, sizeof (map_thp_t));
 
-static numa_entry_t *
-numa_entry_add(numa_map_t *numa_map, uint64_t addr, int nid)
-{
-	numa_entry_t *entry;
+	/*
+	 * The reference on the path is moved from event to entry.
+	 */
+	entry->desc = event->desc;
+	event->desc = NULL;
 
-	if (array_alloc((void **)(&numa_map->arr), &numa_map->nentry_cur,
-		&numa_map->nentry_max, sizeof (numa_entry_t), MAP_ENTRY_NUM) != 0) {
-		return (NULL);
+	if (has_right) {
+		memcpy(&map->arr[i], &right, sizeof (map_entry_t));
 	}
 
-	entry = &(numa_map->arr[numa_map->nentry_cur]);
-	entry->start_addr = addr;
-	entry->end_addr = addr + g_pagesize;
-	entry->nid = nid;
-	numa_map->nentry_cur++;
-	return (entry);
+	map->nentry_cur += nnew - (hi - lo);
+	return (0);
 }
 
-static numa_entry_t *
-numa_map_update(numa_map_t *numa_map, void **addr_arr, int *node_arr,
-	int addr_num, numa_entry_t *last_entry)
+/*
+ * Apply the queued mapping events to the loaded map. Return -1 if
+ * the events can't be trusted and a full reread is required.
+ */
+static int
+map_events_apply(track_proc_t *proc)
 {
-	numa_entry_t *entry;
-	int i = 0, j;
+	map_eventq_t eventq;
+	int i, ret = 0;
 
-	if ((entry = last_entry) == NULL) {
-		if ((entry = numa_entry_add(numa_map, (uint64_t)(uintptr_t)addr_arr[i],
-			node_arr[i])) == NULL) {
-			return (NULL);
-		}
+	(void) pthread_mutex_lock(&proc->mutex);
+	memcpy(&eventq, &proc->map.eventq, sizeof (map_eventq_t));
+	memset(&proc->map.eventq, 0, sizeof (map_eventq_t));
+	(void) pthread_mutex_unlock(&proc->mutex);
 
-		i++;
+	if (eventq.lost) {
+		ret = -1;
+		goto L_EXIT;
 	}
 
-	for (j = i; j < addr_num; j++) {
-		if ((entry->nid == node_arr[j]) &&
-			(entry->end_addr == (uint64_t)(uintptr_t)addr_arr[j])) {
-			entry->end_addr += g_pagesize;
+	for (i = 0; i < eventq.nevent_cur; i++) {
+		if (map_event_apply(&proc->map, &eventq.arr[i]) != 0) {
+			ret = -1;
+			break;
+		}
+	}
+
+L_EXIT:
+	map_eventq_free(&eventq);
+	return (ret);
+}
+
+int
+map_proc_load(track_proc_t *proc)
+{
+	map_proc_t *map = &proc->map;
+	map_proc_t new_map;
+	map_entry_t *old_entry;
+	int i;
+
+	if (g_map_incremental) {
+		if (map->loaded && (map_events_apply(proc) == 0)) {
+			return (0);
+		}
+
+		/*
+		 * The procfs reread covers all the queued events.
+		 */
+		(void) pthread_mutex_lock(&proc->mutex);
+		map_eventq_free(&map->eventq);
+		(void) pthread_mutex_unlock(&proc->mutex);
+	}
+
+	if (map_read(proc->pid, &new_map) != 0) {
+		return (-1);
+	}
+
+	if (map->loaded) {
+		for (i = 0; i < new_map.nentry_cur; i++) {
+			if ((old_entry = map_entry_find(proc, new_map.arr[i].start_addr, 
+				new_map.arr[i].end_addr - new_map.arr[i].start_addr)) == NULL) {
+				new_map.arr[i].need_resolve = B_TRUE;
+			} else {
+				new_map.arr[i].need_resolve = old_entry->need_resolve;
+			}
+		}
+	}
+	
+	map_free(map);
+	map->arr = new_map.arr;
+	map->nentry_cur = new_map.nentry_cur;
+	map->nentry_max = new_map.nentry_max;
+	map->loaded = new_map.loaded;
+	map->thp_loaded = B_FALSE;
+	return (0);	
+}
+
+int
+map_proc_fini(track_proc_t *proc)
+{
+	map_free(&proc->map);
+	map_eventq_free(&proc->map.eventq);
+	pagecache_free(&proc->map.pagecache);
+	heatmap_free(&proc->map.heatmap);
+	numamaps_free(&proc->map.numamaps);
+	return (0);
+}
+
+/*
+ * Queue a mapping reported by PERF_RECORD_MMAP2. It's called in perf
+ * thread, the event is applied later in map_proc_load().
+ */
+void
+map_event_add(track_proc_t *proc, uint64_t addr, uint64_t len,
+	unsigned int prot, unsigned int flags, const char *path)
+{
+	map_eventq_t *eventq = &proc->map.eventq;
+	map_event_t *event;
+	const char *desc;
+	unsigned int attr = 0;
+
+	if (prot & PROT_READ) {
+		MAP_R_SET(attr);
+	}
+
+	if (prot & PROT_WRITE) {
+		MAP_W_SET(attr);
+	}
+
+	if (prot & PROT_EXEC) {
+		MAP_X_SET(attr);
+	}
+
+	if (flags & MAP_SHARED) {
+		MAP_S_SET(attr);
+	}
+
+	if ((desc = map_str_get(path, strlen(path))) == NULL) {
+		map_event_lost(proc);
+		return;
+	}
+
+	(void) pthread_mutex_lock(&proc->mutex);
+
+	if (eventq->lost) {
+		map_str_put(desc);
+		goto L_EXIT;
+	}
+
+	/*
+	 * Too many pending events, a full reread is cheaper.
+	 */
+	if ((eventq->nevent_cur >= MAP_EVENT_MAX) ||
+		(array_alloc((void **)(&eventq->arr), &eventq->nevent_cur,
+		&eventq->nevent_max, sizeof (map_event_t), MAP_EVENT_NUM) != 0)) {
+		map_str_put(desc);
+		map_eventq_free(eventq);
+		eventq->lost = B_TRUE;
+		goto L_EXIT;
+	}
+
+	event = &eventq->arr[eventq->nevent_cur];
+	event->start_addr = addr;
+	event->end_addr = addr + len;
+	event->attr = attr;
+	event->desc = desc;
+	eventq->nevent_cur++;
+
+L_EXIT:
+	(void) pthread_mutex_unlock(&proc->mutex);
+}
+
+/*
+ * Some mapping events were dropped, the next map_proc_load() has to
+ * reread the whole maps file.
+ */
+void
+map_event_lost(track_proc_t *proc)
+{
+	(void) pthread_mutex_lock(&proc->mutex);
+	map_eventq_free(&proc->map.eventq);
+	proc->map.eventq.lost = B_TRUE;
+	(void) pthread_mutex_unlock(&proc->mutex);
+}
+
+/*
+ * The callback function used in bsearch() to compare the buffer address.
+ */
+static int
+entryaddr_cmp(const void *p1, const void *p2)
+{
+	const uint64_t addr = *(const uint64_t *)p1;
+	const map_entry_t *entry = (const map_entry_t *)p2;
+		
+	if (addr < entry->start_addr) {
+		return (-1);
+	}
+
+	if (addr >= entry->end_addr) {
+		return (1);
+	}
+
+	return (0);
+}
+
+/*
+ * Find the map entry which contains the address.
+ */
+map_entry_t *
+map_entry_lookup(track_proc_t *proc, uint64_t addr)
+{
+	return (bsearch(&addr, proc->map.arr, proc->map.nentry_cur,
+		sizeof (map_entry_t), entryaddr_cmp));
+}
+
+map_entry_t *
+map_entry_find(track_proc_t *proc, uint64_t addr, uint64_t size)
+{
+	map_entry_t *entry;
+
+	entry = bsearch(&addr, proc->map.arr, proc->map.nentry_cur,
+		sizeof (map_entry_t), entryaddr_cmp);
+
+	if (entry != NULL) {
+		if ((entry->start_addr == addr) && (entry->end_addr == addr + size)) {
+			return (entry);
+		}
+	}
+
+	return (NULL);
+}
+
+static numa_entry_t *
+numa_entry_add(numa_map_t *numa_map, uint64_t addr, uint64_t size, int nid)
+{
+	numa_entry_t *entry;
+
+	if (array_alloc((void **)(&numa_map->arr), &numa_map->nentry_cur,
+		&numa_map->nentry_max, sizeof (numa_entry_t), MAP_ENTRY_NUM) != 0) {
+		return (NULL);
+	}
+
+	entry = &(numa_map->arr[numa_map->nentry_cur]);
+	entry->start_addr = addr;
+	entry->end_addr = addr + size;
+	entry->nid = nid;
+	numa_map->nentry_cur++;
+	return (entry);
+}
+
+static numa_entry_t *
+numa_map_update(numa_map_t *numa_map, void **addr_arr, uint64_t *size_arr,
+	int *node_arr, int addr_num, numa_entry_t *last_entry)
+{
+	numa_entry_t *entry;
+	int i = 0, j;
+
+	if ((entry = last_entry) == NULL) {
+		if ((entry = numa_entry_add(numa_map, (uint64_t)(uintptr_t)addr_arr[i],
+			size_arr[i], node_arr[i])) == NULL) {
+			return (NULL);
+		}
+
+		i++;
+	}
+
+	for (j = i; j < addr_num; j++) {
+		if ((entry->nid == node_arr[j]) &&
+			(entry->end_addr == (uint64_t)(uintptr_t)addr_arr[j])) {
+			entry->end_addr += size_arr[j];
 		} else {
 			if ((entry = numa_entry_add(numa_map, (uint64_t)(uintptr_t)addr_arr[j],
-				node_arr[j])) == NULL) {
+				size_arr[j], node_arr[j])) == NULL) {
 				return (NULL);
 			}		
 		}
@@ -345,66 +902,1135 @@ numa_map_update(numa_map_t *numa_map, void **addr_arr, int *node_arr,
 	return (entry);
 }
 
-int
-map_map2numa(track_proc_t *proc, map_entry_t *map_entry)
+static uint64_t
+smaps_kb_parse(const char *line)
 {
-	void *addr_arr[NUMA_MOVE_NPAGES];
-	unsigned int i, npages_total, npages_tomove, npages_moved = 0;
-	int node_arr[NUMA_MOVE_NPAGES];
-	numa_entry_t *last_entry = NULL;
-	
-	numa_map_fini(map_entry);
-	
-	npages_total = (map_entry->end_addr - map_entry->start_addr) / g_pagesize;
-	while (npages_moved < npages_total) {
-		npages_tomove = MIN(NUMA_MOVE_NPAGES, npages_total - npages_moved);
-		for (i = 0; i < npages_tomove; i++) {
-			addr_arr[i] = (void *)(uintptr_t)(map_entry->start_addr +
-				(i + npages_moved) * g_pagesize);
-		}
+	while ((*line != 0) && (*line != ':')) {
+		line++;
+	}
 
-		memset(node_arr, 0, sizeof (node_arr));		
-		if (numa_move_pages(proc->pid, npages_tomove, addr_arr, NULL,
-			node_arr, 0) != 0) {
-			return (-1);
+	if (*line == 0) {
+		return (0);
+	}
+
+	return (strtoull(line + 1, NULL, 10) * 1024);
+}
+
+/*
+ * Read the Rss and AnonHugePages of all the mappings from
+ * /proc/<pid>/smaps in one pass. The result is cached in the map
+ * entries until the next refresh.
+ */
+static int
+map_thp_load(track_proc_t *proc)
+{
+	char path[PATH_MAX], line[MAPFILE_LINE_SIZE];
+	uint64_t start_addr, end_addr;
+	map_entry_t *entry = NULL;
+	FILE *fp;
+
+	proc->map.thp_loaded = B_TRUE;
+
+	snprintf(path, sizeof (path), "/proc/%d/smaps", proc->pid);
+	if ((fp = fopen(path, "r")) == NULL) {
+		return (-1);
+	}
+
+	while (fgets(line, sizeof (line), fp) != NULL) {
+		/*
+		 * e.g. 7f4996125000-7f499627b000 r-xp 00026000 fd:00 678793 /usr/lib/libc.so.6
+		 */
+		if (sscanf(line, "%" SCNx64 "-%" SCNx64 " ", &start_addr,
+			&end_addr) == 2) {
+			if ((entry = map_entry_find(proc, start_addr,
+				end_addr - start_addr)) != NULL) {
+				memset(&entry->thp, 0, sizeof (map_thp_t));
+				entry->thp.valid = B_TRUE;
+			}
+
+			continue;
 		}
 
-		if ((last_entry = numa_map_update(&map_entry->numa_map, addr_arr,
-			node_arr, npages_tomove, last_entry)) == NULL) {
-			return (-1);			
+		if (entry == NULL) {
+			continue;
 		}
 
-		npages_moved += npages_tomove;
+		if (strncmp(line, "Rss:", 4) == 0) {
+			entry->thp.rss = smaps_kb_parse(line);
+		} else if (strncmp(line, "AnonHugePages:", 14) == 0) {
+			entry->thp.anon_huge = smaps_kb_parse(line);
+		}
 	}
 
+	fclose(fp);
 	return (0);
 }
 
+/*
+ * The percentage of resident pages of the mapping which are backed by
+ * transparent huge pages, -1 if unknown.
+ */
 int
-map_addr2nodedst(pid_t pid, void **addr_arr, int *lat_arr, int addr_num,
-	map_nodedst_t *nodedst_arr, int nnodes, int *naccess_total)
+map_thp_pct(map_entry_t *map_entry)
 {
-	int *status_arr, i, nid;
-	
-	if ((status_arr = zalloc(sizeof (int) * addr_num)) == NULL) {
+	map_thp_t *thp = &map_entry->thp;
+
+	if (!thp->valid || (thp->rss == 0)) {
+		return (-1);
+	}
+
+	return ((int)(MIN(thp->anon_huge, thp->rss) * 100 / thp->rss));
+}
+
+/*
+ * Parse a line of numa_maps, e.g.
+ * 7f49960fa000 default anon=5 dirty=5 N0=3 N1=2 kernelpagesize_kB=4
+ * The pages are counted first, the page size is at the end of line.
+ */
+static void
+numaline_parse(char *line, map_numaline_t *numaline, uint64_t *node_bytes)
+{
+	char *tok, *saveptr;
+	uint64_t pagesize_kb = g_pagesize / KB_BYTES, n;
+	unsigned int nid;
+	int i;
+
+	numaline->start_addr = strtoull(line, NULL, 16);
+	memset(node_bytes, 0, nnodes_max * sizeof (uint64_t));
+	for (tok = strtok_r(line, " \n", &saveptr); tok != NULL;
+		tok = strtok_r(NULL, " \n", &saveptr)) {
+		if (sscanf(tok, "N%u=%" SCNu64, &nid, &n) == 2) {
+			if ((int)nid < nnodes_max) {
+				node_bytes[nid] = n;
+			}
+		} else if (sscanf(tok, "kernelpagesize_kB=%" SCNu64, &n) == 1) {
+			pagesize_kb = n;
+		}
+	}
+
+	numaline->pagesize = pagesize_kb * KB_BYTES;
+	for (i = 0; i < nnodes_max; i++) {
+		node_bytes[i] *= numaline->pagesize;
+	}
+}
+
+/*
+ * Read /proc/<pid>/numa_maps for all the mappings of process. The lines
+ * are in address order as the mappings.
+ */
+int
+map_numamaps_load(track_proc_t *proc)
+{
+	map_numamaps_t *numamaps = &proc->map.numamaps;
+	char path[PATH_MAX], *line = NULL;
+	map_numaline_t *arr;
+	uint64_t *node_bytes;
+	size_t len = 0;
+	int nmax;
+	FILE *fp;
+
+	numamaps->nline_cur = 0;
+	numamaps->loaded = B_FALSE;
+	proc->map.thp_loaded = B_FALSE;
+
+	snprintf(path, sizeof (path), "/proc/%d/numa_maps", proc->pid);
+	if ((fp = fopen(path, "r")) == NULL) {
+		return (-1);
+	}
+
+	while (getline(&line, &len, fp) > 0) {
+		if (numamaps->nline_cur == numamaps->nline_max) {
+			nmax = (numamaps->nline_max == 0) ?
+				MAP_ENTRY_NUM : numamaps->nline_max * 2;
+			if ((arr = realloc(numamaps->arr,
+				nmax * sizeof (map_numaline_t))) == NULL) {
+				goto L_EXIT;
+			}
+
+			numamaps->arr = arr;
+			if ((node_bytes = realloc(numamaps->node_bytes,
+				nmax * nnodes_max * sizeof (uint64_t))) == NULL) {
+				goto L_EXIT;
+			}
+
+			numamaps->node_bytes = node_bytes;
+			numamaps->nline_max = nmax;
+		}
+
+		arr = &numamaps->arr[numamaps->nline_cur];
+		arr->idx = numamaps->nline_cur * nnodes_max;
+		numaline_parse(line, arr, &numamaps->node_bytes[arr->idx]);
+		numamaps->nline_cur++;
+	}
+
+	numamaps->loaded = B_TRUE;
+
+L_EXIT:
+	free(line);
+	fclose(fp);
+	return (numamaps->loaded ? 0 : -1);
+}
+
+static int
+numaline_cmp(const void *p1, const void *p2)
+{
+	const uint64_t *addr = (const uint64_t *)p1;
+	const map_numaline_t *numaline = (const map_numaline_t *)p2;
+
+	if (*addr < numaline->start_addr) {
 		return (-1);
 	}
 
-	if (numa_move_pages(pid, addr_num, addr_arr, NULL, status_arr, 0) != 0) {
-		free(status_arr);
+	return ((*addr > numaline->start_addr) ? 1 : 0);
+}
+
+/*
+ * Find the numa_maps line of the mapping in what map_numamaps_load()
+ * read last time.
+ */
+static map_numaline_t *
+numaline_find(track_proc_t *proc, map_entry_t *map_entry)
+{
+	map_numamaps_t *numamaps = &proc->map.numamaps;
+
+	if (!numamaps->loaded) {
+		return (NULL);
+	}
+
+	return (bsearch(&map_entry->start_addr, numamaps->arr,
+		numamaps->nline_cur, sizeof (map_numaline_t), numaline_cmp));
+}
+
+/*
+ * Compare the node distribution of sampled pages with the real one
+ * reported by numa_maps. The confidence is 100% minus the total
+ * variation distance of the two distributions.
+ */
+static int
+numa_map_confidence(numa_map_t *numa_map)
+{
+	uint64_t *sampled, sampled_total = 0, real_total = 0;
+	numa_entry_t *entry;
+	double diff, dist = 0.0;
+	int i;
+
+	if ((sampled = zalloc(nnodes_max * sizeof (uint64_t))) == NULL) {
 		return (-1);
 	}
 
-	*naccess_total = 0;
-	for (i = 0; i < addr_num; i++) {
-		nid = status_arr[i];
-		if ((nid >= 0) && (nid < nnodes)) {
-			nodedst_arr[nid].naccess++;
-			nodedst_arr[nid].total_lat += lat_arr[i];
-			*naccess_total += 1;
+	for (i = 0; i < numa_map->nentry_cur; i++) {
+		entry = &numa_map->arr[i];
+		if ((entry->nid >= 0) && (entry->nid < nnodes_max)) {
+			sampled[entry->nid] += entry->end_addr - entry->start_addr;
+			sampled_total += entry->end_addr - entry->start_addr;
 		}
 	}
 
-	free(status_arr);
-	return (0);
+	for (i = 0; i < nnodes_max; i++) {
+		real_total += numa_map->node_bytes[i];
+	}
+
+	if ((sampled_total == 0) || (real_total == 0)) {
+		free(sampled);
+		return (-1);
+	}
+
+	for (i = 0; i < nnodes_max; i++) {
+		diff = (double)sampled[i] / (double)sampled_total -
+			(double)numa_map->node_bytes[i] / (double)real_total;
+		dist += (diff > 0) ? diff : -diff;
+	}
+
+	free(sampled);
+	return ((int)(100.0 * (1.0 - dist / 2.0)));
+}
+
+/*
+ * Query the node of each page in the mapping. The query is done once per
+ * huge page for hugetlbfs or THP backed mapping, so the time scales with
+ * the number of pages rather than the size of mapping.
+ *
+ * If 'g_map_granularity' is set, only one page per granularity is queried
+ * and it stands for the whole stride. The per-node totals are taken from
+ * numa_maps to report how close the sampled layout is.
+ *
+ * The page size and the per-node totals come from the numa_maps read by
+ * map_numamaps_load(), the caller loads it once before walking mappings.
+ */
+int
+map_map2numa(track_proc_t *proc, map_entry_t *map_entry)
+{
+	void *addr_arr[NUMA_MOVE_NPAGES];
+	uint64_t size_arr[NUMA_MOVE_NPAGES];
+	uint64_t addr, pagesize, thp_size, stride = 0;
+	int node_arr[NUMA_MOVE_NPAGES];
+	numa_entry_t *last_entry = NULL;
+	numa_map_t *numa_map = &map_entry->numa_map;
+	map_numaline_t *numaline;
+	int npages;
+	
+	numa_map_fini(map_entry);
+	numa_map->confidence = -1;
+
+	numaline = numaline_find(proc, map_entry);
+	pagesize = (numaline != NULL) ? numaline->pagesize : 0;
+	if (pagesize < (uint64_t)g_pagesize) {
+		pagesize = g_pagesize;
+	}
+
+	/*
+	 * smaps is only read for the mappings which could be THP backed.
+	 * The query per huge page is only right if all the resident pages
+	 * are THP, a partly covered mapping is queried per page.
+	 */
+	thp_size = 0;
+	if (s_thp_size > pagesize) {
+		if (!map_entry->thp.valid && !proc->map.thp_loaded) {
+			(void) map_thp_load(proc);
+		}
+
+		if (map_thp_pct(map_entry) == 100) {
+			thp_size = s_thp_size;
+		}
+	}
+
+	debug_print(NULL, 2, "map_map2numa: %"PRIx64"-%"PRIx64" pagesize = %"
+		PRIu64", thp_size = %"PRIu64"\n", map_entry->start_addr,
+		map_entry->end_addr, pagesize, thp_size);
+
+	if ((g_map_granularity > pagesize) && (g_map_granularity > thp_size)) {
+		stride = ((g_map_granularity + pagesize - 1) / pagesize) * pagesize;
+		numa_map->granularity = stride;
+
+		if ((numaline != NULL) && ((numa_map->node_bytes =
+			zalloc(nnodes_max * sizeof (uint64_t))) != NULL)) {
+			memcpy(numa_map->node_bytes,
+				&proc->map.numamaps.node_bytes[numaline->idx],
+				nnodes_max * sizeof (uint64_t));
+		}
+	}
+
+	addr = map_entry->start_addr;
+	while (addr < map_entry->end_addr) {
+		npages = 0;
+		while ((npages < NUMA_MOVE_NPAGES) && (addr < map_entry->end_addr)) {
+			addr_arr[npages] = (void *)(uintptr_t)addr;
+			if (stride > 0) {
+				size_arr[npages] = MIN(stride, map_entry->end_addr - addr);
+			} else if ((thp_size > 0) && ((addr & (thp_size - 1)) == 0) &&
+				(addr + thp_size <= map_entry->end_addr)) {
+				size_arr[npages] = thp_size;
+			} else {
+				size_arr[npages] = MIN(pagesize, map_entry->end_addr - addr);
+			}
+
+			addr += size_arr[npages];
+			npages++;
+		}
+
+		memset(node_arr, 0, sizeof (node_arr));		
+		if (numa_move_pages(proc->pid, npages, addr_arr, NULL,
+			node_arr, 0) != 0) {
+			return (-1);
+		}
+
+		if ((last_entry = numa_map_update(numa_map, addr_arr,
+			size_arr, node_arr, npages, last_entry)) == NULL) {
+			return (-1);			
+		}
+	}
+
+	if (numa_map->node_bytes != NULL) {
+		numa_map->confidence = numa_map_confidence(numa_map);
+	}
+
+	return (0);
+}
+
+static unsigned int
+pagecache_hash(uint64_t page, int npages_max)
+{
+	return ((unsigned int)((page / g_pagesize) * 2654435761ULL) &
+		(npages_max - 1));
+}
+
+/*
+ * Find the slot of page, or the empty slot where the page should be
+ * inserted.
+ */
+static map_page_t *
+pagecache_slot(map_pagecache_t *cache, uint64_t page)
+{
+	unsigned int i;
+
+	i = pagecache_hash(page, cache->npages_max);
+	while ((cache->arr[i].page != 0) && (cache->arr[i].page != page)) {
+		i = (i + 1) & (cache->npages_max - 1);
+	}
+
+	return (&cache->arr[i]);
+}
+
+/*
+ * Keep the load factor of hash table under 1/2.
+ */
+static int
+pagecache_reserve(map_pagecache_t *cache, int n)
+{
+	map_page_t *old_arr = cache->arr, *slot;
+	int old_max = cache->npages_max, nmax, i;
+
+	if ((cache->npages_cur + n) * 2 <= old_max) {
+		return (0);
+	}
+
+	nmax = (old_max == 0) ? MAP_PAGECACHE_NUM : old_max;
+	while ((cache->npages_cur + n) * 2 > nmax) {
+		nmax <<= 1;
+	}
+
+	if ((cache->arr = zalloc(nmax * sizeof (map_page_t))) == NULL) {
+		cache->arr = old_arr;
+		return (-1);
+	}
+
+	cache->npages_max = nmax;
+	for (i = 0; i < old_max; i++) {
+		if (old_arr[i].page != 0) {
+			slot = pagecache_slot(cache, old_arr[i].page);
+			memcpy(slot, &old_arr[i], sizeof (map_page_t));
+		}
+	}
+
+	if (old_arr != NULL) {
+		free(old_arr);
+	}
+
+	return (0);
+}
+
+static int
+pagecache_buf_reserve(map_pagecache_t *cache, int n)
+{
+	void **addr_buf;
+	int *status_buf;
+
+	if (n <= cache->nbuf_max) {
+		return (0);
+	}
+
+	if ((addr_buf = realloc(cache->addr_buf, n * sizeof (void *))) == NULL) {
+		return (-1);
+	}
+
+	cache->addr_buf = addr_buf;
+	if ((status_buf = realloc(cache->status_buf, n * sizeof (int))) == NULL) {
+		return (-1);
+	}
+
+	cache->status_buf = status_buf;
+	cache->nbuf_max = n;
+	return (0);
+}
+
+/*
+ * Walk the LL sample addresses, queue the pages which are not in cache
+ * or expired. A few of valid cached pages are also queued in rotation
+ * to catch the pages migrated by kernel (e.g. NUMA balancing).
+ */
+static int
+pagecache_miss_collect(map_pagecache_t *cache, void **addr_arr, int addr_num)
+{
+	map_page_t *slot;
+	uint64_t page;
+	int i, nmiss = 0, nrevalidate = 0;
+
+	for (i = 0; i < addr_num; i++) {
+		page = (uint64_t)(uintptr_t)addr_arr[i] & ~((uint64_t)g_pagesize - 1);
+		if (page == 0) {
+			continue;
+		}
+
+		slot = pagecache_slot(cache, page);
+		if (slot->page == 0) {
+			slot->page = page;
+			cache->npages_cur++;
+		} else if (cache->gen - slot->gen < MAP_PAGECACHE_TTL) {
+			/* Already queued in this round or still valid. */
+			continue;
+		}
+
+		slot->nid = MAP_NID_PENDING;
+		slot->gen = cache->gen;
+		cache->addr_buf[nmiss++] = (void *)(uintptr_t)page;
+	}
+
+	for (i = 0; (i < cache->npages_max) &&
+		(nrevalidate < MAP_PAGECACHE_REVALIDATE); i++) {
+		slot = &cache->arr[cache->revalidate_idx];
+		cache->revalidate_idx = (cache->revalidate_idx + 1) &
+			(cache->npages_max - 1);
+
+		if ((slot->page != 0) && (slot->gen != cache->gen)) {
+			slot->nid = MAP_NID_PENDING;
+			slot->gen = cache->gen;
+			cache->addr_buf[nmiss++] = (void *)(uintptr_t)slot->page;
+			nrevalidate++;
+		}
+	}
+
+	return (nmiss);
+}
+
+/*
+ * Start a new generation of the page cache, once per refresh however
+ * many times the cache is updated in the refresh (e.g. per thread).
+ * Generation 0 is never used, so a zeroed slot is always expired.
+ */
+void
+map_pagecache_refresh(track_proc_t *proc)
+{
+	map_pagecache_t *cache = &proc->map.pagecache;
+
+	if (++cache->gen == 0) {
+		cache->gen = 1;
+	}
+}
+
+/*
+ * Make sure the node of each page in "addr_arr" is in page cache, only
+ * the pages which are not seen recently are looked up by
+ * numa_move_pages().
+ */
+static int
+pagecache_update(track_proc_t *proc, void **addr_arr, int addr_num)
+{
+	map_pagecache_t *cache = &proc->map.pagecache;
+	map_page_t *slot;
+	int i, nmiss;
+
+	if (cache->npages_cur + addr_num > MAP_PAGECACHE_MAX) {
+		pagecache_free(cache);
+	}
+
+	if ((pagecache_reserve(cache, addr_num) != 0) ||
+		(pagecache_buf_reserve(cache,
+		addr_num + MAP_PAGECACHE_REVALIDATE) != 0)) {
+		return (-1);
+	}
+
+	if ((nmiss = pagecache_miss_collect(cache, addr_arr, addr_num)) > 0) {
+		if (numa_move_pages(proc->pid, nmiss, cache->addr_buf, NULL,
+			cache->status_buf, 0) != 0) {
+			pagecache_free(cache);
+			return (-1);
+		}
+
+		for (i = 0; i < nmiss; i++) {
+			slot = pagecache_slot(cache,
+				(uint64_t)(uintptr_t)cache->addr_buf[i]);
+			slot->nid = cache->status_buf[i];
+		}
+	}
+
+	debug_print(NULL, 2, "pagecache_update: %d samples, %d pages queried, "
+		"%d pages cached\n", addr_num, nmiss, cache->npages_cur);
+
+	return (0);
+}
+
+/*
+ * Get the node distribution of LL sample addresses. The node of each page
+ * is cached per process.
+ */
+int
+map_addr2nodedst(track_proc_t *proc, void **addr_arr, int *lat_arr,
+	mem_src_t *src_arr, int addr_num, map_nodedst_t *nodedst_arr, int nnodes,
+	int *naccess_total)
+{
+	map_pagecache_t *cache = &proc->map.pagecache;
+	uint64_t page;
+	int i, nid;
+
+	map_pagecache_refresh(proc);
+	if (pagecache_update(proc, addr_arr, addr_num) != 0) {
+		return (-1);
+	}
+
+	*naccess_total = 0;
+	for (i = 0; i < addr_num; i++) {
+		page = (uint64_t)(uintptr_t)addr_arr[i] & ~((uint64_t)g_pagesize - 1);
+		if (page == 0) {
+			continue;
+		}
+
+		nid = pagecache_slot(cache, page)->nid;
+		if ((nid >= 0) && (nid < nnodes)) {
+			nodedst_arr[nid].naccess++;
+			nodedst_arr[nid].total_lat += lat_arr[i];
+			lat_hist_add(&nodedst_arr[nid].hist, lat_arr[i]);
+			nodedst_arr[nid].memsrc.count[src_arr[i]]++;
+			*naccess_total += 1;
+		}
+	}
+
+	return (0);
+}
+
+/*
+ * Start tracking the hot pages of process, or of one thread if "lwpid"
+ * is not 0. The pages tracked before are dropped. The token of the new
+ * owner is returned in "owner".
+ */
+int
+map_heatmap_start(track_proc_t *proc, int lwpid, unsigned int *owner)
+{
+	map_heatmap_t *heatmap = &proc->map.heatmap;
+	map_heat_t *arr;
+
+	if ((arr = zalloc(sizeof (map_heat_t) * MAP_HEAT_NUM)) == NULL) {
+		return (-1);
+	}
+
+	(void) pthread_mutex_lock(&proc->mutex);
+	heatmap_free(heatmap);
+	heatmap->arr = arr;
+	heatmap->lwpid = lwpid;
+
+	/*
+	 * 0 is never a valid owner.
+	 */
+	if (++s_heatmap_owner == 0) {
+		s_heatmap_owner = 1;
+	}
+
+	heatmap->owner = s_heatmap_owner;
+	*owner = s_heatmap_owner;
+	(void) pthread_mutex_unlock(&proc->mutex);
+	return (0);
+}
+
+/*
+ * Stop tracking if the heatmap is still owned by "owner", otherwise it
+ * belongs to another window now.
+ */
+void
+map_heatmap_stop(track_proc_t *proc, unsigned int owner)
+{
+	(void) pthread_mutex_lock(&proc->mutex);
+	if (proc->map.heatmap.owner == owner) {
+		heatmap_free(&proc->map.heatmap);
+	}
+
+	(void) pthread_mutex_unlock(&proc->mutex);
+}
+
+boolean_t
+map_heatmap_owned(track_proc_t *proc, unsigned int owner)
+{
+	boolean_t ret;
+
+	(void) pthread_mutex_lock(&proc->mutex);
+	ret = (proc->map.heatmap.arr != NULL) &&
+		(proc->map.heatmap.owner == owner);
+	(void) pthread_mutex_unlock(&proc->mutex);
+	return (ret);
+}
+
+/*
+ * Count a LL sample in the page it hits. "nid" is the node of the CPU
+ * which issues the access. It's called in perf thread with proc->mutex
+ * held.
+ */
+void
+map_heatmap_add(track_proc_t *proc, int tid, int nid, os_perf_llrec_t *rec)
+{
+	map_heatmap_t *heatmap = &proc->map.heatmap;
+	map_heat_t *heat = NULL, *min = NULL;
+	uint64_t page;
+	uint32_t naccess;
+	int i;
+
+	if ((heatmap->arr == NULL) || (rec->addr == 0) ||
+		((heatmap->lwpid != 0) && (heatmap->lwpid != tid))) {
+		return;
+	}
+
+	page = rec->addr & ~((uint64_t)g_pagesize - 1);
+	for (i = 0; i < heatmap->nheat_cur; i++) {
+		if (heatmap->arr[i].page == page) {
+			heat = &heatmap->arr[i];
+			break;
+		}
+
+		if ((min == NULL) || (heatmap->arr[i].naccess < min->naccess)) {
+			min = &heatmap->arr[i];
+		}
+	}
+
+	if (heat == NULL) {
+		if (heatmap->nheat_cur < MAP_HEAT_NUM) {
+			heat = &heatmap->arr[heatmap->nheat_cur++];
+			naccess = 0;
+		} else {
+			heat = min;
+			naccess = min->naccess;
+		}
+
+		memset(heat, 0, sizeof (map_heat_t));
+		heat->page = page;
+		heat->naccess = naccess;
+	}
+
+	heat->naccess++;
+	heat->total_lat += rec->latency;
+	lat_hist_add(&heat->hist, rec->latency);
+	heat->line_count[(rec->addr - page) * MAP_HEAT_LINE_NUM / g_pagesize]++;
+
+	if ((nid >= 0) && (nid < 64)) {
+		heat->node_mask |= 1ULL << nid;
+	}
+
+	/*
+	 * Keep the call-chain of the latest access.
+	 */
+	heat->ip_num = rec->callchain.ip_num;
+	memcpy(heat->ips, rec->callchain.ips, heat->ip_num * sizeof (uint64_t));
+	heatmap->nsamples++;
+}
+
+static int
+heat_cmp(const void *p1, const void *p2)
+{
+	const map_heat_t *h1 = (const map_heat_t *)p1;
+	const map_heat_t *h2 = (const map_heat_t *)p2;
+
+	if (h1->naccess < h2->naccess) {
+		return (1);
+	}
+
+	if (h1->naccess > h2->naccess) {
+		return (-1);
+	}
+
+	return (0);
+}
+
+/*
+ * Copy out the hot pages sorted by the number of accesses and get the
+ * node where each page is allocated. The caller frees "*arr".
+ */
+int
+map_heatmap_get(track_proc_t *proc, map_heat_t **arr, int *num,
+	uint64_t *nsamples)
+{
+	map_heatmap_t *heatmap = &proc->map.heatmap;
+	map_heat_t *buf = NULL;
+	void **addr_buf = NULL;
+	int *status_buf = NULL;
+	int i, n, ret = -1;
+
+	(void) pthread_mutex_lock(&proc->mutex);
+	if ((heatmap->arr == NULL) || ((n = heatmap->nheat_cur) > 0 &&
+		(buf = malloc(sizeof (map_heat_t) * n)) == NULL)) {
+		(void) pthread_mutex_unlock(&proc->mutex);
+		return (-1);
+	}
+
+	if (n > 0) {
+		memcpy(buf, heatmap->arr, sizeof (map_heat_t) * n);
+	}
+
+	*nsamples = heatmap->nsamples;
+	(void) pthread_mutex_unlock(&proc->mutex);
+
+	if (n == 0) {
+		*arr = NULL;
+		*num = 0;
+		return (0);
+	}
+
+	qsort(buf, n, sizeof (map_heat_t), heat_cmp);
+
+	if (((addr_buf = zalloc(sizeof (void *) * n)) == NULL) ||
+		((status_buf = zalloc(sizeof (int) * n)) == NULL)) {
+		goto L_EXIT;
+	}
+
+	for (i = 0; i < n; i++) {
+		addr_buf[i] = (void *)(uintptr_t)(buf[i].page);
+	}
+
+	if (numa_move_pages(proc->pid, n, addr_buf, NULL, status_buf, 0) != 0) {
+		for (i = 0; i < n; i++) {
+			status_buf[i] = -1;
+		}
+	}
+
+	for (i = 0; i < n; i++) {
+		buf[i].nid = (status_buf[i] >= 0) ? status_buf[i] : -1;
+	}
+
+	*arr = buf;
+	*num = n;
+	buf = NULL;
+	ret = 0;
+
+L_EXIT:
+	if (buf != NULL) {
+		free(buf);
+	}
+
+	if (addr_buf != NULL) {
+		free(addr_buf);
+	}
+
+	if (status_buf != NULL) {
+		free(status_buf);
+	}
+
+	return (ret);
+}
+
+static int
+migrate_addr_cmp(const void *p1, const void *p2)
+{
+	const map_migrate_page_t *m1 = (const map_migrate_page_t *)p1;
+	const map_migrate_page_t *m2 = (const map_migrate_page_t *)p2;
+
+	if (m1->page < m2->page) {
+		return (-1);
+	}
+
+	return ((m1->page > m2->page) ? 1 : 0);
+}
+
+static int
+migrate_hot_cmp(const void *p1, const void *p2)
+{
+	const map_migrate_page_t *m1 = (const map_migrate_page_t *)p1;
+	const map_migrate_page_t *m2 = (const map_migrate_page_t *)p2;
+
+	return (m2->naccess - m1->naccess);
+}
+
+/*
+ * Collect the pages hit by the LL samples in [addr, addr + size) (all
+ * the samples if "size" is 0) together with the node of CPU which
+ * issues each access. Return the number of samples collected.
+ */
+static int
+llrec_page_collect(track_proc_t *proc, track_lwp_t *lwp, uint64_t addr,
+	uint64_t size, map_migrate_page_t **arr)
+{
+	perf_llrecgrp_t *grp;
+	os_perf_llrec_t *rec;
+	map_migrate_page_t *buf;
+	node_t *node;
+	int *cpu_nid;
+	uint64_t page;
+	int i, nid, n = 0;
+
+	*arr = NULL;
+	if ((cpu_nid = zalloc(sizeof (int) * ncpus_max)) == NULL) {
+		return (-1);
+	}
+
+	for (i = 0; i < ncpus_max; i++) {
+		cpu_nid[i] = MAP_NID_PENDING;
+	}
+
+	(void) pthread_mutex_lock(&proc->mutex);
+	grp = (lwp == NULL) ? &proc->llrec_grp : &lwp->llrec_grp;
+	if ((grp->nrec_cur == 0) || ((buf = zalloc(sizeof (map_migrate_page_t) *
+		grp->nrec_cur)) == NULL)) {
+		(void) pthread_mutex_unlock(&proc->mutex);
+		free(cpu_nid);
+		return ((grp->nrec_cur == 0) ? 0 : -1);
+	}
+
+	for (i = 0; i < grp->nrec_cur; i++) {
+		rec = grp->rec_arr[i];
+		if ((size > 0) &&
+			((rec->addr < addr) || (rec->addr >= addr + size))) {
+			continue;
+		}
+
+		if (rec->cpu >= (uint64_t)ncpus_max) {
+			continue;
+		}
+
+		if ((nid = cpu_nid[rec->cpu]) == MAP_NID_PENDING) {
+			node = node_by_cpu((int)rec->cpu);
+			nid = (node != NULL) ? node->nid : -1;
+			cpu_nid[rec->cpu] = nid;
+		}
+
+		page = rec->addr & ~((uint64_t)g_pagesize - 1);
+		if ((page == 0) || (nid < 0) || (nid >= nnodes_max)) {
+			continue;
+		}
+
+		buf[n].page = page;
+		buf[n].nid = nid;
+		buf[n].naccess = 1;
+		n++;
+	}
+
+	(void) pthread_mutex_unlock(&proc->mutex);
+	free(cpu_nid);
+	*arr = buf;
+	return (n);
+}
+
+/*
+ * Merge the samples of the same page and pick the node which accesses
+ * the page most as the target. Return the number of pages.
+ */
+static int
+migrate_page_merge(map_migrate_page_t *arr, int n, int *node_cnt)
+{
+	int i, j, k, nid, npages = 0;
+
+	qsort(arr, n, sizeof (map_migrate_page_t), migrate_addr_cmp);
+
+	for (i = 0; i < n; i = j) {
+		nid = arr[i].nid;
+		for (j = i; (j < n) && (arr[j].page == arr[i].page); j++) {
+			node_cnt[arr[j].nid]++;
+		}
+
+		for (k = i; k < j; k++) {
+			if (node_cnt[arr[k].nid] > node_cnt[nid]) {
+				nid = arr[k].nid;
+			}
+		}
+
+		for (k = i; k < j; k++) {
+			node_cnt[arr[k].nid] = 0;
+		}
+
+		arr[npages].page = arr[i].page;
+		arr[npages].nid = nid;
+		arr[npages].naccess = j - i;
+		npages++;
+	}
+
+	qsort(arr, npages, sizeof (map_migrate_page_t), migrate_hot_cmp);
+	return (npages);
+}
+
+/*
+ * Build the plan of moving the sampled pages of the range to the node
+ * which accesses them most. The pages which are already on that node
+ * are only counted in "nlocal".
+ */
+int
+map_migrate_plan(track_proc_t *proc, track_lwp_t *lwp, uint64_t addr,
+	uint64_t size, map_migrate_t *mig)
+{
+	map_migrate_page_t *arr = NULL;
+	void **addr_buf = NULL;
+	int *node_cnt = NULL, *status_buf = NULL;
+	int i, n, ret = -1;
+
+	map_migrate_free(mig);
+
+	if ((n = llrec_page_collect(proc, lwp, addr, size, &arr)) <= 0) {
+		return (n);
+	}
+
+	if ((node_cnt = zalloc(sizeof (int) * nnodes_max)) == NULL) {
+		goto L_EXIT;
+	}
+
+	n = migrate_page_merge(arr, n, node_cnt);
+
+	if (((addr_buf = zalloc(sizeof (void *) * n)) == NULL) ||
+		((status_buf = zalloc(sizeof (int) * n)) == NULL) ||
+		((mig->addr_arr = zalloc(sizeof (void *) * n)) == NULL) ||
+		((mig->nid_arr = zalloc(sizeof (int) * n)) == NULL) ||
+		((mig->status_arr = zalloc(sizeof (int) * n)) == NULL)) {
+		goto L_EXIT;
+	}
+
+	for (i = 0; i < n; i++) {
+		addr_buf[i] = (void *)(uintptr_t)(arr[i].page);
+	}
+
+	if (numa_move_pages(proc->pid, n, addr_buf, NULL, status_buf, 0) != 0) {
+		goto L_EXIT;
+	}
+
+	for (i = 0; i < n; i++) {
+		if (status_buf[i] < 0) {
+			continue;
+		}
+
+		if (status_buf[i] == arr[i].nid) {
+			mig->nlocal++;
+			continue;
+		}
+
+		mig->addr_arr[mig->npages] = addr_buf[i];
+		mig->nid_arr[mig->npages] = arr[i].nid;
+		mig->npages++;
+	}
+
+	ret = 0;
+
+L_EXIT:
+	if (ret != 0) {
+		map_migrate_free(mig);
+	}
+
+	free(arr);
+
+	if (node_cnt != NULL) {
+		free(node_cnt);
+	}
+
+	if (addr_buf != NULL) {
+		free(addr_buf);
+	}
+
+	if (status_buf != NULL) {
+		free(status_buf);
+	}
+
+	return (ret);
+}
+
+/*
+ * Move the next pages of plan, at most "max_bytes" (but at least one
+ * page) at a time. The node of moved pages is updated in page cache.
+ */
+int
+map_migrate_run(track_proc_t *proc, map_migrate_t *mig, uint64_t max_bytes)
+{
+	map_pagecache_t *cache = &proc->map.pagecache;
+	map_page_t *slot;
+	uint64_t page;
+	int i, num;
+
+	if ((num = mig->npages - mig->next) <= 0) {
+		return (0);
+	}
+
+	if ((uint64_t)num > max_bytes / g_pagesize) {
+		num = (int)(max_bytes / g_pagesize);
+	}
+
+	if (num == 0) {
+		num = 1;
+	}
+
+	if (numa_move_pages(proc->pid, num, &mig->addr_arr[mig->next],
+		&mig->nid_arr[mig->next], &mig->status_arr[mig->next],
+		MPOL_MF_MOVE) < 0) {
+		debug_print(NULL, 2, "map_migrate_run: move_pages failed "
+			"(pid: %d, pages: %d)\n", proc->pid, num);
+		mig->nfailed += num;
+		mig->next += num;
+		return (-1);
+	}
+
+	for (i = mig->next; i < mig->next + num; i++) {
+		if (mig->status_arr[i] != mig->nid_arr[i]) {
+			mig->nfailed++;
+			continue;
+		}
+
+		mig->nmoved++;
+		if (cache->arr != NULL) {
+			page = (uint64_t)(uintptr_t)mig->addr_arr[i];
+			if ((slot = pagecache_slot(cache, page))->page == page) {
+				slot->nid = mig->status_arr[i];
+			}
+		}
+	}
+
+	mig->next += num;
+	return (0);
+}
+
+void
+map_migrate_free(map_migrate_t *mig)
+{
+	if (mig->addr_arr != NULL) {
+		free(mig->addr_arr);
+	}
+
+	if (mig->nid_arr != NULL) {
+		free(mig->nid_arr);
+	}
+
+	if (mig->status_arr != NULL) {
+		free(mig->status_arr);
+	}
+
+	mig->addr_arr = NULL;
+	mig->nid_arr = NULL;
+	mig->status_arr = NULL;
+	mig->npages = 0;
+	mig->next = 0;
+	mig->nmoved = 0;
+	mig->nfailed = 0;
+	mig->nlocal = 0;
+}
+
+/*
+ * Break down the LL samples of thread by the node where the thread runs
+ * and the node where the accessed page is allocated.
+ */
+int
+map_lwp_place(track_proc_t *proc, track_lwp_t *lwp, map_place_t *place)
+{
+	map_pagecache_t *cache = &proc->map.pagecache;
+	map_migrate_page_t *arr;
+	void **addr_buf;
+	int i, n, nid, ret = -1;
+
+	place->naccess = 0;
+	place->nremote = 0;
+	(void) memset(place->run_cnt, 0, sizeof (int) * nnodes_max);
+	(void) memset(place->mem_cnt, 0, sizeof (int) * nnodes_max);
+
+	if ((n = llrec_page_collect(proc, lwp, 0, 0, &arr)) <= 0) {
+		return (n);
+	}
+
+	if ((addr_buf = zalloc(sizeof (void *) * n)) == NULL) {
+		free(arr);
+		return (-1);
+	}
+
+	for (i = 0; i < n; i++) {
+		addr_buf[i] = (void *)(uintptr_t)(arr[i].page);
+	}
+
+	if (pagecache_update(proc, addr_buf, n) != 0) {
+		goto L_EXIT;
+	}
+
+	for (i = 0; i < n; i++) {
+		place->run_cnt[arr[i].nid]++;
+		nid = pagecache_slot(cache, arr[i].page)->nid;
+		if ((nid < 0) || (nid >= nnodes_max)) {
+			continue;
+		}
+
+		place->mem_cnt[nid]++;
+		place->naccess++;
+		if (nid != arr[i].nid) {
+			place->nremote++;
+		}
+	}
+
+	ret = 0;
+
+L_EXIT:
+	free(arr);
+	free(addr_buf);
+	return (ret);
 }
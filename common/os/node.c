@@ -75,15 +75,33 @@ node_fini(node_t *node)
 		return;
 	}
 
+	/*
+	 * The burst sampler reads the uncore events of node.
+	 */
+	os_uncore_burst_stop(node);
 	os_perf_cpuarr_fini(node->cpus, ncpus_max, B_FALSE);
 	node->ncpus = 0;
 	free(node->cpus);
+
+	if (node->qpi.qpi_info != NULL) {
+		free(node->qpi.qpi_info);
+		node->qpi.qpi_info = NULL;
+		node->qpi.qpi_num = 0;
+	}
+
+	if (node->imc.imc_info != NULL) {
+		free(node->imc.imc_info);
+		node->imc.imc_info = NULL;
+		node->imc.imc_num = 0;
+	}
+
 	node->nid = INVALID_NID;
 }
 
 static void
 node_hotremove(node_t *node)
 {
+	os_uncore_burst_stop(node);
 	node->hotremove = B_TRUE;
 	os_perf_cpuarr_fini(node->cpus, ncpus_max, B_TRUE);
 }
@@ -112,6 +130,12 @@ node_group_init(void)
 		return (-1);
 	}
 
+	if ((s_node_group.distance = zalloc(nnodes_max * nnodes_max *
+		sizeof (int))) == NULL) {
+		free(s_node_group.nodes);
+		return (-1);
+	}
+
 	s_node_group.inited = B_TRUE;
 	for (i = 0; i < nnodes_max; i++) {
 		node = node_get(i);
@@ -147,6 +171,7 @@ node_group_reset(void)
 
 	s_node_group.nnodes = 0;
 	free(s_node_group.nodes);
+	free(s_node_group.distance);
 }
 
 /*
@@ -158,6 +183,7 @@ node_group_fini(void)
 	if (s_node_group.inited) {
 		(void) pthread_mutex_destroy(&s_node_group.mutex);
 		node_group_reset();
+		os_sysfs_fini();
 	}
 }
 
@@ -220,6 +246,7 @@ cpu_refresh(boolean_t init)
 			}
 
 			node->ncpus = num;
+			node->memory_only = (num == 0);
 			j = cpuid_max_get(cpu_arr, num);
 			if (cpuid_max < j) {
 				cpuid_max = j;
@@ -240,6 +267,62 @@ L_EXIT:
 	return (ret);
 }
 
+/*
+ * The remote accesses from a node are assumed to spread over the other
+ * nodes by their used memory, so a memory-only node far away weighs
+ * more once the pages are placed on it. The same spread tells how much
+ * of the remote traffic leaves the socket.
+ */
+static void
+remote_target_refresh(void)
+{
+	node_t *node, *target;
+	node_meminfo_t *mi;
+	uint64_t used;
+	double wsum, wdist, wx, sum;
+	int i, j, n, nx;
+
+	for (i = 0; i < nnodes_max; i++) {
+		node = node_get(i);
+		if (!NODE_VALID(node)) {
+			continue;
+		}
+
+		wsum = wdist = wx = sum = 0.0;
+		n = nx = 0;
+		for (j = 0; j < nnodes_max; j++) {
+			target = node_get(j);
+			if ((j == i) || !NODE_VALID(target)) {
+				continue;
+			}
+
+			mi = &target->meminfo;
+			used = (mi->mem_total > mi->mem_free) ?
+				mi->mem_total - mi->mem_free : 0;
+			wsum += (double)used;
+			wdist += (double)used * node_distance(i, j);
+			sum += node_distance(i, j);
+			n++;
+
+			if (target->pkgid != node->pkgid) {
+				wx += (double)used;
+				nx++;
+			}
+		}
+
+		if (wsum > 0.0) {
+			node->remote_distance = wdist / wsum;
+			node->xsocket_ratio = wx / wsum;
+		} else if (n > 0) {
+			node->remote_distance = sum / n;
+			node->xsocket_ratio = (double)nx / n;
+		} else {
+			node->remote_distance = NODE_DISTANCE_REMOTE;
+			node->xsocket_ratio = 0.0;
+		}
+	}
+}
+
 static int
 meminfo_refresh(void)
 {
@@ -256,9 +339,110 @@ meminfo_refresh(void)
 		}
 	}
 
+	remote_target_refresh();
 	return (0);
 }
 
+/*
+ * A hot-removed node keeps its nid until the perf thread has freed its
+ * CPUs, but it's not in the online list of sysfs any more.
+ */
+static boolean_t
+node_online(node_t *node)
+{
+	return (NODE_VALID(node) && !node->hotremove);
+}
+
+/*
+ * Load the SLIT distance matrix. The distances in a node's file are
+ * in the order of the online nodes. The ACPI defaults are used if the
+ * file can't be read.
+ */
+static void
+distance_refresh(void)
+{
+	int *dist_arr, i, j, k, num;
+	node_t *target;
+
+	if ((dist_arr = zalloc(nnodes_max * sizeof (int))) == NULL) {
+		return;
+	}
+
+	for (i = 0; i < nnodes_max; i++) {
+		if (!node_online(node_get(i)) ||
+		    !os_sysfs_node_distance(i, dist_arr, nnodes_max, &num)) {
+			num = 0;
+		}
+
+		for (j = 0, k = 0; j < nnodes_max; j++) {
+			target = node_get(j);
+			if (node_online(target) && (k < num)) {
+				s_node_group.distance[i * nnodes_max + j] =
+				    dist_arr[k++];
+			} else {
+				s_node_group.distance[i * nnodes_max + j] =
+				    (i == j) ? NODE_DISTANCE_LOCAL : NODE_DISTANCE_REMOTE;
+			}
+		}
+	}
+
+	free(dist_arr);
+}
+
+/*
+ * Get the socket and the LLC domain of each CPU. A memory-only node is
+ * put in the socket of its nearest node with CPU.
+ */
+static void
+topo_refresh(void)
+{
+	node_t *node, *near;
+	perf_cpu_t *cpu;
+	int i, j, d, dmin;
+
+	for (i = 0; i < nnodes_max; i++) {
+		node = node_get(i);
+		if (!node_online(node)) {
+			continue;
+		}
+
+		node->pkgid = -1;
+		for (j = 0; j < ncpus_max; j++) {
+			cpu = &node->cpus[j];
+			if ((cpu->cpuid == INVALID_CPUID) || cpu->hotremove) {
+				continue;
+			}
+
+			cpu->pkgid = os_sysfs_cpu_pkgid(cpu->cpuid);
+			cpu->llcid = os_sysfs_cpu_llcid(cpu->cpuid);
+			if (node->pkgid == -1) {
+				node->pkgid = cpu->pkgid;
+			}
+		}
+	}
+
+	for (i = 0; i < nnodes_max; i++) {
+		node = node_get(i);
+		if (!node_online(node) || !node->memory_only) {
+			continue;
+		}
+
+		dmin = -1;
+		for (j = 0; j < nnodes_max; j++) {
+			near = node_get(j);
+			if (!node_online(near) || near->memory_only) {
+				continue;
+			}
+
+			d = node_distance(i, j);
+			if ((dmin == -1) || (d < dmin)) {
+				dmin = d;
+				node->pkgid = near->pkgid;
+			}
+		}
+	}
+}
+
 /*
  * Refresh the information of each node in group. The information
  * includes such as: CPU, physical memory size, free memory size.
@@ -272,6 +456,16 @@ node_group_refresh(boolean_t init)
 
 	node_group_lock();
 
+	/*
+	 * Without hotplug only the memory usage needs to be refreshed,
+	 * which costs one read per node.
+	 */
+	if (!os_sysfs_topo_changed() && !init) {
+		ret = meminfo_refresh();
+		node_group_unlock();
+		return (ret);
+	}
+
 	if ((node_arr = zalloc(nnodes_max * sizeof(int))) == NULL) {
 		goto L_EXIT;
 	}
@@ -314,6 +508,9 @@ node_group_refresh(boolean_t init)
 		goto L_EXIT;
 	}
 
+	distance_refresh();
+	topo_refresh();
+
 	if (meminfo_refresh() != 0) {
 		goto L_EXIT;
 	}
@@ -321,6 +518,14 @@ node_group_refresh(boolean_t init)
 	ret = 0;
 
 L_EXIT:
+	/*
+	 * The online masks are already saved, make the next refresh
+	 * enumerate again instead of taking the meminfo-only path.
+	 */
+	if (ret != 0) {
+		os_sysfs_topo_reset();
+	}
+
 	free(node_arr);
 	node_group_unlock();
 	return (ret);
@@ -446,6 +651,7 @@ node_cpu_traverse(pfn_perf_cpu_op_t func, void *arg, boolean_t err_ret,
 			cpu = &node->cpus[j];
 			if (cpu->hotremove) {
 				pf_resource_free(cpu);
+				pf_ll_resource_free(cpu);
 				cpu->hotremove = B_FALSE;
 				cpu->cpuid = INVALID_CPUID;
 				continue;
@@ -534,11 +740,17 @@ void
 node_profiling_clear(void)
 {
 	node_t *node;
-	int i;
+	int i, j;
 
 	for (i = 0; i < nnodes_max; i++) {
 		node = node_get(i);
 		(void) memset(&node->countval, 0, sizeof (count_value_t));
+		if (NODE_VALID(node)) {
+			for (j = 0; j < ncpus_max; j++) {
+				(void) memset(&node->cpus[j].countval, 0,
+				    sizeof (count_value_t));
+			}
+		}
 	}	
 }
 
@@ -562,6 +774,25 @@ node_valid_get(int node_idx)
 	return (NULL);
 }
 
+/*
+ * The uncore events of a node are opened on its first online CPU.
+ */
+int
+node_uncore_cpu(node_t *node)
+{
+	perf_cpu_t *cpu;
+	int i;
+
+	for (i = 0; i < ncpus_max; i++) {
+		cpu = &node->cpus[i];
+		if ((cpu->cpuid != INVALID_CPUID) && !cpu->hotremove) {
+			return (cpu->cpuid);
+		}
+	}
+
+	return (INVALID_CPUID);
+}
+
 int
 node_cpuid_max(void)
 {
@@ -569,65 +800,244 @@ node_cpuid_max(void)
 }
 
 int
-node_qpi_init(void)
+node_distance(int from, int to)
+{
+	return (s_node_group.distance[from * nnodes_max + to]);
+}
+
+/*
+ * Weight each memory access by the distance to its target, in units
+ * of local accesses. The local accesses are at the node's own distance,
+ * the remote ones at the node's expected remote distance.
+ */
+double
+node_access_cost(count_value_t *countval_arr, int nid)
+{
+	node_t *node;
+	double cost = 0.0;
+	int i;
+
+	for (i = 0; i < nnodes_max; i++) {
+		node = node_get(i);
+		if (!NODE_VALID(node) || ((nid != NODE_ALL) && (nid != i))) {
+			continue;
+		}
+
+		cost += (double)countval_sum(countval_arr, i, UI_COUNT_LMA) *
+		    node_distance(i, i);
+		cost += (double)countval_sum(countval_arr, i, UI_COUNT_RMA) *
+		    node->remote_distance;
+	}
+
+	return (cost / NODE_DISTANCE_LOCAL);
+}
+
+/*
+ * The remote accesses which are expected to leave the socket. The
+ * accesses between the sub-NUMA nodes of a socket are not counted.
+ */
+double
+node_xsocket_access(count_value_t *countval_arr, int nid)
 {
-	qpi_info_t qpi_tmp[NODE_QPI_MAX];
-	int qpi_num, i;
 	node_t *node;
+	double value = 0.0;
+	int i;
 
-	qpi_num = os_sysfs_uncore_qpi_init(qpi_tmp, NODE_QPI_MAX);
-	if (qpi_num < 0)
-		return -1;
+	for (i = 0; i < nnodes_max; i++) {
+		node = node_get(i);
+		if (!NODE_VALID(node) || ((nid != NODE_ALL) && (nid != i))) {
+			continue;
+		}
 
-	if (qpi_num == 0) {
-		qpi_num = os_sysfs_uncore_upi_init(qpi_tmp, NODE_QPI_MAX);
-		if (qpi_num < 0)
-			return -1;
+		value += (double)countval_sum(countval_arr, i, UI_COUNT_RMA) *
+		    node->xsocket_ratio;
 	}
 
+	return (value);
+}
+
+static topo_domain_t *
+domain_get(topo_domain_t *arr, int *num, int size, int id)
+{
+	int i;
+
+	for (i = 0; i < *num; i++) {
+		if (arr[i].id == id) {
+			return (&arr[i]);
+		}
+	}
+
+	if (*num == size) {
+		return (NULL);
+	}
+
+	(void) memset(&arr[*num], 0, sizeof (topo_domain_t));
+	arr[*num].id = id;
+	arr[*num].nid = INVALID_NID;
+	return (&arr[(*num)++]);
+}
+
+static void
+domain_countval_add(topo_domain_t *domain, count_value_t *countval)
+{
+	int i;
+
+	for (i = 0; i < PERF_COUNT_NUM; i++) {
+		domain->countval.counts[i] += countval->counts[i];
+	}
+}
+
+static int
+domain_id_cmp(const void *a, const void *b)
+{
+	const topo_domain_t *d1 = (const topo_domain_t *)a;
+	const topo_domain_t *d2 = (const topo_domain_t *)b;
+
+	return ((d1->id > d2->id) - (d1->id < d2->id));
+}
+
+/*
+ * Sum up the perf data of the nodes per socket, or of the CPUs per LLC
+ * domain. Return the number of domains saved in "arr", in the order of
+ * their ids.
+ */
+int
+node_topo_domains(topo_level_t level, topo_domain_t *arr, int size)
+{
+	topo_domain_t *domain;
+	node_t *node;
+	perf_cpu_t *cpu;
+	int i, j, num = 0;
+
+	for (i = 0; i < nnodes_max; i++) {
+		node = node_get(i);
+		if (!NODE_VALID(node)) {
+			continue;
+		}
+
+		if (level == TOPO_LEVEL_SOCKET) {
+			if ((domain = domain_get(arr, &num, size,
+			    node->pkgid)) == NULL) {
+				break;
+			}
+
+			domain_countval_add(domain, &node->countval);
+			domain->nnodes++;
+			domain->ncpus += node->ncpus;
+			domain->mem_total += node->meminfo.mem_total;
+			domain->mem_free += node->meminfo.mem_free;
+			continue;
+		}
+
+		for (j = 0; j < ncpus_max; j++) {
+			cpu = &node->cpus[j];
+			if ((cpu->cpuid == INVALID_CPUID) || cpu->hotremove) {
+				continue;
+			}
+
+			if ((domain = domain_get(arr, &num, size,
+			    cpu->llcid)) == NULL) {
+				break;
+			}
+
+			/*
+			 * The nodes are walked in order, "nid" is the last
+			 * node counted until all the nodes are done.
+			 */
+			domain_countval_add(domain, &cpu->countval);
+			if ((domain->nnodes == 0) || (domain->nid != node->nid)) {
+				domain->nid = node->nid;
+				domain->nnodes++;
+			}
+
+			domain->ncpus++;
+		}
+	}
+
+	for (i = 0; i < num; i++) {
+		if (arr[i].nnodes > 1) {
+			arr[i].nid = INVALID_NID;
+		}
+	}
+
+	qsort(arr, num, sizeof (topo_domain_t), domain_id_cmp);
+	return (num);
+}
+
+/*
+ * The number of links is probed from sysfs, there is no fixed limit.
+ */
+int
+node_qpi_init(void)
+{
+	boolean_t upi = B_FALSE;
+	int qpi_num, i, ret = 0;
+	node_t *node;
+
+	if ((qpi_num = os_sysfs_uncore_num("uncore_qpi")) == 0) {
+		qpi_num = os_sysfs_uncore_num("uncore_upi");
+		upi = B_TRUE;
+	}
+
+	if (qpi_num == 0)
+		return 0;
+
 	node_group_lock();
 
 	for (i = 0; i < nnodes_max; i++) {
 		node = node_get(i);
-		if (NODE_VALID(node) && (qpi_num > 0)) {
-			memcpy(node->qpi.qpi_info, qpi_tmp,
-				sizeof(node->qpi.qpi_info));
-			node->qpi.qpi_num = qpi_num;
+		if (!NODE_VALID(node) || node->memory_only ||
+			(node->qpi.qpi_info != NULL))
+			continue;
+
+		if ((node->qpi.qpi_info = zalloc(qpi_num *
+			sizeof (qpi_info_t))) == NULL) {
+			ret = -1;
+			break;
 		}
+
+		node->qpi.qpi_num = upi ?
+			os_sysfs_uncore_upi_init(node->qpi.qpi_info, qpi_num) :
+			os_sysfs_uncore_qpi_init(node->qpi.qpi_info, qpi_num);
 	}
 
 	node_group_unlock();
 
 	debug_print(NULL, 2, "%d QPI/UPI links per node\n", qpi_num);
 
-	return 0;
+	return ret;
 }
 
 int
 node_imc_init(void)
 {
-	imc_info_t imc_tmp[NODE_IMC_MAX];
-	int imc_num, i;
+	int imc_num, i, ret = 0;
 	node_t *node;
 
-	imc_num = os_sysfs_uncore_imc_init(imc_tmp, NODE_IMC_MAX);
-	if (imc_num < 0)
-		return -1;
+	if ((imc_num = os_sysfs_uncore_num("uncore_imc")) == 0)
+		return 0;
 
 	node_group_lock();
 
 	for (i = 0; i < nnodes_max; i++) {
 		node = node_get(i);
-		if (NODE_VALID(node) && (imc_num > 0)) {
-			memcpy(node->imc.imc_info, imc_tmp,
-				sizeof(node->imc.imc_info));
-			node->imc.imc_num = imc_num;
+		if (!NODE_VALID(node) || node->memory_only ||
+			(node->imc.imc_info != NULL))
+			continue;
+
+		if ((node->imc.imc_info = zalloc(imc_num *
+			sizeof (imc_info_t))) == NULL) {
+			ret = -1;
+			break;
 		}
+
+		node->imc.imc_num = os_sysfs_uncore_imc_init(node->imc.imc_info,
+			imc_num);
 	}
 
 	node_group_unlock();
 
 	debug_print(NULL, 2, "%d memory controllers per node\n", imc_num);
 
-	return 0;
+	return ret;
 }
@@ -0,0 +1,405 @@
+/*
+ * Copyright (c) 2013, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Intel Corporation nor the names of its contributors
+ *     may be used to endorse or promote products derived from this software
+ *     without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * This file contains the routines to sample what the kernel does for
+ * NUMA: the automatic NUMA balancing and the memory tiering counters in
+ * '/proc/vmstat', the per-node 'numastat' and the NUMA balancing state
+ * of the busiest processes in '/proc/<pid>/sched'. The counters are
+ * turned into rates per second between two refreshes.
+ */
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <sys/types.h>
+#include "../include/types.h"
+#include "../include/util.h"
+#include "../include/proc.h"
+#include "../include/os/numastat.h"
+#include "../include/os/statfile.h"
+
+static const char *s_vm_name[NUMASTAT_VM_NUM] = {
+	"numa_pte_updates",
+	"numa_hint_faults",
+	"numa_hint_faults_local",
+	"numa_pages_migrated",
+	"pgpromote_success",
+	"pgpromote_candidate",
+	"pgdemote_kswapd",
+	"pgdemote_direct",
+	"pgdemote_khugepaged"
+};
+
+/*
+ * The names in the node's 'numastat', the promotion and demotion
+ * counters are in the node's 'vmstat'.
+ */
+static const char *s_node_name[NUMASTAT_NODE_PROMOTE] = {
+	"numa_hit",
+	"numa_miss",
+	"numa_foreign",
+	"local_node",
+	"other_node"
+};
+
+/*
+ * Only accessed from the display thread.
+ */
+static numastat_t s_stat;
+static uint64_t s_vm_last[NUMASTAT_VM_NUM];
+static uint64_t *s_node_last;
+static numastat_proc_t s_procs_last[NUMASTAT_NPROCS_MAX];
+static int s_nprocs_last;
+static uint64_t s_last_ms;
+
+/*
+ * The per-node 'numastat' and 'vmstat' files are at "nid * 2" and
+ * "nid * 2 + 1" of s_node_sf.
+ */
+static statfile_t s_vm_sf;
+static statfile_t s_balancing_sf;
+static statfile_t *s_node_sf;
+
+static double
+rate_get(uint64_t cur, uint64_t last, uint64_t intval_ms)
+{
+	if ((intval_ms == 0) || (cur < last)) {
+		return (0.0);
+	}
+
+	return ((double)(cur - last) * MS_SEC / (double)intval_ms);
+}
+
+/*
+ * Read the "name value" lines of a file. The value of a name in "names"
+ * is saved at the same index of "values".
+ */
+static int
+stat_file_read(statfile_t *sf, const char *path, const char **names,
+	int num, uint64_t *values, boolean_t *valid)
+{
+	char name[128], *buf, *line, *save = NULL;
+	uint64_t val;
+	int i;
+
+	if ((buf = statfile_get(sf, path)) == NULL) {
+		return (-1);
+	}
+
+	for (line = strtok_r(buf, "\n", &save); line != NULL;
+		line = strtok_r(NULL, "\n", &save)) {
+		if (sscanf(line, "%127s %" SCNu64, name, &val) != 2) {
+			continue;
+		}
+
+		for (i = 0; i < num; i++) {
+			if (strcmp(name, names[i]) == 0) {
+				values[i] = val;
+				valid[i] = B_TRUE;
+				break;
+			}
+		}
+	}
+
+	return (0);
+}
+
+/*
+ * The promotions are counted on the target node and the demotions on
+ * the source node.
+ */
+static void
+node_vmstat_read(int nid, uint64_t *values, boolean_t *valid)
+{
+	char path[PATH_MAX], name[128], *buf, *line, *save = NULL;
+	uint64_t val;
+
+	(void) snprintf(path, sizeof (path),
+		"/sys/devices/system/node/node%d/vmstat", nid);
+	if ((buf = statfile_get(&s_node_sf[nid * 2 + 1], path)) == NULL) {
+		return;
+	}
+
+	for (line = strtok_r(buf, "\n", &save); line != NULL;
+		line = strtok_r(NULL, "\n", &save)) {
+		if (sscanf(line, "%127s %" SCNu64, name, &val) != 2) {
+			continue;
+		}
+
+		if (strcmp(name, "pgpromote_success") == 0) {
+			values[NUMASTAT_NODE_PROMOTE] = val;
+			valid[NUMASTAT_NODE_PROMOTE] = B_TRUE;
+		} else if (strncmp(name, "pgdemote_", 9) == 0) {
+			values[NUMASTAT_NODE_DEMOTE] += val;
+			valid[NUMASTAT_NODE_DEMOTE] = B_TRUE;
+		}
+	}
+}
+
+static void
+node_refresh(uint64_t intval_ms)
+{
+	char path[PATH_MAX];
+	uint64_t values[NUMASTAT_NODE_NUM], *last;
+	boolean_t *valid;
+	int nid, i;
+
+	for (nid = 0; nid < nnodes_max; nid++) {
+		valid = NUMASTAT_NODE_VALID(&s_stat, nid);
+		(void) memset(valid, 0, sizeof (boolean_t) * NUMASTAT_NODE_NUM);
+		(void) memset(values, 0, sizeof (values));
+		(void) snprintf(path, sizeof (path),
+			"/sys/devices/system/node/node%d/numastat", nid);
+		if (stat_file_read(&s_node_sf[nid * 2], path, s_node_name,
+			NUMASTAT_NODE_PROMOTE, values, valid) != 0) {
+			continue;
+		}
+
+		node_vmstat_read(nid, values, valid);
+
+		last = &s_node_last[nid * NUMASTAT_NODE_NUM];
+		for (i = 0; i < NUMASTAT_NODE_NUM; i++) {
+			NUMASTAT_NODE_RATE(&s_stat, nid, i) =
+				rate_get(values[i], last[i], intval_ms);
+		}
+
+		(void) memcpy(last, values, sizeof (values));
+	}
+}
+
+/*
+ * The fields only exist with CONFIG_SCHED_DEBUG and
+ * CONFIG_NUMA_BALANCING.
+ */
+static void
+sched_read(numastat_proc_t *p, boolean_t *faults_valid,
+	boolean_t *migrated_valid)
+{
+	char path[PATH_MAX], line[256], name[128], *s;
+	FILE *fp;
+
+	p->cur_node = -1;
+	p->pref_node = -1;
+	*faults_valid = B_FALSE;
+	*migrated_valid = B_FALSE;
+
+	(void) snprintf(path, sizeof (path), "/proc/%d/sched", p->pid);
+	if ((fp = fopen(path, "r")) == NULL) {
+		return;
+	}
+
+	while (fgets(line, sizeof (line), fp) != NULL) {
+		if ((s = strstr(line, "current_node=")) != NULL) {
+			p->cur_node = atoi(s + strlen("current_node="));
+			continue;
+		}
+
+		if ((s = strchr(line, ':')) == NULL) {
+			continue;
+		}
+
+		*s++ = '\0';
+		if (sscanf(line, "%127s", name) != 1) {
+			continue;
+		}
+
+		if (strcmp(name, "numa_pages_migrated") == 0) {
+			p->migrated = strtoull(s, NULL, 10);
+			*migrated_valid = B_TRUE;
+		} else if (strcmp(name, "total_numa_faults") == 0) {
+			p->faults = strtoull(s, NULL, 10);
+			*faults_valid = B_TRUE;
+		} else if (strcmp(name, "numa_preferred_nid") == 0) {
+			p->pref_node = atoi(s);
+		}
+	}
+
+	(void) fclose(fp);
+}
+
+static numastat_proc_t *
+proc_last_find(pid_t pid)
+{
+	int i;
+
+	for (i = 0; i < s_nprocs_last; i++) {
+		if (s_procs_last[i].pid == pid) {
+			return (&s_procs_last[i]);
+		}
+	}
+
+	return (NULL);
+}
+
+/*
+ * The busiest processes by CPU utilization. The rate is -1 if there is
+ * no earlier reading of the process.
+ */
+static void
+proc_refresh(uint64_t intval_ms)
+{
+	numastat_proc_t *p, *last;
+	track_proc_t *proc;
+	boolean_t faults_valid, migrated_valid;
+	int nprocs, nlwps, i;
+
+	proc_lwp_count(&nprocs, &nlwps);
+	nprocs = MIN(nprocs, NUMASTAT_NPROCS_MAX);
+
+	/*
+	 * Don't hold the lock of the process table while reading '/proc'.
+	 */
+	proc_group_lock();
+	proc_resort(SORT_KEY_CPU);
+	for (i = 0; i < nprocs; i++) {
+		if ((proc = proc_sort_next()) == NULL) {
+			break;
+		}
+
+		p = &s_stat.procs[i];
+		(void) memset(p, 0, sizeof (numastat_proc_t));
+		p->pid = proc->pid;
+		(void) snprintf(p->name, NUMASTAT_NAME_SIZE, "%s", proc->name);
+	}
+
+	proc_group_unlock();
+	s_stat.nprocs = i;
+
+	for (i = 0; i < s_stat.nprocs; i++) {
+		p = &s_stat.procs[i];
+		sched_read(p, &faults_valid, &migrated_valid);
+		last = proc_last_find(p->pid);
+
+		p->faults_rate = -1.0;
+		if (faults_valid && (last != NULL)) {
+			p->faults_rate = rate_get(p->faults, last->faults,
+				intval_ms);
+		}
+
+		p->migrated_rate = -1.0;
+		if (migrated_valid && (last != NULL)) {
+			p->migrated_rate = rate_get(p->migrated, last->migrated,
+				intval_ms);
+		}
+	}
+
+	(void) memcpy(s_procs_last, s_stat.procs, sizeof (s_procs_last));
+	s_nprocs_last = s_stat.nprocs;
+}
+
+static int
+balancing_get(void)
+{
+	char *buf;
+
+	if ((buf = statfile_get(&s_balancing_sf,
+		"/proc/sys/kernel/numa_balancing")) == NULL) {
+		return (-1);
+	}
+
+	return (atoi(buf));
+}
+
+/*
+ * Sample all the counters and compute the rates since the last call.
+ * The rates of the first call are 0.
+ */
+numastat_t *
+numastat_refresh(void)
+{
+	uint64_t vm[NUMASTAT_VM_NUM], cur_ms, intval_ms;
+	int i;
+
+	if (s_stat.node == NULL) {
+		if (((s_stat.node = zalloc(sizeof (double) * nnodes_max *
+			NUMASTAT_NODE_NUM)) == NULL) ||
+			((s_stat.node_valid = zalloc(sizeof (boolean_t) *
+			nnodes_max * NUMASTAT_NODE_NUM)) == NULL) ||
+			((s_node_last = zalloc(sizeof (uint64_t) * nnodes_max *
+			NUMASTAT_NODE_NUM)) == NULL) ||
+			((s_node_sf = zalloc(sizeof (statfile_t) * nnodes_max *
+			2)) == NULL)) {
+			free(s_node_last);
+			free(s_stat.node_valid);
+			free(s_stat.node);
+			s_node_last = NULL;
+			s_stat.node_valid = NULL;
+			s_stat.node = NULL;
+			return (NULL);
+		}
+	}
+
+	cur_ms = current_ms(&g_tvbase);
+	intval_ms = (s_last_ms == 0) ? 0 : cur_ms - s_last_ms;
+
+	s_stat.balancing = balancing_get();
+
+	(void) memset(vm, 0, sizeof (vm));
+	(void) memset(s_stat.vm_valid, 0, sizeof (s_stat.vm_valid));
+	(void) stat_file_read(&s_vm_sf, "/proc/vmstat", s_vm_name,
+		NUMASTAT_VM_NUM, vm, s_stat.vm_valid);
+	for (i = 0; i < NUMASTAT_VM_NUM; i++) {
+		s_stat.vm[i] = rate_get(vm[i], s_vm_last[i], intval_ms);
+	}
+
+	(void) memcpy(s_vm_last, vm, sizeof (vm));
+
+	node_refresh(intval_ms);
+	proc_refresh(intval_ms);
+
+	s_last_ms = cur_ms;
+	return (&s_stat);
+}
+
+void
+numastat_fini(void)
+{
+	int i;
+
+	if (s_node_sf != NULL) {
+		for (i = 0; i < nnodes_max * 2; i++) {
+			statfile_close(&s_node_sf[i]);
+		}
+
+		free(s_node_sf);
+		s_node_sf = NULL;
+	}
+
+	statfile_close(&s_vm_sf);
+	statfile_close(&s_balancing_sf);
+	free(s_stat.node);
+	free(s_stat.node_valid);
+	free(s_node_last);
+	(void) memset(&s_stat, 0, sizeof (s_stat));
+	s_node_last = NULL;
+	s_nprocs_last = 0;
+	s_last_ms = 0;
+}
@@ -41,6 +41,7 @@
 #include "../include/disp.h"
 #include "../include/os/map.h"
 #include "../include/os/os_cmd.h"
+#include "../include/os/cgroup.h"
 
 static int s_callchain_ui_countid[] = {
 	UI_COUNT_RMA,
@@ -53,6 +54,7 @@ int
 os_preop_switch2profiling(cmd_t *cmd __attribute__((unused)), boolean_t *smpl)
 {
 	*smpl = B_FALSE;
+	cgroup_fini();
 
 	if (perf_pqos_cmt_started()) {
 		perf_pqos_cmt_stop(0, 0);
@@ -65,7 +67,10 @@ os_preop_switch2profiling(cmd_t *cmd __attribute__((unused)), boolean_t *smpl)
 	}
 
 	if (!perf_profiling_started()) {
-		perf_allstop();
+		if (!g_perf_concurrent) {
+			perf_allstop();
+		}
+
 		if (perf_profiling_start() != 0) {
 			return (-1);	
 		}
@@ -81,7 +86,10 @@ os_preop_switch2ll(cmd_t *cmd __attribute__((unused)), boolean_t *smpl)
 {
 	*smpl = B_FALSE;
 	if (!perf_ll_started()) {
-		perf_allstop();
+		if (!g_perf_concurrent) {
+			perf_allstop();
+		}
+
 		if (perf_ll_start(0) != 0) {
 			return (-1);
 		}
@@ -189,6 +197,141 @@ os_preop_switch2accdst(cmd_t *cmd,
 	return (0);
 }
 
+int
+os_preop_switch2heatmap(cmd_t *cmd,
+	boolean_t *smpl __attribute__((unused)))
+{
+	page_t *cur = page_current_get();
+	win_type_t type = PAGE_WIN_TYPE(cur);
+
+	switch (type) {
+	case WIN_TYPE_LAT_PROC:
+		CMD_HEATMAP(cmd)->pid = DYN_LAT(cur)->pid;
+		CMD_HEATMAP(cmd)->lwpid = 0;
+		break;
+
+	case WIN_TYPE_LAT_LWP:
+		CMD_HEATMAP(cmd)->pid = DYN_LAT(cur)->pid;
+		CMD_HEATMAP(cmd)->lwpid = DYN_LAT(cur)->lwpid;
+		break;
+
+	default:
+		return (-1);
+	}
+
+	return (0);
+}
+
+int
+os_preop_switch2contend(cmd_t *cmd,
+	boolean_t *smpl __attribute__((unused)))
+{
+	page_t *cur = page_current_get();
+	win_type_t type = PAGE_WIN_TYPE(cur);
+
+	switch (type) {
+	case WIN_TYPE_LAT_PROC:
+		CMD_CONTEND(cmd)->pid = DYN_LAT(cur)->pid;
+		CMD_CONTEND(cmd)->lwpid = 0;
+		break;
+
+	case WIN_TYPE_LAT_LWP:
+		CMD_CONTEND(cmd)->pid = DYN_LAT(cur)->pid;
+		CMD_CONTEND(cmd)->lwpid = DYN_LAT(cur)->lwpid;
+		break;
+
+	default:
+		return (-1);
+	}
+
+	return (0);
+}
+
+int
+os_preop_switch2damon(cmd_t *cmd,
+	boolean_t *smpl __attribute__((unused)))
+{
+	page_t *cur = page_current_get();
+
+	if (PAGE_WIN_TYPE(cur) != WIN_TYPE_MONIPROC) {
+		return (-1);
+	}
+
+	CMD_DAMON(cmd)->pid = DYN_MONI_PROC(cur)->pid;
+	return (0);
+}
+
+/*
+ * Plan the migration of the hot pages of the selected range in the
+ * memory area node breakdown window, or of all sampled pages in the
+ * memory access node distribution window.
+ */
+int
+os_preop_migrate(cmd_t *cmd __attribute__((unused)),
+	boolean_t *smpl __attribute__((unused)))
+{
+	page_t *cur = page_current_get();
+	dyn_latnode_t *latnode;
+	dyn_accdst_t *accdst;
+	lat_line_t *lines;
+	int highlight;
+
+	switch (PAGE_WIN_TYPE(cur)) {
+	case WIN_TYPE_LATNODE_PROC:
+	case WIN_TYPE_LATNODE_LWP:
+		latnode = DYN_LATNODE(cur);
+		lines = (lat_line_t *)(latnode->data.buf);
+		highlight = latnode->data.scroll.highlight;
+		if ((lines != NULL) && (highlight >= 0) &&
+			(highlight < latnode->data.nlines_total)) {
+			return (os_migrate_start(&latnode->migrate, latnode->pid,
+				latnode->lwpid, lines[highlight].bufaddr.addr,
+				lines[highlight].bufaddr.size));
+		}
+
+		return (os_migrate_start(&latnode->migrate, latnode->pid,
+			latnode->lwpid, latnode->addr, latnode->size));
+
+	case WIN_TYPE_ACCDST_PROC:
+	case WIN_TYPE_ACCDST_LWP:
+		accdst = DYN_ACCDST(cur);
+		return (os_migrate_start(&accdst->migrate, accdst->pid,
+			accdst->lwpid, 0, 0));
+
+	default:
+		return (-1);
+	}
+}
+
+int
+os_preop_switch2advisor(cmd_t *cmd, boolean_t *smpl)
+{
+	page_t *cur = page_current_get();
+
+	if (PAGE_WIN_TYPE(cur) != WIN_TYPE_TOPNLWP) {
+		return (-1);
+	}
+
+	CMD_ADVISOR(cmd)->pid = DYN_TOPNLWP(cur)->pid;
+	return (os_preop_switch2ll(cmd, smpl));
+}
+
+/*
+ * Bind the highlighted thread in advisor window to the recommended node.
+ */
+int
+os_preop_bind(cmd_t *cmd __attribute__((unused)),
+	boolean_t *smpl __attribute__((unused)))
+{
+	page_t *cur = page_current_get();
+
+	if (PAGE_WIN_TYPE(cur) != WIN_TYPE_ADVISOR) {
+		return (-1);
+	}
+
+	return (os_advisor_bind(DYN_ADVISOR(cur)));
+}
+
 int
 os_preop_leavecallchain(cmd_t *cmd __attribute__((unused)), boolean_t *smpl)
 {
@@ -233,6 +376,7 @@ os_preop_switch2pqoscmt(cmd_t *cmd,
 
 	case WIN_TYPE_PQOS_MBM_MONIPROC:
 	case WIN_TYPE_PQOS_MBM_MONILWP:
+	case WIN_TYPE_PQOS_MBM_TOPNPROC:
 		CMD_PQOS_CMT(cmd)->pid = DYN_PQOS_MBM_PROC(cur)->pid;
 		CMD_PQOS_CMT(cmd)->lwpid = DYN_PQOS_MBM_PROC(cur)->lwpid;
 		CMD_PQOS_CMT(cmd)->flags = PERF_PQOS_FLAG_LLC;
@@ -268,7 +412,9 @@ os_preop_switch2pqosmbm(cmd_t *cmd,
 	win_type_t type = PAGE_WIN_TYPE(cur);
 	int ret = 0;
 
-	if ((type == WIN_TYPE_PQOS_CMT_MONIPROC) || (type == WIN_TYPE_PQOS_CMT_MONILWP)) {
+	if ((type == WIN_TYPE_PQOS_CMT_MONIPROC) ||
+	    (type == WIN_TYPE_PQOS_CMT_MONILWP) ||
+	    (type == WIN_TYPE_PQOS_CMT_TOPNPROC)) {
 
 		if (perf_profiling_smpl(B_FALSE) != 0)
 			return -1;
@@ -282,8 +428,13 @@ os_preop_switch2pqosmbm(cmd_t *cmd,
 
 		perf_pqos_cmt_stop(CMD_PQOS_MBM(cmd)->pid, CMD_PQOS_MBM(cmd)->lwpid);
 
-		ret = perf_pqos_proc_setup(CMD_PQOS_MBM(cmd)->pid,
-			CMD_PQOS_MBM(cmd)->lwpid, CMD_PQOS_MBM(cmd)->flags);
+		if (CMD_PQOS_MBM(cmd)->pid == 0) {
+			ret = perf_pqos_active_proc_setup(
+				CMD_PQOS_MBM(cmd)->flags, B_FALSE);
+		} else {
+			ret = perf_pqos_proc_setup(CMD_PQOS_MBM(cmd)->pid,
+				CMD_PQOS_MBM(cmd)->lwpid, CMD_PQOS_MBM(cmd)->flags);
+		}
 	}
 
 	return (ret);
@@ -312,6 +463,54 @@ os_preop_switch2uncore(cmd_t *cmd,
 	return (ret);
 }
 
+/*
+ * Stop all the sampling and count the uncore events on all nodes.
+ */
+int
+os_preop_switch2uncoreall(cmd_t *cmd __attribute__((unused)),
+	boolean_t *smpl)
+{
+	*smpl = B_FALSE;
+	perf_allstop();
+
+	if (perf_uncore_setup(NODE_ALL) != 0) {
+		return (-1);
+	}
+
+	*smpl = B_TRUE;
+	return (0);
+}
+
+/*
+ * The uncore window is the home window in uncore-only mode, there is
+ * nothing to go back to then.
+ */
+int
+os_preop_leaveuncore(cmd_t *cmd, boolean_t *smpl)
+{
+	if (page_curprev_get() == NULL) {
+		*smpl = B_FALSE;
+		return (0);
+	}
+
+	return (os_preop_switch2profiling(cmd, smpl));
+}
+
+/*
+ * The cgroup window shares the monitor groups with the PQoS windows,
+ * it can't be opened while they hold any.
+ */
+int
+os_preop_switch2cgroup(cmd_t *cmd __attribute__((unused)),
+	boolean_t *smpl __attribute__((unused)))
+{
+	if (perf_pqos_cmt_started()) {
+		perf_pqos_cmt_stop(0, 0);
+	}
+
+	return (0);
+}
+
 int
 os_op_llmap_stop(cmd_t *cmd __attribute__((unused)),
 	boolean_t smpl __attribute__((unused)))
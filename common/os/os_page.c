@@ -61,6 +61,12 @@ os_page_smpl_start(page_t *page)
 	case CMD_NODE_OVERVIEW_ID:
 		/* fall through */
 	case CMD_CALLCHAIN_ID:
+		/* fall through */
+	case CMD_DAMON_ID:
+		/* fall through */
+	case CMD_CGROUP_ID:
+		/* fall through */
+	case CMD_NUMASTAT_ID:
 		if (perf_profiling_smpl(B_TRUE) == 0) {
 			return (B_TRUE);
 		}
@@ -78,6 +84,12 @@ os_page_smpl_start(page_t *page)
 
 		return B_TRUE;
 
+	case CMD_UNCORE_ID:
+		if (perf_uncore_smpl(NODE_ALL) == 0) {
+			return (B_TRUE);
+		}
+		break;
+
 	case CMD_LAT_ID:
 		/* fall through */
 	case CMD_LLCALLCHAIN_ID:
@@ -85,6 +97,12 @@ os_page_smpl_start(page_t *page)
 	case CMD_LATNODE_ID:
 		/* fall through */
 	case CMD_ACCDST_ID:
+		/* fall through */
+	case CMD_HEATMAP_ID:
+		/* fall through */
+	case CMD_CONTEND_ID:
+		/* fall through */
+	case CMD_ADVISOR_ID:
 		if (perf_ll_smpl(0, 0) == 0) {
 			return (B_TRUE);
 		}
@@ -120,8 +138,13 @@ os_page_smpl_start(page_t *page)
 		if (disp_flag2_wait() != DISP_FLAG_PROFILING_DATA_READY)
 			break;
 
-		if (perf_pqos_cmt_smpl(CMD_PQOS_CMT(cmd)->pid,
-			CMD_PQOS_CMT(cmd)->lwpid) != 0)
+		if (type == WIN_TYPE_PQOS_MBM_TOPNPROC) {
+			perf_pqos_active_proc_setup(CMD_PQOS_MBM(cmd)->flags,
+				B_TRUE);
+		}
+
+		if (perf_pqos_cmt_smpl(CMD_PQOS_MBM(cmd)->pid,
+			CMD_PQOS_MBM(cmd)->lwpid) != 0)
 			break;
 
 		return B_TRUE;
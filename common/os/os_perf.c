@@ -32,6 +32,8 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <string.h>
+#include <time.h>
+#include <pthread.h>
 #include "../include/types.h"
 #include "../include/proc.h"
 #include "../include/lwp.h"
@@ -41,9 +43,11 @@
 #include "../include/ui_perf_map.h"
 #include "../include/os/pfwrapper.h"
 #include "../include/os/node.h"
+#include "../include/os/map.h"
 #include "../include/os/plat.h"
 #include "../include/os/os_perf.h"
 #include "../include/os/os_util.h"
+#include "../include/os/resctrl.h"
 
 precise_type_t g_precise;
 
@@ -53,9 +57,18 @@ typedef struct _profiling_conf {
 
 static pf_profiling_rec_t *s_profiling_recbuf = NULL;
 static pf_ll_rec_t *s_ll_recbuf = NULL;
+static pf_mmap_recbuf_t s_ll_mmapbuf;
 static profiling_conf_t s_profiling_conf;
 static pf_conf_t s_ll_conf;
 static boolean_t s_partpause_enabled;
+static boolean_t s_profiling_armed;
+static boolean_t s_ll_armed;
+static boolean_t s_profiling_opened;
+static boolean_t s_ll_opened;
+static uint64_t s_pqos_seq;
+static uint64_t s_ll_seq;
+
+static void exclusive_stop(void);
 
 static boolean_t
 event_valid(perf_cpu_t *cpu)
@@ -79,6 +92,24 @@ cpu_op(perf_cpu_t *cpu, pfn_pf_event_op_t op)
 	}
 }
 
+static boolean_t
+ll_event_valid(perf_cpu_t *cpu)
+{
+	return (cpu->ll_map_base != MAP_FAILED);
+}
+
+static void
+cpu_ll_op(perf_cpu_t *cpu, pfn_pf_event_op_t op)
+{
+	if (!ll_event_valid(cpu)) {
+		return;
+	}
+
+	if (op(cpu) != 0) {
+		pf_ll_resource_free(cpu);
+	}
+}
+
 static void
 cpu_init(perf_cpu_t *cpu)
 {
@@ -91,6 +122,13 @@ cpu_init(perf_cpu_t *cpu)
 	cpu->map_base = MAP_FAILED;
 }
 
+static void
+cpu_ll_init(perf_cpu_t *cpu)
+{
+	cpu->ll_fd = INVALID_FD;
+	cpu->ll_map_base = MAP_FAILED;
+}
+
 static int
 cpu_profiling_setup(perf_cpu_t *cpu,
 	void *arg __attribute__((unused)))
@@ -144,6 +182,14 @@ cpu_resource_free(perf_cpu_t *cpu,
 	return (0);
 }
 
+static int
+cpu_ll_resource_free(perf_cpu_t *cpu,
+	void *arg __attribute__((unused)))
+{	
+	pf_ll_resource_free(cpu);
+	return (0);
+}
+
 static void
 countval_diff_base(perf_cpu_t *cpu, pf_profiling_rec_t *record)
 {
@@ -177,25 +223,53 @@ countval_diff(perf_cpu_t *cpu, pf_profiling_rec_t *record,
 	}
 }
 
+static perf_chainrec_t *
+chainrec_alloc(uint64_t count_value, uint64_t *ips, int ip_num)
+{
+	perf_chainrec_t *rec;
+
+	if ((rec = malloc(sizeof (perf_chainrec_t) +
+		ip_num * sizeof (uint64_t))) == NULL) {
+		return (NULL);
+	}
+
+	rec->ref_count = 1;
+	rec->count_value = count_value;
+	rec->callchain.ip_num = ip_num;
+	memcpy(rec->callchain.ips, ips, ip_num * sizeof (uint64_t));
+	return (rec);
+}
+
+/*
+ * Offer the record to the reservoir of group, the group takes a
+ * reference if the record is kept.
+ */
 static int
-chain_add(perf_countchain_t *count_chain, int perf_count_id, uint64_t count_value,
-	uint64_t *ips, int ip_num)
+chain_add(perf_countchain_t *count_chain, int perf_count_id,
+	perf_chainrec_t *rec)
 {
 	perf_chainrecgrp_t *grp;
-	perf_chainrec_t *rec;
+	int i;
 
 	grp = &count_chain->chaingrps[perf_count_id];
 	
-	if (array_alloc((void **)&grp->rec_arr, &grp->nrec_cur, &grp->nrec_max,
-		sizeof (perf_chainrec_t), PERF_REC_NUM) != 0) {
-		return (-1);
+	if ((i = perf_rec_slot(&grp->nrec_seen, grp->nrec_cur)) < 0) {
+		return (0);
 	}
 
-	rec = &(grp->rec_arr[grp->nrec_cur]);
-	rec->count_value = count_value;
-	rec->callchain.ip_num = ip_num;
-	memcpy(rec->callchain.ips, ips, IP_NUM * sizeof (uint64_t));
-	grp->nrec_cur++;
+	if (i == grp->nrec_cur) {
+		if (array_alloc((void **)&grp->rec_arr, &grp->nrec_cur,
+			&grp->nrec_max, sizeof (perf_chainrec_t *), PERF_REC_NUM) != 0) {
+			return (-1);
+		}
+
+		grp->nrec_cur++;
+	} else {
+		perf_chainrec_put(grp->rec_arr[i]);
+	}
+
+	__sync_add_and_fetch(&rec->ref_count, 1);
+	grp->rec_arr[i] = rec;
 	return (0);
 }
 
@@ -204,6 +278,7 @@ cpu_profiling_smpl(perf_cpu_t *cpu,
 	void *arg __attribute__((unused)))
 {
 	pf_profiling_rec_t *record;
+	perf_chainrec_t *chainrec;
 	track_proc_t *proc;
 	track_lwp_t *lwp;
 	node_t *node;
@@ -253,6 +328,7 @@ cpu_profiling_smpl(perf_cpu_t *cpu,
 				proc_countval_update(proc, cpu->cpuid, j, diff.counts[j]);			
 				lwp_countval_update(lwp, cpu->cpuid, j, diff.counts[j]);
 				node_countval_update(node, j, diff.counts[j]);
+				cpu->countval.counts[j] += diff.counts[j];
 			}
 
 			if ((record->ip_num > 0) &&
@@ -262,11 +338,12 @@ cpu_profiling_smpl(perf_cpu_t *cpu,
 				 * The event is overflowed. The call-chain represents
 				 * the context when event is overflowed.
 				 */
-				chain_add(&proc->count_chain, j, diff.counts[j], record->ips,
-					record->ip_num);
-
-				chain_add(&lwp->count_chain, j, diff.counts[j], record->ips,
-					record->ip_num);
+				if ((chainrec = chainrec_alloc(diff.counts[j],
+					record->ips, record->ip_num)) != NULL) {
+					chain_add(&proc->count_chain, j, chainrec);
+					chain_add(&lwp->count_chain, j, chainrec);
+					perf_chainrec_put(chainrec);
+				}
 			}
 		}		
 
@@ -392,24 +469,72 @@ cpu_profiling_multi_restore(perf_cpu_t *cpu, void *arg)
 	return (0);
 }
 
+/*
+ * Reuse the events which are opened yet. The events are reopened if
+ * the CPU is hot-added or they were freed on an error.
+ */
+static int
+cpu_profiling_reset(perf_cpu_t *cpu,
+	void *arg __attribute__((unused)))
+{
+	int i;
+
+	if (!event_valid(cpu)) {
+		return (cpu_profiling_setup(cpu, NULL));
+	}
+
+	pf_profiling_allstop(cpu);
+
+	/*
+	 * Discard the existing records in ring buffer and enable the
+	 * members which might be paused by the partpause.
+	 */
+	pf_profiling_record(cpu, NULL, NULL);
+
+	for (i = 1; i < PERF_COUNT_NUM; i++) {
+		pf_profiling_start(cpu, i);
+	}
+
+	return (0);
+}
+
 static int
 cpu_ll_setup(perf_cpu_t *cpu,
 	void *arg __attribute__((unused)))
 {
-	cpu_init(cpu);
+	cpu_ll_init(cpu);
 	if (pf_ll_setup(cpu, &s_ll_conf) != 0) {
-		pf_resource_free(cpu);
+		pf_ll_resource_free(cpu);
 		return (-1);
 	}
 
 	return (0);
 }
 
+static int
+cpu_ll_reset(perf_cpu_t *cpu,
+	void *arg __attribute__((unused)))
+{
+	int record_num;
+
+	if (!ll_event_valid(cpu)) {
+		return (cpu_ll_setup(cpu, NULL));
+	}
+
+	pf_ll_stop(cpu);
+
+	/*
+	 * Discard the existing records in ring buffer.
+	 */
+	pf_ll_record(cpu, NULL, &record_num, NULL);
+	return (0);
+}
+
 static int
 cpu_ll_start(perf_cpu_t *cpu,
 	void *arg __attribute__((unused)))
 {
-	cpu_op(cpu, pf_ll_start);	
+	cpu_ll_op(cpu, pf_ll_start);	
 	return (0);
 }
 
@@ -417,44 +542,127 @@ static int
 cpu_ll_stop(perf_cpu_t *cpu,
 	void *arg __attribute__((unused)))
 {
-	cpu_op(cpu, pf_ll_stop);	
+	cpu_ll_op(cpu, pf_ll_stop);	
 	return (0);
 }
 
-static int
-llrec_add(perf_llrecgrp_t *grp, pf_ll_rec_t *record)
+static os_perf_llrec_t *
+llrec_alloc(pf_ll_rec_t *record)
 {
 	os_perf_llrec_t *llrec;
 
-	if (array_alloc((void **)(&grp->rec_arr), &grp->nrec_cur, &grp->nrec_max,
-		sizeof (os_perf_llrec_t), PERF_REC_NUM) != 0) {
-		return (-1);
+	if ((llrec = malloc(sizeof (os_perf_llrec_t) +
+		record->ip_num * sizeof (uint64_t))) == NULL) {
+		return (NULL);
 	}
 
-	llrec = &(grp->rec_arr[grp->nrec_cur]);
+	/*
+	 * The reservoir doesn't keep the records in arrival order, the
+	 * sequence number tells which one is the latest.
+	 */
+	llrec->ref_count = 1;
+	llrec->seq = ++s_ll_seq;
 	llrec->addr = record->addr;
 	llrec->cpu = record->cpu;
 	llrec->latency = record->latency;
+	llrec->mem_src = record->mem_src;
+	llrec->hitm = record->hitm;
 	llrec->callchain.ip_num = record->ip_num;
-	memcpy(llrec->callchain.ips, record->ips, IP_NUM * sizeof (uint64_t));
-	grp->nrec_cur++;
+	memcpy(llrec->callchain.ips, record->ips,
+		record->ip_num * sizeof (uint64_t));
+	return (llrec);
+}
+
+/*
+ * Offer the record to the reservoir of group, the group takes a
+ * reference if the record is kept.
+ */
+static int
+llrec_add(perf_llrecgrp_t *grp, os_perf_llrec_t *llrec)
+{
+	int i;
+
+	if ((i = perf_rec_slot(&grp->nrec_seen, grp->nrec_cur)) < 0) {
+		return (0);
+	}
+
+	if (i == grp->nrec_cur) {
+		if (array_alloc((void **)(&grp->rec_arr), &grp->nrec_cur,
+			&grp->nrec_max, sizeof (os_perf_llrec_t *), PERF_REC_NUM) != 0) {
+			return (-1);
+		}
+
+		grp->nrec_cur++;
+	} else {
+		perf_llrec_put(grp->rec_arr[i]);
+	}
+
+	__sync_add_and_fetch(&llrec->ref_count, 1);
+	grp->rec_arr[i] = llrec;
 	return (0);
 }
 
+/*
+ * Queue the mappings reported by PERF_RECORD_MMAP2 to the tracked
+ * processes.
+ */
+static void
+ll_mmap_update(pf_mmap_recbuf_t *mmap_buf)
+{
+	pf_mmap_rec_t *record;
+	track_proc_t *proc;
+	int i;
+
+	if (mmap_buf->lost) {
+		proc_map_lost();
+	}
+
+	for (i = 0; i < mmap_buf->nrec_cur; i++) {
+		record = &mmap_buf->rec_arr[i];
+		if ((proc = proc_find(record->pid)) == NULL) {
+			continue;
+		}
+
+		map_event_add(proc, record->addr, record->len, record->prot,
+			record->flags, record->path);
+		proc_refcount_dec(proc);
+	}
+
+	mmap_buf->nrec_cur = 0;
+	mmap_buf->lost = B_FALSE;
+}
+
 static int
 cpu_ll_smpl(perf_cpu_t *cpu, void *arg)
 {
 	task_ll_t *task = (task_ll_t *)arg;
 	pf_ll_rec_t *record;
+	os_perf_llrec_t *llrec;
 	track_proc_t *proc;
 	track_lwp_t *lwp;
-	int record_num, i;
+	node_t *node;
+	int record_num, i, nid;
+
+	if (!ll_event_valid(cpu)) {
+		return (0);
+	}
+
+	if (s_ll_mmapbuf.rec_arr != NULL) {
+		pf_ll_record(cpu, s_ll_recbuf, &record_num, &s_ll_mmapbuf);
+		ll_mmap_update(&s_ll_mmapbuf);
+	} else {
+		pf_ll_record(cpu, s_ll_recbuf, &record_num, NULL);
+	}
 
-	pf_ll_record(cpu, s_ll_recbuf, &record_num);
 	if (record_num == 0) {
 		return (0);
 	}
 
+	/*
+	 * All the records in the ring buffer are sampled on this CPU.
+	 */
+	nid = ((node = node_by_cpu(cpu->cpuid)) != NULL) ? node->nid : -1;
+
 	for (i = 0; i < record_num; i++) {
 		record = &s_ll_recbuf[i];
 		if ((task->pid != 0) && (task->pid != (int)record->pid)) {
@@ -477,8 +685,15 @@ cpu_ll_smpl(perf_cpu_t *cpu, void *arg)
 
 		pthread_mutex_lock(&proc->mutex);
 
-		llrec_add(&proc->llrec_grp, record);
-		llrec_add(&lwp->llrec_grp, record);
+		if ((llrec = llrec_alloc(record)) != NULL) {
+			llrec_add(&proc->llrec_grp, llrec);
+			llrec_add(&lwp->llrec_grp, llrec);
+			if (proc->map.heatmap.arr != NULL) {
+				map_heatmap_add(proc, record->tid, nid, llrec);
+			}
+
+			perf_llrec_put(llrec);
+		}
 
  		pthread_mutex_unlock(&proc->mutex);
  		lwp_refcount_dec(lwp);
@@ -506,21 +721,42 @@ profiling_pause(void)
 	return (0);
 }
 
+/*
+ * The events are only disabled, they are kept opened to be reused by
+ * the next profiling_start().
+ */
 static int
 profiling_stop(void)
 {
 	profiling_pause();
-	node_cpu_traverse(cpu_resource_free, NULL, B_FALSE, NULL);
+	s_profiling_armed = B_FALSE;
 	return (0);
 }
 
+static void
+profiling_free(void)
+{
+	profiling_pause();
+	node_cpu_traverse(cpu_resource_free, NULL, B_FALSE, NULL);
+	s_profiling_armed = B_FALSE;
+	s_profiling_opened = B_FALSE;
+}
+
 static int
 profiling_start(perf_ctl_t *ctl,
 	task_profiling_t *task __attribute__((unused)))
 {
-	/* Setup perf on each CPU. */
-	if (node_cpu_traverse(cpu_profiling_setup, NULL, B_TRUE, NULL) != 0) {
-		return (-1);
+	s_profiling_armed = B_TRUE;
+	if (s_profiling_opened) {
+		if (node_cpu_traverse(cpu_profiling_reset, NULL, B_TRUE, NULL) != 0) {
+			return (-1);
+		}
+	} else {
+		/* Setup perf on each CPU. */
+		s_profiling_opened = B_TRUE;
+		if (node_cpu_traverse(cpu_profiling_setup, NULL, B_TRUE, NULL) != 0) {
+			return (-1);
+		}
 	}
 
 	profiling_pause();
@@ -595,15 +831,31 @@ profiling_multi_restore(perf_ctl_t *ctl, task_multi_restore_t *task)
 static int
 ll_start(perf_ctl_t *ctl)
 {
-	/* Setup perf on each CPU. */
-	if (node_cpu_traverse(cpu_ll_setup, NULL, B_TRUE, NULL) != 0) {
-		return (-1);
+	s_ll_armed = B_TRUE;
+	if (s_ll_opened) {
+		if (node_cpu_traverse(cpu_ll_reset, NULL, B_TRUE, NULL) != 0) {
+			return (-1);
+		}
+	} else {
+		/* Setup perf on each CPU. */
+		s_ll_opened = B_TRUE;
+		if (node_cpu_traverse(cpu_ll_setup, NULL, B_TRUE, NULL) != 0) {
+			return (-1);
+		}
+	}
+
+	/*
+	 * The mmap records are not generated when the event is disabled
+	 * or not opened yet, so the tracked maps might be stale.
+	 */
+	if (s_ll_mmapbuf.rec_arr != NULL) {
+		proc_map_lost();
 	}
 
 	/* Start to count on each CPU. */
 	node_cpu_traverse(cpu_ll_start, NULL, B_FALSE, NULL);
 
-	ctl->last_ms = current_ms(&g_tvbase);
+	ctl->last_ms_ll = current_ms(&g_tvbase);
 	return (0);
 }
 
@@ -611,23 +863,74 @@ static int
 ll_stop(void)
 {
 	node_cpu_traverse(cpu_ll_stop, NULL, B_FALSE, NULL);
-	node_cpu_traverse(cpu_resource_free, NULL, B_FALSE, NULL);
+	s_ll_armed = B_FALSE;
 	return (0);	
 }
 
+static void
+ll_free(void)
+{
+	node_cpu_traverse(cpu_ll_stop, NULL, B_FALSE, NULL);
+	node_cpu_traverse(cpu_ll_resource_free, NULL, B_FALSE, NULL);
+	s_ll_armed = B_FALSE;
+	s_ll_opened = B_FALSE;
+}
+
 static int
 ll_smpl(perf_ctl_t *ctl, task_ll_t *task, int *intval_ms)
 {
-	*intval_ms = current_ms(&g_tvbase) - ctl->last_ms;
+	*intval_ms = current_ms(&g_tvbase) - ctl->last_ms_ll;
 	proc_intval_update(*intval_ms);
 	node_cpu_traverse(cpu_ll_smpl, (void *)task, B_FALSE, cpu_ll_setupstart);
-	ctl->last_ms = current_ms(&g_tvbase);
+	ctl->last_ms_ll = current_ms(&g_tvbase);
 	return (0);	
 }
 
+/*
+ * In concurrent mode, the events of the windows which are not shown
+ * are drained at the same interval, so both data sets stay current.
+ */
+static void
+concurrent_ll_smpl(perf_ctl_t *ctl)
+{
+	task_ll_t task;
+	int intval_ms;
+
+	if (!g_perf_concurrent || !s_ll_armed) {
+		return;
+	}
+
+	(void) memset(&task, 0, sizeof (task_ll_t));
+	proc_ll_clear(NULL);
+	(void) ll_smpl(ctl, &task, &intval_ms);
+}
+
+static void
+concurrent_profiling_smpl(perf_ctl_t *ctl)
+{
+	int intval_ms;
+
+	if (!g_perf_concurrent || !s_profiling_armed) {
+		return;
+	}
+
+	proc_callchain_clear();
+	proc_profiling_clear();
+	node_profiling_clear();
+	(void) profiling_smpl(ctl, NULL, &intval_ms);
+}
+
 boolean_t
 os_profiling_started(perf_ctl_t *ctl)
 {
+	/*
+	 * Stopping the uncore counting reports the profiling status
+	 * back, even if it was the only thing running (uncore-only mode).
+	 */
+	if (!s_profiling_armed) {
+		return (B_FALSE);
+	}
+
 	if ((ctl->status == PERF_STATUS_PROFILING_PART_STARTED) ||
 		(ctl->status == PERF_STATUS_PROFILING_STARTED) ||
 		(ctl->status == PERF_STATUS_PQOS_CMT_STARTED)) {
@@ -647,16 +950,34 @@ os_profiling_start(perf_ctl_t *ctl, perf_task_t *task)
 		return (0);
 	}
 
-	os_allstop();
-	proc_ll_clear(NULL);
+	if (g_perf_concurrent) {
+		/*
+		 * The profiling events are kept armed while the LL windows
+		 * are shown, so the switch back doesn't lose any data.
+		 */
+		exclusive_stop();
+		if (s_profiling_armed) {
+			perf_status_set(PERF_STATUS_PROFILING_STARTED);
+			return (0);
+		}
+	} else {
+		os_allstop();
+		proc_ll_clear(NULL);
+	}
 
 	if (profiling_start(ctl, (task_profiling_t *)(task)) != 0) {
 		exit_msg_put("Fail to setup perf (probably permission denied or need to increase the ulimit)!\n");
 		debug_print(NULL, 2, "os_profiling_start failed\n");
+		profiling_free();
 		perf_status_set(PERF_STATUS_PROFILING_FAILED);
 		return (-1);
 	}
 
+	if (g_perf_concurrent && !s_ll_armed && (ll_start(ctl) != 0)) {
+		debug_print(NULL, 2, "concurrent ll_start is failed\n");
+		ll_free();
+	}
+
 	debug_print(NULL, 2, "os_profiling_start success\n");	
 	perf_status_set(PERF_STATUS_PROFILING_STARTED);
 	return (0);
@@ -677,6 +998,7 @@ os_profiling_smpl(perf_ctl_t *ctl, perf_task_t *task, int *intval_ms)
 	proc_callchain_clear();
 	proc_profiling_clear();
 	node_profiling_clear();
+	concurrent_ll_smpl(ctl);
 
 	if (profiling_smpl(ctl, t, intval_ms) != 0) {
 		perf_status_set(PERF_STATUS_PROFILING_FAILED);
@@ -757,20 +1079,35 @@ int
 os_ll_start(perf_ctl_t *ctl,
 	perf_task_t *task __attribute__((unused)))
 {
-	os_allstop();
-	proc_callchain_clear();
-	proc_profiling_clear();
-	node_profiling_clear();
+	if (g_perf_concurrent) {
+		exclusive_stop();
+		if (s_ll_armed) {
+			perf_status_set(PERF_STATUS_LL_STARTED);
+			return (0);
+		}
+	} else {
+		os_allstop();
+		proc_callchain_clear();
+		proc_profiling_clear();
+		node_profiling_clear();
+	}
 
 	if (ll_start(ctl) != 0) {
 		/*
 		 * It could be failed if the kernel doesn't support PEBS LL.
 		 */
 		debug_print(NULL, 2, "ll_start is failed\n");
+		ll_free();
 		perf_status_set(PERF_STATUS_LL_FAILED);
 		return (-1);
 	}
 
+	if (g_perf_concurrent && !s_profiling_armed &&
+		(profiling_start(ctl, NULL) != 0)) {
+		debug_print(NULL, 2, "concurrent profiling_start is failed\n");
+		profiling_free();
+	}
+
 	debug_print(NULL, 2, "ll_start success\n");
 	perf_status_set(PERF_STATUS_LL_STARTED);
 	return (0);
@@ -784,6 +1121,7 @@ os_ll_smpl(perf_ctl_t *ctl, perf_task_t *task, int *intval_ms)
 	}
 
 	proc_enum_update(0);
+	concurrent_profiling_smpl(ctl);
 	proc_ll_clear(0);
 
 	if (ll_smpl(ctl, (task_ll_t *)(task), intval_ms) != 0) {
@@ -842,6 +1180,7 @@ ll_init(pf_conf_t *conf)
 	conf->config1 = cfg.extra_value;
 	conf->sample_period = cfg.sample_period;
 	conf->exclude_guest = cfg.exclude_guest;
+	conf->mmap_track = (s_ll_mmapbuf.rec_arr != NULL);
 
 	/* If sample period is not set, choose a default value */
 	if (!cfg.sample_period)
@@ -856,6 +1195,7 @@ os_perf_init(void)
 
 	s_profiling_recbuf = NULL;
 	s_ll_recbuf = NULL;
+	memset(&s_ll_mmapbuf, 0, sizeof (pf_mmap_recbuf_t));
 	s_partpause_enabled = B_FALSE;
 
 	/*
@@ -891,6 +1231,18 @@ os_perf_init(void)
 		return (-1);
 	}
 
+	if (g_map_incremental) {
+		/*
+		 * Not fatal, fall back to reread the maps file.
+		 */
+		if ((s_ll_mmapbuf.rec_arr = zalloc(PF_MMAP_REC_NUM *
+			sizeof (pf_mmap_rec_t))) != NULL) {
+			s_ll_mmapbuf.nrec_max = PF_MMAP_REC_NUM;
+		} else {
+			g_map_incremental = B_FALSE;
+		}
+	}
+
 	ll_init(&s_ll_conf);
 	return (0);	
 }
@@ -907,6 +1259,11 @@ os_perf_fini(void)
 		free(s_ll_recbuf);
 		s_ll_recbuf = NULL;	
 	}
+
+	if (s_ll_mmapbuf.rec_arr != NULL) {
+		free(s_ll_mmapbuf.rec_arr);
+		memset(&s_ll_mmapbuf, 0, sizeof (pf_mmap_recbuf_t));
+	}
 }
 
 void
@@ -1007,11 +1364,15 @@ void
 os_perf_countchain_reset(perf_countchain_t *count_chain)
 {
 	perf_chainrecgrp_t *grp;
-	int i;
+	int i, j;
 	
 	for (i = 0; i < PERF_COUNT_NUM; i++) {
 		grp = &count_chain->chaingrps[i];
 		if (grp->rec_arr != NULL) {
+			for (j = 0; j < grp->nrec_cur; j++) {
+				perf_chainrec_put(grp->rec_arr[j]);
+			}
+
 			free(grp->rec_arr);	
 		}
 	}
@@ -1019,12 +1380,220 @@ os_perf_countchain_reset(perf_countchain_t *count_chain)
 	memset(count_chain, 0, sizeof (perf_countchain_t));
 }
 
+/*
+ * The burst sampler reads the uncore counters of the node shown in
+ * the node detail window every UNCORE_BURST_MS, so the bandwidth bursts
+ * which are averaged away in a display interval can be reported.
+ */
+typedef struct _uncore_burst_ctl {
+	pthread_t thr;
+	pthread_mutex_t thr_mutex;
+	pthread_mutex_t mutex;
+	boolean_t running;
+	volatile boolean_t quit;
+	node_t *node;
+	int head;
+	int num;
+	double mem[UNCORE_BURST_NUM];
+	double link[UNCORE_BURST_NUM];
+} uncore_burst_ctl_t;
+
+static uncore_burst_ctl_t s_burst = {
+	.thr_mutex = PTHREAD_MUTEX_INITIALIZER,
+	.mutex = PTHREAD_MUTEX_INITIALIZER
+};
+
+static uint64_t
+burst_now_ns(void)
+{
+	struct timespec ts;
+
+	(void) clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * NS_SEC + (uint64_t)ts.tv_nsec);
+}
+
+static void *
+uncore_burst_handler(void *arg __attribute__((unused)))
+{
+	struct timespec intval = { 0, UNCORE_BURST_MS * NS_MS };
+	uint64_t cas, flits, cas_last, flits_last, ts, ts_last;
+	double secs;
+	int i;
+
+	while (pf_uncore_burst_read(s_burst.node, &cas_last,
+		&flits_last) != 0) {
+		if (s_burst.quit) {
+			return (NULL);
+		}
+
+		(void) nanosleep(&intval, NULL);
+	}
+
+	ts_last = burst_now_ns();
+
+	while (!s_burst.quit) {
+		(void) nanosleep(&intval, NULL);
+		if (pf_uncore_burst_read(s_burst.node, &cas, &flits) != 0) {
+			continue;
+		}
+
+		ts = burst_now_ns();
+		if ((ts <= ts_last) || (cas < cas_last) || (flits < flits_last)) {
+			continue;
+		}
+
+		secs = (double)(ts - ts_last) / (double)NS_SEC;
+
+		(void) pthread_mutex_lock(&s_burst.mutex);
+		if (s_burst.num < UNCORE_BURST_NUM) {
+			i = (s_burst.head + s_burst.num) % UNCORE_BURST_NUM;
+			s_burst.num++;
+		} else {
+			/* Overwrite the oldest one. */
+			i = s_burst.head;
+			s_burst.head = (s_burst.head + 1) % UNCORE_BURST_NUM;
+		}
+
+		s_burst.mem[i] = (double)((cas - cas_last) * 64) / secs;
+		s_burst.link[i] = (double)((flits - flits_last) * 8) / secs;
+		(void) pthread_mutex_unlock(&s_burst.mutex);
+
+		cas_last = cas;
+		flits_last = flits;
+		ts_last = ts;
+	}
+
+	return (NULL);
+}
+
+/*
+ * The sampler is started by the perf thread and can be stopped by the
+ * node refresh as well, "thr_mutex" serializes them.
+ */
+static void
+uncore_burst_start(node_t *node)
+{
+	(void) pthread_mutex_lock(&s_burst.thr_mutex);
+	if (s_burst.running) {
+		(void) pthread_mutex_unlock(&s_burst.thr_mutex);
+		return;
+	}
+
+	s_burst.node = node;
+	s_burst.quit = B_FALSE;
+	s_burst.head = 0;
+	s_burst.num = 0;
+	memset(&node->imc.burst, 0, sizeof (uncore_burst_t));
+	memset(&node->qpi.burst, 0, sizeof (uncore_burst_t));
+
+	if (pthread_create(&s_burst.thr, NULL, uncore_burst_handler,
+		NULL) != 0) {
+		debug_print(NULL, 2, "uncore_burst_start: pthread_create failed\n");
+	} else {
+		s_burst.running = B_TRUE;
+	}
+
+	(void) pthread_mutex_unlock(&s_burst.thr_mutex);
+}
+
+/*
+ * Stop the sampler if it reads the node, or whatever node it reads if
+ * "node" is NULL.
+ */
+static void
+burst_stop(node_t *node)
+{
+	(void) pthread_mutex_lock(&s_burst.thr_mutex);
+	if (s_burst.running && ((node == NULL) || (s_burst.node == node))) {
+		s_burst.quit = B_TRUE;
+		(void) pthread_join(s_burst.thr, NULL);
+		s_burst.running = B_FALSE;
+	}
+
+	(void) pthread_mutex_unlock(&s_burst.thr_mutex);
+}
+
+static void
+uncore_burst_stop(void)
+{
+	burst_stop(NULL);
+}
+
+/*
+ * The uncore events of node are going to be freed, e.g. the node is
+ * hot-removed.
+ */
+void
+os_uncore_burst_stop(node_t *node)
+{
+	burst_stop(node);
+}
+
+static int
+burst_cmp(const void *a, const void *b)
+{
+	double d1 = *(const double *)a, d2 = *(const double *)b;
+
+	if (d1 < d2) {
+		return (-1);
+	}
+
+	return ((d1 > d2) ? 1 : 0);
+}
+
+static void
+burst_stat(double *arr, int num, uncore_burst_t *burst)
+{
+	double sum = 0.0;
+	int i;
+
+	memset(burst, 0, sizeof (uncore_burst_t));
+	if (num == 0) {
+		return;
+	}
+
+	qsort(arr, num, sizeof (double), burst_cmp);
+	for (i = 0; i < num; i++) {
+		sum += arr[i];
+	}
+
+	burst->nsamples = num;
+	burst->peak = arr[num - 1];
+	burst->p99 = arr[(num * 99 + 99) / 100 - 1];
+	burst->mean = sum / num;
+}
+
+/*
+ * Summarize the burst samples taken since the last display interval
+ * and start a new interval.
+ */
+static void
+uncore_burst_update(node_t *node)
+{
+	if (!s_burst.running || (s_burst.node != node)) {
+		return;
+	}
+
+	(void) pthread_mutex_lock(&s_burst.mutex);
+	/*
+	 * The order of samples doesn't matter for the statistics, so the
+	 * ring is sorted in place.
+	 */
+	burst_stat(s_burst.mem, s_burst.num, &node->imc.burst);
+	burst_stat(s_burst.link, s_burst.num, &node->qpi.burst);
+	s_burst.head = 0;
+	s_burst.num = 0;
+	(void) pthread_mutex_unlock(&s_burst.mutex);
+}
+
 static int
 uncore_stop_all(void)
 {
 	node_t *node;
 	int i;
 
+	uncore_burst_stop();
+
 	for (i = 0; i < nnodes_max; i++) {
 		node = node_get(i);
 		if (NODE_VALID(node)) {
@@ -1039,23 +1608,51 @@ uncore_stop_all(void)
 	return 0;
 }
 
+/*
+ * Stop the counting which can't run together with the profiling or
+ * the LL sampling.
+ */
+static void
+exclusive_stop(void)
+{
+	if (perf_pqos_cmt_started()) {
+		proc_pqos_func(NULL, os_pqos_cmt_proc_free);
+	}
+
+	if (perf_uncore_started()) {
+		uncore_stop_all();
+	}
+}
+
 void
 os_allstop(void)
 {
-	if (perf_profiling_started()) {
+	if (s_profiling_armed) {
 		profiling_stop();
 	}
 
-	if (perf_ll_started()) {
+	if (s_ll_armed) {
 		ll_stop();				
 	}
 
-	if (perf_pqos_cmt_started()) {
-		proc_pqos_func(NULL, os_pqos_cmt_proc_free);
+	exclusive_stop();
+}
+
+/*
+ * Stop all and release the events kept opened for reuse.
+ */
+void
+os_allfree(void)
+{
+	os_allstop();
+	uncore_burst_stop();
+
+	if (s_profiling_opened) {
+		profiling_free();
 	}
 
-	if (perf_uncore_started()) {
-		uncore_stop_all();
+	if (s_ll_opened) {
+		ll_free();
 	}
 }
 
@@ -1119,6 +1716,7 @@ os_perf_cpuarr_init(perf_cpu_t *cpu_arr, int num, boolean_t hotadd)
 		cpu_arr[i].cpuid = INVALID_CPUID;
 		cpu_arr[i].hotadd = hotadd;
 		cpu_init(&cpu_arr[i]);		
+		cpu_ll_init(&cpu_arr[i]);
 	}
 }
 
@@ -1194,6 +1792,8 @@ os_perf_cpuarr_refresh(perf_cpu_t *cpu_arr, int cpu_num, int *cpuid_arr,
 				cpu_arr[j].fds[k] = INVALID_FD;
 			}
 
+			cpu_ll_init(&cpu_arr[j]);
+
 			cpu_arr[j].hit = B_TRUE;
 			cpu_arr[j].hotadd = !init;
 
@@ -1243,8 +1843,13 @@ pqos_cmt_start(perf_ctl_t *ctl __attribute__((unused)),
 		proc->lwp_pqosed = B_TRUE;
 	}
 
-	memset(pqos, 0, sizeof(perf_pqos_t));
+	/*
+	 * The last values are kept, so a process which waits for its turn
+	 * in the rotation still shows what it had.
+	 */
+	os_sysfs_cmt_task_free(pqos);
 	pqos->flags = flags;
+	pqos->seq = ++s_pqos_seq;
 
 	ret = os_sysfs_cmt_task_set(pid, lwpid, pqos);
 
@@ -1340,9 +1945,31 @@ os_pqos_cmt_smpl(perf_ctl_t *ctl, perf_task_t *task, int *intval_ms)
 void
 os_perf_pqos_free(perf_pqos_t *pqos)
 {
+	os_sysfs_cmt_task_free(pqos);
 	pf_pqos_resource_free(pqos);
 }
 
+/*
+ * Give the monitor group back to the pool but keep the last values.
+ */
+void
+os_perf_pqos_release(perf_pqos_t *pqos)
+{
+	os_sysfs_cmt_task_free(pqos);
+}
+
+int
+os_perf_pqos_nfree(void)
+{
+	return (resctrl_pool_nfree());
+}
+
+int
+os_perf_pqos_size(void)
+{
+	return (resctrl_pool_size());
+}
+
 static int pqos_record(struct _perf_pqos *pqos)
 {
 	if (pqos->task_id == 0)
@@ -1376,7 +2003,7 @@ os_pqos_cmt_lwp_free(track_lwp_t *lwp __attribute__((unused)),
 	boolean_t *end)
 {
 	*end = B_FALSE;
-	/* os_perf_pqos_free(&lwp->pqos); */
+	os_perf_pqos_free(&lwp->pqos);
 	return 0;
 }
 
@@ -1385,7 +2012,7 @@ int os_pqos_cmt_proc_free(struct _track_proc *proc,
 	boolean_t *end)
 {
 	*end = B_FALSE;
-	/* os_perf_pqos_free(&proc->pqos); */
+	os_perf_pqos_free(&proc->pqos);
 
 	if (proc->lwp_pqosed) {
 		proc_lwp_traverse(proc, os_pqos_cmt_lwp_free, NULL);
@@ -1404,36 +2031,18 @@ os_perf_pqos_cmt_started(perf_ctl_t *ctl)
 	return (B_FALSE);
 }
 
+/*
+ * A single process or thread keeps its monitor group when it's stopped,
+ * it's set up again right after that when switching between the LLC
+ * occupancy and the memory bandwidth windows.
+ */
 int os_pqos_proc_stop(perf_ctl_t *ctl __attribute__((unused)),
 	perf_task_t *task)
 {
 	task_pqos_cmt_t *t = (task_pqos_cmt_t *)task;
-	track_proc_t *proc;
-	track_lwp_t *lwp = NULL;
-	boolean_t end;
 
 	if (t->pid == 0)
 		proc_pqos_func(NULL, os_pqos_cmt_proc_free);
-	else {
-		if ((proc = proc_find(t->pid)) == NULL)
-			return -1;
-
-		if (t->lwpid == 0)
-			os_pqos_cmt_proc_free(proc, NULL, &end);
-		else {
-			if ((lwp = proc_lwp_find(proc, t->lwpid)) == NULL) {
-				proc_refcount_dec(proc);
-				return -1;
-			}
-
-			os_pqos_cmt_lwp_free(lwp, NULL, &end);
-		}
-
-		if (lwp != NULL)
-			lwp_refcount_dec(lwp);
-
-		proc_refcount_dec(proc);
-	}
 
 	return (0);
 }
@@ -1445,6 +2054,8 @@ int os_uncore_stop(perf_ctl_t *ctl __attribute__((unused)),
 	node_t *node;
 	int i;
 	
+	uncore_burst_stop();
+
 	if (t->nid >= 0) {
 		node = node_get(t->nid);
 		if (NODE_VALID(node)) {
@@ -1470,16 +2081,11 @@ int os_uncore_stop(perf_ctl_t *ctl __attribute__((unused)),
 	return 0;
 }
 
-static int uncore_start(perf_ctl_t *ctl __attribute__((unused)),
-	int nid)
+static int
+uncore_node_start(node_t *node)
 {
-	node_t *node;
 	int ret = -1;
-	
-	node = node_get(nid);
-	if (!NODE_VALID(node))
-		return -1;
-	
+
 	if (pf_uncoreqpi_setup(node) != 0)
 		goto L_EXIT;
 	
@@ -1503,6 +2109,39 @@ L_EXIT:
 	return ret;
 }
 
+/*
+ * Start the uncore counting on one node, or on all nodes if "nid" is
+ * NODE_ALL. The burst sampler only follows a single node.
+ */
+static int uncore_start(perf_ctl_t *ctl __attribute__((unused)),
+	int nid)
+{
+	node_t *node;
+	int i;
+
+	if (nid != NODE_ALL) {
+		node = node_get(nid);
+		if (!NODE_VALID(node) || node->memory_only ||
+			(uncore_node_start(node) != 0))
+			return -1;
+
+		uncore_burst_start(node);
+		return 0;
+	}
+
+	for (i = 0; i < nnodes_max; i++) {
+		node = node_get(i);
+		/* A memory-only node has no uncore PMU of its own */
+		if (NODE_VALID(node) && !node->memory_only &&
+			(uncore_node_start(node) != 0)) {
+			uncore_stop_all();
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
 int
 os_uncore_start(perf_ctl_t *ctl, perf_task_t *task)
 {
@@ -1516,33 +2155,55 @@ os_uncore_start(perf_ctl_t *ctl, perf_task_t *task)
 		return (-1);
 	}
 
+	ctl->last_ms_uncore = current_ms(&g_tvbase);
 	perf_status_set(PERF_STATUS_UNCORE_STARTED);
 	return (0);
 }
 
+static int
+uncore_node_smpl(node_t *node)
+{
+	int ret;
+
+	if ((ret = pf_uncoreqpi_smpl(node)) != 0)
+		return ret;
+
+	return (pf_uncoreimc_smpl(node));
+}
+
 int
-os_uncore_smpl(perf_ctl_t *ctl __attribute__((unused)),
-	perf_task_t *task, int *intval_ms)
+os_uncore_smpl(perf_ctl_t *ctl, perf_task_t *task, int *intval_ms)
 {
 	task_uncore_t *t = (task_uncore_t *)task;
 	node_t *node;
-	int ret;
+	int ret = 0, i;
 
-	node = node_get(t->nid);
-	if (!NODE_VALID(node))
-		return -1;
+	*intval_ms = current_ms(&g_tvbase) - ctl->last_ms_uncore;
+	ctl->last_ms_uncore = current_ms(&g_tvbase);
 
-	ret = pf_uncoreqpi_smpl(node);
-	if (ret != 0) {
-		disp_profiling_data_fail();
-		return ret;
+	if (t->nid != NODE_ALL) {
+		node = node_get(t->nid);
+		if (!NODE_VALID(node))
+			return -1;
+
+		if ((ret = uncore_node_smpl(node)) == 0)
+			uncore_burst_update(node);
+	} else {
+		for (i = 0; i < nnodes_max; i++) {
+			node = node_get(i);
+			if (NODE_VALID(node) && !node->memory_only &&
+				((ret = uncore_node_smpl(node)) != 0)) {
+				break;
+			}
+		}
 	}
 
-	ret = pf_uncoreimc_smpl(node);
-	if (ret == 0)
+	if (ret == 0) {
 		disp_profiling_data_ready(*intval_ms);
-	else
+	}
+	else {
 		disp_profiling_data_fail();
+	}
 
 	return (ret);
 }
@@ -42,16 +42,17 @@
 #include <limits.h>
 #include <locale.h>
 #include <math.h>
-#include <ftw.h>
 #include <sys/wait.h>
 #include <sys/mount.h>
 #include "../include/types.h"
 #include "../include/util.h"
 #include "../include/os/os_util.h"
+#include "../include/os/resctrl.h"
+#include "../include/os/cgroup.h"
+#include "../include/os/statfile.h"
 
 uint64_t g_clkofsec;
 double g_nsofclk;
-unsigned int g_pqos_moni_id;
 
 boolean_t
 os_authorized(void)
@@ -105,6 +106,45 @@ os_procfs_pname_get(pid_t pid, char *buf, int size)
 	return (0);
 }
 
+/*
+ * Retrieve the process's cgroup v2 path from '/proc', e.g.
+ * "0::/system.slice/docker-<id>.scope".
+ */
+int
+os_procfs_cgroup_get(pid_t pid, char *buf, int size)
+{
+	char path[PATH_MAX], line[PATH_MAX];
+	FILE *fp;
+	int len, ret = -1;
+
+	(void) snprintf(path, sizeof (path), "/proc/%d/cgroup", pid);
+	if ((fp = fopen(path, "r")) == NULL) {
+		return (-1);
+	}
+
+	while (fgets(line, sizeof (line), fp) != NULL) {
+		if (strncmp(line, "0::", 3) != 0) {
+			continue;
+		}
+
+		len = strlen(line + 3);
+		if ((len > 0) && (line[len + 2] == '\n')) {
+			line[len + 2] = '\0';
+			len--;
+		}
+
+		if ((len > 0) && (len < size)) {
+			(void) strcpy(buf, line + 3);
+			ret = 0;
+		}
+
+		break;
+	}
+
+	(void) fclose(fp);
+	return (ret);
+}
+
 /*
  * Retrieve the lwpid in process from '/proc'.
  */
@@ -167,6 +207,81 @@ processor_unbind(void)
 	return (0);
 }
 
+/*
+ * Bind a thread of any process to the CPUs of node.
+ */
+int
+os_lwp_node_bind(int lwpid, node_t *node)
+{
+	cpu_set_t cs;
+	int i, n = 0;
+
+	CPU_ZERO (&cs);
+	for (i = 0; i < ncpus_max; i++) {
+		if ((node->cpus[i].cpuid != INVALID_CPUID) &&
+			(node->cpus[i].cpuid < CPU_SETSIZE)) {
+			CPU_SET (node->cpus[i].cpuid, &cs);
+			n++;
+		}
+	}
+
+	if (n == 0) {
+		return (-1);
+	}
+
+	if (sched_setaffinity(lwpid, sizeof (cs), &cs) < 0) {
+		debug_print(NULL, 2, "Fail to bind thread %d to node %d\n",
+			lwpid, node->nid);
+		return (-1);
+	}
+
+	return (0);
+}
+
+/*
+ * Read the busy and total time (in clock ticks) of each CPU from
+ * '/proc/stat'. The arrays are indexed by CPU id.
+ */
+int
+os_procfs_cpu_time(uint64_t *busy, uint64_t *total, int ncpus)
+{
+	FILE *fp;
+	char buf[LINE_SIZE];
+	uint64_t v[8];
+	int cpuid, i;
+
+	if ((fp = fopen("/proc/stat", "r")) == NULL) {
+		return (-1);
+	}
+
+	(void) memset(busy, 0, sizeof (uint64_t) * ncpus);
+	(void) memset(total, 0, sizeof (uint64_t) * ncpus);
+
+	while (fgets(buf, LINE_SIZE, fp) != NULL) {
+		(void) memset(v, 0, sizeof (v));
+		if (sscanf(buf, "cpu%d %"SCNu64" %"SCNu64" %"SCNu64" %"SCNu64
+			" %"SCNu64" %"SCNu64" %"SCNu64" %"SCNu64, &cpuid,
+			&v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6],
+			&v[7]) < 5) {
+			continue;
+		}
+
+		if ((cpuid < 0) || (cpuid >= ncpus)) {
+			continue;
+		}
+
+		for (i = 0; i < 8; i++) {
+			total[cpuid] += v[i];
+		}
+
+		/* idle and iowait */
+		busy[cpuid] = total[cpuid] - v[3] - v[4];
+	}
+
+	fclose(fp);
+	return (0);
+}
+
 static int
 calibrate_cpuinfo(double *nsofclk, uint64_t *clkofsec)
 {
@@ -452,10 +567,25 @@ file_int_extract(char *path, int *arr, int arr_size, int *num)
 	return (str_int_extract(buf, arr, arr_size, num));
 }
 
+/*
+ * The files read at every refresh stay opened, see statfile.c.
+ */
+static statfile_t s_node_online_sf;
+static statfile_t s_cpu_online_sf;
+static statfile_t *s_meminfo_sf;
+static char *s_node_online_last;
+static char *s_cpu_online_last;
+
 boolean_t
 os_sysfs_node_enum(int *node_arr, int arr_size, int *num)
 {
-	return (file_int_extract(NODE_NONLINE_PATH, node_arr, arr_size, num));
+	char *buf;
+
+	if ((buf = statfile_get(&s_node_online_sf, NODE_NONLINE_PATH)) == NULL) {
+		return (B_FALSE);
+	}
+
+	return (str_int_extract(buf, node_arr, arr_size, num));
 }
 
 boolean_t
@@ -467,18 +597,60 @@ os_sysfs_cpu_enum(int nid, int *cpu_arr, int arr_size, int *num)
 	return (file_int_extract(path, cpu_arr, arr_size, num));
 }
 
+/*
+ * Read the SLIT distances from a node to each online node, e.g.
+ * "10 21 31". The distances are in the order of the online node ids.
+ */
+boolean_t
+os_sysfs_node_distance(int nid, int *dist_arr, int arr_size, int *num)
+{
+	char path[PATH_MAX], buf[LINE_SIZE], *p, *end;
+	FILE *fp;
+	int n = 0;
+	long d;
+
+	snprintf(path, PATH_MAX, "%s/node%d/distance", NODE_INFO_ROOT, nid);
+	if ((fp = fopen(path, "r")) == NULL) {
+		return (B_FALSE);
+	}
+
+	if (fgets(buf, LINE_SIZE, fp) == NULL) {
+		fclose(fp);
+		return (B_FALSE);
+	}
+
+	fclose(fp);
+
+	p = buf;
+	while (n < arr_size) {
+		d = strtol(p, &end, 10);
+		if (end == p) {
+			break;
+		}
+
+		dist_arr[n++] = (int)d;
+		p = end;
+	}
+
+	*num = n;
+	return (n > 0);
+}
+
 int
 os_sysfs_online_ncpus(void)
 {
 	int *cpu_arr, num, ret = -1;
-	char path[PATH_MAX];
+	char *buf;
 
 	cpu_arr = (int *) malloc(ncpus_max * sizeof(int));
 	if (!cpu_arr)
 		return (-1);
 
-	snprintf(path, PATH_MAX, "/sys/devices/system/cpu/online");
-	if (!file_int_extract(path, cpu_arr, ncpus_max, &num)) {
+	if ((buf = statfile_get(&s_cpu_online_sf, CPU_ONLINE_PATH)) == NULL) {
+		goto L_EXIT;
+	}
+
+	if (!str_int_extract(buf, cpu_arr, ncpus_max, &num)) {
 		goto L_EXIT;
 	}
 
@@ -489,6 +661,152 @@ L_EXIT:
 	return (ret);
 }
 
+static boolean_t
+file_int_get(const char *path, int *val)
+{
+	FILE *fp;
+	boolean_t ret;
+
+	if ((fp = fopen(path, "r")) == NULL) {
+		return (B_FALSE);
+	}
+
+	ret = (fscanf(fp, "%d", val) == 1);
+	fclose(fp);
+	return (ret);
+}
+
+int
+os_sysfs_cpu_pkgid(int cpuid)
+{
+	char path[PATH_MAX];
+	int pkgid;
+
+	snprintf(path, PATH_MAX, "%s/cpu%d/topology/physical_package_id",
+		CPU_INFO_ROOT, cpuid);
+	if (!file_int_get(path, &pkgid)) {
+		return (-1);
+	}
+
+	return (pkgid);
+}
+
+/*
+ * The LLC of a CPU is its cache of the highest level. The cache "id" is
+ * unique among the caches of a level; the first CPU sharing the cache
+ * stands for it if the kernel doesn't report the "id".
+ */
+int
+os_sysfs_cpu_llcid(int cpuid)
+{
+	char path[PATH_MAX];
+	int *cpu_arr, i, level, llc_idx = -1, llc_level = -1, id = -1, num;
+
+	for (i = 0; ; i++) {
+		snprintf(path, PATH_MAX, "%s/cpu%d/cache/index%d/level",
+			CPU_INFO_ROOT, cpuid, i);
+		if (!file_int_get(path, &level)) {
+			break;
+		}
+
+		if (level >= llc_level) {
+			llc_level = level;
+			llc_idx = i;
+		}
+	}
+
+	if (llc_idx < 0) {
+		return (-1);
+	}
+
+	snprintf(path, PATH_MAX, "%s/cpu%d/cache/index%d/id",
+		CPU_INFO_ROOT, cpuid, llc_idx);
+	if (file_int_get(path, &id)) {
+		return (id);
+	}
+
+	if ((cpu_arr = zalloc(ncpus_max * sizeof (int))) == NULL) {
+		return (-1);
+	}
+
+	snprintf(path, PATH_MAX, "%s/cpu%d/cache/index%d/shared_cpu_list",
+		CPU_INFO_ROOT, cpuid, llc_idx);
+	if (file_int_extract(path, cpu_arr, ncpus_max, &num) && (num > 0)) {
+		id = cpu_arr[0];
+	}
+
+	free(cpu_arr);
+	return (id);
+}
+
+static boolean_t
+online_changed(statfile_t *sf, const char *path, char **last)
+{
+	char *buf;
+
+	if ((buf = statfile_get(sf, path)) == NULL) {
+		return (B_TRUE);
+	}
+
+	if ((*last != NULL) && (strcmp(*last, buf) == 0)) {
+		return (B_FALSE);
+	}
+
+	free(*last);
+	*last = strdup(buf);
+	return (B_TRUE);
+}
+
+/*
+ * Check if the online nodes or CPUs have changed since the last call.
+ * Hotplug always shows up in one of the two masks, so the per-node
+ * topology only needs to be enumerated again when this returns B_TRUE.
+ */
+boolean_t
+os_sysfs_topo_changed(void)
+{
+	boolean_t node_changed, cpu_changed;
+
+	node_changed = online_changed(&s_node_online_sf, NODE_NONLINE_PATH,
+	    &s_node_online_last);
+	cpu_changed = online_changed(&s_cpu_online_sf, CPU_ONLINE_PATH,
+	    &s_cpu_online_last);
+
+	return (node_changed || cpu_changed);
+}
+
+/*
+ * Forget the saved online masks, so the next os_sysfs_topo_changed()
+ * returns B_TRUE. It's called if the re-enumeration has failed.
+ */
+void
+os_sysfs_topo_reset(void)
+{
+	free(s_node_online_last);
+	free(s_cpu_online_last);
+	s_node_online_last = NULL;
+	s_cpu_online_last = NULL;
+}
+
+void
+os_sysfs_fini(void)
+{
+	int i;
+
+	if (s_meminfo_sf != NULL) {
+		for (i = 0; i < nnodes_max; i++) {
+			statfile_close(&s_meminfo_sf[i]);
+		}
+
+		free(s_meminfo_sf);
+		s_meminfo_sf = NULL;
+	}
+
+	statfile_close(&s_node_online_sf);
+	statfile_close(&s_cpu_online_sf);
+	os_sysfs_topo_reset();
+}
+
 static boolean_t
 memsize_parse(char *str, uint64_t *size)
 {
@@ -511,23 +829,26 @@ memsize_parse(char *str, uint64_t *size)
 boolean_t
 os_sysfs_meminfo(int nid, node_meminfo_t *info)
 {
-	FILE *fp;
 	char path[PATH_MAX];
-	char *line = NULL;
-	size_t len = 0;
-	boolean_t ret = B_FALSE;
+	char *buf, *line, *save = NULL;
 	int num = sizeof (node_meminfo_t) / sizeof (uint64_t), i = 0;
 
 	memset(info, 0, sizeof (node_meminfo_t));	
+	if ((s_meminfo_sf == NULL) &&
+	    ((s_meminfo_sf = zalloc(nnodes_max * sizeof (statfile_t))) == NULL)) {
+		return (B_FALSE);
+	}
+
 	snprintf(path, PATH_MAX, "%s/node%d/meminfo", NODE_INFO_ROOT, nid);
-	if ((fp = fopen(path, "r")) == NULL) {
+	if ((buf = statfile_get(&s_meminfo_sf[nid], path)) == NULL) {
 		return (B_FALSE);
 	}
 
-	while ((getline(&line, &len, fp) > 0) && (i < num)) {
+	for (line = strtok_r(buf, "\n", &save); (line != NULL) && (i < num);
+	    line = strtok_r(NULL, "\n", &save)) {
 		if (strstr(line, "MemTotal:") != NULL) {
 			if (!memsize_parse(line, &info->mem_total)) {
-				goto L_EXIT;
+				return (B_FALSE);
 			}
 			i++;
 			continue;
@@ -535,7 +856,7 @@ os_sysfs_meminfo(int nid, node_meminfo_t *info)
 
 		if (strstr(line, "MemFree:") != NULL) {
 			if (!memsize_parse(line, &info->mem_free)) {
-				goto L_EXIT;
+				return (B_FALSE);
 			}
 			i++;
 			continue;
@@ -543,7 +864,7 @@ os_sysfs_meminfo(int nid, node_meminfo_t *info)
 
 		if (strstr(line, "Active:") != NULL) {
 			if (!memsize_parse(line, &info->active)) {
-				goto L_EXIT;
+				return (B_FALSE);
 			}
 			i++;
 			continue;
@@ -551,7 +872,7 @@ os_sysfs_meminfo(int nid, node_meminfo_t *info)
 
 		if (strstr(line, "Inactive:") != NULL) {			
 			if (!memsize_parse(line, &info->inactive)) {
-				goto L_EXIT;
+				return (B_FALSE);
 			}
 			i++;
 			continue;
@@ -559,7 +880,7 @@ os_sysfs_meminfo(int nid, node_meminfo_t *info)
 
 		if (strstr(line, "Dirty:") != NULL) {
 			if (!memsize_parse(line, &info->dirty)) {
-				goto L_EXIT;
+				return (B_FALSE);
 			}
 			i++;
 			continue;
@@ -567,7 +888,7 @@ os_sysfs_meminfo(int nid, node_meminfo_t *info)
 
 		if (strstr(line, "Writeback:") != NULL) {
 			if (!memsize_parse(line, &info->writeback)) {
-				goto L_EXIT;
+				return (B_FALSE);
 			}
 			i++;
 			continue;
@@ -575,22 +896,14 @@ os_sysfs_meminfo(int nid, node_meminfo_t *info)
 
 		if (strstr(line, "Mapped:") != NULL) {
 			if (!memsize_parse(line, &info->mapped)) {
-				goto L_EXIT;
+				return (B_FALSE);
 			}
 			i++;
 			continue;
 		}
 	}
 
-	ret = B_TRUE;
-
-L_EXIT:
-	if (line != NULL) {
-		free(line);
-	}
-
-	fclose(fp);
-	return (ret);
+	return (B_TRUE);
 }
 
 int
@@ -616,6 +929,27 @@ os_sysfs_cqm_llc_scale(const char *path, double *scale)
 	return 0;
 }
 
+/*
+ * Count the uncore PMU boxes named "/sys/devices/<prefix>_<n>".
+ */
+int
+os_sysfs_uncore_num(const char *prefix)
+{
+	char path[PATH_MAX];
+	int num = 0;
+
+	for (;;) {
+		snprintf(path, PATH_MAX, "/sys/devices/%s_%d/type", prefix, num);
+		if (access(path, R_OK) != 0) {
+			break;
+		}
+
+		num++;
+	}
+
+	return (num);
+}
+
 int
 os_sysfs_uncore_qpi_init(qpi_info_t *qpi, int num)
 {
@@ -676,11 +1010,48 @@ os_sysfs_uncore_upi_init(qpi_info_t *qpi, int num)
 	return qpi_num;
 }
 
+/*
+ * Convert the event alias of an uncore PMU, e.g.
+ * "/sys/devices/uncore_imc_0/events/cas_count_read" which contains
+ * "event=0x04,umask=0x03", to the raw config.
+ */
+static int
+uncore_event_config(const char *pmu, const char *name, unsigned int *config)
+{
+	char path[PATH_MAX], buf[128], *p;
+	unsigned int event, umask = 0;
+	FILE *fp;
+
+	snprintf(path, PATH_MAX, "/sys/devices/%s/events/%s", pmu, name);
+	if ((fp = fopen(path, "r")) == NULL) {
+		return (-1);
+	}
+
+	if (fgets(buf, sizeof (buf), fp) == NULL) {
+		fclose(fp);
+		return (-1);
+	}
+
+	fclose(fp);
+
+	if (((p = strstr(buf, "event=")) == NULL) ||
+	    (sscanf(p, "event=%x", &event) != 1)) {
+		return (-1);
+	}
+
+	if ((p = strstr(buf, "umask=")) != NULL) {
+		(void) sscanf(p, "umask=%x", &umask);
+	}
+
+	*config = (event & 0xff) | ((umask & 0xff) << 8);
+	return (0);
+}
+
 int
 os_sysfs_uncore_imc_init(imc_info_t *imc, int num)
 {
 	int i, fd, imc_num = 0;
-	char path[PATH_MAX], buf[32];
+	char path[PATH_MAX], buf[32], pmu[32];
 	
 	for (i = 0; i < num; i++)
 	{
@@ -698,8 +1069,24 @@ os_sysfs_uncore_imc_init(imc_info_t *imc, int num)
 		imc[i].id = i;
 		imc[i].value_scaled = 0;
 		memset(imc[i].values, 0, sizeof(imc[i].values));
-		imc[i].fd = INVALID_FD;
+		imc[i].fds[IMC_CAS_RD] = INVALID_FD;
+		imc[i].fds[IMC_CAS_WR] = INVALID_FD;
 		close(fd);
+
+		/*
+		 * Count the read and the write CAS separately if the kernel
+		 * exports their encodings, otherwise count all CAS.
+		 */
+		snprintf(pmu, sizeof (pmu), "uncore_imc_%d", i);
+		if ((uncore_event_config(pmu, "cas_count_read",
+		    &imc[i].config[IMC_CAS_RD]) == 0) &&
+		    (uncore_event_config(pmu, "cas_count_write",
+		    &imc[i].config[IMC_CAS_WR]) == 0)) {
+			imc[i].nevents = IMC_CAS_NUM;
+		} else {
+			imc[i].config[IMC_CAS_RD] = 0xff04;
+			imc[i].nevents = 1;
+		}
 	}
 
 	return imc_num;
@@ -723,18 +1110,18 @@ boolean_t os_cmt_init(void)
 {
 	int ret;
 
-	g_pqos_moni_id = 0;
-
-	if (resctrl_mounted())
-		return B_TRUE;
+	if (!resctrl_mounted()) {
+		ret = mount("resctrl", "/sys/fs/resctrl", "resctrl", 0, NULL);
+		if (ret < 0) {
+			debug_print(NULL, 2, "Mount of /sys/fs/resctrl failed (errno = %d)\n", errno);
+			return B_FALSE;
+		}
 
-	ret = mount("resctrl", "/sys/fs/resctrl", "resctrl", 0, NULL);
-	if (ret < 0) {
-		debug_print(NULL, 2, "Mount of /sys/fs/resctrl failed (errno = %d)\n", errno);
-		return B_FALSE;
+		if (!resctrl_mounted())
+			return B_FALSE;
 	}
 
-	return resctrl_mounted();
+	return (resctrl_pool_init() == 0);
 }
 
 void os_cmt_fini(void)
@@ -744,158 +1131,56 @@ void os_cmt_fini(void)
 	if (!resctrl_mounted())
 		return;
 
+	cgroup_fini();
+	resctrl_pool_fini();
+
 	ret = umount("/sys/fs/resctrl");
 	if (ret < 0) {
 		debug_print(NULL, 2, "Unmount of /sys/fs/resctrl failed (errno = %d)\n", errno);
 	}
-
-	g_pqos_moni_id = 0;
-}
-
-static int os_sysfs_nftw_unlink(const char *fpath, const struct stat *statbuf,
-			       int tflag, struct FTW *ftwbuf)
-{
-	int ret;
-
-	(void)statbuf;
-	(void)ftwbuf;
-
-	switch (tflag) {
-	case FTW_F:
-	case FTW_SL:
-	case FTW_SLN:
-	default:
-		errno = 0;
-		ret = unlink(fpath);
-		if (ret < 0)
-			debug_print(NULL, 2, "unlink %s (errno=%d)\n", fpath, errno);
-		break;
-	case FTW_D:
-	case FTW_DP:
-	case FTW_DNR:
-		errno = 0;
-		ret = rmdir(fpath);
-		if (ret < 0)
-			debug_print(NULL, 2, "rmdir %s (errno=%d)\n", fpath, errno);
-		break;
-	}
-
-	return 0;
 }
 
+/*
+ * Move the task to a monitor group from the pool. The counters of the
+ * group are read as the baseline at the first sampling, since the RMID
+ * may be recycled from another task.
+ */
 int os_sysfs_cmt_task_set(int pid, int lwpid, struct _perf_pqos *pqos)
 {
-	char data[64], path[128];
-	int ret, fd;
-
-	if (lwpid)
-		pqos->task_id = lwpid;
-	else if (pid)
-		pqos->task_id = pid;
-	else
-		pqos->task_id = ++g_pqos_moni_id;
-
-	snprintf(path, sizeof(path),
-		"/sys/fs/resctrl/mon_groups/%d", pqos->task_id);
+	int slot;
 
-	/* nftw will return -1 if the path does not exist, ignore this */
-	(void)nftw(path, os_sysfs_nftw_unlink, 32, FTW_DEPTH | FTW_PHYS);
-
-	ret = mkdir(path, 0777);
-	if (ret < 0) {
-		debug_print(NULL, 2, "mkdir %s failed, errno=%d\n", path, errno);
-		return -1;
-	}
-
-	snprintf(path, sizeof(path),
-		"/sys/fs/resctrl/mon_groups/%d/tasks", pqos->task_id);
-	fd = open(path, O_RDWR);
-	if (fd < 0) {
-		debug_print(NULL, 2, "open %s failed, errno=%d\n", path, errno);
+	if ((slot = resctrl_slot_alloc((lwpid != 0) ? lwpid : pid)) < 0)
 		return -1;
-	}
-
-	if (lwpid == 0)
-		snprintf(data, sizeof(data), "%d\n", pid);
-	else
-		snprintf(data, sizeof(data), "%d\n", lwpid);
-	if (write(fd, data, strlen(data)) < 0) {
-		debug_print(NULL, 2, "write to %s failed, errno=%d\n", path, errno);
-		(void)close(fd);
-		return -1;
-	}
-	(void)close(fd);
 
+	pqos->task_id = slot + 1;
+	pqos->nsmpl = 0;
 	return 0;
 }
 
-static int cmt_task_node_value(const char *dir, int nid,
-	const char *field, uint64_t *val)
+void os_sysfs_cmt_task_free(struct _perf_pqos *pqos)
 {
-	FILE *fp;
-	char buf[LINE_SIZE], path[128];
-
-	*val = 0;
-
-	if (nid < 10) {
-		snprintf(path, sizeof(path),
-			"%s/mon_L3_0%d/%s", dir, nid, field);
-	} else {
-		snprintf(path, sizeof(path),
-			"%s/mon_L3_%d/%s", dir, nid, field);
+	if (pqos->task_id != 0) {
+		resctrl_slot_free(pqos->task_id - 1);
+		pqos->task_id = 0;
 	}
-
-	if ((fp = fopen(path, "r")) == NULL)
-		return (-1);
-
-	if (fgets(buf, LINE_SIZE, fp) == NULL) {
-		fclose(fp);
-		return (-1);
-	}
-
-	fclose(fp);
-	*val = strtod(buf, NULL);
-
-	debug_print(NULL, 2, "%s: val = %" PRId64 ", nid = %d\n", path, *val, nid);
-
-	return 0;
-}
-
-static uint64_t cmt_field_value(char *dir, const char *field, int nid)
-{
-	uint64_t val = 0, tmp;
-	int i;
-
-	if (nid == -1) {
-		for (i = 0; i < nnodes_max; i++) {
-			if (cmt_task_node_value(dir, i, field,
-				&tmp) == 0)
-				val += tmp;
-		}
-	} else {
-		cmt_task_node_value(dir, nid, field, &val);
-	}
-
-	return val;
 }
 
 int os_sysfs_cmt_task_value(struct _perf_pqos *pqos, int nid)
 {
-	char dir[128];
-	uint64_t tmp;
-
-	snprintf(dir, sizeof(dir),
-		"/sys/fs/resctrl/mon_groups/%d/mon_data", pqos->task_id);
+	uint64_t values[RESCTRL_EVENT_NUM];
 
-	pqos->occupancy_scaled = cmt_field_value(dir, "llc_occupancy", nid);
+	if (resctrl_slot_read(pqos->task_id - 1, nid, values) != 0)
+		return -1;
 
-	tmp = cmt_field_value(dir, "mbm_total_bytes", nid);
-	pqos->totalbw_scaled = tmp - pqos->totalbw;
-	pqos->totalbw = tmp;
+	pqos->occupancy_scaled = values[RESCTRL_LLC_OCCUPANCY];
 
-	tmp = cmt_field_value(dir, "mbm_local_bytes", nid);
-	pqos->localbw_scaled = tmp - pqos->localbw;
-	pqos->localbw = tmp;
+	if (pqos->nsmpl > 0) {
+		pqos->totalbw_scaled = values[RESCTRL_MBM_TOTAL] - pqos->totalbw;
+		pqos->localbw_scaled = values[RESCTRL_MBM_LOCAL] - pqos->localbw;
+	}
 
+	pqos->totalbw = values[RESCTRL_MBM_TOTAL];
+	pqos->localbw = values[RESCTRL_MBM_LOCAL];
+	pqos->nsmpl++;
 	return 0;
 }
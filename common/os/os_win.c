@@ -52,39 +52,73 @@
 #include "../include/os/os_util.h"
 #include "../include/os/plat.h"
 #include "../include/os/os_win.h"
+#include "../include/os/cgroup.h"
+#include "../include/os/numastat.h"
 
 /*
  * Build the readable string for caption line.
  * (window type: "WIN_TYPE_NODE_OVERVIEW")
  */
 void
-os_nodeoverview_caption_build(char *buf, int size)
+os_nodeoverview_caption_build(char *buf, int size, topo_level_t level)
 {
-	(void) snprintf(buf, size,
-	    "%5s%12s%12s%11s%11s%11s%12s",
-	    CAPTION_NID, CAPTION_MEM_ALL, CAPTION_MEM_FREE,
-	    CAPTION_RMA, CAPTION_LMA, CAPTION_RL, CAPTION_CPU);
+	switch (level) {
+	case TOPO_LEVEL_SOCKET:
+		(void) snprintf(buf, size,
+		    "%5s%12s%12s%11s%11s%11s%12s",
+		    CAPTION_SOCKET, CAPTION_MEM_ALL, CAPTION_MEM_FREE,
+		    CAPTION_RMA, CAPTION_LMA, CAPTION_RL, CAPTION_CPU);
+		break;
+
+	case TOPO_LEVEL_LLC:
+		/* The memory is per node, show the node of the LLC */
+		(void) snprintf(buf, size,
+		    "%5s%12s%12s%11s%11s%11s%12s",
+		    CAPTION_LLC, CAPTION_NID, CAPTION_NCPUS,
+		    CAPTION_RMA, CAPTION_LMA, CAPTION_RL, CAPTION_CPU);
+		break;
+
+	default:
+		(void) snprintf(buf, size,
+		    "%5s%12s%12s%11s%11s%11s%12s",
+		    CAPTION_NID, CAPTION_MEM_ALL, CAPTION_MEM_FREE,
+		    CAPTION_RMA, CAPTION_LMA, CAPTION_RL, CAPTION_CPU);
+		break;
+	}
 }
 
 void
-os_nodeoverview_data_build(char *buf, int size, nodeoverview_line_t *line,
-    node_t *node)
+os_nodeoverview_data_build(char *buf, int size, nodeoverview_line_t *line)
 {
 	win_countvalue_t *value = &line->value;
 	char mem_all[32], mem_free[32];
 
-	(void) snprintf(mem_all, sizeof (mem_all), "%.1fG", line->mem_all);
-	(void) snprintf(mem_free, sizeof (mem_free), "%.1fG", line->mem_free);
+	if (line->level == TOPO_LEVEL_LLC) {
+		/* With SNC an LLC spans the nodes of socket */
+		if (line->nid == INVALID_NID) {
+			(void) strcpy(mem_all, "-");
+		} else {
+			(void) snprintf(mem_all, sizeof (mem_all), "%d",
+			    line->nid);
+		}
+
+		(void) snprintf(mem_free, sizeof (mem_free), "%d", line->ncpus);
+	} else {
+		(void) snprintf(mem_all, sizeof (mem_all), "%.1fG",
+		    line->mem_all);
+		(void) snprintf(mem_free, sizeof (mem_free), "%.1fG",
+		    line->mem_free);
+	}
 
 	if (plat_offcore_num() > 1) {
 		(void) snprintf(buf, size,
 		    "%5d%12s%12s%11.1f%11.1f%11.1f%11.1f",
-		    node->nid, mem_all, mem_free, value->rma, value->lma,
+		    line->id, mem_all, mem_free, value->rma, value->lma,
 		    value->rl, value->cpu * 100);
 	} else {
 		(void) snprintf(buf, size,
 		    "%5d%12s%12s%11.1f%11s%11s%11.1f",
-		    node->nid, mem_all, mem_free, value->rma,
+		    line->id, mem_all, mem_free, value->rma,
 		    "-", "-", value->cpu * 100);		
 	}
 }
@@ -206,22 +240,118 @@ node_cpu_string(node_t *node, char *s1, int size)
 }
 
 static void
-nodedetail_line_show(win_reg_t *reg, char *title, char *value, int line)
+nodedetail_line_show(callchain_line_t *lines, char *title, char *value,
+	int line)
+{
+	(void) snprintf(lines[line].content, WIN_LINECHAR_MAX, "%-30s%15s",
+		title, value);
+}
+
+/*
+ * Display the peak/p99/mean of the bandwidth bursts sampled every
+ * UNCORE_BURST_MS within the interval.
+ */
+static void
+burst_line_show(callchain_line_t *lines, char *title, uncore_burst_t *burst,
+	int *line)
+{
+	char s1[64];
+
+	if (burst->nsamples == 0) {
+		return;
+	}
+
+	(void) snprintf(s1, sizeof (s1), "%.1f/%.1f/%.1fGB/s",
+		burst->peak / (double)(GB_BYTES),
+		burst->p99 / (double)(GB_BYTES),
+		burst->mean / (double)(GB_BYTES));
+	nodedetail_line_show(lines, title, s1, (*line)++);
+}
+
+static double
+imc_gbps(uint64_t cas, uint64_t intval_ns)
+{
+	if (intval_ns == 0) {
+		return (0.0);
+	}
+
+	return ((double)(cas * 64) / (double)(GB_BYTES) /
+		((double)intval_ns / (double)NS_SEC));
+}
+
+/*
+ * Display the read/write bandwidth of the memory controllers, how
+ * unevenly the channels are loaded (busiest channel / mean) and the
+ * bandwidth per channel.
+ */
+static void
+imc_bw_show(callchain_line_t *lines, node_imc_t *imc, int *line)
 {
-	char s1[256];
+	imc_info_t *info;
+	char s1[32], s2[32];
+	double rd = 0.0, wr = 0.0, bw, bw_max = 0.0;
+	boolean_t split = B_TRUE;
+	int j;
+
+	if (imc->imc_num == 0) {
+		return;
+	}
+
+	for (j = 0; j < imc->imc_num; j++) {
+		info = &imc->imc_info[j];
+		if (info->nevents < IMC_CAS_NUM) {
+			split = B_FALSE;
+		}
+
+		rd += imc_gbps(info->cas_scaled[IMC_CAS_RD], info->intval_ns);
+		wr += imc_gbps(info->cas_scaled[IMC_CAS_WR], info->intval_ns);
+		bw = imc_gbps(info->value_scaled, info->intval_ns);
+		if (bw > bw_max) {
+			bw_max = bw;
+		}
+	}
+
+	if (split) {
+		(void) snprintf(s1, sizeof (s1), "%.2fGB/s", rd);
+		nodedetail_line_show(lines, "Memory read bandwidth:", s1, (*line)++);
+		(void) snprintf(s1, sizeof (s1), "%.2fGB/s", wr);
+		nodedetail_line_show(lines, "Memory write bandwidth:", s1, (*line)++);
+	} else {
+		(void) snprintf(s1, sizeof (s1), "%.2fGB/s", rd);
+		nodedetail_line_show(lines, "Memory bandwidth:", s1, (*line)++);
+	}
+
+	(void) snprintf(s1, sizeof (s1), "%.2f",
+		((rd + wr) > 0.0) ? bw_max * imc->imc_num / (rd + wr) : 0.0);
+	nodedetail_line_show(lines, "Memory channel imbalance:", s1, (*line)++);
+	burst_line_show(lines, "Memory burst peak/p99/mean:", &imc->burst, line);
+
+	for (j = 0; j < imc->imc_num; j++) {
+		info = &imc->imc_info[j];
+		if (split) {
+			(void) snprintf(s1, sizeof (s1), "%.1f/%.1fGB/s",
+				imc_gbps(info->cas_scaled[IMC_CAS_RD], info->intval_ns),
+				imc_gbps(info->cas_scaled[IMC_CAS_WR], info->intval_ns));
+			(void) snprintf(s2, sizeof (s2), "IMC %d read/write:", j);
+		} else {
+			(void) snprintf(s1, sizeof (s1), "%.1fGB/s",
+				imc_gbps(info->value_scaled, info->intval_ns));
+			(void) snprintf(s2, sizeof (s2), "IMC %d bandwidth:", j);
+		}
 
-	snprintf(s1, sizeof (s1), "%-30s%15s", title, value);
-	reg_line_write(reg, line, ALIGN_LEFT, s1);
-	dump_write("%s\n", s1);
+		nodedetail_line_show(lines, s2, s1, (*line)++);
+	}
 }
 
 /*
- * Display the performance statistics per node.
+ * Display the performance statistics per node. The lines per link and
+ * per memory channel can be more than the screen, so they are scrolled.
  */
 void
 os_nodedetail_data(dyn_nodedetail_t *dyn, win_reg_t *seg)
 {
 	char s1[512], s2[32];
+	callchain_line_t *lines;
 	node_t *node;
 	win_countvalue_t value;
 	node_meminfo_t meminfo;
@@ -232,26 +362,57 @@ os_nodedetail_data(dyn_nodedetail_t *dyn, win_reg_t *seg)
 
 	reg_erase(seg);
 	node = node_get(dyn->nid);
+	if ((lines = zalloc(sizeof (callchain_line_t) * (NODEDETAIL_LINES +
+		node->qpi.qpi_num + node->imc.imc_num))) == NULL) {
+		return;
+	}
+
 	win_node_countvalue(node, &value);
 	node_meminfo(node->nid, &meminfo);
 
 	/*
 	 * Display the CPU
 	 */
-	node_cpu_string(node, s1, sizeof (s1));
-	nodedetail_line_show(seg, "CPU:", s1, i++);
+	if (node->memory_only) {
+		(void) strncpy(s1, "- (memory only)", sizeof (s1));
+	} else {
+		node_cpu_string(node, s1, sizeof (s1));
+	}
+
+	nodedetail_line_show(lines, "CPU:", s1, i++);
+
+	/*
+	 * Display the SLIT distance to each node, e.g. "0:10 1:21"
+	 */
+	s1[0] = 0;
+	for (j = 0; j < nnodes_max; j++) {
+		if (NODE_VALID(node_get(j))) {
+			(void) snprintf(s2, sizeof (s2), "%s%d:%d",
+				(s1[0] != 0) ? " " : "", j,
+				node_distance(node->nid, j));
+			(void) strncat(s1, s2, sizeof (s1) - strlen(s1) - 1);
+		}
+	}
+
+	nodedetail_line_show(lines, "Distance:", s1, i++);
+
+	/*
+	 * Display the socket, several nodes share it with SNC
+	 */
+	(void) snprintf(s1, sizeof (s1), "%d", node->pkgid);
+	nodedetail_line_show(lines, "Socket:", s1, i++);
 
 	/*
 	 * Display the CPU utilization
 	 */
 	(void) snprintf(s1, sizeof (s1), "%.1f%%", value.cpu * 100.0);	
-	nodedetail_line_show(seg, "CPU%:", s1, i++);
+	nodedetail_line_show(lines, "CPU%:", s1, i++);
 
 	/*
 	 * Display the number of RMA
 	 */
 	(void) snprintf(s1, sizeof (s1), "%.1fK", value.rma);	
-	nodedetail_line_show(seg, "RMA:", s1, i++);
+	nodedetail_line_show(lines, "RMA:", s1, i++);
 
 	/*
 	 * Display the number of LMA if platform supports
@@ -262,56 +423,56 @@ os_nodedetail_data(dyn_nodedetail_t *dyn, win_reg_t *seg)
 		(void) snprintf(s1, sizeof (s1), "%s", "-");	
 	}
 
-	nodedetail_line_show(seg, "LMA:", s1, i++);
+	nodedetail_line_show(lines, "LMA:", s1, i++);
 
 	/*
 	 * Display the size of total memory
 	 */
 	(void) snprintf(s1, sizeof (s1), "%.1fG",
 		(double)((double)(meminfo.mem_total) / (double)(GB_BYTES)));
-	nodedetail_line_show(seg, "MEM total:", s1, i++);
+	nodedetail_line_show(lines, "MEM total:", s1, i++);
 
 	/*
 	 * Display the size of free memory
 	 */
 	(void) snprintf(s1, sizeof (s1), "%.1fG",
 		(double)((double)(meminfo.mem_free) / (double)(GB_BYTES)));
-	nodedetail_line_show(seg, "MEM free:", s1, i++);
+	nodedetail_line_show(lines, "MEM free:", s1, i++);
 
 	/*
 	 * Display the size of active memory.
 	 */
 	(void) snprintf(s1, sizeof (s1), "%.2fG",
 		(double)((double)(meminfo.active) / (double)(GB_BYTES)));	
-	nodedetail_line_show(seg, "MEM active:", s1, i++);
+	nodedetail_line_show(lines, "MEM active:", s1, i++);
 
 	/*
 	 * Display the size of inactive memory.
 	 */
 	(void) snprintf(s1, sizeof (s1), "%.2fG",
 		(double)((double)(meminfo.inactive) / (double)(GB_BYTES)));
-	nodedetail_line_show(seg, "MEM inactive:", s1, i++);
+	nodedetail_line_show(lines, "MEM inactive:", s1, i++);
 
 	/*
 	 * Display the size of dirty memory.
 	 */
 	(void) snprintf(s1, sizeof (s1), "%.2fG",
 		(double)((double)(meminfo.dirty) / (double)(GB_BYTES)));
-	nodedetail_line_show(seg, "Dirty:", s1, i++);
+	nodedetail_line_show(lines, "Dirty:", s1, i++);
 
 	/*
 	 * Display the size of writeback memory.
 	 */
 	(void) snprintf(s1, sizeof (s1), "%.2fG",
 		(double)((double)(meminfo.dirty) / (double)(GB_BYTES)));
-	nodedetail_line_show(seg, "Writeback:", s1, i++);
+	nodedetail_line_show(lines, "Writeback:", s1, i++);
 
 	/*
 	 * Display the size of mapped memory.
 	 */
 	(void) snprintf(s1, sizeof (s1), "%.2fG",
 		(double)((double)(meminfo.mapped) / (double)(GB_BYTES)));
-	nodedetail_line_show(seg, "Mapped:", s1, i++);
+	nodedetail_line_show(lines, "Mapped:", s1, i++);
 
 	/*
 	 * Display the QPI link bandwidth
@@ -322,7 +483,12 @@ os_nodedetail_data(dyn_nodedetail_t *dyn, win_reg_t *seg)
 		snprintf(s1, sizeof (s1), "%.1fMB", 
 			ratio(qpi->qpi_info[j].value_scaled * 8, 1024 * 1024));
 		snprintf(s2, sizeof (s2), "QPI/UPI %d bandwidth:", j);
-		nodedetail_line_show(seg, s2, s1, i++);	
+		nodedetail_line_show(lines, s2, s1, i++);	
+	}
+
+	if (qpi->qpi_num > 0) {
+		burst_line_show(lines, "QPI/UPI burst peak/p99/mean:", &qpi->burst,
+			&i);
 	}
 
 	/*
@@ -335,8 +501,17 @@ os_nodedetail_data(dyn_nodedetail_t *dyn, win_reg_t *seg)
 	}
 
 	snprintf(s1, sizeof (s1), "%.1fMB", ratio(v, 1024 * 1024));
-	nodedetail_line_show(seg,  "Memory controller bandwidth:", s1, i++);	
+	nodedetail_line_show(lines,  "Memory controller bandwidth:", s1, i++);	
+
+	imc_bw_show(lines, &node->imc, &i);
+
+	if (seg->buf != NULL) {
+		free(seg->buf);
+	}
 
+	seg->buf = (void *)lines;
+	seg->nlines_total = i;
+	reg_scroll_show(seg, (void *)lines, i, win_callchain_str_build);
 	reg_refresh_nout(seg);
 }
 
@@ -420,7 +595,7 @@ os_callchain_list_show(dyn_callchain_t *dyn, track_proc_t *proc,
 {
 	perf_countchain_t *count_chain;
 	perf_chainrecgrp_t *rec_grp;
-	perf_chainrec_t *rec_arr;
+	perf_chainrec_t **rec_arr;
 	sym_chainlist_t chainlist;
 	win_reg_t *reg;
 	char content[WIN_LINECHAR_MAX];
@@ -461,8 +636,8 @@ os_callchain_list_show(dyn_callchain_t *dyn, track_proc_t *proc,
 		rec_arr = rec_grp->rec_arr;
 
 		for (j = 0; j < rec_grp->nrec_cur; j++) {
-			sym_callchain_add(&proc->sym, rec_arr[j].callchain.ips,
-				rec_arr[j].callchain.ip_num, &chainlist);
+			sym_callchain_add(&proc->sym, rec_arr[j]->callchain.ips,
+				rec_arr[j]->callchain.ip_num, &chainlist);
 		}
 	}
 
@@ -601,14 +776,18 @@ llcallchain_bufinfo_show(dyn_llcallchain_t *dyn, track_proc_t *proc,
 	
 	/*
 	 * Display the caption of data table:
-	 * "ADDR SIZE ACCESS% LAT(ns) DESC"
+	 * "ADDR SIZE ACCESS% LAT(ns) P50(ns) P90(ns) P99(ns) MAX(ns) DESC
+	 *  L3% LDRAM% RDRAM% RCACHE% CXL% HITM%"
 	 */
 	reg = &dyn->buf_caption;
 	reg_erase(reg);	
 	(void) snprintf(content, sizeof (content),
-	    "%16s%8s%11s%11s%34s",
+	    "%16s%8s%11s%11s%10s%10s%10s%10s%34s%9s%9s%9s%9s%9s%9s",
 	    CAPTION_ADDR, CAPTION_SIZE, CAPTION_BUFHIT,
-	    CAPTION_AVGLAT, CAPTION_DESC);
+	    CAPTION_AVGLAT, CAPTION_P50LAT, CAPTION_P90LAT,
+	    CAPTION_P99LAT, CAPTION_MAXLAT, CAPTION_DESC, CAPTION_L3,
+	    CAPTION_LDRAM, CAPTION_RDRAM, CAPTION_RCACHE, CAPTION_CXL,
+	    CAPTION_HITM);
 	reg_line_write(&dyn->buf_caption, 1, ALIGN_LEFT, content);
 	dump_write("%s\n", content);
 	reg_refresh_nout(reg);
@@ -630,7 +809,7 @@ llcallchain_bufinfo_show(dyn_llcallchain_t *dyn, track_proc_t *proc,
 	/*
 	 * Fill in the memory access information.
 	 */
-	win_lat_buf_fill(lat_buf, nlines, proc, lwp, &lat);
+	win_lat_buf_fill(lat_buf, nlines, proc, lwp, &lat, NULL, NULL);
 	
 	/*
 	 * Check if the linear address is located in a buffer in
@@ -654,7 +833,7 @@ llcallchain_list_show(dyn_llcallchain_t *dyn, track_proc_t *proc,
 {
 	perf_llrecgrp_t *llrec_grp;
 	char content[WIN_LINECHAR_MAX];
-	os_perf_llrec_t *rec_arr;
+	os_perf_llrec_t **rec_arr;
 	sym_chainlist_t chainlist;
 	win_reg_t *reg;
 	int i;
@@ -687,13 +866,13 @@ llcallchain_list_show(dyn_llcallchain_t *dyn, track_proc_t *proc,
 	rec_arr = llrec_grp->rec_arr;
 
 	for (i = 0; i < llrec_grp->nrec_cur; i++) {
-		if ((rec_arr[i].addr < dyn->addr) ||
-			(rec_arr[i].addr >= dyn->addr + dyn->size)) {
+		if ((rec_arr[i]->addr < dyn->addr) ||
+			(rec_arr[i]->addr >= dyn->addr + dyn->size)) {
 			continue;
 		}
 
-		sym_callchain_add(&proc->sym, rec_arr[i].callchain.ips,
-			rec_arr[i].callchain.ip_num, &chainlist);		
+		sym_callchain_add(&proc->sym, rec_arr[i]->callchain.ips,
+			rec_arr[i]->callchain.ip_num, &chainlist);		
 	}
 
 	chainlist_show(&chainlist, &dyn->chain_data);
@@ -814,6 +993,8 @@ os_lat_buf_hit(lat_line_t *lat_buf, int nlines, os_perf_llrec_t *rec,
 		 */
 		line->naccess++;
 		line->latency += rec->latency;
+		lat_hist_add(&line->hist, rec->latency);
+		line->memsrc.count[rec->mem_src]++;
 		*total_lat += rec->latency;
 		*total_sample += 1;
 	}
@@ -857,8 +1038,10 @@ static int
 latnode_data_get(track_proc_t *proc, track_lwp_t *lwp, dyn_latnode_t *dyn)
 {
 	lat_line_t *buf;
+	memsrc_count_t memsrc;
 	char content[WIN_LINECHAR_MAX];
-	int nlines, lwpid = 0, lat = 0;
+	int nlines, lwpid = 0, lat = 0, i, j;
+	uint64_t naccess = 0, total_lat = 0;
 
 	reg_erase(&dyn->caption);
 	reg_refresh_nout(&dyn->caption);
@@ -877,7 +1060,18 @@ latnode_data_get(track_proc_t *proc, track_lwp_t *lwp, dyn_latnode_t *dyn)
 		return (-1);
 	}
 
-	win_lat_buf_fill(buf, nlines, proc, lwp, &lat);
+	win_lat_buf_fill(buf, nlines, proc, lwp, &lat, NULL, NULL);
+
+	(void) memset(&memsrc, 0, sizeof (memsrc));
+	for (i = 0; i < nlines; i++) {
+		naccess += buf[i].naccess;
+		total_lat += buf[i].latency;
+		for (j = 0; j < MEM_SRC_NUM; j++) {
+			memsrc.count[j] += buf[i].memsrc.count[j];
+		}
+	}
+
+	os_migrate_update(&dyn->migrate, proc, naccess, total_lat, &memsrc);
 
 	/*
 	 * Sort by the number of buffer accessing.
@@ -886,12 +1080,15 @@ latnode_data_get(track_proc_t *proc, track_lwp_t *lwp, dyn_latnode_t *dyn)
 
 	/*
 	 * Display the caption of data table:
-	 * "ADDR SIZE NODE ACCESS% LAT(ns) DESC"
+	 * "ADDR SIZE NODE ACCESS% LAT(ns) P50(ns) P90(ns) P99(ns) MAX(ns)
+	 *  L3% LDRAM% RDRAM% RCACHE% CXL% HITM%"
 	 */
 	(void) snprintf(content, sizeof (content),
-	    "%16s%8s%8s%11s%11s",
+	    "%16s%8s%8s%11s%11s%10s%10s%10s%10s%9s%9s%9s%9s%9s%9s",
 	    CAPTION_ADDR, CAPTION_SIZE, CAPTION_NID, CAPTION_BUFHIT,
-	    CAPTION_AVGLAT);
+	    CAPTION_AVGLAT, CAPTION_P50LAT, CAPTION_P90LAT,
+	    CAPTION_P99LAT, CAPTION_MAXLAT, CAPTION_L3, CAPTION_LDRAM,
+	    CAPTION_RDRAM, CAPTION_RCACHE, CAPTION_CXL, CAPTION_HITM);
 
 	reg_line_write(&dyn->caption, 1, ALIGN_LEFT, content);
 	reg_refresh_nout(&dyn->caption);
@@ -912,13 +1109,69 @@ latnode_data_get(track_proc_t *proc, track_lwp_t *lwp, dyn_latnode_t *dyn)
 	    nlines, win_lat_str_build);
 	reg_refresh_nout(&dyn->data);
 
+	os_migrate_show(&dyn->hint, &dyn->migrate);
 	return (0);
 }
 
+/*
+ * Append the THP coverage of the resident pages if any of them is
+ * backed by transparent huge pages.
+ */
+static void
+latnode_thp_str(map_entry_t *entry, char *buf, int size)
+{
+	int pct, len;
+
+	if ((pct = map_thp_pct(entry)) <= 0) {
+		return;
+	}
+
+	len = strlen(buf);
+	(void) snprintf(buf + len, size - len, ", THP: %d%%", pct);
+}
+
+/*
+ * Append the sampling granularity, the confidence and the per-node
+ * totals from numa_maps if the node breakdown is sampled.
+ */
+static void
+latnode_smpl_str(numa_map_t *numa_map, char *buf, int size)
+{
+	char size_str[32];
+	int i, len;
+
+	if (numa_map->granularity == 0) {
+		return;
+	}
+
+	win_size2str(numa_map->granularity, size_str, sizeof (size_str));
+	len = strlen(buf);
+	if (numa_map->confidence >= 0) {
+		len += snprintf(buf + len, size - len,
+		    ", sampled per %s (confidence: %d%%)", size_str,
+		    numa_map->confidence);
+	} else {
+		len += snprintf(buf + len, size - len,
+		    ", sampled per %s", size_str);
+	}
+
+	if (numa_map->node_bytes == NULL) {
+		return;
+	}
+
+	for (i = 0; (i < nnodes_max) && (len < size); i++) {
+		if (numa_map->node_bytes[i] == 0) {
+			continue;
+		}
+
+		win_size2str(numa_map->node_bytes[i], size_str, sizeof (size_str));
+		len += snprintf(buf + len, size - len, " N%d=%s", i, size_str);
+	}
+}
+
 static boolean_t
 latnode_data_show(track_proc_t *proc, dyn_latnode_t *dyn,
-	map_entry_t *entry __attribute__((unused)),
-	boolean_t *note_out)
+	map_entry_t *entry, boolean_t *note_out)
 {
 	win_reg_t *reg;
 	track_lwp_t *lwp = NULL;
@@ -957,6 +1210,8 @@ latnode_data_show(track_proc_t *proc, dyn_latnode_t *dyn,
 		    dyn->addr, size_str, proc->pid);
 	}
 
+	latnode_thp_str(entry, content, sizeof (content));
+	latnode_smpl_str(&entry->numa_map, content, sizeof (content));
 	reg_line_write(reg, 1, ALIGN_LEFT, content);
 	dump_write("\n*** %s\n", content);
 	reg_refresh_nout(reg);
@@ -995,6 +1250,7 @@ os_latnode_win_draw(dyn_win_t *win)
 		return (B_FALSE);
 	}
 
+	(void) map_numamaps_load(proc);
 	if (map_map2numa(proc, entry) != 0) {
 		proc_refcount_dec(proc);
 		win_warn_msg(WARN_INVALID_NUMAMAP);
@@ -1012,3 +1268,2547 @@ os_latnode_win_draw(dyn_win_t *win)
 	reg_update_all();
 	return (ret);
 }
+
+/*
+ * Build the list of nodes which access the page, such as "0,2".
+ */
+static void
+heat_nodes_str(uint64_t node_mask, char *buf, int size)
+{
+	int i, len = 0;
+
+	buf[0] = 0;
+	for (i = 0; (i < 64) && (len < size); i++) {
+		if (node_mask & (1ULL << i)) {
+			len += snprintf(buf + len, size - len, "%s%d",
+				(len > 0) ? "," : "", i);
+		}
+	}
+
+	if (len == 0) {
+		(void) snprintf(buf, size, "-");
+	}
+}
+
+/*
+ * Build the readable string of data line which contains page address,
+ * number of accesses, access%, average latency, p99 latency, the node
+ * where the page is allocated, the accessing nodes and the description
+ * of memory area.
+ */
+static void
+heat_str_build(char *buf, int size, int idx, void *pv)
+{
+	heat_line_t *lines = (heat_line_t *)pv;
+	heat_line_t *line = &lines[idx];
+	map_heat_t *heat = &line->heat;
+	char nid_str[16], nodes_str[16];
+	uint64_t lat = 0;
+	double hit;
+
+	if (heat->hist.nsamples > 0) {
+		lat = heat->total_lat / heat->hist.nsamples;
+	}
+
+	if (heat->nid < 0) {
+		(void) snprintf(nid_str, sizeof (nid_str), "-");
+	} else {
+		(void) snprintf(nid_str, sizeof (nid_str), "%d", heat->nid);
+	}
+
+	heat_nodes_str(heat->node_mask, nodes_str, sizeof (nodes_str));
+
+	/*
+	 * "naccess" may include the count inherited from a replaced page,
+	 * don't let the ratio go beyond 100%.
+	 */
+	hit = MIN(ratio(heat->naccess, line->nsamples), 1.0);
+
+	(void) snprintf(buf, size,
+		"%16"PRIX64"%8u%10.1f%11"PRIu64"%10"PRIu64"%8s%12s%34s",
+		heat->page, heat->naccess, hit * 100.0, cyc2ns(lat),
+		cyc2ns(lat_hist_percentile(&heat->hist, 99)),
+		nid_str, nodes_str, line->desc);
+}
+
+static void
+heat_line_get(win_reg_t *r, int idx, char *line, int size)
+{
+	heat_str_build(line, size, idx, r->buf);
+}
+
+/*
+ * Show the hottest cachelines and the latest call-chain of the page
+ * which is highlighted (or the hottest page if nothing is highlighted).
+ */
+static void
+heatmap_detail_show(dyn_heatmap_t *dyn, track_proc_t *proc)
+{
+	heat_line_t *lines = (heat_line_t *)(dyn->data.buf);
+	map_heat_t *heat;
+	sym_chainlist_t chainlist;
+	char content[WIN_LINECHAR_MAX];
+	uint32_t count[MAP_HEAT_LINE_NUM];
+	uint64_t line_size = g_pagesize / MAP_HEAT_LINE_NUM;
+	int i, j, k, idx, len;
+
+	reg_erase(&dyn->line_caption);
+	reg_erase(&dyn->line_data);
+
+	if ((lines == NULL) || (dyn->data.nlines_total == 0)) {
+		reg_refresh_nout(&dyn->line_caption);
+		reg_refresh_nout(&dyn->line_data);
+		memset(&chainlist, 0, sizeof (sym_chainlist_t));
+		chainlist_show(&chainlist, &dyn->chain_data);
+		return;
+	}
+
+	if ((idx = dyn->data.scroll.highlight) < 0) {
+		idx = 0;
+	}
+
+	heat = &lines[idx].heat;
+	(void) snprintf(content, sizeof (content),
+		"Hot cachelines and call-chain of page %"PRIX64":", heat->page);
+	reg_line_write(&dyn->line_caption, 1, ALIGN_LEFT, content);
+	dump_write("%s\n", content);
+	reg_refresh_nout(&dyn->line_caption);
+
+	/*
+	 * List the 8 hottest cachelines by offset in page.
+	 */
+	memcpy(count, heat->line_count, sizeof (count));
+	len = 0;
+	content[0] = 0;
+	for (i = 0; i < 8; i++) {
+		k = 0;
+		for (j = 1; j < MAP_HEAT_LINE_NUM; j++) {
+			if (count[j] > count[k]) {
+				k = j;
+			}
+		}
+
+		if (count[k] == 0) {
+			break;
+		}
+
+		len += snprintf(content + len, sizeof (content) - len,
+			"+0x%04"PRIX64" %.1f%%  ", k * line_size,
+			ratio(count[k], heat->hist.nsamples) * 100.0);
+		count[k] = 0;
+	}
+
+	reg_line_write(&dyn->line_data, 0, ALIGN_LEFT, content);
+	dump_write("%s\n", content);
+	reg_refresh_nout(&dyn->line_data);
+
+	memset(&chainlist, 0, sizeof (sym_chainlist_t));
+	if ((heat->ip_num > 0) && (sym_load(proc, SYM_TYPE_FUNC) == 0)) {
+		sym_callchain_add(&proc->sym, heat->ips, heat->ip_num,
+			&chainlist);
+	}
+
+	chainlist_show(&chainlist, &dyn->chain_data);
+}
+
+static boolean_t
+heatmap_data_show(track_proc_t *proc, dyn_heatmap_t *dyn, boolean_t *note_out)
+{
+	map_heat_t *heat_arr;
+	map_entry_t *entry;
+	heat_line_t *lines = NULL;
+	uint64_t nsamples;
+	char content[WIN_LINECHAR_MAX], intval_buf[16];
+	int nheat, i;
+
+	*note_out = B_FALSE;
+
+	/*
+	 * The heatmap of process is shared, another heatmap window may
+	 * have restarted it for a different process or thread.
+	 */
+	if (!map_heatmap_owned(proc, dyn->owner) &&
+		(map_heatmap_start(proc, dyn->lwpid, &dyn->owner) != 0)) {
+		return (B_FALSE);
+	}
+
+	if (map_heatmap_get(proc, &heat_arr, &nheat, &nsamples) != 0) {
+		return (B_FALSE);
+	}
+
+	if ((nheat > 0) &&
+		((lines = zalloc(sizeof (heat_line_t) * nheat)) == NULL)) {
+		free(heat_arr);
+		return (B_FALSE);
+	}
+
+	for (i = 0; i < nheat; i++) {
+		lines[i].heat = heat_arr[i];
+		lines[i].nsamples = nsamples;
+		if (((entry = map_entry_lookup(proc, heat_arr[i].page)) != NULL) &&
+			(entry->desc != NULL)) {
+			bufdesc_cut(lines[i].desc, WIN_DESCBUF_SIZE, entry->desc);
+		} else {
+			(void) strcpy(lines[i].desc, "-");
+		}
+	}
+
+	if (heat_arr != NULL) {
+		free(heat_arr);
+	}
+
+	reg_erase(&dyn->msg);
+	disp_intval(intval_buf, 16);
+	if (dyn->lwpid == 0) {
+		(void) snprintf(content, sizeof (content),
+			"Hot pages (pid: %d, pages: %d/%d, samples: %"PRIu64
+			", interval: %s)", proc->pid, nheat, MAP_HEAT_NUM,
+			nsamples, intval_buf);
+	} else {
+		(void) snprintf(content, sizeof (content),
+			"Hot pages (lwpid: %d, pages: %d/%d, samples: %"PRIu64
+			", interval: %s)", dyn->lwpid, nheat, MAP_HEAT_NUM,
+			nsamples, intval_buf);
+	}
+
+	reg_line_write(&dyn->msg, 1, ALIGN_LEFT, content);
+	dump_write("\n*** %s\n", content);
+	reg_refresh_nout(&dyn->msg);
+
+	/*
+	 * Display the caption of data table:
+	 * "ADDR ACCESS ACCESS% LAT(ns) P99(ns) NODE ACC.NODES DESC"
+	 */
+	reg_erase(&dyn->caption);
+	(void) snprintf(content, sizeof (content),
+		"%16s%8s%11s%11s%10s%8s%12s%34s",
+		CAPTION_ADDR, CAPTION_ACCESS, CAPTION_BUFHIT, CAPTION_AVGLAT,
+		CAPTION_P99LAT, CAPTION_NID, CAPTION_ACCNODES, CAPTION_DESC);
+	reg_line_write(&dyn->caption, 1, ALIGN_LEFT, content);
+	dump_write("%s\n", content);
+	reg_refresh_nout(&dyn->caption);
+
+	reg_erase(&dyn->data);
+	if (dyn->data.buf != NULL) {
+		free(dyn->data.buf);
+	}
+
+	dyn->data.buf = (void *)lines;
+	dyn->data.nlines_total = nheat;
+	if (dyn->data.scroll.highlight >= nheat) {
+		dyn->data.scroll.highlight = -1;
+	}
+
+	reg_scroll_show(&dyn->data, (void *)lines, nheat, heat_str_build);
+	reg_refresh_nout(&dyn->data);
+
+	heatmap_detail_show(dyn, proc);
+	return (B_TRUE);
+}
+
+/*
+ * Initialize the display layout for window type
+ * "WIN_TYPE_HEATMAP_PROC" and "WIN_TYPE_HEATMAP_LWP". The hot pages
+ * are tracked as long as the window exists.
+ */
+void *
+os_heatmap_dyn_create(page_t *page)
+{
+	dyn_heatmap_t *dyn;
+	cmd_heatmap_t *cmd = CMD_HEATMAP(&page->cmd);
+	track_proc_t *proc;
+	int i, ndata;
+
+	if ((dyn = zalloc(sizeof (dyn_heatmap_t))) == NULL) {
+		return (NULL);
+	}
+
+	dyn->pid = cmd->pid;
+	dyn->lwpid = cmd->lwpid;
+
+	if ((i = reg_init(&dyn->msg, 0, 1, g_scr_width, 2, A_BOLD)) < 0)
+		goto L_EXIT;
+	if ((i = reg_init(&dyn->caption, 0, i, g_scr_width, 2, A_BOLD | A_UNDERLINE)) < 0)
+		goto L_EXIT;
+
+	ndata = (g_scr_height - i - 6) / 2;
+	if ((i = reg_init(&dyn->data, 0, i, g_scr_width, ndata, 0)) < 0)
+		goto L_EXIT;
+	reg_buf_init(&dyn->data, NULL, heat_line_get);
+	reg_scroll_init(&dyn->data, B_TRUE);
+
+	if ((i = reg_init(&dyn->line_caption, 0, i, g_scr_width, 2, A_BOLD | A_UNDERLINE)) < 0)
+		goto L_EXIT;
+	if ((i = reg_init(&dyn->line_data, 0, i, g_scr_width, 1, 0)) < 0)
+		goto L_EXIT;
+	if ((reg_init(&dyn->chain_data, 0, i, g_scr_width, g_scr_height - i - 2, 0)) < 0)
+		goto L_EXIT;
+	reg_buf_init(&dyn->chain_data, NULL, win_callchain_line_get);
+	reg_scroll_init(&dyn->chain_data, B_FALSE);
+
+	if ((proc = proc_find(cmd->pid)) == NULL) {
+		goto L_EXIT;
+	}
+
+	if (map_heatmap_start(proc, cmd->lwpid, &dyn->owner) != 0) {
+		proc_refcount_dec(proc);
+		goto L_EXIT;
+	}
+
+	proc_refcount_dec(proc);
+	return (dyn);
+L_EXIT:
+	free(dyn);
+	return (NULL);
+}
+
+void
+os_heatmap_win_destroy(dyn_win_t *win)
+{
+	dyn_heatmap_t *dyn;
+	track_proc_t *proc;
+
+	if ((dyn = win->dyn) != NULL) {
+		if ((proc = proc_find(dyn->pid)) != NULL) {
+			map_heatmap_stop(proc, dyn->owner);
+			proc_refcount_dec(proc);
+		}
+
+		if (dyn->data.buf != NULL) {
+			free(dyn->data.buf);
+		}
+
+		if (dyn->chain_data.buf != NULL) {
+			free(dyn->chain_data.buf);
+		}
+
+		reg_win_destroy(&dyn->msg);
+		reg_win_destroy(&dyn->caption);
+		reg_win_destroy(&dyn->data);
+		reg_win_destroy(&dyn->line_caption);
+		reg_win_destroy(&dyn->line_data);
+		reg_win_destroy(&dyn->chain_data);
+		free(dyn);
+	}
+}
+
+/*
+ * The implementation of displaying window on screen for
+ * window type "WIN_TYPE_HEATMAP_PROC" and "WIN_TYPE_HEATMAP_LWP"
+ */
+boolean_t
+os_heatmap_win_draw(dyn_win_t *win)
+{
+	dyn_heatmap_t *dyn = (dyn_heatmap_t *)(win->dyn);
+	track_proc_t *proc;
+	track_lwp_t *lwp;
+	boolean_t note_out, ret;
+
+	if ((proc = proc_find(dyn->pid)) == NULL) {
+		win_warn_msg(WARN_INVALID_PID);
+		win_note_show(NOTE_INVALID_PID);
+		return (B_FALSE);
+	}
+
+	if (dyn->lwpid > 0) {
+		if ((lwp = proc_lwp_find(proc, dyn->lwpid)) == NULL) {
+			proc_refcount_dec(proc);
+			win_warn_msg(WARN_INVALID_LWPID);
+			win_note_show(NOTE_INVALID_LWPID);
+			return (B_FALSE);
+		}
+
+		lwp_refcount_dec(lwp);
+	}
+
+	win_title_show();
+	dump_cache_enable();
+	ret = heatmap_data_show(proc, dyn, &note_out);
+	dump_cache_disable();
+	dump_cache_flush();
+	if (!note_out) {
+		win_note_show(NOTE_HEATMAP);
+	}
+
+	proc_refcount_dec(proc);
+	reg_update_all();
+	return (ret);
+}
+
+/*
+ * Scrolling the page list also switches the cacheline and call-chain
+ * detail to the highlighted page.
+ */
+void
+os_heatmap_win_scroll(dyn_win_t *win, int scroll_type)
+{
+	dyn_heatmap_t *dyn = (dyn_heatmap_t *)(win->dyn);
+	track_proc_t *proc;
+
+	reg_line_scroll(&dyn->data, scroll_type);
+
+	if ((proc = proc_find(dyn->pid)) != NULL) {
+		heatmap_detail_show(dyn, proc);
+		proc_refcount_dec(proc);
+		reg_update_all();
+	}
+}
+
+/*
+ * An LL sample reduced to what is needed to group by cacheline,
+ * "idx" is the index of record in the group of process/thread and
+ * "seq" is the arrival sequence number of record.
+ */
+typedef struct _contend_smpl {
+	uint64_t line;
+	uint64_t seq;
+	uint64_t latency;
+	int nid;
+	int idx;
+	boolean_t hitm;
+} contend_smpl_t;
+
+static int
+contend_smpl_cmp(const void *p1, const void *p2)
+{
+	const contend_smpl_t *s1 = (const contend_smpl_t *)p1;
+	const contend_smpl_t *s2 = (const contend_smpl_t *)p2;
+
+	if (s1->line != s2->line) {
+		return ((s1->line < s2->line) ? -1 : 1);
+	}
+
+	return (s1->idx - s2->idx);
+}
+
+static int
+contend_line_cmp(const void *p1, const void *p2)
+{
+	const contend_line_t *l1 = (const contend_line_t *)p1;
+	const contend_line_t *l2 = (const contend_line_t *)p2;
+
+	if (l1->nhitm != l2->nhitm) {
+		return (l2->nhitm - l1->nhitm);
+	}
+
+	return (l2->naccess - l1->naccess);
+}
+
+static int
+node_mask_count(uint64_t node_mask)
+{
+	int n = 0;
+
+	while (node_mask != 0) {
+		node_mask &= node_mask - 1;
+		n++;
+	}
+
+	return (n);
+}
+
+/*
+ * Group the LL samples of process (or thread) by cacheline. A line is
+ * reported if it's accessed from CPUs on more than one node and either
+ * it has a HITM access or its average latency is not lower than the
+ * p90 latency of all the samples ("*lat_thresh").
+ */
+static int
+contend_lines_get(track_proc_t *proc, track_lwp_t *lwp,
+	contend_line_t **arr, int *nlines, uint64_t *nsamples,
+	uint64_t *lat_thresh)
+{
+	perf_llrecgrp_t *grp;
+	os_perf_llrec_t *rec;
+	contend_smpl_t *smpl = NULL;
+	contend_line_t *lines = NULL, *line;
+	lat_hist_t hist;
+	node_t *node;
+	int *cpu_nid;
+	int i, j, n = 0, nlines_cur = 0, nlines_max = 0, last, nhitm;
+	uint64_t node_mask, total_lat, max_lat;
+
+	*arr = NULL;
+	*nlines = 0;
+	*nsamples = 0;
+	*lat_thresh = 0;
+	memset(&hist, 0, sizeof (lat_hist_t));
+
+	if ((cpu_nid = zalloc(sizeof (int) * ncpus_max)) == NULL) {
+		return (-1);
+	}
+
+	for (i = 0; i < ncpus_max; i++) {
+		cpu_nid[i] = MAP_NID_PENDING;
+	}
+
+	(void) pthread_mutex_lock(&proc->mutex);
+	grp = (lwp == NULL) ? &proc->llrec_grp : &lwp->llrec_grp;
+	if ((grp->nrec_cur > 0) &&
+		((smpl = zalloc(sizeof (contend_smpl_t) * grp->nrec_cur)) == NULL)) {
+		goto L_EXIT;
+	}
+
+	for (i = 0; i < grp->nrec_cur; i++) {
+		rec = grp->rec_arr[i];
+		if ((rec->addr == 0) || (rec->cpu >= (uint64_t)ncpus_max)) {
+			continue;
+		}
+
+		if (cpu_nid[rec->cpu] == MAP_NID_PENDING) {
+			node = node_by_cpu((int)rec->cpu);
+			cpu_nid[rec->cpu] = (node != NULL) ? node->nid : -1;
+		}
+
+		smpl[n].line = rec->addr & ~((uint64_t)CACHELINE_SIZE - 1);
+		smpl[n].latency = rec->latency;
+		smpl[n].nid = cpu_nid[rec->cpu];
+		smpl[n].idx = i;
+		smpl[n].seq = rec->seq;
+		smpl[n].hitm = rec->hitm;
+		lat_hist_add(&hist, rec->latency);
+		n++;
+	}
+
+	*nsamples = n;
+	*lat_thresh = lat_hist_percentile(&hist, 90);
+	qsort(smpl, n, sizeof (contend_smpl_t), contend_smpl_cmp);
+
+	for (i = 0; i < n; i = j) {
+		node_mask = 0;
+		total_lat = 0;
+		max_lat = 0;
+		nhitm = 0;
+		last = i;
+		for (j = i; (j < n) && (smpl[j].line == smpl[i].line); j++) {
+			if (smpl[j].seq > smpl[last].seq) {
+				last = j;
+			}
+
+			if ((smpl[j].nid >= 0) && (smpl[j].nid < 64)) {
+				node_mask |= 1ULL << smpl[j].nid;
+			}
+
+			if (smpl[j].hitm) {
+				nhitm++;
+			}
+
+			total_lat += smpl[j].latency;
+			if (smpl[j].latency > max_lat) {
+				max_lat = smpl[j].latency;
+			}
+		}
+
+		if ((node_mask_count(node_mask) < 2) ||
+			((nhitm == 0) && (total_lat / (j - i) < *lat_thresh))) {
+			continue;
+		}
+
+		if (array_alloc((void **)&lines, &nlines_cur, &nlines_max,
+			sizeof (contend_line_t), 16) != 0) {
+			goto L_EXIT;
+		}
+
+		line = &lines[nlines_cur++];
+		memset(line, 0, sizeof (contend_line_t));
+		line->addr = smpl[i].line;
+		line->naccess = j - i;
+		line->nhitm = nhitm;
+		line->total_lat = total_lat;
+		line->max_lat = max_lat;
+		line->node_mask = node_mask;
+
+		/*
+		 * Show the call chain of the latest access.
+		 */
+		last = smpl[last].idx;
+		line->ip_num = grp->rec_arr[last]->callchain.ip_num;
+		memcpy(line->ips, grp->rec_arr[last]->callchain.ips,
+			line->ip_num * sizeof (uint64_t));
+	}
+
+	(void) pthread_mutex_unlock(&proc->mutex);
+	free(smpl);
+	free(cpu_nid);
+
+	if (nlines_cur > 0) {
+		qsort(lines, nlines_cur, sizeof (contend_line_t), contend_line_cmp);
+	}
+
+	*arr = lines;
+	*nlines = nlines_cur;
+	return (0);
+
+L_EXIT:
+	(void) pthread_mutex_unlock(&proc->mutex);
+	if (smpl != NULL) {
+		free(smpl);
+	}
+
+	if (lines != NULL) {
+		free(lines);
+	}
+
+	free(cpu_nid);
+	return (-1);
+}
+
+/*
+ * Build the readable string of data line which contains cacheline
+ * address, number of accesses, HITM%, average latency, max latency,
+ * the accessing nodes and the data symbol.
+ */
+static void
+contend_str_build(char *buf, int size, int idx, void *pv)
+{
+	contend_line_t *lines = (contend_line_t *)pv;
+	contend_line_t *line = &lines[idx];
+	char nodes_str[16];
+
+	heat_nodes_str(line->node_mask, nodes_str, sizeof (nodes_str));
+
+	(void) snprintf(buf, size,
+		"%16"PRIX64"%8d%8.1f%11"PRIu64"%11"PRIu64"%12s  %s",
+		line->addr, line->naccess,
+		ratio(line->nhitm, line->naccess) * 100.0,
+		cyc2ns(line->total_lat / line->naccess), cyc2ns(line->max_lat),
+		nodes_str, line->desc);
+}
+
+static void
+contend_line_get(win_reg_t *r, int idx, char *line, int size)
+{
+	contend_str_build(line, size, idx, r->buf);
+}
+
+/*
+ * Show the call-chain of the latest access to the cacheline which is
+ * highlighted (or the first cacheline if nothing is highlighted).
+ */
+static void
+contend_detail_show(dyn_contend_t *dyn, track_proc_t *proc)
+{
+	contend_line_t *lines = (contend_line_t *)(dyn->data.buf);
+	contend_line_t *line;
+	sym_chainlist_t chainlist;
+	char content[WIN_LINECHAR_MAX];
+	int idx;
+
+	reg_erase(&dyn->chain_caption);
+	memset(&chainlist, 0, sizeof (sym_chainlist_t));
+
+	if ((lines == NULL) || (dyn->data.nlines_total == 0)) {
+		reg_refresh_nout(&dyn->chain_caption);
+		chainlist_show(&chainlist, &dyn->chain_data);
+		return;
+	}
+
+	if ((idx = dyn->data.scroll.highlight) < 0) {
+		idx = 0;
+	}
+
+	line = &lines[idx];
+	(void) snprintf(content, sizeof (content),
+		"Call-chain of the latest access to cacheline %"PRIX64" (%s):",
+		line->addr, line->desc);
+	reg_line_write(&dyn->chain_caption, 1, ALIGN_LEFT, content);
+	dump_write("%s\n", content);
+	reg_refresh_nout(&dyn->chain_caption);
+
+	if ((line->ip_num > 0) && (sym_load(proc, SYM_TYPE_FUNC) == 0)) {
+		sym_callchain_add(&proc->sym, line->ips, line->ip_num,
+			&chainlist);
+	}
+
+	chainlist_show(&chainlist, &dyn->chain_data);
+}
+
+static boolean_t
+contend_data_show(track_proc_t *proc, track_lwp_t *lwp, dyn_contend_t *dyn)
+{
+	contend_line_t *lines;
+	map_entry_t *entry;
+	uint64_t nsamples, lat_thresh;
+	char content[WIN_LINECHAR_MAX], intval_buf[16];
+	boolean_t loaded;
+	int nlines, i;
+
+	if (contend_lines_get(proc, lwp, &lines, &nlines, &nsamples,
+		&lat_thresh) != 0) {
+		return (B_FALSE);
+	}
+
+	/*
+	 * Prefer the data symbol, fall back to the memory area.
+	 */
+	loaded = (nlines > 0) && (sym_load(proc, SYM_TYPE_FUNC) == 0);
+	for (i = 0; i < nlines; i++) {
+		if (loaded && (sym_data_resolve(&proc->sym, lines[i].addr,
+			lines[i].desc, WIN_DESCBUF_SIZE) == 0)) {
+			continue;
+		}
+
+		if (((entry = map_entry_lookup(proc, lines[i].addr)) != NULL) &&
+			(entry->desc != NULL)) {
+			bufdesc_cut(lines[i].desc, WIN_DESCBUF_SIZE, entry->desc);
+		} else {
+			(void) strcpy(lines[i].desc, "-");
+		}
+	}
+
+	reg_erase(&dyn->msg);
+	disp_intval(intval_buf, 16);
+	(void) snprintf(content, sizeof (content),
+		"Cross-node cachelines (%s: %d, lines: %d, samples: %"PRIu64
+		", p90: %"PRIu64"ns, interval: %s)",
+		(dyn->lwpid == 0) ? "pid" : "lwpid",
+		(dyn->lwpid == 0) ? proc->pid : dyn->lwpid, nlines, nsamples,
+		cyc2ns(lat_thresh), intval_buf);
+	reg_line_write(&dyn->msg, 1, ALIGN_LEFT, content);
+	dump_write("\n*** %s\n", content);
+	reg_refresh_nout(&dyn->msg);
+
+	/*
+	 * Display the caption of data table:
+	 * "ADDR ACCESS HITM% LAT(ns) MAX(ns) ACC.NODES DATA"
+	 */
+	reg_erase(&dyn->caption);
+	(void) snprintf(content, sizeof (content),
+		"%16s%8s%9s%11s%11s%12s  %s",
+		CAPTION_ADDR, CAPTION_ACCESS, CAPTION_HITM, CAPTION_AVGLAT,
+		CAPTION_MAXLAT, CAPTION_ACCNODES, CAPTION_DATA);
+	reg_line_write(&dyn->caption, 1, ALIGN_LEFT, content);
+	dump_write("%s\n", content);
+	reg_refresh_nout(&dyn->caption);
+
+	reg_erase(&dyn->data);
+	if (dyn->data.buf != NULL) {
+		free(dyn->data.buf);
+	}
+
+	dyn->data.buf = (void *)lines;
+	dyn->data.nlines_total = nlines;
+	if (dyn->data.scroll.highlight >= nlines) {
+		dyn->data.scroll.highlight = -1;
+	}
+
+	reg_scroll_show(&dyn->data, (void *)lines, nlines, contend_str_build);
+	reg_refresh_nout(&dyn->data);
+
+	contend_detail_show(dyn, proc);
+	return (B_TRUE);
+}
+
+/*
+ * Initialize the display layout for window type
+ * "WIN_TYPE_CONTEND_PROC" and "WIN_TYPE_CONTEND_LWP".
+ */
+void *
+os_contend_dyn_create(page_t *page)
+{
+	dyn_contend_t *dyn;
+	cmd_contend_t *cmd = CMD_CONTEND(&page->cmd);
+	int i, ndata;
+
+	if ((dyn = zalloc(sizeof (dyn_contend_t))) == NULL) {
+		return (NULL);
+	}
+
+	dyn->pid = cmd->pid;
+	dyn->lwpid = cmd->lwpid;
+
+	if ((i = reg_init(&dyn->msg, 0, 1, g_scr_width, 2, A_BOLD)) < 0)
+		goto L_EXIT;
+	if ((i = reg_init(&dyn->caption, 0, i, g_scr_width, 2, A_BOLD | A_UNDERLINE)) < 0)
+		goto L_EXIT;
+
+	ndata = (g_scr_height - i - 4) / 2;
+	if ((i = reg_init(&dyn->data, 0, i, g_scr_width, ndata, 0)) < 0)
+		goto L_EXIT;
+	reg_buf_init(&dyn->data, NULL, contend_line_get);
+	reg_scroll_init(&dyn->data, B_TRUE);
+
+	if ((i = reg_init(&dyn->chain_caption, 0, i, g_scr_width, 2, A_BOLD | A_UNDERLINE)) < 0)
+		goto L_EXIT;
+	if ((reg_init(&dyn->chain_data, 0, i, g_scr_width, g_scr_height - i - 2, 0)) < 0)
+		goto L_EXIT;
+	reg_buf_init(&dyn->chain_data, NULL, win_callchain_line_get);
+	reg_scroll_init(&dyn->chain_data, B_FALSE);
+
+	return (dyn);
+L_EXIT:
+	free(dyn);
+	return (NULL);
+}
+
+void
+os_contend_win_destroy(dyn_win_t *win)
+{
+	dyn_contend_t *dyn;
+
+	if ((dyn = win->dyn) != NULL) {
+		if (dyn->data.buf != NULL) {
+			free(dyn->data.buf);
+		}
+
+		if (dyn->chain_data.buf != NULL) {
+			free(dyn->chain_data.buf);
+		}
+
+		reg_win_destroy(&dyn->msg);
+		reg_win_destroy(&dyn->caption);
+		reg_win_destroy(&dyn->data);
+		reg_win_destroy(&dyn->chain_caption);
+		reg_win_destroy(&dyn->chain_data);
+		free(dyn);
+	}
+}
+
+/*
+ * The implementation of displaying window on screen for
+ * window type "WIN_TYPE_CONTEND_PROC" and "WIN_TYPE_CONTEND_LWP"
+ */
+boolean_t
+os_contend_win_draw(dyn_win_t *win)
+{
+	dyn_contend_t *dyn = (dyn_contend_t *)(win->dyn);
+	track_proc_t *proc;
+	track_lwp_t *lwp = NULL;
+	boolean_t ret;
+
+	if ((proc = proc_find(dyn->pid)) == NULL) {
+		win_warn_msg(WARN_INVALID_PID);
+		win_note_show(NOTE_INVALID_PID);
+		return (B_FALSE);
+	}
+
+	if ((dyn->lwpid > 0) &&
+		((lwp = proc_lwp_find(proc, dyn->lwpid)) == NULL)) {
+		proc_refcount_dec(proc);
+		win_warn_msg(WARN_INVALID_LWPID);
+		win_note_show(NOTE_INVALID_LWPID);
+		return (B_FALSE);
+	}
+
+	win_title_show();
+	dump_cache_enable();
+	ret = contend_data_show(proc, lwp, dyn);
+	dump_cache_disable();
+	dump_cache_flush();
+	win_note_show(NOTE_CONTEND);
+
+	if (lwp != NULL) {
+		lwp_refcount_dec(lwp);
+	}
+
+	proc_refcount_dec(proc);
+	reg_update_all();
+	return (ret);
+}
+
+/*
+ * Scrolling the cacheline list also switches the call-chain to the
+ * highlighted cacheline.
+ */
+void
+os_contend_win_scroll(dyn_win_t *win, int scroll_type)
+{
+	dyn_contend_t *dyn = (dyn_contend_t *)(win->dyn);
+	track_proc_t *proc;
+
+	reg_line_scroll(&dyn->data, scroll_type);
+
+	if ((proc = proc_find(dyn->pid)) != NULL) {
+		contend_detail_show(dyn, proc);
+		proc_refcount_dec(proc);
+		reg_update_all();
+	}
+}
+
+/*
+ * Plan the migration of the sampled pages in [addr, addr + size) (all
+ * the sampled pages if "size" is 0). The pages are only reported if
+ * migration is not enabled by "-a".
+ */
+int
+os_migrate_start(map_migrate_t *mig, pid_t pid, int lwpid, uint64_t addr,
+	uint64_t size)
+{
+	track_proc_t *proc;
+	track_lwp_t *lwp = NULL;
+	int ret;
+
+	mig->state = MIGRATE_NONE;
+	if ((proc = proc_find(pid)) == NULL) {
+		return (-1);
+	}
+
+	if ((lwpid != 0) && ((lwp = proc_lwp_find(proc, lwpid)) == NULL)) {
+		proc_refcount_dec(proc);
+		return (-1);
+	}
+
+	if ((ret = map_migrate_plan(proc, lwp, addr, size, mig)) == 0) {
+		mig->state = (g_migrate_rate > 0) ? MIGRATE_RUNNING : MIGRATE_DRYRUN;
+		mig->rma_before = mig->rma_cur;
+		mig->lat_before = mig->lat_cur;
+		mig->last_ms = current_ms(&g_tvbase) - MS_SEC;
+	}
+
+	if (lwp != NULL) {
+		lwp_refcount_dec(lwp);
+	}
+
+	proc_refcount_dec(proc);
+	return (ret);
+}
+
+/*
+ * Called on each interval with the LL metrics of the range. The next
+ * pages of plan are moved if migration is running, no more than
+ * "g_migrate_rate" bytes per second.
+ */
+void
+os_migrate_update(map_migrate_t *mig, track_proc_t *proc, uint64_t naccess,
+	uint64_t total_lat, const memsrc_count_t *memsrc)
+{
+	uint64_t now;
+
+	mig->rma_cur = ratio(memsrc->count[MEM_SRC_REM_DRAM] +
+		memsrc->count[MEM_SRC_REM_CACHE], naccess);
+	mig->lat_cur = (naccess > 0) ? total_lat / naccess : 0;
+
+	if (mig->state != MIGRATE_RUNNING) {
+		return;
+	}
+
+	now = current_ms(&g_tvbase);
+	(void) map_migrate_run(proc, mig,
+		g_migrate_rate * (now - mig->last_ms) / MS_SEC);
+	mig->last_ms = now;
+
+	if (mig->next >= mig->npages) {
+		mig->state = MIGRATE_DONE;
+	}
+}
+
+void
+os_migrate_show(win_reg_t *r, map_migrate_t *mig)
+{
+	char content[WIN_LINECHAR_MAX], size_str[32];
+
+	reg_erase(r);
+
+	switch (mig->state) {
+	case MIGRATE_DRYRUN:
+		win_size2str((uint64_t)mig->npages * g_pagesize, size_str,
+			sizeof (size_str));
+		(void) snprintf(content, sizeof (content),
+			"Dry run: %d pages (%s) to move, %d pages already on "
+			"the accessing node (run with -a to migrate)",
+			mig->npages, size_str, mig->nlocal);
+		break;
+
+	case MIGRATE_RUNNING:
+	case MIGRATE_DONE:
+		win_size2str((uint64_t)mig->nmoved * g_pagesize, size_str,
+			sizeof (size_str));
+		(void) snprintf(content, sizeof (content),
+			"Migration %s: %d/%d pages (%s) moved, %d failed; "
+			"RMA: %.1f%% -> %.1f%%, LAT: %"PRIu64"ns -> %"PRIu64"ns",
+			(mig->state == MIGRATE_DONE) ? "done" : "running",
+			mig->nmoved, mig->npages, size_str, mig->nfailed,
+			mig->rma_before * 100.0, mig->rma_cur * 100.0,
+			cyc2ns(mig->lat_before), cyc2ns(mig->lat_cur));
+		break;
+
+	default:
+		reg_refresh_nout(r);
+		return;
+	}
+
+	reg_line_write(r, 0, ALIGN_LEFT, content);
+	dump_write("%s\n", content);
+	reg_refresh_nout(r);
+}
+
+static void
+advisor_str_build(char *buf, int size, int idx, void *pv)
+{
+	advisor_line_t *lines = (advisor_line_t *)pv;
+	advisor_line_t *line = &lines[idx];
+	char run_str[16], mem_str[16], advice_str[16];
+
+	(void) snprintf(run_str, sizeof (run_str), "%d", line->run_nid);
+	(void) snprintf(mem_str, sizeof (mem_str), "%d", line->mem_nid);
+	if (line->advise) {
+		(void) snprintf(advice_str, sizeof (advice_str), "node %d",
+			line->mem_nid);
+	} else {
+		(void) snprintf(advice_str, sizeof (advice_str), "-");
+	}
+
+	(void) snprintf(buf, size, "%8d%10d%10s%10s%8.1f%12.1f%10.1f%10s",
+		line->lwpid, line->naccess,
+		(line->run_nid >= 0) ? run_str : "-",
+		(line->mem_nid >= 0) ? mem_str : "-",
+		line->rma * 100.0, line->rma_bind * 100.0, line->idle_cpus,
+		advice_str);
+}
+
+static void
+advisor_line_get(win_reg_t *r, int idx, char *line, int size)
+{
+	advisor_str_build(line, size, idx, r->buf);
+}
+
+static int
+advisor_line_cmp(const void *p1, const void *p2)
+{
+	const advisor_line_t *l1 = (const advisor_line_t *)p1;
+	const advisor_line_t *l2 = (const advisor_line_t *)p2;
+
+	return (l2->naccess - l1->naccess);
+}
+
+/*
+ * Compute the number of idle CPUs per node since the last refresh from
+ * the CPU time in '/proc/stat'. Nothing is computed until there is a
+ * previous sample to diff against.
+ */
+static void
+advisor_idle_get(dyn_advisor_t *dyn, double *node_idle)
+{
+	uint64_t *busy, *total, dbusy, dtotal;
+	node_t *node;
+	int i, j, cpuid;
+
+	(void) memset(node_idle, 0, sizeof (double) * nnodes_max);
+
+	if (((busy = zalloc(sizeof (uint64_t) * ncpus_max)) == NULL) ||
+		((total = zalloc(sizeof (uint64_t) * ncpus_max)) == NULL)) {
+		if (busy != NULL) {
+			free(busy);
+		}
+
+		return;
+	}
+
+	if (os_procfs_cpu_time(busy, total, ncpus_max) != 0) {
+		free(busy);
+		free(total);
+		return;
+	}
+
+	for (i = 0; (i < nnodes_max) && dyn->cpu_valid; i++) {
+		node = node_get(i);
+		if (!NODE_VALID(node)) {
+			continue;
+		}
+
+		for (j = 0; j < ncpus_max; j++) {
+			if ((cpuid = node->cpus[j].cpuid) == INVALID_CPUID) {
+				continue;
+			}
+
+			dbusy = busy[cpuid] - dyn->cpu_busy[cpuid];
+			dtotal = total[cpuid] - dyn->cpu_total[cpuid];
+			if (dtotal > 0) {
+				node_idle[i] += 1.0 - ratio(dbusy, dtotal);
+			}
+		}
+	}
+
+	free(dyn->cpu_busy);
+	free(dyn->cpu_total);
+	dyn->cpu_busy = busy;
+	dyn->cpu_total = total;
+	dyn->cpu_valid = B_TRUE;
+}
+
+static int
+node_argmax(int *cnt)
+{
+	int i, nid = -1;
+
+	for (i = 0; i < nnodes_max; i++) {
+		if ((cnt[i] > 0) && ((nid == -1) || (cnt[i] > cnt[nid]))) {
+			nid = i;
+		}
+	}
+
+	return (nid);
+}
+
+/*
+ * Work out the placement of a thread from its LL samples. The thread
+ * is advised to run on the node which holds most of the memory it
+ * accesses if that lowers the remote accesses and the node has at
+ * least one idle CPU.
+ */
+static boolean_t
+advisor_line_build(track_proc_t *proc, int lwpid, map_place_t *place,
+	double *node_idle, advisor_line_t *line)
+{
+	track_lwp_t *lwp;
+	int ret;
+
+	(void) memset(line, 0, sizeof (advisor_line_t));
+	if ((lwp = proc_lwp_find(proc, lwpid)) == NULL) {
+		return (B_FALSE);
+	}
+
+	ret = map_lwp_place(proc, lwp, place);
+	lwp_refcount_dec(lwp);
+	if ((ret != 0) || (place->naccess == 0)) {
+		return (B_FALSE);
+	}
+
+	line->lwpid = lwpid;
+	line->naccess = place->naccess;
+	line->run_nid = node_argmax(place->run_cnt);
+	line->mem_nid = node_argmax(place->mem_cnt);
+	line->rma = ratio(place->nremote, place->naccess);
+	line->rma_bind = ratio(place->naccess -
+		place->mem_cnt[line->mem_nid], place->naccess);
+	line->idle_cpus = node_idle[line->mem_nid];
+	line->advise = ((line->mem_nid != line->run_nid) &&
+		(line->rma_bind < line->rma) && (line->idle_cpus >= 1.0));
+
+	return (B_TRUE);
+}
+
+static boolean_t
+advisor_data_show(track_proc_t *proc, dyn_advisor_t *dyn)
+{
+	advisor_line_t *lines = NULL;
+	map_place_t place;
+	double *node_idle = NULL;
+	int *lwpids = NULL;
+	int i, nlwps, nlines = 0;
+	char content[WIN_LINECHAR_MAX], intval_buf[16];
+	boolean_t ret = B_FALSE;
+
+	(void) memset(&place, 0, sizeof (place));
+	if (((node_idle = zalloc(sizeof (double) * nnodes_max)) == NULL) ||
+		((place.run_cnt = zalloc(sizeof (int) * nnodes_max)) == NULL) ||
+		((place.mem_cnt = zalloc(sizeof (int) * nnodes_max)) == NULL) ||
+		((lwpids = zalloc(sizeof (int) * WIN_NLINES_MAX)) == NULL) ||
+		((lines = zalloc(sizeof (advisor_line_t) * WIN_NLINES_MAX)) ==
+		NULL)) {
+		goto L_EXIT;
+	}
+
+	advisor_idle_get(dyn, node_idle);
+	map_pagecache_refresh(proc);
+
+	(void) pthread_mutex_lock(&proc->mutex);
+	nlwps = MIN(proc->lwp_list.nlwps, WIN_NLINES_MAX);
+	for (i = 0; i < nlwps; i++) {
+		lwpids[i] = proc->lwp_list.id_arr[i]->id;
+	}
+	(void) pthread_mutex_unlock(&proc->mutex);
+
+	for (i = 0; i < nlwps; i++) {
+		if (advisor_line_build(proc, lwpids[i], &place, node_idle,
+			&lines[nlines])) {
+			nlines++;
+		}
+	}
+
+	qsort(lines, nlines, sizeof (advisor_line_t), advisor_line_cmp);
+
+	reg_erase(&dyn->msg);
+	disp_intval(intval_buf, 16);
+	(void) snprintf(content, sizeof (content),
+		"Thread placement advisor for \"%s\" (%d) (interval: %s)",
+		proc->name, proc->pid, intval_buf);
+	reg_line_write(&dyn->msg, 1, ALIGN_LEFT, content);
+	dump_write("\n*** %s\n", content);
+	reg_refresh_nout(&dyn->msg);
+
+	/*
+	 * Display the caption of data table:
+	 * "LWP SAMPLES RUN.NODE MEM.NODE RMA% RMA%.BIND IDLE.CPU ADVICE"
+	 */
+	reg_erase(&dyn->caption);
+	(void) snprintf(content, sizeof (content),
+		"%8s%10s%10s%10s%9s%13s%10s%10s",
+		CAPTION_LWP, CAPTION_SAMPLES, CAPTION_RUNNODE, CAPTION_MEMNODE,
+		CAPTION_RMA_NOW, CAPTION_RMA_BIND, CAPTION_IDLECPU,
+		CAPTION_ADVICE);
+	reg_line_write(&dyn->caption, 1, ALIGN_LEFT, content);
+	dump_write("%s\n", content);
+	reg_refresh_nout(&dyn->caption);
+
+	reg_erase(&dyn->data);
+	if (dyn->data.buf != NULL) {
+		free(dyn->data.buf);
+	}
+
+	dyn->data.buf = (void *)lines;
+	dyn->data.nlines_total = nlines;
+	if (dyn->data.scroll.highlight >= nlines) {
+		dyn->data.scroll.highlight = -1;
+	}
+
+	reg_scroll_show(&dyn->data, (void *)lines, nlines, advisor_str_build);
+	reg_refresh_nout(&dyn->data);
+	lines = NULL;
+
+	reg_erase(&dyn->hint);
+	if (dyn->status[0] != 0) {
+		reg_line_write(&dyn->hint, 0, ALIGN_LEFT, dyn->status);
+		dump_write("%s\n", dyn->status);
+	} else {
+		reg_line_write(&dyn->hint, 0, ALIGN_LEFT,
+			"RMA%% = samples to memory on other nodes, "
+			"RMA%%.BIND = if bound to MEM.NODE, "
+			"IDLE.CPU = idle CPUs on MEM.NODE");
+	}
+
+	reg_refresh_nout(&dyn->hint);
+	ret = B_TRUE;
+
+L_EXIT:
+	if (node_idle != NULL) {
+		free(node_idle);
+	}
+
+	if (place.run_cnt != NULL) {
+		free(place.run_cnt);
+	}
+
+	if (place.mem_cnt != NULL) {
+		free(place.mem_cnt);
+	}
+
+	if (lwpids != NULL) {
+		free(lwpids);
+	}
+
+	if (lines != NULL) {
+		free(lines);
+	}
+
+	return (ret);
+}
+
+/*
+ * Initialize the display layout for window type "WIN_TYPE_ADVISOR"
+ */
+void *
+os_advisor_dyn_create(page_t *page)
+{
+	dyn_advisor_t *dyn;
+	int i;
+
+	if ((dyn = zalloc(sizeof (dyn_advisor_t))) == NULL) {
+		return (NULL);
+	}
+
+	if (((dyn->cpu_busy = zalloc(sizeof (uint64_t) * ncpus_max)) == NULL) ||
+		((dyn->cpu_total = zalloc(sizeof (uint64_t) * ncpus_max)) == NULL))
+		goto L_EXIT;
+
+	/*
+	 * The first interval starts from here rather than from zero.
+	 */
+	dyn->cpu_valid = (os_procfs_cpu_time(dyn->cpu_busy, dyn->cpu_total,
+		ncpus_max) == 0);
+	dyn->pid = CMD_ADVISOR(&page->cmd)->pid;
+
+	if ((i = reg_init(&dyn->msg, 0, 1, g_scr_width, 2, A_BOLD)) < 0)
+		goto L_EXIT;
+	if ((i = reg_init(&dyn->caption, 0, i, g_scr_width, 2, A_BOLD | A_UNDERLINE)) < 0)
+		goto L_EXIT;
+	if ((i = reg_init(&dyn->data, 0, i, g_scr_width, g_scr_height - i - 4, 0)) < 0)
+		goto L_EXIT;
+	reg_buf_init(&dyn->data, NULL, advisor_line_get);
+	reg_scroll_init(&dyn->data, B_TRUE);
+	(void) reg_init(&dyn->hint, 0, i, g_scr_width, 1, A_BOLD);
+
+	return (dyn);
+L_EXIT:
+	if (dyn->cpu_busy != NULL) {
+		free(dyn->cpu_busy);
+	}
+
+	if (dyn->cpu_total != NULL) {
+		free(dyn->cpu_total);
+	}
+
+	free(dyn);
+	return (NULL);
+}
+
+void
+os_advisor_win_destroy(dyn_win_t *win)
+{
+	dyn_advisor_t *dyn;
+
+	if ((dyn = win->dyn) != NULL) {
+		if (dyn->data.buf != NULL) {
+			free(dyn->data.buf);
+		}
+
+		free(dyn->cpu_busy);
+		free(dyn->cpu_total);
+		reg_win_destroy(&dyn->msg);
+		reg_win_destroy(&dyn->caption);
+		reg_win_destroy(&dyn->data);
+		reg_win_destroy(&dyn->hint);
+		free(dyn);
+	}
+}
+
+/*
+ * The implementation of displaying window on screen for
+ * window type "WIN_TYPE_ADVISOR"
+ */
+boolean_t
+os_advisor_win_draw(dyn_win_t *win)
+{
+	dyn_advisor_t *dyn = (dyn_advisor_t *)(win->dyn);
+	track_proc_t *proc;
+	boolean_t ret;
+
+	if ((proc = proc_find(dyn->pid)) == NULL) {
+		win_warn_msg(WARN_INVALID_PID);
+		win_note_show(NOTE_INVALID_PID);
+		return (B_FALSE);
+	}
+
+	win_title_show();
+	ret = advisor_data_show(proc, dyn);
+	win_note_show(NOTE_ADVISOR);
+	proc_refcount_dec(proc);
+	reg_update_all();
+	return (ret);
+}
+
+void
+os_advisor_win_scroll(dyn_win_t *win, int scroll_type)
+{
+	dyn_advisor_t *dyn = (dyn_advisor_t *)(win->dyn);
+
+	reg_line_scroll(&dyn->data, scroll_type);
+}
+
+/*
+ * Bind the highlighted thread to the CPUs of the node it's advised to
+ * run on. The result is shown in the hint line on next refresh.
+ */
+int
+os_advisor_bind(dyn_advisor_t *dyn)
+{
+	advisor_line_t *lines = (advisor_line_t *)(dyn->data.buf);
+	advisor_line_t *line;
+	int idx = dyn->data.scroll.highlight;
+
+	if ((lines == NULL) || (idx < 0) || (idx >= dyn->data.nlines_total)) {
+		(void) snprintf(dyn->status, sizeof (dyn->status),
+			"Select a thread with <UP>/<DOWN> to bind");
+		return (-1);
+	}
+
+	line = &lines[idx];
+	if (!line->advise) {
+		(void) snprintf(dyn->status, sizeof (dyn->status),
+			"No binding is advised for thread %d", line->lwpid);
+		return (-1);
+	}
+
+	if (os_lwp_node_bind(line->lwpid, node_get(line->mem_nid)) != 0) {
+		(void) snprintf(dyn->status, sizeof (dyn->status),
+			"Failed to bind thread %d to node %d", line->lwpid,
+			line->mem_nid);
+		return (-1);
+	}
+
+	(void) snprintf(dyn->status, sizeof (dyn->status),
+		"Thread %d is bound to node %d", line->lwpid, line->mem_nid);
+	return (0);
+}
+
+/*
+ * The node where the process runs, i.e. the node on which the process
+ * consumed most of the CPU cycles in the last interval.
+ */
+static int
+damon_run_node(track_proc_t *proc)
+{
+	uint64_t clk, max = 0;
+	int i, nid = -1;
+
+	for (i = 0; i < nnodes_max; i++) {
+		if (!NODE_VALID(node_get(i))) {
+			continue;
+		}
+
+		clk = node_countval_sum(proc->countval_arr, i, UI_COUNT_CLK);
+		if (clk > max) {
+			max = clk;
+			nid = i;
+		}
+	}
+
+	return (nid);
+}
+
+/*
+ * Accumulate the resident bytes per node of the DAMON regions. The node
+ * placement is refreshed once for each mapping which overlaps at least
+ * one region. "node_bytes" has "nnodes_max" entries per line.
+ */
+static void
+damon_nodes_fill(track_proc_t *proc, damon_line_t *lines, int nlines,
+	uint64_t *node_bytes)
+{
+	map_entry_t *entry;
+	numa_entry_t *ne;
+	damon_region_t *r;
+	uint64_t start, end;
+	int i, j, k;
+
+	if (map_proc_load(proc) != 0) {
+		return;
+	}
+
+	(void) map_numamaps_load(proc);
+	for (i = 0; i < proc->map.nentry_cur; i++) {
+		entry = &proc->map.arr[i];
+		for (j = 0; j < nlines; j++) {
+			r = &lines[j].region;
+			if ((r->start_addr < entry->end_addr) &&
+				(r->end_addr > entry->start_addr)) {
+				break;
+			}
+		}
+
+		if ((j == nlines) || (map_map2numa(proc, entry) != 0)) {
+			continue;
+		}
+
+		for (k = 0; k < entry->numa_map.nentry_cur; k++) {
+			ne = &entry->numa_map.arr[k];
+			if ((ne->nid < 0) || (ne->nid >= nnodes_max)) {
+				continue;
+			}
+
+			for (j = 0; j < nlines; j++) {
+				r = &lines[j].region;
+				start = (r->start_addr > ne->start_addr) ?
+					r->start_addr : ne->start_addr;
+				end = MIN(r->end_addr, ne->end_addr);
+				if (start < end) {
+					node_bytes[j * nnodes_max + ne->nid] +=
+						end - start;
+				}
+			}
+		}
+	}
+}
+
+static int
+damon_line_cmp(const void *p1, const void *p2)
+{
+	const damon_line_t *l1 = (const damon_line_t *)p1;
+	const damon_line_t *l2 = (const damon_line_t *)p2;
+
+	if (l1->region.nr_accesses != l2->region.nr_accesses) {
+		return ((l1->region.nr_accesses > l2->region.nr_accesses) ?
+			-1 : 1);
+	}
+
+	if (l1->remote != l2->remote) {
+		return ((l1->remote > l2->remote) ? -1 : 1);
+	}
+
+	return (0);
+}
+
+/*
+ * Build the readable string of data line which contains region address,
+ * size, access frequency, age, the node holding most of the pages, the
+ * remote ratio and the description of memory area.
+ */
+static void
+damon_str_build(char *buf, int size, int idx, void *pv)
+{
+	damon_line_t *lines = (damon_line_t *)pv;
+	damon_line_t *line = &lines[idx];
+	damon_region_t *r = &line->region;
+	char size_str[32], nid_str[16];
+
+	win_size2str(r->end_addr - r->start_addr, size_str, sizeof (size_str));
+
+	if (line->nid < 0) {
+		(void) snprintf(nid_str, sizeof (nid_str), "-");
+	} else {
+		(void) snprintf(nid_str, sizeof (nid_str), "%d", line->nid);
+	}
+
+	(void) snprintf(buf, size,
+		"%16"PRIX64"%8s%8.1f%8.1f%6s%9.1f  %s",
+		r->start_addr, size_str,
+		ratio(r->nr_accesses, DAMON_ACCESS_MAX) * 100.0,
+		(double)r->age * DAMON_AGGR_US / MICROSEC,
+		nid_str, line->remote * 100.0, line->desc);
+}
+
+static void
+damon_line_get(win_reg_t *r, int idx, char *line, int size)
+{
+	damon_str_build(line, size, idx, r->buf);
+}
+
+/*
+ * Show the regions which are accessed in the latest aggregation interval
+ * and have resident pages on other nodes than where the process runs.
+ */
+static boolean_t
+damon_data_show(track_proc_t *proc, dyn_damon_t *dyn)
+{
+	damon_region_t *regions = NULL;
+	damon_line_t *lines = NULL, *line;
+	map_entry_t *entry;
+	uint64_t *node_bytes = NULL, bytes;
+	char content[WIN_LINECHAR_MAX], intval_buf[16];
+	int nregions = 0, nlines = 0, nhot = 0, run_nid, i, j, k;
+	boolean_t ret = B_FALSE;
+
+	reg_erase(&dyn->msg);
+	if (!dyn->started ||
+		(damon_regions_get(&regions, &nregions) != 0)) {
+		(void) snprintf(content, sizeof (content),
+			"DAMON is not available or busy (pid: %d, sysfs: %s)",
+			dyn->pid, g_damon_root);
+		reg_line_write(&dyn->msg, 1, ALIGN_LEFT, content);
+		dump_write("\n*** %s\n", content);
+		reg_refresh_nout(&dyn->msg);
+		return (B_FALSE);
+	}
+
+	for (i = 0; i < nregions; i++) {
+		if (regions[i].nr_accesses > 0) {
+			nhot++;
+		}
+	}
+
+	if ((nhot > 0) &&
+		(((lines = zalloc(sizeof (damon_line_t) * nhot)) == NULL) ||
+		((node_bytes = zalloc(sizeof (uint64_t) * nhot *
+		nnodes_max)) == NULL))) {
+		goto L_EXIT;
+	}
+
+	for (i = 0; i < nregions; i++) {
+		if (regions[i].nr_accesses > 0) {
+			lines[nlines++].region = regions[i];
+		}
+	}
+
+	damon_nodes_fill(proc, lines, nlines, node_bytes);
+	run_nid = damon_run_node(proc);
+
+	/*
+	 * Keep the "hot but remote" regions only.
+	 */
+	for (i = 0, j = 0; i < nlines; i++) {
+		line = &lines[i];
+		line->nid = -1;
+		bytes = 0;
+		for (k = 0; k < nnodes_max; k++) {
+			line->resident += node_bytes[i * nnodes_max + k];
+			if (node_bytes[i * nnodes_max + k] > bytes) {
+				bytes = node_bytes[i * nnodes_max + k];
+				line->nid = k;
+			}
+		}
+
+		if ((line->resident == 0) || (run_nid < 0)) {
+			continue;
+		}
+
+		line->remote = 1.0 - ratio(node_bytes[i * nnodes_max + run_nid],
+			line->resident);
+		if (line->remote <= 0.0) {
+			continue;
+		}
+
+		if (((entry = map_entry_lookup(proc,
+			line->region.start_addr)) != NULL) &&
+			(entry->desc != NULL)) {
+			bufdesc_cut(line->desc, WIN_DESCBUF_SIZE, entry->desc);
+		} else {
+			(void) strcpy(line->desc, "-");
+		}
+
+		lines[j++] = *line;
+	}
+
+	nlines = j;
+	if (nlines > 0) {
+		qsort(lines, nlines, sizeof (damon_line_t), damon_line_cmp);
+	}
+
+	disp_intval(intval_buf, 16);
+	if (run_nid >= 0) {
+		(void) snprintf(content, sizeof (content),
+			"Hot remote regions (pid: %d, run node: %d, regions: %d/%d"
+			", interval: %s)", proc->pid, run_nid, nlines, nregions,
+			intval_buf);
+	} else {
+		(void) snprintf(content, sizeof (content),
+			"Hot remote regions (pid: %d, run node: -, regions: %d/%d"
+			", interval: %s)", proc->pid, nlines, nregions,
+			intval_buf);
+	}
+
+	reg_line_write(&dyn->msg, 1, ALIGN_LEFT, content);
+	dump_write("\n*** %s\n", content);
+	reg_refresh_nout(&dyn->msg);
+
+	/*
+	 * Display the caption of data table:
+	 * "ADDR SIZE FREQ% AGE(s) NODE REMOTE% DESC"
+	 */
+	reg_erase(&dyn->caption);
+	(void) snprintf(content, sizeof (content),
+		"%16s%8s%9s%8s%6s%10s  %s",
+		CAPTION_ADDR, CAPTION_SIZE, CAPTION_FREQ, CAPTION_AGE,
+		CAPTION_NID, CAPTION_REMOTE, CAPTION_DESC);
+	reg_line_write(&dyn->caption, 1, ALIGN_LEFT, content);
+	dump_write("%s\n", content);
+	reg_refresh_nout(&dyn->caption);
+
+	reg_erase(&dyn->data);
+	if (dyn->data.buf != NULL) {
+		free(dyn->data.buf);
+	}
+
+	dyn->data.buf = (void *)lines;
+	dyn->data.nlines_total = nlines;
+	if (dyn->data.scroll.highlight >= nlines) {
+		dyn->data.scroll.highlight = -1;
+	}
+
+	reg_scroll_show(&dyn->data, (void *)lines, nlines, damon_str_build);
+	reg_refresh_nout(&dyn->data);
+	lines = NULL;
+	ret = B_TRUE;
+
+L_EXIT:
+	if (lines != NULL) {
+		free(lines);
+	}
+
+	if (node_bytes != NULL) {
+		free(node_bytes);
+	}
+
+	if (regions != NULL) {
+		free(regions);
+	}
+
+	return (ret);
+}
+
+/*
+ * Initialize the display layout for window type "WIN_TYPE_DAMON". DAMON
+ * monitors the process as long as the window exists.
+ */
+void *
+os_damon_dyn_create(page_t *page)
+{
+	dyn_damon_t *dyn;
+	int i;
+
+	if ((dyn = zalloc(sizeof (dyn_damon_t))) == NULL) {
+		return (NULL);
+	}
+
+	dyn->pid = CMD_DAMON(&page->cmd)->pid;
+
+	if ((i = reg_init(&dyn->msg, 0, 1, g_scr_width, 2, A_BOLD)) < 0)
+		goto L_EXIT;
+	if ((i = reg_init(&dyn->caption, 0, i, g_scr_width, 2, A_BOLD | A_UNDERLINE)) < 0)
+		goto L_EXIT;
+	if ((reg_init(&dyn->data, 0, i, g_scr_width, g_scr_height - i - 2, 0)) < 0)
+		goto L_EXIT;
+	reg_buf_init(&dyn->data, NULL, damon_line_get);
+	reg_scroll_init(&dyn->data, B_TRUE);
+
+	/*
+	 * The window is still shown if DAMON can't be started, with the
+	 * reason in the message line.
+	 */
+	dyn->started = (damon_start(dyn->pid) == 0);
+	return (dyn);
+L_EXIT:
+	free(dyn);
+	return (NULL);
+}
+
+void
+os_damon_win_destroy(dyn_win_t *win)
+{
+	dyn_damon_t *dyn;
+
+	if ((dyn = win->dyn) != NULL) {
+		if (dyn->started) {
+			damon_stop();
+		}
+
+		if (dyn->data.buf != NULL) {
+			free(dyn->data.buf);
+		}
+
+		reg_win_destroy(&dyn->msg);
+		reg_win_destroy(&dyn->caption);
+		reg_win_destroy(&dyn->data);
+		free(dyn);
+	}
+}
+
+/*
+ * The implementation of displaying window on screen for
+ * window type "WIN_TYPE_DAMON"
+ */
+boolean_t
+os_damon_win_draw(dyn_win_t *win)
+{
+	dyn_damon_t *dyn = (dyn_damon_t *)(win->dyn);
+	track_proc_t *proc;
+	boolean_t ret;
+
+	if ((proc = proc_find(dyn->pid)) == NULL) {
+		win_warn_msg(WARN_INVALID_PID);
+		win_note_show(NOTE_INVALID_PID);
+		return (B_FALSE);
+	}
+
+	win_title_show();
+	dump_cache_enable();
+	ret = damon_data_show(proc, dyn);
+	dump_cache_disable();
+	dump_cache_flush();
+	win_note_show(NOTE_DAMON);
+
+	proc_refcount_dec(proc);
+	reg_update_all();
+	return (ret);
+}
+
+void
+os_damon_win_scroll(dyn_win_t *win, int scroll_type)
+{
+	dyn_damon_t *dyn = (dyn_damon_t *)(win->dyn);
+
+	reg_line_scroll(&dyn->data, scroll_type);
+}
+
+static double
+link_gbps(uint64_t flits, uint64_t intval_ns)
+{
+	if (intval_ns == 0) {
+		return (0.0);
+	}
+
+	return ((double)(flits * 8) / (double)(GB_BYTES) /
+		((double)intval_ns / (double)NS_SEC));
+}
+
+/*
+ * Sum up the memory controller and link traffic of a node. Without the
+ * separate CAS read/write events the whole memory traffic is in "rd".
+ */
+static void
+uncore_line_fill(node_t *node, uncore_line_t *line)
+{
+	imc_info_t *info;
+	qpi_info_t *qpi;
+	double total;
+	int j;
+
+	(void) memset(line, 0, sizeof (uncore_line_t));
+	line->nid = node->nid;
+	line->split = (node->imc.imc_num > 0) ? B_TRUE : B_FALSE;
+
+	for (j = 0; j < node->imc.imc_num; j++) {
+		info = &node->imc.imc_info[j];
+		if (info->nevents < IMC_CAS_NUM) {
+			line->split = B_FALSE;
+		}
+
+		line->rd += imc_gbps(info->cas_scaled[IMC_CAS_RD], info->intval_ns);
+		line->wr += imc_gbps(info->cas_scaled[IMC_CAS_WR], info->intval_ns);
+	}
+
+	if (!line->split) {
+		line->rd += line->wr;
+		line->wr = 0.0;
+	}
+
+	for (j = 0; j < node->qpi.qpi_num; j++) {
+		qpi = &node->qpi.qpi_info[j];
+		line->link += link_gbps(qpi->value_scaled, qpi->intval_ns);
+	}
+
+	total = line->rd + line->wr + line->link;
+	line->remote = (total > 0.0) ? line->link / total : 0.0;
+}
+
+static void
+uncore_str_build(char *buf, int size, int idx, void *pv)
+{
+	uncore_line_t *lines = (uncore_line_t *)pv;
+	uncore_line_t *line = &lines[idx];
+	char wr[16];
+
+	if (line->split) {
+		(void) snprintf(wr, sizeof (wr), "%.2f", line->wr);
+	} else {
+		(void) strcpy(wr, "-");
+	}
+
+	(void) snprintf(buf, size, "%5d%14.2f%14s%12.2f%9.1f",
+		line->nid, line->rd, wr, line->link, line->remote * 100.0);
+}
+
+static void
+uncore_line_get(win_reg_t *r, int idx, char *line, int size)
+{
+	uncore_str_build(line, size, idx, r->buf);
+}
+
+/*
+ * Show the per-node memory and link traffic, which comes from the
+ * uncore counters only.
+ */
+static boolean_t
+uncore_data_show(dyn_uncore_t *dyn)
+{
+	uncore_line_t *lines;
+	node_t *node;
+	char content[WIN_LINECHAR_MAX], intval_buf[16];
+	double rd = 0.0, wr = 0.0, link = 0.0;
+	int nnodes, i;
+
+	disp_intval(intval_buf, 16);
+	(void) snprintf(content, sizeof (content),
+		"Uncore traffic, counting only (interval: %s)", intval_buf);
+	reg_erase(&dyn->msg);
+	reg_line_write(&dyn->msg, 1, ALIGN_LEFT, content);
+	dump_write("\n*** %s\n", content);
+	reg_refresh_nout(&dyn->msg);
+
+	/*
+	 * Display the caption of data table:
+	 * "NODE MEM.RD(GB/s) MEM.WR(GB/s) LINK(GB/s) REMOTE%"
+	 */
+	(void) snprintf(content, sizeof (content), "%5s%14s%14s%12s%10s",
+		CAPTION_NID, CAPTION_MEM_RD, CAPTION_MEM_WR, CAPTION_LINK,
+		CAPTION_REMOTE);
+	reg_erase(&dyn->caption);
+	reg_line_write(&dyn->caption, 1, ALIGN_LEFT, content);
+	dump_write("%s\n", content);
+	reg_refresh_nout(&dyn->caption);
+
+	nnodes = node_num();
+	if ((lines = zalloc(sizeof (uncore_line_t) * nnodes)) == NULL) {
+		return (B_FALSE);
+	}
+
+	for (i = 0; i < nnodes; i++) {
+		if ((node = node_valid_get(i)) == NULL) {
+			continue;
+		}
+
+		uncore_line_fill(node, &lines[i]);
+		rd += lines[i].rd;
+		wr += lines[i].wr;
+		link += lines[i].link;
+	}
+
+	reg_erase(&dyn->data);
+	if (dyn->data.buf != NULL) {
+		free(dyn->data.buf);
+	}
+
+	dyn->data.buf = (void *)lines;
+	dyn->data.nlines_total = nnodes;
+	if (dyn->data.scroll.highlight >= nnodes) {
+		dyn->data.scroll.highlight = -1;
+	}
+
+	reg_scroll_show(&dyn->data, (void *)lines, nnodes, uncore_str_build);
+	reg_refresh_nout(&dyn->data);
+
+	/*
+	 * The links don't tell the destination node, the traffic between
+	 * a pair of nodes is only known when there are two nodes.
+	 */
+	if (nnodes == 2) {
+		(void) snprintf(content, sizeof (content),
+			"Node %d -> %d: %.2fGB/s, node %d -> %d: %.2fGB/s; "
+			"total memory: %.2fGB/s",
+			lines[0].nid, lines[1].nid, lines[0].link,
+			lines[1].nid, lines[0].nid, lines[1].link, rd + wr);
+	} else {
+		(void) snprintf(content, sizeof (content),
+			"Total memory: %.2fGB/s, total link: %.2fGB/s",
+			rd + wr, link);
+	}
+
+	reg_erase(&dyn->total);
+	reg_line_write(&dyn->total, dyn->total.nlines_scr - 2, ALIGN_LEFT,
+		content);
+	dump_write("%s\n", content);
+	reg_refresh_nout(&dyn->total);
+	return (B_TRUE);
+}
+
+/*
+ * Initialize the display layout for window type "WIN_TYPE_UNCORE".
+ */
+void *
+os_uncore_dyn_create(page_t *page __attribute__((unused)))
+{
+	dyn_uncore_t *dyn;
+	int i;
+
+	if ((dyn = zalloc(sizeof (dyn_uncore_t))) == NULL) {
+		return (NULL);
+	}
+
+	if ((i = reg_init(&dyn->msg, 0, 1, g_scr_width, 2, A_BOLD)) < 0)
+		goto L_EXIT;
+	if ((i = reg_init(&dyn->caption, 0, i, g_scr_width, 2,
+		A_BOLD | A_UNDERLINE)) < 0)
+		goto L_EXIT;
+	if ((i = reg_init(&dyn->data, 0, i, g_scr_width,
+		g_scr_height - i - 5, 0)) < 0)
+		goto L_EXIT;
+	if (reg_init(&dyn->total, 0, i, g_scr_width, 3, 0) < 0)
+		goto L_EXIT;
+	reg_buf_init(&dyn->data, NULL, uncore_line_get);
+	reg_scroll_init(&dyn->data, B_TRUE);
+	return (dyn);
+L_EXIT:
+	free(dyn);
+	return (NULL);
+}
+
+void
+os_uncore_win_destroy(dyn_win_t *win)
+{
+	dyn_uncore_t *dyn;
+
+	if ((dyn = win->dyn) != NULL) {
+		if (dyn->data.buf != NULL) {
+			free(dyn->data.buf);
+		}
+
+		reg_win_destroy(&dyn->msg);
+		reg_win_destroy(&dyn->caption);
+		reg_win_destroy(&dyn->data);
+		reg_win_destroy(&dyn->total);
+		free(dyn);
+	}
+}
+
+/*
+ * The implementation of displaying window on screen for
+ * window type "WIN_TYPE_UNCORE"
+ */
+boolean_t
+os_uncore_win_draw(dyn_win_t *win)
+{
+	dyn_uncore_t *dyn = (dyn_uncore_t *)(win->dyn);
+	boolean_t ret;
+
+	win_title_show();
+	dump_cache_enable();
+	node_group_lock();
+	ret = uncore_data_show(dyn);
+	node_group_unlock();
+	dump_cache_disable();
+	dump_cache_flush();
+	win_note_show(NOTE_UNCORE);
+	reg_update_all();
+	return (ret);
+}
+
+void
+os_uncore_win_scroll(dyn_win_t *win, int scroll_type)
+{
+	dyn_uncore_t *dyn = (dyn_uncore_t *)(win->dyn);
+
+	reg_line_scroll(&dyn->data, scroll_type);
+}
+
+static void
+cgroup_name_fill(const char *path, char *name, int size)
+{
+	const char *p;
+
+	if ((p = strrchr(path, '/')) == NULL) {
+		p = path;
+	} else {
+		p++;
+	}
+
+	(void) strncpy(name, p, size - 1);
+	name[size - 1] = '\0';
+}
+
+/*
+ * A node which has no L3 domain of its own (SNC) is shown as "-", its
+ * counters are only in the total of cgroup.
+ */
+static void
+cgroup_line_values(cgroup_line_t *line, cgroup_node_t *cgnode)
+{
+	line->monitored = cgnode->valid;
+	line->llc = ratio(cgnode->llc_occupancy, 1048576);
+	line->total = ratio(cgnode->totalbw, 1048576);
+	line->local = ratio(cgnode->localbw, 1048576);
+	line->remote = (cgnode->totalbw > cgnode->localbw) ?
+		ratio(cgnode->totalbw - cgnode->localbw, 1048576) : 0.0;
+}
+
+/*
+ * One line for a cgroup, followed by one line per node if the cgroup
+ * has a monitor group. The remote bandwidth is what the cgroup reads
+ * and writes from the memory of the other nodes.
+ */
+static int
+cgroup_lines_fill(cgroup_t *cgroups, int ncgroups, cgroup_line_t *lines,
+	int *nmonitored)
+{
+	cgroup_line_t *line, *cgline;
+	node_t *node;
+	int i, j, n = 0;
+
+	*nmonitored = 0;
+	for (i = 0; i < ncgroups; i++) {
+		cgline = &lines[n++];
+		cgroup_name_fill(cgroups[i].path, cgline->name,
+			sizeof (cgline->name));
+		cgline->nid = -1;
+		cgline->nprocs = cgroups[i].nprocs;
+		cgline->monitored = (cgroups[i].slot != -1);
+		if (!cgline->monitored) {
+			continue;
+		}
+
+		/*
+		 * None of its threads could join the monitor group, e.g.
+		 * they are in a control group of their own.
+		 */
+		cgroup_line_values(cgline, &cgroups[i].total);
+		if (!cgline->monitored) {
+			continue;
+		}
+
+		(*nmonitored)++;
+		for (j = 0; j < node_num(); j++) {
+			if ((node = node_valid_get(j)) == NULL) {
+				continue;
+			}
+
+			line = &lines[n++];
+			line->nid = node->nid;
+			cgroup_line_values(line, &cgroups[i].nodes[node->nid]);
+		}
+	}
+
+	return (n);
+}
+
+static void
+cgroup_str_build(char *buf, int size, int idx, void *pv)
+{
+	cgroup_line_t *lines = (cgroup_line_t *)pv;
+	cgroup_line_t *line = &lines[idx];
+	char name[32];
+
+	if (line->nid == -1) {
+		(void) snprintf(name, sizeof (name), "%s", line->name);
+	} else {
+		(void) snprintf(name, sizeof (name), "  node %d", line->nid);
+	}
+
+	if (!line->monitored && (line->nid == -1)) {
+		(void) snprintf(buf, size, "%-26s%6d%9s%12s%12s%13s",
+			name, line->nprocs, "-", "-", "-", "-");
+	} else if (!line->monitored) {
+		(void) snprintf(buf, size, "%-26s%6s%9s%12s%12s%13s",
+			name, "", "-", "-", "-", "-");
+	} else if (line->nid == -1) {
+		(void) snprintf(buf, size,
+			"%-26s%6d%9.1f%12.1f%12.1f%13.1f",
+			name, line->nprocs, line->llc, line->total,
+			line->local, line->remote);
+	} else {
+		(void) snprintf(buf, size,
+			"%-26s%6s%9.1f%12.1f%12.1f%13.1f",
+			name, "", line->llc, line->total,
+			line->local, line->remote);
+	}
+}
+
+static void
+cgroup_line_get(win_reg_t *r, int idx, char *line, int size)
+{
+	cgroup_str_build(line, size, idx, r->buf);
+}
+
+/*
+ * Show the LLC occupancy and the memory bandwidth of the cgroups, from
+ * the resctrl monitor groups which follow their threads.
+ */
+static boolean_t
+cgroup_data_show(dyn_cgroup_t *dyn)
+{
+	cgroup_line_t *lines;
+	cgroup_t *cgroups;
+	char content[WIN_LINECHAR_MAX], intval_buf[16];
+	int ncgroups, nlines, nmonitored;
+
+	disp_intval(intval_buf, 16);
+	(void) snprintf(content, sizeof (content),
+		"Monitoring cgroups with resctrl (interval: %s)", intval_buf);
+	reg_erase(&dyn->msg);
+	reg_line_write(&dyn->msg, 1, ALIGN_LEFT, content);
+	dump_write("\n*** %s\n", content);
+	reg_refresh_nout(&dyn->msg);
+
+	/*
+	 * Display the caption of data table:
+	 * "CGROUP NPROC LLC(MB) TOTAL(MB/s) LOCAL(MB/s) REMOTE(MB/s)"
+	 */
+	(void) snprintf(content, sizeof (content), "%-26s%6s%9s%12s%12s%13s",
+		CAPTION_CGROUP, CAPTION_NPROC, CAPTION_LLC_MB,
+		CAPTION_MBAND_TOTAL, CAPTION_MBAND_LOCAL, CAPTION_MBAND_REMOTE);
+	reg_erase(&dyn->caption);
+	reg_line_write(&dyn->caption, 1, ALIGN_LEFT, content);
+	dump_write("%s\n", content);
+	reg_refresh_nout(&dyn->caption);
+
+	reg_erase(&dyn->hint);
+	if (cgroup_refresh() != 0) {
+		reg_line_write(&dyn->hint, 1, ALIGN_LEFT,
+			"-- No cgroup v2 hierarchy is found --");
+		reg_refresh_nout(&dyn->hint);
+		return (B_FALSE);
+	}
+
+	cgroups = cgroup_get(&ncgroups);
+	if ((lines = zalloc(sizeof (cgroup_line_t) *
+		(ncgroups * (node_num() + 1) + 1))) == NULL) {
+		return (B_FALSE);
+	}
+
+	nlines = cgroup_lines_fill(cgroups, ncgroups, lines, &nmonitored);
+
+	reg_erase(&dyn->data);
+	if (dyn->data.buf != NULL) {
+		free(dyn->data.buf);
+	}
+
+	dyn->data.buf = (void *)lines;
+	dyn->data.nlines_total = nlines;
+	if (dyn->data.scroll.highlight >= nlines) {
+		dyn->data.scroll.highlight = -1;
+	}
+
+	reg_scroll_show(&dyn->data, (void *)lines, nlines, cgroup_str_build);
+	reg_refresh_nout(&dyn->data);
+
+	(void) snprintf(content, sizeof (content),
+		"-- %d of %d cgroups are monitored, the busiest first --",
+		nmonitored, ncgroups);
+	reg_line_write(&dyn->hint, 1, ALIGN_LEFT, content);
+	reg_line_write(&dyn->hint, 2, ALIGN_LEFT,
+		"REMOTE = TOTAL - LOCAL, the bandwidth to the other nodes");
+	reg_refresh_nout(&dyn->hint);
+	return (B_TRUE);
+}
+
+/*
+ * Initialize the display layout for window type "WIN_TYPE_CGROUP".
+ */
+void *
+os_cgroup_dyn_create(page_t *page __attribute__((unused)))
+{
+	dyn_cgroup_t *dyn;
+	int i;
+
+	if ((dyn = zalloc(sizeof (dyn_cgroup_t))) == NULL) {
+		return (NULL);
+	}
+
+	if ((i = reg_init(&dyn->msg, 0, 1, g_scr_width, 2, A_BOLD)) < 0)
+		goto L_EXIT;
+	if ((i = reg_init(&dyn->caption, 0, i, g_scr_width, 2,
+		A_BOLD | A_UNDERLINE)) < 0)
+		goto L_EXIT;
+	if ((i = reg_init(&dyn->data, 0, i, g_scr_width,
+		g_scr_height - i - 5, 0)) < 0)
+		goto L_EXIT;
+	if (reg_init(&dyn->hint, 0, i, g_scr_width,
+		g_scr_height - i - 1, A_BOLD) < 0)
+		goto L_EXIT;
+	reg_buf_init(&dyn->data, NULL, cgroup_line_get);
+	reg_scroll_init(&dyn->data, B_TRUE);
+	return (dyn);
+L_EXIT:
+	free(dyn);
+	return (NULL);
+}
+
+/*
+ * The monitor groups are given back to the pool when the window is
+ * left, e.g. by Back or Home.
+ */
+void
+os_cgroup_win_destroy(dyn_win_t *win)
+{
+	dyn_cgroup_t *dyn;
+
+	cgroup_fini();
+	if ((dyn = win->dyn) != NULL) {
+		if (dyn->data.buf != NULL) {
+			free(dyn->data.buf);
+		}
+
+		reg_win_destroy(&dyn->msg);
+		reg_win_destroy(&dyn->caption);
+		reg_win_destroy(&dyn->data);
+		reg_win_destroy(&dyn->hint);
+		free(dyn);
+	}
+}
+
+/*
+ * The implementation of displaying window on screen for
+ * window type "WIN_TYPE_CGROUP"
+ */
+boolean_t
+os_cgroup_win_draw(dyn_win_t *win)
+{
+	dyn_cgroup_t *dyn = (dyn_cgroup_t *)(win->dyn);
+	boolean_t ret;
+
+	win_title_show();
+	dump_cache_enable();
+	node_group_lock();
+	ret = cgroup_data_show(dyn);
+	node_group_unlock();
+	dump_cache_disable();
+	dump_cache_flush();
+	win_note_show(NOTE_CGROUP);
+	reg_update_all();
+	return (ret);
+}
+
+void
+os_cgroup_win_scroll(dyn_win_t *win, int scroll_type)
+{
+	dyn_cgroup_t *dyn = (dyn_cgroup_t *)(win->dyn);
+
+	reg_line_scroll(&dyn->data, scroll_type);
+}
+
+static const char *
+balancing_str(int mode)
+{
+	switch (mode) {
+	case 0:
+		return ("off");
+	case 1:
+		return ("normal");
+	case 2:
+		return ("tiering");
+	case 3:
+		return ("normal+tiering");
+	default:
+		return ("n/a");
+	}
+}
+
+static void
+numastat_rate_str(double rate, boolean_t valid, char *buf, int size)
+{
+	if (valid && (rate >= 0.0)) {
+		(void) snprintf(buf, size, "%.0f", rate);
+	} else {
+		(void) strncpy(buf, "-", size);
+	}
+}
+
+static void
+numastat_sys_show(numastat_t *stat, win_reg_t *r)
+{
+	char content[WIN_LINECHAR_MAX];
+	double hint, local;
+
+	hint = stat->vm[NUMASTAT_HINT_FAULTS];
+	local = stat->vm[NUMASTAT_HINT_FAULTS_LOCAL];
+	(void) snprintf(content, sizeof (content),
+		"NUMA balancing: %s, PTE updates: %.0f/s, hint faults: %.0f/s "
+		"(%.1f%% local)", balancing_str(stat->balancing),
+		stat->vm[NUMASTAT_PTE_UPDATES], hint,
+		(hint > 0.0) ? local * 100.0 / hint : 0.0);
+	reg_line_write(r, 0, ALIGN_LEFT, content);
+	dump_write("%s\n", content);
+
+	if (stat->vm_valid[NUMASTAT_PROMOTE_SUCCESS] ||
+	    stat->vm_valid[NUMASTAT_DEMOTE_KSWAPD]) {
+		(void) snprintf(content, sizeof (content),
+			"Pages migrated: %.0f/s, promoted: %.0f/s (candidates: "
+			"%.0f/s), demoted: %.0f/s",
+			stat->vm[NUMASTAT_PAGES_MIGRATED],
+			stat->vm[NUMASTAT_PROMOTE_SUCCESS],
+			stat->vm[NUMASTAT_PROMOTE_CANDIDATE],
+			stat->vm[NUMASTAT_DEMOTE_KSWAPD] +
+			stat->vm[NUMASTAT_DEMOTE_DIRECT] +
+			stat->vm[NUMASTAT_DEMOTE_KHUGEPAGED]);
+	} else {
+		(void) snprintf(content, sizeof (content),
+			"Pages migrated: %.0f/s, no memory tiering counters",
+			stat->vm[NUMASTAT_PAGES_MIGRATED]);
+	}
+
+	reg_line_write(r, 1, ALIGN_LEFT, content);
+	dump_write("%s\n", content);
+}
+
+static void
+numastat_node_show(numastat_t *stat, win_reg_t *r)
+{
+	char content[WIN_LINECHAR_MAX];
+	char rates[NUMASTAT_NODE_NUM][16];
+	node_t *node;
+	int i, j, line = 0;
+
+	for (i = 0; (i < node_num()) && (line < r->nlines_scr); i++) {
+		if ((node = node_valid_get(i)) == NULL) {
+			continue;
+		}
+
+		for (j = 0; j < NUMASTAT_NODE_NUM; j++) {
+			numastat_rate_str(NUMASTAT_NODE_RATE(stat, node->nid, j),
+				NUMASTAT_NODE_VALID(stat, node->nid)[j], rates[j],
+				sizeof (rates[j]));
+		}
+
+		(void) snprintf(content, sizeof (content),
+			"%5d%10s%10s%10s%10s%10s%10s%10s", node->nid,
+			rates[NUMASTAT_NODE_HIT], rates[NUMASTAT_NODE_MISS],
+			rates[NUMASTAT_NODE_FOREIGN], rates[NUMASTAT_NODE_LOCAL],
+			rates[NUMASTAT_NODE_OTHER], rates[NUMASTAT_NODE_PROMOTE],
+			rates[NUMASTAT_NODE_DEMOTE]);
+		reg_line_write(r, line++, ALIGN_LEFT, content);
+		dump_write("%s\n", content);
+	}
+}
+
+static void
+numastat_str_build(char *buf, int size, int idx, void *pv)
+{
+	numastat_proc_t *procs = (numastat_proc_t *)pv;
+	numastat_proc_t *p = &procs[idx];
+	char cur[16], pref[16], faults[16], migrated[16];
+
+	(void) snprintf(cur, sizeof (cur), "%d", p->cur_node);
+	(void) snprintf(pref, sizeof (pref), "%d", p->pref_node);
+	numastat_rate_str(p->faults_rate, B_TRUE, faults, sizeof (faults));
+	numastat_rate_str(p->migrated_rate, B_TRUE, migrated,
+		sizeof (migrated));
+
+	(void) snprintf(buf, size, "%10d%15s%8s%11s%12s%13s",
+		p->pid, p->name, (p->cur_node < 0) ? "-" : cur,
+		(p->pref_node < 0) ? "-" : pref, faults, migrated);
+}
+
+static void
+numastat_line_get(win_reg_t *r, int idx, char *line, int size)
+{
+	numastat_str_build(line, size, idx, r->buf);
+}
+
+/*
+ * Show the kernel's NUMA balancing and memory tiering activity, the
+ * per-node allocation statistics and the NUMA balancing state of the
+ * busiest processes.
+ */
+static boolean_t
+numastat_data_show(dyn_numastat_t *dyn)
+{
+	numastat_t *stat;
+	numastat_proc_t *procs;
+	char content[WIN_LINECHAR_MAX], intval_buf[16];
+
+	disp_intval(intval_buf, 16);
+	(void) snprintf(content, sizeof (content),
+		"Kernel NUMA balancing and tiering (interval: %s)", intval_buf);
+	reg_erase(&dyn->msg);
+	reg_line_write(&dyn->msg, 1, ALIGN_LEFT, content);
+	dump_write("\n*** %s\n", content);
+	reg_refresh_nout(&dyn->msg);
+
+	if ((stat = numastat_refresh()) == NULL) {
+		return (B_FALSE);
+	}
+
+	reg_erase(&dyn->sys);
+	numastat_sys_show(stat, &dyn->sys);
+	reg_refresh_nout(&dyn->sys);
+
+	/*
+	 * Display the caption of the node table:
+	 * "NODE HIT/s MISS/s FOREIGN/s LOCAL/s OTHER/s PROMOTE/s DEMOTE/s"
+	 */
+	(void) snprintf(content, sizeof (content),
+		"%5s%10s%10s%10s%10s%10s%10s%10s", CAPTION_NID, CAPTION_HIT,
+		CAPTION_MISS, CAPTION_FOREIGN, CAPTION_LOCAL, CAPTION_OTHER,
+		CAPTION_PROMOTE, CAPTION_DEMOTE);
+	reg_erase(&dyn->caption_node);
+	reg_line_write(&dyn->caption_node, 1, ALIGN_LEFT, content);
+	dump_write("%s\n", content);
+	reg_refresh_nout(&dyn->caption_node);
+
+	reg_erase(&dyn->data_node);
+	numastat_node_show(stat, &dyn->data_node);
+	reg_refresh_nout(&dyn->data_node);
+
+	/*
+	 * Display the caption of the process table:
+	 * "PID PROC NODE PREF.NODE FAULTS/s MIGRATED/s"
+	 */
+	(void) snprintf(content, sizeof (content), "%10s%15s%8s%11s%12s%13s",
+		CAPTION_PID, CAPTION_PROC, CAPTION_NID, CAPTION_PREFNODE,
+		CAPTION_FAULTS, CAPTION_MIGRATED);
+	reg_erase(&dyn->caption_proc);
+	reg_line_write(&dyn->caption_proc, 1, ALIGN_LEFT, content);
+	dump_write("%s\n", content);
+	reg_refresh_nout(&dyn->caption_proc);
+
+	if ((procs = zalloc(sizeof (numastat_proc_t) *
+		(stat->nprocs + 1))) == NULL) {
+		return (B_FALSE);
+	}
+
+	(void) memcpy(procs, stat->procs,
+		sizeof (numastat_proc_t) * stat->nprocs);
+
+	reg_erase(&dyn->data_proc);
+	if (dyn->data_proc.buf != NULL) {
+		free(dyn->data_proc.buf);
+	}
+
+	dyn->data_proc.buf = (void *)procs;
+	dyn->data_proc.nlines_total = stat->nprocs;
+	if (dyn->data_proc.scroll.highlight >= stat->nprocs) {
+		dyn->data_proc.scroll.highlight = -1;
+	}
+
+	reg_scroll_show(&dyn->data_proc, (void *)procs, stat->nprocs,
+		numastat_str_build);
+	reg_refresh_nout(&dyn->data_proc);
+	return (B_TRUE);
+}
+
+/*
+ * Initialize the display layout for window type "WIN_TYPE_NUMASTAT".
+ * At most 8 nodes are shown.
+ */
+void *
+os_numastat_dyn_create(page_t *page __attribute__((unused)))
+{
+	dyn_numastat_t *dyn;
+	int i;
+
+	if ((dyn = zalloc(sizeof (dyn_numastat_t))) == NULL) {
+		return (NULL);
+	}
+
+	if ((i = reg_init(&dyn->msg, 0, 1, g_scr_width, 2, A_BOLD)) < 0)
+		goto L_EXIT;
+	if ((i = reg_init(&dyn->sys, 0, i, g_scr_width, 3, 0)) < 0)
+		goto L_EXIT;
+	if ((i = reg_init(&dyn->caption_node, 0, i, g_scr_width, 2,
+		A_BOLD | A_UNDERLINE)) < 0)
+		goto L_EXIT;
+	if ((i = reg_init(&dyn->data_node, 0, i, g_scr_width,
+		MIN(node_num(), 8), 0)) < 0)
+		goto L_EXIT;
+	if ((i = reg_init(&dyn->caption_proc, 0, i, g_scr_width, 2,
+		A_BOLD | A_UNDERLINE)) < 0)
+		goto L_EXIT;
+	if (reg_init(&dyn->data_proc, 0, i, g_scr_width,
+		g_scr_height - i - 2, 0) < 0)
+		goto L_EXIT;
+	reg_buf_init(&dyn->data_proc, NULL, numastat_line_get);
+	reg_scroll_init(&dyn->data_proc, B_TRUE);
+	return (dyn);
+L_EXIT:
+	free(dyn);
+	return (NULL);
+}
+
+void
+os_numastat_win_destroy(dyn_win_t *win)
+{
+	dyn_numastat_t *dyn;
+
+	if ((dyn = win->dyn) != NULL) {
+		if (dyn->data_proc.buf != NULL) {
+			free(dyn->data_proc.buf);
+		}
+
+		reg_win_destroy(&dyn->msg);
+		reg_win_destroy(&dyn->sys);
+		reg_win_destroy(&dyn->caption_node);
+		reg_win_destroy(&dyn->data_node);
+		reg_win_destroy(&dyn->caption_proc);
+		reg_win_destroy(&dyn->data_proc);
+		free(dyn);
+	}
+
+	numastat_fini();
+}
+
+/*
+ * The implementation of displaying window on screen for
+ * window type "WIN_TYPE_NUMASTAT"
+ */
+boolean_t
+os_numastat_win_draw(dyn_win_t *win)
+{
+	dyn_numastat_t *dyn = (dyn_numastat_t *)(win->dyn);
+	boolean_t ret;
+
+	win_title_show();
+	dump_cache_enable();
+	node_group_lock();
+	ret = numastat_data_show(dyn);
+	node_group_unlock();
+	dump_cache_disable();
+	dump_cache_flush();
+	win_note_show(NOTE_NUMASTAT);
+	reg_update_all();
+	return (ret);
+}
+
+void
+os_numastat_win_scroll(dyn_win_t *win, int scroll_type)
+{
+	dyn_numastat_t *dyn = (dyn_numastat_t *)(win->dyn);
+
+	reg_line_scroll(&dyn->data_proc, scroll_type);
+}
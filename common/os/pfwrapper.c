@@ -424,7 +424,6 @@ int
 pf_ll_setup(struct _perf_cpu *cpu, pf_conf_t *conf)
 {
 	struct perf_event_attr attr;
-	int *fds = cpu->fds;
 
 	memset(&attr, 0, sizeof (attr));
 	attr.type = conf->type;
@@ -438,30 +437,41 @@ pf_ll_setup(struct _perf_cpu *cpu, pf_conf_t *conf)
 		PERF_SAMPLE_DATA_SRC;
 	attr.disabled = 1;
 
-	if ((fds[0] = pf_event_open(&attr, -1, cpu->cpuid, -1, 0)) < 0) {
+	if (conf->mmap_track) {
+		/*
+		 * Report both code and data mappings in PERF_RECORD_MMAP2
+		 * format, so the process address space can be tracked
+		 * without rereading /proc/<pid>/maps.
+		 */
+		attr.mmap = 1;
+		attr.mmap2 = 1;
+		attr.mmap_data = 1;
+	}
+
+	if ((cpu->ll_fd = pf_event_open(&attr, -1, cpu->cpuid, -1, 0)) < 0) {
 		debug_print(NULL, 2, "pf_ll_setup: pf_event_open is failed "
 			"for CPU%d\n", cpu->cpuid);
-		fds[0] = INVALID_FD;
+		cpu->ll_fd = INVALID_FD;
 		return (-1);
 	}
 	
-	if ((cpu->map_base = mmap(NULL, s_mapsize, PROT_READ | PROT_WRITE,
-		MAP_SHARED, fds[0], 0)) == MAP_FAILED) {
-		close(fds[0]);
-		fds[0] = INVALID_FD;
+	if ((cpu->ll_map_base = mmap(NULL, s_mapsize, PROT_READ | PROT_WRITE,
+		MAP_SHARED, cpu->ll_fd, 0)) == MAP_FAILED) {
+		close(cpu->ll_fd);
+		cpu->ll_fd = INVALID_FD;
 		return (-1);
 	}
 
-	cpu->map_len = s_mapsize;
-	cpu->map_mask = s_mapmask;
+	cpu->ll_map_len = s_mapsize;
+	cpu->ll_map_mask = s_mapmask;
 	return (0);
 }
 
 int
 pf_ll_start(struct _perf_cpu *cpu)
 {
-	if (cpu->fds[0] != INVALID_FD) {
-		return (ioctl(cpu->fds[0], PERF_EVENT_IOC_ENABLE, 0));
+	if (cpu->ll_fd != INVALID_FD) {
+		return (ioctl(cpu->ll_fd, PERF_EVENT_IOC_ENABLE, 0));
 	}
 	
 	return (0);
@@ -470,13 +480,94 @@ pf_ll_start(struct _perf_cpu *cpu)
 int
 pf_ll_stop(struct _perf_cpu *cpu)
 {
-	if (cpu->fds[0] != INVALID_FD) {
-		return (ioctl(cpu->fds[0], PERF_EVENT_IOC_DISABLE, 0));
+	if (cpu->ll_fd != INVALID_FD) {
+		return (ioctl(cpu->ll_fd, PERF_EVENT_IOC_DISABLE, 0));
 	}
 	
 	return (0);
 }
 
+/*
+ * Classify the data source of a load. The level number, the remote flag
+ * and the hop level are used if the kernel provides them, otherwise fall
+ * back to the legacy level bits.
+ */
+static mem_src_t
+mem_src_decode(union perf_mem_data_src *data_src)
+{
+	unsigned int lvl = data_src->mem_lvl;
+	unsigned int lvl_num = data_src->mem_lvl_num;
+	boolean_t remote = (data_src->mem_remote == PERF_MEM_REMOTE_REMOTE);
+
+	if (data_src->mem_snoop & PERF_MEM_SNOOP_HITM) {
+		if ((remote && (data_src->mem_hops != PERF_MEM_HOPS_0)) ||
+		    (lvl & (PERF_MEM_LVL_REM_CCE1 | PERF_MEM_LVL_REM_CCE2))) {
+			return (MEM_SRC_REM_CACHE);
+		}
+
+		return (MEM_SRC_HITM);
+	}
+
+	switch (lvl_num) {
+	case PERF_MEM_LVLNUM_CXL:
+	case PERF_MEM_LVLNUM_PMEM:
+		return (MEM_SRC_CXL);
+
+	case PERF_MEM_LVLNUM_RAM:
+		return (remote ? MEM_SRC_REM_DRAM : MEM_SRC_LOC_DRAM);
+
+	case PERF_MEM_LVLNUM_L1:
+	case PERF_MEM_LVLNUM_L2:
+	case PERF_MEM_LVLNUM_L3:
+	case PERF_MEM_LVLNUM_L4:
+	case PERF_MEM_LVLNUM_ANY_CACHE:
+	case PERF_MEM_LVLNUM_LFB:
+		if ((lvl & PERF_MEM_LVL_MISS) && !(lvl & PERF_MEM_LVL_HIT)) {
+			return (MEM_SRC_OTHER);
+		}
+
+		/*
+		 * A hit in the cache of another core on the same node is
+		 * still a local access.
+		 */
+		if (remote && (data_src->mem_hops != PERF_MEM_HOPS_0)) {
+			return (MEM_SRC_REM_CACHE);
+		}
+
+		if ((lvl_num == PERF_MEM_LVLNUM_L3) ||
+		    (lvl_num == PERF_MEM_LVLNUM_L4)) {
+			return (MEM_SRC_L3);
+		}
+
+		return (MEM_SRC_OTHER);
+
+	default:
+		break;
+	}
+
+	if (!(lvl & PERF_MEM_LVL_HIT)) {
+		return (MEM_SRC_OTHER);
+	}
+
+	if (lvl & (PERF_MEM_LVL_REM_CCE1 | PERF_MEM_LVL_REM_CCE2)) {
+		return (MEM_SRC_REM_CACHE);
+	}
+
+	if (lvl & (PERF_MEM_LVL_REM_RAM1 | PERF_MEM_LVL_REM_RAM2)) {
+		return (MEM_SRC_REM_DRAM);
+	}
+
+	if (lvl & PERF_MEM_LVL_LOC_RAM) {
+		return (MEM_SRC_LOC_DRAM);
+	}
+
+	if (lvl & PERF_MEM_LVL_L3) {
+		return (MEM_SRC_L3);
+	}
+
+	return (MEM_SRC_OTHER);
+}
+
 static int
 ll_sample_read(struct perf_event_mmap_page *mhdr, int size,
 	pf_ll_rec_t *rec)
@@ -572,6 +663,9 @@ ll_sample_read(struct perf_event_mmap_page *mhdr, int size,
 	rec->addr = addr;
 	rec->cpu = cpu;
 	rec->latency = weight;	
+	rec->mem_src = mem_src_decode(&data_src);
+	rec->hitm = (data_src.mem_snoop & PERF_MEM_SNOOP_HITM) ?
+	    B_TRUE : B_FALSE;
 	ret = 0;
 
 L_EXIT:
@@ -602,10 +696,94 @@ ll_recbuf_update(pf_ll_rec_t *rec_arr, int *nrec, pf_ll_rec_t *rec)
 	*nrec += 1;
 }
 
+static int
+mmap2_record_read(struct perf_event_mmap_page *mhdr, int size,
+	pf_mmap_rec_t *rec)
+{
+	struct {
+		uint32_t pid, tid;
+		uint64_t addr, len, pgoff;
+		uint32_t maj, min;
+		uint64_t ino, ino_generation;
+		uint32_t prot, flags;
+	} body;
+	int len;
+
+	/*
+	 * struct {
+	 *	{ u32	pid, tid; }
+	 *	{ u64	addr, len, pgoff; }
+	 *	{ u32	maj, min; }
+	 *	{ u64	ino, ino_generation; }
+	 *	{ u32	prot, flags; }
+	 *	{ char	filename[]; }
+	 * };
+	 *
+	 * The maj/min/ino fields are replaced by build id when
+	 * PERF_RECORD_MISC_MMAP_BUILD_ID is set, the size is the same.
+	 */
+	if ((size < (int)sizeof (body)) ||
+		(mmap_buffer_read(mhdr, &body, sizeof (body)) == -1)) {
+		debug_print(NULL, 2, "mmap2_record_read: read body failed.\n");
+		mmap_buffer_skip(mhdr, size);
+		return (-1);
+	}
+
+	size -= sizeof (body);
+	len = MIN(size, PATH_MAX - 1);
+
+	if (mmap_buffer_read(mhdr, rec->path, len) == -1) {
+		debug_print(NULL, 2, "mmap2_record_read: read filename failed.\n");
+		mmap_buffer_skip(mhdr, size);
+		return (-1);
+	}
+
+	rec->path[len] = 0;
+	size -= len;
+	if (size > 0) {
+		mmap_buffer_skip(mhdr, size);
+	}
+
+	rec->pid = body.pid;
+	rec->tid = body.tid;
+	rec->addr = body.addr;
+	rec->len = body.len;
+	rec->prot = body.prot;
+	rec->flags = body.flags;
+	return (0);
+}
+
+static void
+mmap_recbuf_update(pf_mmap_recbuf_t *mmap_buf, struct perf_event_mmap_page *mhdr,
+	int size)
+{
+	pf_mmap_rec_t *rec;
+
+	if (mmap_buf->nrec_cur >= mmap_buf->nrec_max) {
+		mmap_buf->lost = B_TRUE;
+		mmap_buffer_skip(mhdr, size);
+		return;
+	}
+
+	rec = &mmap_buf->rec_arr[mmap_buf->nrec_cur];
+	if (mmap2_record_read(mhdr, size, rec) != 0) {
+		mmap_buf->lost = B_TRUE;
+		return;
+	}
+
+	if ((rec->pid == 0) || (rec->pid == (unsigned int)-1)) {
+		/* Just consider the user-land process. */
+		return;
+	}
+
+	mmap_buf->nrec_cur++;
+}
+
 void
-pf_ll_record(struct _perf_cpu *cpu, pf_ll_rec_t *rec_arr, int *nrec)
+pf_ll_record(struct _perf_cpu *cpu, pf_ll_rec_t *rec_arr, int *nrec,
+	pf_mmap_recbuf_t *mmap_buf)
 {
-	struct perf_event_mmap_page *mhdr = cpu->map_base;
+	struct perf_event_mmap_page *mhdr = cpu->ll_map_base;
 	struct perf_event_header ehdr;
 	pf_ll_rec_t rec;
 	int size;
@@ -629,7 +807,13 @@ pf_ll_record(struct _perf_cpu *cpu, pf_ll_rec_t *rec_arr, int *nrec)
 				/* No valid record in ring buffer. */
 				return;	
 			}
+		} else if ((ehdr.type == PERF_RECORD_MMAP2) && (mmap_buf != NULL)) {
+			mmap_recbuf_update(mmap_buf, mhdr, size);
 		} else {
+			if ((ehdr.type == PERF_RECORD_LOST) && (mmap_buf != NULL)) {
+				mmap_buf->lost = B_TRUE;
+			}
+
 			mmap_buffer_skip(mhdr, size);
 		}
 	}
@@ -654,6 +838,21 @@ pf_resource_free(struct _perf_cpu *cpu)
 	}
 }
 
+void
+pf_ll_resource_free(struct _perf_cpu *cpu)
+{
+	if (cpu->ll_fd != INVALID_FD) {
+		close(cpu->ll_fd);
+		cpu->ll_fd = INVALID_FD;
+	}
+
+	if (cpu->ll_map_base != MAP_FAILED) {
+		munmap(cpu->ll_map_base, cpu->ll_map_len);
+		cpu->ll_map_base = MAP_FAILED;
+		cpu->ll_map_len = 0;
+	}
+}
+
 int
 pf_pqos_occupancy_setup(struct _perf_pqos *pqos __attribute__((unused)),
 	int pid __attribute__((unused)),
@@ -728,6 +927,69 @@ pf_pqos_resource_free(struct _perf_pqos *pqos)
 	memset(pqos, 0, sizeof(struct _perf_pqos));
 }
 
+/*
+ * The uncore counters of a PMU box are opened as one group with
+ * PERF_FORMAT_GROUP, so the box is read in one syscall and all its
+ * counters share the same time_enabled/time_running. The kernel
+ * doesn't allow a group to span PMUs, so there is one group per box.
+ */
+static int
+uncore_event_open(struct _node *node, int type, uint64_t config,
+	int group_fd)
+{
+	struct perf_event_attr attr;
+	int cpuid;
+
+	if ((cpuid = node_uncore_cpu(node)) == INVALID_CPUID) {
+		return (-1);
+	}
+
+	memset(&attr, 0, sizeof (attr));
+	attr.type = type;
+	attr.size = sizeof(attr);
+	attr.config = config;
+	attr.disabled = (group_fd == -1) ? 1 : 0;
+	attr.read_format = PERF_FORMAT_GROUP |
+		PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+	return (pf_event_open(&attr, -1, cpuid, group_fd, 0));
+}
+
+/*
+ * Read the group of a box into 'values' as
+ * { value[0], ..., value[nevents - 1], time_enabled, time_running }.
+ */
+static int
+uncore_group_read(int fd, uint64_t *values, int nevents)
+{
+	/*
+	 * struct read_format {
+	 *	{ u64	nr; }
+	 *	{ u64	time_enabled; }
+	 *	{ u64	time_running; }
+	 *	{ u64	value; } [nr]
+	 * };
+	 */
+	uint64_t buf[3 + UNCORE_GROUP_MAX];
+	int i;
+
+	if (read_fd(fd, buf, (3 + nevents) * sizeof (uint64_t)) != 0) {
+		return (-1);
+	}
+
+	if (buf[0] != (uint64_t)nevents) {
+		return (-1);
+	}
+
+	for (i = 0; i < nevents; i++) {
+		values[i] = buf[3 + i];
+	}
+
+	values[nevents] = buf[1];
+	values[nevents + 1] = buf[2];
+	return (0);
+}
+
 void
 pf_uncoreqpi_free(struct _node *node)
 {
@@ -743,6 +1005,7 @@ pf_uncoreqpi_free(struct _node *node)
 
 		qpi->qpi_info[i].fd = INVALID_FD;
 		qpi->qpi_info[i].value_scaled = 0;
+		qpi->qpi_info[i].intval_ns = 0;
 		memset(qpi->qpi_info[i].values, 0, sizeof(qpi->qpi_info[i].values));
 	}
 }
@@ -750,7 +1013,6 @@ pf_uncoreqpi_free(struct _node *node)
 int
 pf_uncoreqpi_setup(struct _node *node)
 {
-	struct perf_event_attr attr;
 	node_qpi_t *qpi = &node->qpi;
 	int i;
 
@@ -759,30 +1021,23 @@ pf_uncoreqpi_setup(struct _node *node)
 			continue;
 
 		qpi->qpi_info[i].value_scaled = 0;
+		qpi->qpi_info[i].intval_ns = 0;
 		memset(qpi->qpi_info[i].values, 0, sizeof(qpi->qpi_info[i].values));
 
-		memset(&attr, 0, sizeof (attr));
-		attr.type = qpi->qpi_info[i].type;
-		attr.size = sizeof(attr);
-		attr.config = qpi->qpi_info[i].config;
-		attr.disabled = 1;
-		attr.inherit = 1;
-		attr.read_format =
-			PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
-
-		if ((qpi->qpi_info[i].fd = pf_event_open(&attr, -1,
-			node->cpus[0].cpuid, -1, 0)) < 0) {
+		if ((qpi->qpi_info[i].fd = uncore_event_open(node,
+			qpi->qpi_info[i].type, qpi->qpi_info[i].config, -1)) < 0) {
 			debug_print(NULL, 2, "pf_uncoreqpi_setup: pf_event_open is failed "
-				"for node %d, qpi %d, cpu %d, type %d, config 0x%lx\n",
-				node->nid, i, node->cpus[0].cpuid, attr.type, attr.config);
+				"for node %d, qpi %d, cpu %d, type %d, config 0x%x\n",
+				node->nid, i, node_uncore_cpu(node), qpi->qpi_info[i].type,
+				qpi->qpi_info[i].config);
 			qpi->qpi_info[i].fd = INVALID_FD;
 			return (-1);
 		}
 
 		debug_print(NULL, 2, "pf_uncoreqpi_setup: pf_event_open is successful "
-			"for node %d, qpi %d, cpu %d, type %d, config 0x%lx, fd %d\n",
-			node->nid, i, node->cpus[0].cpuid, attr.type, attr.config,
-			qpi->qpi_info[i].fd);
+			"for node %d, qpi %d, cpu %d, type %d, config 0x%x, fd %d\n",
+			node->nid, i, node_uncore_cpu(node), qpi->qpi_info[i].type,
+			qpi->qpi_info[i].config, qpi->qpi_info[i].fd);
 	}
 
 	return (0);
@@ -797,9 +1052,10 @@ int pf_uncoreqpi_start(struct _node *node)
 		if (qpi->qpi_info[i].fd != INVALID_FD) {
 			debug_print(NULL, 2, "pf_uncorqpi_start: "
 				"for node %d, qpi %d, cpu %d, type %d, fd %d\n",
-				node->nid, i, node->cpus[0].cpuid, qpi->qpi_info[i].type,
+				node->nid, i, node_uncore_cpu(node), qpi->qpi_info[i].type,
 				qpi->qpi_info[i].fd);
-			ioctl(qpi->qpi_info[i].fd, PERF_EVENT_IOC_ENABLE, 0);
+			ioctl(qpi->qpi_info[i].fd, PERF_EVENT_IOC_ENABLE,
+				PERF_IOC_FLAG_GROUP);
 		}
 	}
 
@@ -814,18 +1070,7 @@ int pf_uncoreqpi_smpl(struct _node *node)
 
 	for (i = 0; i < qpi->qpi_num; i++) {
 		if (qpi->qpi_info[i].fd != INVALID_FD) {
-
-			/*
-			 * struct read_format {
-			 *	{ u64	value; }
-			 *	{ u64	time_enabled; }
-			 *	{ u64	time_running; }
-			 * };
-			 */
-
-			if (read_fd(qpi->qpi_info[i].fd, values,
-				sizeof(values)) != 0) {
-
+			if (uncore_group_read(qpi->qpi_info[i].fd, values, 1) != 0) {
 				debug_print(NULL, 2,
 					"pf_uncoreqpi_smpl: read fd %d fail\n",
 					qpi->qpi_info[i].fd);
@@ -845,6 +1090,8 @@ int pf_uncoreqpi_smpl(struct _node *node)
 				values[1] - qpi->qpi_info[i].values[1],
 				values[2] - qpi->qpi_info[i].values[2]);
 
+			qpi->qpi_info[i].intval_ns = values[1] -
+				qpi->qpi_info[i].values[1];
 			memcpy(qpi->qpi_info[i].values, values, sizeof(values));
 		}
 	}
@@ -855,58 +1102,70 @@ int pf_uncoreqpi_smpl(struct _node *node)
 void
 pf_uncoreimc_free(struct _node *node)
 {
-	int i;
+	int i, j;
 	node_imc_t *imc = &node->imc;
 
 	for (i = 0; i < imc->imc_num; i++) {
-		if (imc->imc_info[i].fd != INVALID_FD) {
-			debug_print(NULL, 2, "pf_uncoreimc_free: nid %d, imc %d, fd %d\n",
-				node->nid, i, imc->imc_info[i].fd);
-			close(imc->imc_info[i].fd);
+		for (j = 0; j < IMC_CAS_NUM; j++) {
+			if (imc->imc_info[i].fds[j] != INVALID_FD) {
+				debug_print(NULL, 2, "pf_uncoreimc_free: nid %d, imc %d, "
+					"fd %d\n", node->nid, i, imc->imc_info[i].fds[j]);
+				close(imc->imc_info[i].fds[j]);
+			}
+
+			imc->imc_info[i].fds[j] = INVALID_FD;
 		}
 
-		imc->imc_info[i].fd = INVALID_FD;
 		imc->imc_info[i].value_scaled = 0;
+		imc->imc_info[i].intval_ns = 0;
+		imc->imc_info[i].time_enabled = 0;
+		imc->imc_info[i].time_running = 0;
 		memset(imc->imc_info[i].values, 0, sizeof(imc->imc_info[i].values));
+		memset(imc->imc_info[i].cas_scaled, 0,
+			sizeof(imc->imc_info[i].cas_scaled));
 	}
 }
 
 int
 pf_uncoreimc_setup(struct _node *node)
 {
-	struct perf_event_attr attr;
 	node_imc_t *imc = &node->imc;
-	int i;
+	imc_info_t *info;
+	int i, j;
 
 	for (i = 0; i < imc->imc_num; i++) {
-		if (imc->imc_info[i].type == 0)
+		info = &imc->imc_info[i];
+		if (info->type == 0)
 			continue;
 
-		imc->imc_info[i].value_scaled = 0;
-		memset(imc->imc_info[i].values, 0, sizeof(imc->imc_info[i].values));
-		
-		memset(&attr, 0, sizeof (attr));
-		attr.type = imc->imc_info[i].type;
-		attr.size = sizeof(attr);
-		attr.config = 0xff04;
-		attr.disabled = 1;
-		attr.inherit = 1;
-		attr.read_format =
-			PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
-
-		if ((imc->imc_info[i].fd = pf_event_open(&attr, -1,
-			node->cpus[0].cpuid, -1, 0)) < 0) {
-			debug_print(NULL, 2, "pf_uncoreimc_setup: pf_event_open is failed "
-				"for node %d, imc %d, cpu %d, type %d, config 0x%lx\n",
-				node->nid, i, node->cpus[0].cpuid, attr.type, attr.config);
-			imc->imc_info[i].fd = INVALID_FD;
-			return (-1);
-		}
+		info->value_scaled = 0;
+		info->intval_ns = 0;
+		info->time_enabled = 0;
+		info->time_running = 0;
+		memset(info->values, 0, sizeof(info->values));
+		memset(info->cas_scaled, 0, sizeof(info->cas_scaled));
 
-		debug_print(NULL, 2, "pf_uncoreimc_setup: pf_event_open is successful "
-			"for node %d, imc %d, cpu %d, type %d, config 0x%lx, fd %d\n",
-			node->nid, i, node->cpus[0].cpuid, attr.type, attr.config,
-			imc->imc_info[i].fd);
+		/*
+		 * The read CAS is the group leader, the write CAS joins
+		 * the group of the same channel.
+		 */
+		for (j = 0; j < info->nevents; j++) {
+			if ((info->fds[j] = uncore_event_open(node, info->type,
+				info->config[j],
+				(j == 0) ? -1 : info->fds[0])) < 0) {
+				debug_print(NULL, 2, "pf_uncoreimc_setup: pf_event_open is "
+					"failed for node %d, imc %d, cpu %d, type %d, "
+					"config 0x%x\n", node->nid, i, node_uncore_cpu(node),
+					info->type, info->config[j]);
+				info->fds[j] = INVALID_FD;
+				return (-1);
+			}
+
+			debug_print(NULL, 2, "pf_uncoreimc_setup: pf_event_open is "
+				"successful for node %d, imc %d, cpu %d, type %d, "
+				"config 0x%x, fd %d\n", node->nid, i, node_uncore_cpu(node),
+				info->type, info->config[j], info->fds[j]);
+		}
 	}
 
 	return (0);
@@ -918,12 +1177,13 @@ int pf_uncoreimc_start(struct _node *node)
 	int i;
 	
 	for (i = 0; i < imc->imc_num; i++) {
-		if (imc->imc_info[i].fd != INVALID_FD) {
+		if (imc->imc_info[i].fds[0] != INVALID_FD) {
 			debug_print(NULL, 2, "pf_uncoreimc_start: "
 				"for node %d, imc %d, cpu %d, type %d, fd %d\n",
-				node->nid, i, node->cpus[0].cpuid, imc->imc_info[i].type,
-				imc->imc_info[i].fd);
-			ioctl(imc->imc_info[i].fd, PERF_EVENT_IOC_ENABLE, 0);
+				node->nid, i, node_uncore_cpu(node), imc->imc_info[i].type,
+				imc->imc_info[i].fds[0]);
+			ioctl(imc->imc_info[i].fds[0], PERF_EVENT_IOC_ENABLE,
+				PERF_IOC_FLAG_GROUP);
 		}
 	}
 
@@ -933,45 +1193,91 @@ int pf_uncoreimc_start(struct _node *node)
 int pf_uncoreimc_smpl(struct _node *node)
 {
 	node_imc_t *imc = &node->imc;
-	uint64_t values[3];
-	int i;
+	imc_info_t *info;
+	uint64_t values[IMC_CAS_NUM + 2], enabled, running;
+	int i, j;
 
 	for (i = 0; i < imc->imc_num; i++) {
-		if (imc->imc_info[i].fd != INVALID_FD) {
-
-			/*
-			 * struct read_format {
-			 *	{ u64	value; }
-			 *	{ u64	time_enabled; }
-			 *	{ u64	time_running; }
-			 * };
-			 */
+		info = &imc->imc_info[i];
+		if (info->fds[0] == INVALID_FD) {
+			continue;
+		}
 
-			if (read_fd(imc->imc_info[i].fd, values,
-				sizeof(values)) != 0) {
+		if (uncore_group_read(info->fds[0], values, info->nevents) != 0) {
+			debug_print(NULL, 2,
+				"pf_uncoreimc_smpl: read fd %d fail\n", info->fds[0]);
+			continue;
+		}
 
-				debug_print(NULL, 2,
-					"pf_uncoreimc_smpl: read fd %d fail\n",
-					imc->imc_info[i].fd);
-				continue;
-			}
+		enabled = values[info->nevents] - info->time_enabled;
+		running = values[info->nevents + 1] - info->time_running;
+		info->value_scaled = 0;
 
-			imc->imc_info[i].value_scaled = scale(
-				values[0] - imc->imc_info[i].values[0],
-				values[1] - imc->imc_info[i].values[1],
-				values[2] - imc->imc_info[i].values[2]);
+		for (j = 0; j < info->nevents; j++) {
+			info->cas_scaled[j] = scale(values[j] - info->values[j],
+				enabled, running);
+			info->value_scaled += info->cas_scaled[j];
 
 			debug_print(NULL, 2, "pf_uncoreimc_smpl: "
-				"node %d, imc %d, fd %d: "
+				"node %d, imc %d, event %d: "
 				"%" PRIu64 ", %" PRIu64 ", %" PRIu64 "\n",
-				node->nid, i, imc->imc_info[i].fd,
-				values[0] - imc->imc_info[i].values[0],
-				values[1] - imc->imc_info[i].values[1],
-				values[2] - imc->imc_info[i].values[2]);
+				node->nid, i, j, values[j] - info->values[j],
+				enabled, running);
 
-			memcpy(imc->imc_info[i].values, values, sizeof(values));
+			info->values[j] = values[j];
 		}
+
+		info->intval_ns = enabled;
+		info->time_enabled = values[info->nevents];
+		info->time_running = values[info->nevents + 1];
 	}
-	
+
 	return 0;
 }
+
+/*
+ * Read the raw CAS count of all IMC channels and the raw flit count
+ * of all QPI/UPI links of a node. It's called by the burst sampler
+ * every few milliseconds, so only one read per box is issued.
+ * Return -1 if any box fails to read, the sample is dropped then.
+ */
+int
+pf_uncore_burst_read(struct _node *node, uint64_t *cas, uint64_t *flits)
+{
+	node_imc_t *imc = &node->imc;
+	node_qpi_t *qpi = &node->qpi;
+	uint64_t values[IMC_CAS_NUM + 2];
+	int i, j;
+
+	*cas = 0;
+	*flits = 0;
+
+	for (i = 0; i < imc->imc_num; i++) {
+		if (imc->imc_info[i].fds[0] == INVALID_FD) {
+			continue;
+		}
+
+		if (uncore_group_read(imc->imc_info[i].fds[0], values,
+			imc->imc_info[i].nevents) != 0) {
+			return (-1);
+		}
+
+		for (j = 0; j < imc->imc_info[i].nevents; j++) {
+			*cas += values[j];
+		}
+	}
+
+	for (i = 0; i < qpi->qpi_num; i++) {
+		if (qpi->qpi_info[i].fd == INVALID_FD) {
+			continue;
+		}
+
+		if (uncore_group_read(qpi->qpi_info[i].fd, values, 1) != 0) {
+			return (-1);
+		}
+
+		*flits += values[0];
+	}
+
+	return (0);
+}
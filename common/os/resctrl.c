@@ -0,0 +1,741 @@
+/*
+ * Copyright (c) 2013, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Intel Corporation nor the names of its contributors
+ *     may be used to endorse or promote products derived from this software
+ *     without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * This file contains the routines to manage a pool of resctrl monitor
+ * groups, up to the number of RMIDs the hardware supports. A group is
+ * created when a task is assigned to the slot and removed when the task
+ * is released, so the next owner doesn't inherit the LLC occupancy and
+ * the kernel can keep the freed RMID in limbo. The counter files of
+ * every L3 domain are kept opened while the group exists and read with
+ * pread().
+ */
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <numa.h>
+#include "../include/types.h"
+#include "../include/util.h"
+#include "../include/os/os_util.h"
+#include "../include/os/resctrl.h"
+
+#define RESCTRL_GROUP_PREFIX	"numatop_"
+
+typedef struct _resctrl_slot {
+	boolean_t created;
+	boolean_t removed;
+	boolean_t busy;
+	pid_t pid;
+	char *cgroup;
+	int ntasks;
+	int *fds;
+} resctrl_slot_t;
+
+static const char *s_event_file[RESCTRL_EVENT_NUM] = {
+	"llc_occupancy",
+	"mbm_total_bytes",
+	"mbm_local_bytes"
+};
+
+/*
+ * The L3 domains "mon_L3_<id>" and the node of each domain.
+ */
+static int *s_l3_id;
+static int *s_l3_nid;
+static int s_nl3;
+
+static resctrl_slot_t *s_slots;
+static int s_nslots;
+static int s_nalloc;
+static pthread_mutex_t s_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * The tasks file takes one task per write. Return the number of tasks
+ * written, or -1 if the file can't be opened.
+ */
+static int
+tasks_write(const char *path, pid_t *tids, int num)
+{
+	char data[32];
+	int fd, i, ret = 0;
+
+	if ((fd = open(path, O_WRONLY)) < 0) {
+		debug_print(NULL, 2, "resctrl: open %s failed, errno=%d\n",
+			path, errno);
+		return (-1);
+	}
+
+	for (i = 0; i < num; i++) {
+		(void) snprintf(data, sizeof (data), "%d\n", tids[i]);
+		if (write(fd, data, strlen(data)) < 0) {
+			debug_print(NULL, 2, "resctrl: write %d to %s failed, "
+				"errno=%d\n", tids[i], path, errno);
+		} else {
+			ret++;
+		}
+	}
+
+	(void) close(fd);
+	return (ret);
+}
+
+static int
+tid_cmp(const void *a, const void *b)
+{
+	const pid_t *tid1 = (const pid_t *)a;
+	const pid_t *tid2 = (const pid_t *)b;
+
+	if (*tid1 > *tid2) {
+		return (1);
+	}
+
+	if (*tid1 < *tid2) {
+		return (-1);
+	}
+
+	return (0);
+}
+
+/*
+ * Read a list of task ids, such as a "tasks" or "cgroup.threads" file.
+ * The ids are sorted on return.
+ */
+static int
+tids_read(const char *path, pid_t **tids, int *num)
+{
+	pid_t *arr = NULL, *p;
+	int tid, n = 0, size = 0;
+	FILE *fp;
+
+	if ((fp = fopen(path, "r")) == NULL) {
+		return (-1);
+	}
+
+	while (fscanf(fp, "%d", &tid) == 1) {
+		if (n == size) {
+			size = (size == 0) ? 64 : size * 2;
+			if ((p = realloc(arr, sizeof (pid_t) * size)) == NULL) {
+				free(arr);
+				(void) fclose(fp);
+				return (-1);
+			}
+
+			arr = p;
+		}
+
+		arr[n++] = tid;
+	}
+
+	(void) fclose(fp);
+	if (n > 0) {
+		qsort(arr, n, sizeof (pid_t), tid_cmp);
+	}
+
+	*tids = arr;
+	*num = n;
+	return (0);
+}
+
+/*
+ * Remove the groups left by a previous run which didn't exit cleanly.
+ * The tasks of a removed group go back to the default group.
+ */
+static void
+stale_groups_remove(void)
+{
+	char path[PATH_MAX];
+	struct dirent *dirent;
+	DIR *dir;
+
+	if ((dir = opendir(RESCTRL_ROOT "/mon_groups")) == NULL) {
+		return;
+	}
+
+	while ((dirent = readdir(dir)) != NULL) {
+		if (strncmp(dirent->d_name, RESCTRL_GROUP_PREFIX,
+			strlen(RESCTRL_GROUP_PREFIX)) != 0) {
+			continue;
+		}
+
+		(void) snprintf(path, sizeof (path), "%s/mon_groups/%s",
+			RESCTRL_ROOT, dirent->d_name);
+		(void) rmdir(path);
+	}
+
+	(void) closedir(dir);
+}
+
+/*
+ * The domain id of "mon_L3_<id>" is the id of the L3 cache, which isn't
+ * the node id with SNC or NPS. The node of a domain is the node of its
+ * CPUs; an L3 which spans several nodes (SNC) is left with INVALID_NID
+ * and only counted in the sum of all the nodes.
+ */
+static int
+l3_domains_init(void)
+{
+	struct dirent *dirent;
+	boolean_t *span;
+	DIR *dir;
+	int ncpus, id, cpu, nid, i, n = 0;
+
+	if ((dir = opendir(RESCTRL_ROOT "/mon_data")) == NULL) {
+		return (-1);
+	}
+
+	while ((dirent = readdir(dir)) != NULL) {
+		if (sscanf(dirent->d_name, "mon_L3_%d", &id) != 1) {
+			continue;
+		}
+
+		if (array_alloc((void **)&s_l3_id, &n, &s_nl3,
+			sizeof (int), 16) != 0) {
+			(void) closedir(dir);
+			return (-1);
+		}
+
+		s_l3_id[n++] = id;
+	}
+
+	(void) closedir(dir);
+	s_nl3 = n;
+	if ((n == 0) || ((s_l3_nid = malloc(sizeof (int) * n)) == NULL)) {
+		return (-1);
+	}
+
+	if ((span = zalloc(sizeof (boolean_t) * n)) == NULL) {
+		return (-1);
+	}
+
+	for (i = 0; i < n; i++) {
+		s_l3_nid[i] = INVALID_NID;
+	}
+
+	ncpus = numa_num_possible_cpus();
+	for (cpu = 0; cpu < ncpus; cpu++) {
+		if (((nid = numa_node_of_cpu(cpu)) < 0) ||
+		    ((id = os_sysfs_cpu_llcid(cpu)) < 0)) {
+			continue;
+		}
+
+		for (i = 0; i < n; i++) {
+			if ((s_l3_id[i] != id) || span[i]) {
+				continue;
+			}
+
+			if (s_l3_nid[i] == INVALID_NID) {
+				s_l3_nid[i] = nid;
+			} else if (s_l3_nid[i] != nid) {
+				span[i] = B_TRUE;
+			}
+		}
+	}
+
+	for (i = 0; i < n; i++) {
+		if (span[i]) {
+			s_l3_nid[i] = INVALID_NID;
+			debug_print(NULL, 2, "resctrl: L3 domain %d spans "
+				"several nodes\n", s_l3_id[i]);
+		}
+	}
+
+	free(span);
+	return (0);
+}
+
+/*
+ * The default group holds RMID 0, the others are left for numatop.
+ */
+int
+resctrl_pool_init(void)
+{
+	char buf[32];
+	FILE *fp;
+	int num, i;
+
+	if ((fp = fopen(RESCTRL_ROOT "/info/L3_MON/num_rmids", "r")) == NULL) {
+		return (-1);
+	}
+
+	if (fgets(buf, sizeof (buf), fp) == NULL) {
+		(void) fclose(fp);
+		return (-1);
+	}
+
+	(void) fclose(fp);
+	if ((num = atoi(buf) - 1) <= 0) {
+		return (-1);
+	}
+
+	num = MIN(num, RESCTRL_GROUP_MAX);
+	if ((l3_domains_init() != 0) ||
+	    ((s_slots = zalloc(sizeof (resctrl_slot_t) * num)) == NULL)) {
+		resctrl_pool_fini();
+		return (-1);
+	}
+
+	for (i = 0; i < num; i++) {
+		if ((s_slots[i].fds = malloc(sizeof (int) * s_nl3 *
+			RESCTRL_EVENT_NUM)) == NULL) {
+			s_nalloc = i;
+			resctrl_pool_fini();
+			return (-1);
+		}
+
+		(void) memset(s_slots[i].fds, INVALID_FD,
+			sizeof (int) * s_nl3 * RESCTRL_EVENT_NUM);
+	}
+
+	s_nslots = num;
+	s_nalloc = num;
+	stale_groups_remove();
+	debug_print(NULL, 2, "resctrl: %d monitor groups at most\n", num);
+	return (0);
+}
+
+static void
+slot_fds_close(resctrl_slot_t *slot)
+{
+	int i;
+
+	for (i = 0; i < s_nl3 * RESCTRL_EVENT_NUM; i++) {
+		if (slot->fds[i] != INVALID_FD) {
+			(void) close(slot->fds[i]);
+			slot->fds[i] = INVALID_FD;
+		}
+	}
+}
+
+void
+resctrl_pool_fini(void)
+{
+	char path[PATH_MAX];
+	int i;
+
+	(void) pthread_mutex_lock(&s_mutex);
+	for (i = 0; i < s_nalloc; i++) {
+		slot_fds_close(&s_slots[i]);
+		free(s_slots[i].fds);
+		free(s_slots[i].cgroup);
+
+		if (s_slots[i].created) {
+			(void) snprintf(path, sizeof (path), "%s/mon_groups/%s%d",
+				RESCTRL_ROOT, RESCTRL_GROUP_PREFIX, i);
+			(void) rmdir(path);
+		}
+	}
+
+	free(s_slots);
+	free(s_l3_id);
+	free(s_l3_nid);
+	s_slots = NULL;
+	s_l3_id = NULL;
+	s_l3_nid = NULL;
+	s_nl3 = 0;
+	s_nslots = 0;
+	s_nalloc = 0;
+	(void) pthread_mutex_unlock(&s_mutex);
+}
+
+int
+resctrl_pool_size(void)
+{
+	return (s_nslots);
+}
+
+int
+resctrl_pool_nfree(void)
+{
+	int i, num = 0;
+
+	(void) pthread_mutex_lock(&s_mutex);
+	for (i = 0; i < s_nslots; i++) {
+		if (!s_slots[i].busy) {
+			num++;
+		}
+	}
+
+	(void) pthread_mutex_unlock(&s_mutex);
+	return (num);
+}
+
+/*
+ * Create the group of a slot and open the counter files of all the
+ * L3 domains.
+ */
+static int
+slot_create(int idx)
+{
+	resctrl_slot_t *slot = &s_slots[idx];
+	char path[PATH_MAX];
+	int d, i;
+
+	(void) snprintf(path, sizeof (path), "%s/mon_groups/%s%d",
+		RESCTRL_ROOT, RESCTRL_GROUP_PREFIX, idx);
+	if ((mkdir(path, 0755) < 0) && (errno != EEXIST)) {
+		/*
+		 * Other monitor groups hold the rest of the RMIDs. A slot
+		 * which has been removed may just wait for its RMID to
+		 * leave limbo, it's not dropped from the pool.
+		 */
+		if ((errno == ENOSPC) && !slot->removed) {
+			s_nslots = idx;
+		}
+
+		debug_print(NULL, 2, "resctrl: mkdir %s failed, errno=%d\n",
+			path, errno);
+		return (-1);
+	}
+
+	slot->created = B_TRUE;
+	for (d = 0; d < s_nl3; d++) {
+		for (i = 0; i < RESCTRL_EVENT_NUM; i++) {
+			(void) snprintf(path, sizeof (path),
+				"%s/mon_groups/%s%d/mon_data/mon_L3_%02d/%s",
+				RESCTRL_ROOT, RESCTRL_GROUP_PREFIX, idx,
+				s_l3_id[d], s_event_file[i]);
+			slot->fds[d * RESCTRL_EVENT_NUM + i] =
+				open(path, O_RDONLY);
+		}
+	}
+
+	return (0);
+}
+
+/*
+ * Remove the group of a slot, its RMID goes back to the kernel.
+ */
+static void
+slot_remove(int idx)
+{
+	char path[PATH_MAX];
+
+	slot_fds_close(&s_slots[idx]);
+	(void) snprintf(path, sizeof (path), "%s/mon_groups/%s%d",
+		RESCTRL_ROOT, RESCTRL_GROUP_PREFIX, idx);
+	if (rmdir(path) < 0) {
+		debug_print(NULL, 2, "resctrl: rmdir %s failed, errno=%d\n",
+			path, errno);
+	}
+
+	s_slots[idx].created = B_FALSE;
+	s_slots[idx].removed = B_TRUE;
+}
+
+/*
+ * Pick a free slot and create its group. The lock is taken outside.
+ */
+static int
+slot_get(void)
+{
+	int i;
+
+	for (i = 0; i < s_nslots; i++) {
+		if (!s_slots[i].busy) {
+			break;
+		}
+	}
+
+	if ((i == s_nslots) || (slot_create(i) != 0)) {
+		return (-1);
+	}
+
+	return (i);
+}
+
+/*
+ * Move the task to a free monitor group. Return the slot or -1 if all
+ * the RMIDs are in use.
+ */
+int
+resctrl_slot_alloc(pid_t pid)
+{
+	char path[PATH_MAX];
+	int idx;
+
+	(void) pthread_mutex_lock(&s_mutex);
+	if ((idx = slot_get()) == -1) {
+		goto L_EXIT;
+	}
+
+	(void) snprintf(path, sizeof (path), "%s/mon_groups/%s%d/tasks",
+		RESCTRL_ROOT, RESCTRL_GROUP_PREFIX, idx);
+	if (tasks_write(path, &pid, 1) != 1) {
+		slot_remove(idx);
+		idx = -1;
+		goto L_EXIT;
+	}
+
+	s_slots[idx].busy = B_TRUE;
+	s_slots[idx].pid = pid;
+
+L_EXIT:
+	(void) pthread_mutex_unlock(&s_mutex);
+	return (idx);
+}
+
+/*
+ * Make the tasks of the monitor group the same as the threads of the
+ * cgroup. The threads which have left the cgroup go back to the
+ * default group. The lock is taken outside.
+ *
+ * The group lives under the default control group, the kernel refuses
+ * to move a thread which is in another CTRL_MON group (its own CAT
+ * allocation). "ntasks" is the number of threads which are in the group
+ * after the sync, the counters of a group without any are meaningless.
+ */
+static int
+slot_cgroup_sync(int idx)
+{
+	char path[PATH_MAX];
+	pid_t *want = NULL, *have = NULL, *add = NULL, *del = NULL;
+	int nwant, nhave, nadd = 0, ndel = 0, nadded = 0, i, ret = -1;
+
+	(void) snprintf(path, sizeof (path), "%s/cgroup.threads",
+		s_slots[idx].cgroup);
+	if (tids_read(path, &want, &nwant) != 0) {
+		return (-1);
+	}
+
+	(void) snprintf(path, sizeof (path), "%s/mon_groups/%s%d/tasks",
+		RESCTRL_ROOT, RESCTRL_GROUP_PREFIX, idx);
+	if (tids_read(path, &have, &nhave) != 0) {
+		goto L_EXIT;
+	}
+
+	if (((nwant > 0) && ((add = malloc(sizeof (pid_t) * nwant)) == NULL)) ||
+	    ((nhave > 0) && ((del = malloc(sizeof (pid_t) * nhave)) == NULL))) {
+		goto L_EXIT;
+	}
+
+	for (i = 0; i < nwant; i++) {
+		if ((nhave == 0) || (bsearch(&want[i], have, nhave,
+			sizeof (pid_t), tid_cmp) == NULL)) {
+			add[nadd++] = want[i];
+		}
+	}
+
+	for (i = 0; i < nhave; i++) {
+		if ((nwant == 0) || (bsearch(&have[i], want, nwant,
+			sizeof (pid_t), tid_cmp) == NULL)) {
+			del[ndel++] = have[i];
+		}
+	}
+
+	/*
+	 * Some threads may exit in between, the writes of them fail.
+	 */
+	if ((nadd > 0) && ((nadded = tasks_write(path, add, nadd)) < 0)) {
+		nadded = 0;
+	}
+
+	if (ndel > 0) {
+		(void) tasks_write(RESCTRL_ROOT "/tasks", del, ndel);
+	}
+
+	s_slots[idx].ntasks = nhave - ndel + nadded;
+	if ((nadd > 0) && (nadded == 0)) {
+		debug_print(NULL, 2, "resctrl: no thread of %s could join "
+			"the monitor group\n", s_slots[idx].cgroup);
+	}
+
+	ret = 0;
+
+L_EXIT:
+	free(want);
+	free(have);
+	free(add);
+	free(del);
+	return (ret);
+}
+
+/*
+ * Monitor the threads of a cgroup with a free monitor group. "cgroup"
+ * is the directory of the cgroup. The threads created later follow at
+ * the next resctrl_group_sync(). Return the slot or -1 on failure.
+ */
+int
+resctrl_group_alloc(const char *cgroup)
+{
+	int idx;
+
+	(void) pthread_mutex_lock(&s_mutex);
+	if ((idx = slot_get()) == -1) {
+		goto L_EXIT;
+	}
+
+	if ((s_slots[idx].cgroup = strdup(cgroup)) == NULL) {
+		slot_remove(idx);
+		idx = -1;
+		goto L_EXIT;
+	}
+
+	s_slots[idx].busy = B_TRUE;
+	if (slot_cgroup_sync(idx) != 0) {
+		free(s_slots[idx].cgroup);
+		s_slots[idx].cgroup = NULL;
+		s_slots[idx].busy = B_FALSE;
+		slot_remove(idx);
+		idx = -1;
+	}
+
+L_EXIT:
+	(void) pthread_mutex_unlock(&s_mutex);
+	return (idx);
+}
+
+int
+resctrl_group_sync(int idx)
+{
+	int ret = -1;
+
+	(void) pthread_mutex_lock(&s_mutex);
+	if ((idx >= 0) && (idx < s_nslots) && s_slots[idx].busy &&
+	    (s_slots[idx].cgroup != NULL)) {
+		ret = slot_cgroup_sync(idx);
+	}
+
+	(void) pthread_mutex_unlock(&s_mutex);
+	return (ret);
+}
+
+/*
+ * Move all the tasks of the group back to the default group, which
+ * includes the threads a monitored task has created since, and remove
+ * the group. It fails harmlessly for the tasks which have exited.
+ */
+void
+resctrl_slot_free(int idx)
+{
+	char path[PATH_MAX];
+	pid_t *tids;
+	int num;
+
+	(void) pthread_mutex_lock(&s_mutex);
+	if ((idx >= 0) && (idx < s_nslots) && s_slots[idx].busy) {
+		(void) snprintf(path, sizeof (path), "%s/mon_groups/%s%d/tasks",
+			RESCTRL_ROOT, RESCTRL_GROUP_PREFIX, idx);
+		if (tids_read(path, &tids, &num) == 0) {
+			if (num > 0) {
+				(void) tasks_write(RESCTRL_ROOT "/tasks",
+					tids, num);
+			}
+
+			free(tids);
+		} else if (s_slots[idx].pid != 0) {
+			(void) tasks_write(RESCTRL_ROOT "/tasks",
+				&s_slots[idx].pid, 1);
+		}
+
+		free(s_slots[idx].cgroup);
+		s_slots[idx].cgroup = NULL;
+		s_slots[idx].busy = B_FALSE;
+		s_slots[idx].pid = 0;
+		slot_remove(idx);
+	}
+
+	(void) pthread_mutex_unlock(&s_mutex);
+}
+
+static int
+counter_read(int fd, uint64_t *val)
+{
+	char buf[32];
+	ssize_t len;
+
+	if (fd == INVALID_FD) {
+		return (-1);
+	}
+
+	if ((len = pread(fd, buf, sizeof (buf) - 1, 0)) <= 0) {
+		return (-1);
+	}
+
+	/*
+	 * "Unavailable" or "Error" is reported if the counter can't be read.
+	 */
+	buf[len] = '\0';
+	if ((buf[0] < '0') || (buf[0] > '9')) {
+		return (-1);
+	}
+
+	*val = strtoull(buf, NULL, 10);
+	return (0);
+}
+
+/*
+ * Read the counters of the slot on node "nid", or the sum of all nodes
+ * if "nid" is -1. It fails if no L3 domain belongs to the node alone,
+ * or if none of the threads of a cgroup could join the group.
+ */
+int
+resctrl_slot_read(int idx, int nid, uint64_t *values)
+{
+	uint64_t val;
+	boolean_t found = B_FALSE;
+	int d, i, ret = -1;
+
+	(void) memset(values, 0, sizeof (uint64_t) * RESCTRL_EVENT_NUM);
+
+	(void) pthread_mutex_lock(&s_mutex);
+	if ((idx < 0) || (idx >= s_nslots) || !s_slots[idx].busy ||
+	    ((s_slots[idx].cgroup != NULL) && (s_slots[idx].ntasks == 0))) {
+		goto L_EXIT;
+	}
+
+	for (d = 0; d < s_nl3; d++) {
+		if ((nid != -1) && (s_l3_nid[d] != nid)) {
+			continue;
+		}
+
+		found = B_TRUE;
+		for (i = 0; i < RESCTRL_EVENT_NUM; i++) {
+			if (counter_read(s_slots[idx].fds[d * RESCTRL_EVENT_NUM + i],
+				&val) == 0) {
+				values[i] += val;
+			}
+		}
+	}
+
+	if (found) {
+		ret = 0;
+	}
+
+L_EXIT:
+	(void) pthread_mutex_unlock(&s_mutex);
+	return (ret);
+}
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2013, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Intel Corporation nor the names of its contributors
+ *     may be used to endorse or promote products derived from this software
+ *     without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * This file contains the routines to read the statistics files in sysfs
+ * and procfs with one pread() per refresh. The files regenerate their
+ * content when they are read from offset 0, so they are kept opened.
+ */
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/types.h>
+#include "../include/types.h"
+#include "../include/util.h"
+#include "../include/os/statfile.h"
+
+static int
+statfile_reopen(statfile_t *sf)
+{
+	if (sf->fd != INVALID_FD) {
+		(void) close(sf->fd);
+	}
+
+	if ((sf->fd = open(sf->path, O_RDONLY)) < 0) {
+		debug_print(NULL, 2, "statfile: open %s failed, errno=%d\n",
+			sf->path, errno);
+		sf->fd = INVALID_FD;
+		return (-1);
+	}
+
+	return (0);
+}
+
+int
+statfile_open(statfile_t *sf, const char *path)
+{
+	(void) memset(sf, 0, sizeof (statfile_t));
+	sf->fd = INVALID_FD;
+
+	if ((sf->path = strdup(path)) == NULL) {
+		return (-1);
+	}
+
+	if ((sf->buf = malloc(STATFILE_BUF_SIZE)) == NULL) {
+		free(sf->path);
+		sf->path = NULL;
+		return (-1);
+	}
+
+	sf->size = STATFILE_BUF_SIZE;
+	if (statfile_reopen(sf) != 0) {
+		statfile_close(sf);
+		return (-1);
+	}
+
+	return (0);
+}
+
+/*
+ * Return the whole content of the file, or NULL on failure. A file
+ * which goes away (e.g. with a hot-removed node) is opened again once.
+ */
+char *
+statfile_read(statfile_t *sf)
+{
+	ssize_t len;
+	char *buf;
+	boolean_t reopened = B_FALSE;
+
+	if ((sf->buf == NULL) ||
+	    ((sf->fd == INVALID_FD) && (statfile_reopen(sf) != 0))) {
+		return (NULL);
+	}
+
+	for (;;) {
+		if ((len = pread(sf->fd, sf->buf, sf->size - 1, 0)) < 0) {
+			if (reopened || (statfile_reopen(sf) != 0)) {
+				return (NULL);
+			}
+
+			reopened = B_TRUE;
+			continue;
+		}
+
+		if (len < sf->size - 1) {
+			break;
+		}
+
+		/*
+		 * The content may be truncated, read it again with a
+		 * larger buffer.
+		 */
+		if ((buf = realloc(sf->buf, sf->size * 2)) == NULL) {
+			return (NULL);
+		}
+
+		sf->buf = buf;
+		sf->size *= 2;
+	}
+
+	sf->buf[len] = '\0';
+	return (sf->buf);
+}
+
+/*
+ * Read a zero-initialized statfile_t, opening it at the first call.
+ */
+char *
+statfile_get(statfile_t *sf, const char *path)
+{
+	if ((sf->path == NULL) && (statfile_open(sf, path) != 0)) {
+		return (NULL);
+	}
+
+	return (statfile_read(sf));
+}
+
+void
+statfile_close(statfile_t *sf)
+{
+	if (sf->path == NULL) {
+		/* Never opened */
+		return;
+	}
+
+	if (sf->fd != INVALID_FD) {
+		(void) close(sf->fd);
+	}
+
+	free(sf->path);
+	free(sf->buf);
+	(void) memset(sf, 0, sizeof (statfile_t));
+	sf->fd = INVALID_FD;
+}
@@ -260,6 +260,15 @@ elf32_symtab_copyout(sym_binary_t *binary, uint64_t symtab_off,
 					sym.st_size, sym_type, load_addr) != 0) {
 					goto L_EXIT;
 				}
+			} else if (ELF32_ST_TYPE(sym.st_info) == STT_OBJECT) {
+				/*
+				 * Data objects never overlap with text, keep them
+				 * too so that sampled data addresses can be resolved.
+				 */
+				if (sym_item_add(binary, strtab + sym.st_name, sym.st_value,
+					sym.st_size, SYM_TYPE_OBJECT, load_addr) != 0) {
+					goto L_EXIT;
+				}
 			}
 			break;
 
@@ -322,6 +331,15 @@ elf64_symtab_copyout(sym_binary_t *binary, uint64_t symtab_off,
 					sym.st_size, sym_type, load_addr) != 0) {
 					goto L_EXIT;
 				}
+			} else if (ELF64_ST_TYPE(sym.st_info) == STT_OBJECT) {
+				/*
+				 * Data objects never overlap with text, keep them
+				 * too so that sampled data addresses can be resolved.
+				 */
+				if (sym_item_add(binary, strtab + sym.st_name, sym.st_value,
+					sym.st_size, SYM_TYPE_OBJECT, load_addr) != 0) {
+					goto L_EXIT;
+				}
 			}
 			break;
 
@@ -605,7 +623,7 @@ image_sym_read(sym_t *sym, map_entry_t *map, sym_type_t sym_type)
 }
 
 static sym_lib_t *
-lib_find(char *path)
+lib_find(const char *path)
 {
 	sym_lib_t *p = s_first_lib;
 	
@@ -621,7 +639,7 @@ lib_find(char *path)
 }
 
 static sym_lib_t *
-lib_add(char *path, sym_type_t sym_type)
+lib_add(const char *path, sym_type_t sym_type)
 {
 	sym_lib_t *lib, *p;
 	sym_binary_t *binary;
@@ -863,6 +881,31 @@ resolve_unique(sym_t *sym, uint64_t addr, sym_item_t **arr, uint64_t *base_addr)
 	return (item);
 }
 
+/*
+ * Resolve a data address to "object+offset". Only the objects of
+ * mappings which have been loaded by sym_load() can be found.
+ */
+int
+sym_data_resolve(sym_t *sym, uint64_t addr, char *buf, int size)
+{
+	sym_item_t *item_arr, *item;
+	uint64_t base_addr;
+	int ret = -1;
+
+	if ((item = resolve_unique(sym, addr, &item_arr, &base_addr)) == NULL) {
+		return (-1);
+	}
+
+	if (item->type == SYM_TYPE_OBJECT) {
+		(void) snprintf(buf, size, "%s+0x%llx", item->name,
+			(unsigned long long)(addr - base_addr - item->off));
+		ret = 0;
+	}
+
+	free(item_arr);
+	return (ret);
+}
+
 static boolean_t
 ips_exist(sym_callchain_t *chain, uint64_t *ips, int ips_num)
 {
@@ -48,6 +48,10 @@
 
 static perf_ctl_t s_perf_ctl;
 
+int g_rec_max;
+boolean_t g_perf_concurrent;
+boolean_t g_uncore_only;
+
 uint64_t g_sample_period[PERF_COUNT_NUM][PRECISE_NUM] = {
 	{ SMPL_PERIOD_CORECLK_DEFAULT,
 	  SMPL_PERIOD_CORECLK_MIN,
@@ -82,7 +86,7 @@ typedef struct _perf_pqos_arg {
 	int lwpid;
 } perf_pqos_arg_t;
 
-static perf_pqos_arg_t s_pqos_arg[PERF_PQOS_CMT_MAX];
+static perf_pqos_arg_t s_pqos_arg[PERF_PQOS_TOPN];
 
 static boolean_t
 task_valid(perf_task_t *task)
@@ -161,6 +165,10 @@ status_failed(perf_status_t status)
 	case PERF_STATUS_LL_FAILED:
 		/* fall through */
 	case PERF_STATUS_CALLCHAIN_FAILED:
+		/* fall through */
+	case PERF_STATUS_UNCORE_FAILED:
+		/* fall through */
+	case PERF_STATUS_PQOS_CMT_FAILED:
 		return (B_TRUE);
 
 	default:
@@ -229,7 +237,7 @@ perf_handler(void *arg __attribute__((unused)))
 		switch (TASKID(&task)) {
 		case PERF_QUIT_ID:
 			debug_print(NULL, 2, "perf_handler: received QUIT\n");
-			os_allstop();
+			os_allfree();
 			goto L_EXIT;
 
 		case PERF_STOP_ID:
@@ -357,7 +365,13 @@ perf_init(void)
 	}
 
 	s_perf_ctl.last_ms = current_ms(&g_tvbase);
-	if (perf_profiling_start() != 0) {
+
+	/*
+	 * In uncore-only mode nothing is sampled until the user asks for
+	 * a profiling window, the uncore counting is started by the home
+	 * window.
+	 */
+	if (!g_uncore_only && (perf_profiling_start() != 0)) {
 		debug_print(NULL, 2, "perf_init: "
 		    "perf_profiling_start() failed\n");
 		goto L_EXIT;
@@ -580,10 +594,64 @@ perf_ll_smpl(pid_t pid, int lwpid)
 	return (os_perf_ll_smpl(&s_perf_ctl, pid, lwpid));
 }
 
+/*
+ * Reservoir sampling (Algorithm R). A group keeps at most 'g_rec_max'
+ * records. When the group is full, the n-th record offered replaces a
+ * random one with probability g_rec_max / n, so each record offered has
+ * the same chance to be kept.
+ *
+ * Return the slot for the new record, 'nrec_cur' means appending and
+ * -1 means the record is dropped.
+ */
+int
+perf_rec_slot(uint64_t *nrec_seen, int nrec_cur)
+{
+	uint64_t i;
+
+	(*nrec_seen)++;
+	if (nrec_cur < g_rec_max) {
+		return (nrec_cur);
+	}
+
+	i = (((uint64_t)random() << 31) | (uint64_t)random()) % *nrec_seen;
+	if (i < (uint64_t)g_rec_max) {
+		return ((int)i);
+	}
+
+	return (-1);
+}
+
+/*
+ * The record may be referenced by both the process and the thread,
+ * lwp_free() drops the references without holding the process mutex,
+ * so the refcount is updated atomically.
+ */
+void
+perf_llrec_put(os_perf_llrec_t *rec)
+{
+	if (__sync_sub_and_fetch(&rec->ref_count, 1) == 0) {
+		free(rec);
+	}
+}
+
+void
+perf_chainrec_put(perf_chainrec_t *rec)
+{
+	if (__sync_sub_and_fetch(&rec->ref_count, 1) == 0) {
+		free(rec);
+	}
+}
+
 void
 perf_llrecgrp_reset(perf_llrecgrp_t *grp)
 {
+	int i;
+
 	if (grp->rec_arr != NULL) {
+		for (i = 0; i < grp->nrec_cur; i++) {
+			perf_llrec_put(grp->rec_arr[i]);
+		}
+
 		free(grp->rec_arr);
 	}
 
@@ -636,13 +704,34 @@ perf_pqos_cmt_smpl(pid_t pid, int lwpid)
 	return (os_perf_pqos_cmt_smpl(&s_perf_ctl, pid, lwpid));
 }
 
+static int
+pqos_seq_cmp(const void *p1, const void *p2)
+{
+	const track_proc_t *proc1 = *(const track_proc_t * const *)p1;
+	const track_proc_t *proc2 = *(const track_proc_t * const *)p2;
+
+	if (proc1->pqos.seq < proc2->pqos.seq)
+		return (-1);
+
+	if (proc1->pqos.seq > proc2->pqos.seq)
+		return (1);
+
+	return (0);
+}
+
+/*
+ * Monitor the top processes with the resctrl monitor groups. If there
+ * are more processes than groups, the processes which got their groups
+ * first hand them over to the waiting ones at each refresh, once they
+ * have been sampled for a whole interval.
+ */
 int perf_pqos_active_proc_setup(int flags, boolean_t refresh)
 {
-	int nprocs, nlwps, i, j = 0, pqos_num;
-	track_proc_t *proc;
+	track_proc_t *held[PERF_PQOS_TOPN], *proc;
+	int nprocs, nlwps, i, j = 0, nheld = 0, pqos_num, nfree;
 
 	proc_lwp_count(&nprocs, &nlwps);
-	pqos_num = MIN(nprocs, PERF_PQOS_CMT_MAX);
+	pqos_num = MIN(nprocs, PERF_PQOS_TOPN);
 
 	memset(s_pqos_arg, 0, sizeof(s_pqos_arg));
 
@@ -657,6 +746,8 @@ int perf_pqos_active_proc_setup(int flags, boolean_t refresh)
 		if (!proc->pqos.task_id) {
 			s_pqos_arg[j].pid = proc->pid;
 			j++;
+		} else if (proc->pqos.nsmpl > 1) {
+			held[nheld++] = proc;
 		}
 	}
 
@@ -665,15 +756,27 @@ int perf_pqos_active_proc_setup(int flags, boolean_t refresh)
 			break;
 		}
 
-		if (!proc->pqos.task_id)
-			os_perf_pqos_free(&proc->pqos);
+		if (proc->pqos.task_id)
+			os_perf_pqos_release(&proc->pqos);
+	}
+
+	nfree = os_perf_pqos_nfree();
+	if ((j > nfree) && (nheld > 0)) {
+		qsort(held, nheld, sizeof (track_proc_t *), pqos_seq_cmp);
+		for (i = 0; (i < nheld) && (nfree < j); i++) {
+			os_perf_pqos_release(&held[i]->pqos);
+			nfree++;
+		}
 	}
 
 	proc_group_unlock();
 
+	/*
+	 * A process may exit before it's set up, skip it.
+	 */
+	j = MIN(j, nfree);
 	for (i = 0; i < j; i++) {
-		if (perf_pqos_cmt_start(s_pqos_arg[i].pid, 0, flags) != 0)
-			return -1;
+		(void) perf_pqos_cmt_start(s_pqos_arg[i].pid, 0, flags);
 	}
 
 	if ((j > 0) && (!refresh))
@@ -474,6 +474,16 @@ proc_key_compute(track_proc_t *proc, void *arg, boolean_t *end)
 		proc->key = (uint64_t)ratio(rma * 1000, lma);
 		break;
 
+	case SORT_KEY_COST:
+		proc->key = (uint64_t)node_access_cost(proc->countval_arr,
+		    NODE_ALL);
+		break;
+
+	case SORT_KEY_XSOCKET:
+		proc->key = (uint64_t)node_xsocket_access(proc->countval_arr,
+		    NODE_ALL);
+		break;
+
 	default:
 		break;
 	}
@@ -1021,6 +1031,29 @@ proc_ll_clear(track_proc_t *proc)
 	}
 }
 
+/* ARGSUSED */
+static int
+map_lost(track_proc_t *proc,
+	void *arg __attribute__((unused)),
+	boolean_t *end)
+{
+	*end = B_FALSE;
+	map_event_lost(proc);
+	return (0);
+}
+
+/*
+ * Some mapping events were dropped in perf ring buffer, force all the
+ * processes to reread the maps file.
+ */
+void
+proc_map_lost(void)
+{
+	(void) pthread_mutex_lock(&s_proc_group.mutex);
+	proc_traverse(map_lost, NULL);
+	(void) pthread_mutex_unlock(&s_proc_group.mutex);
+}
+
 void proc_pqos_func(track_proc_t *proc,
 	int (*func)(track_proc_t *, void *, boolean_t *))
 {
@@ -315,6 +315,97 @@ cyc2ns(uint64_t cyc)
 	return (ns);
 }
 
+static int
+lat_hist_idx(uint64_t value)
+{
+	int shift, idx;
+
+	if (value < LAT_HIST_SUB_NUM) {
+		return ((int)value);
+	}
+
+	shift = 63 - __builtin_clzll(value) - LAT_HIST_SUB_BITS;
+	idx = (shift + 1) * LAT_HIST_SUB_NUM +
+	    (int)(value >> shift) - LAT_HIST_SUB_NUM;
+
+	return (MIN(idx, LAT_HIST_NUM - 1));
+}
+
+/*
+ * Count one latency sample (in CPU cycles) in the histogram.
+ */
+void
+lat_hist_add(lat_hist_t *hist, uint64_t value)
+{
+	hist->bucket[lat_hist_idx(value)]++;
+	hist->nsamples++;
+
+	if (value > hist->max) {
+		hist->max = (uint32_t)MIN(value, MAX_VALUE);
+	}
+}
+
+/*
+ * Add the samples of "src" to "dst". Since both histograms share the
+ * bucket layout, merging is just adding the bucket counts.
+ */
+void
+lat_hist_merge(lat_hist_t *dst, const lat_hist_t *src)
+{
+	int i;
+
+	if (src->nsamples == 0) {
+		return;
+	}
+
+	for (i = 0; i < LAT_HIST_NUM; i++) {
+		dst->bucket[i] += src->bucket[i];
+	}
+
+	dst->nsamples += src->nsamples;
+	if (src->max > dst->max) {
+		dst->max = src->max;
+	}
+}
+
+/*
+ * Return the latency (in CPU cycles) below which "pct" percent of the
+ * samples fall. The value is the middle of the bucket which holds the
+ * sample of that rank, it never exceeds the recorded maximum.
+ */
+uint64_t
+lat_hist_percentile(const lat_hist_t *hist, int pct)
+{
+	uint64_t rank, sum = 0, low, width;
+	int i, shift;
+
+	if (hist->nsamples == 0) {
+		return (0);
+	}
+
+	rank = ((uint64_t)hist->nsamples * pct + 99) / 100;
+	if (rank == 0) {
+		rank = 1;
+	}
+
+	for (i = 0; i < LAT_HIST_NUM - 1; i++) {
+		if ((sum += hist->bucket[i]) >= rank) {
+			break;
+		}
+	}
+
+	if (i < LAT_HIST_SUB_NUM) {
+		low = i;
+		width = 1;
+	} else {
+		shift = i / LAT_HIST_SUB_NUM - 1;
+		low = (uint64_t)(LAT_HIST_SUB_NUM + i % LAT_HIST_SUB_NUM) << shift;
+		width = 1ULL << shift;
+	}
+
+	return (MIN(low + width / 2, hist->max));
+}
+
 /*
  * Initialization for dump control structure.
  */
@@ -46,6 +46,7 @@
 #include "include/proc.h"
 #include "include/page.h"
 #include "include/perf.h"
+#include "include/ui_perf_map.h"
 #include "include/os/node.h"
 #include "include/os/plat.h"
 #include "include/os/os_util.h"
@@ -55,6 +56,25 @@ static boolean_t s_first_load = B_TRUE;
 static win_reg_t s_note_reg;
 static win_reg_t s_title_reg;
 
+/*
+ * The RMA/LMA column shows the metric of the sort key instead if the
+ * metric has no column of its own.
+ */
+static double
+rl_column_value(win_countvalue_t *value)
+{
+	switch (g_sortkey) {
+	case SORT_KEY_COST:
+		return (value->cost);
+
+	case SORT_KEY_XSOCKET:
+		return (value->xsocket);
+
+	default:
+		return (value->rl);
+	}
+}
+
 /*
  * Build the readable string for caption line.
  * (window type: "WIN_TYPE_TOPNPROC")
@@ -105,6 +125,23 @@ topnproc_caption_build(char *buf, int size)
 		    CAPTION_LPI, tmp, CAPTION_CPI, CAPTION_CPU);
 		break;
 
+	case SORT_KEY_COST:
+		/* The cost takes the place of RMA/LMA */
+		(void) snprintf(tmp, sizeof (tmp), "*%s", CAPTION_COST);
+		(void) snprintf(buf, size,
+		    "%10s%15s%11s%11s%11s%11s%11s",
+		    CAPTION_PID, CAPTION_PROC, CAPTION_RPI,
+		    CAPTION_LPI, tmp, CAPTION_CPI, CAPTION_CPU);
+		break;
+
+	case SORT_KEY_XSOCKET:
+		(void) snprintf(tmp, sizeof (tmp), "*%s", CAPTION_XSOCKET);
+		(void) snprintf(buf, size,
+		    "%10s%15s%11s%11s%11s%11s%11s",
+		    CAPTION_PID, CAPTION_PROC, CAPTION_RPI,
+		    CAPTION_LPI, tmp, CAPTION_CPI, CAPTION_CPU);
+		break;
+
 	default:
 		(void) snprintf(buf, size,
 		    "%10s%15s%11s%11s%11s%11s%11s",
@@ -122,7 +159,8 @@ topnproc_data_build(char *buf, int size, topnproc_line_t *line)
 	(void) snprintf(buf, size,
 	    "%10d%15s%11.1f%11.1f%11.1f%11.2f%10.1f",
 	    line->pid, line->proc_name, value->rpi, value->lpi,
-	    value->rl, value->cpi, value->cpu * 100);
+	    rl_column_value(value),
+	    value->cpi, value->cpu * 100);
 }
 
 /*
@@ -201,6 +239,23 @@ rawnum_caption_build(char *buf, int size)
 		    CAPTION_LMA, tmp, CAPTION_CPI, CAPTION_CPU);
 		break;
 
+	case SORT_KEY_COST:
+		/* The cost takes the place of RMA/LMA */
+		(void) snprintf(tmp, sizeof (tmp), "*%s", CAPTION_COST);
+		(void) snprintf(buf, size,
+		    "%10s%15s%11s%11s%11s%11s%11s",
+		    CAPTION_PID, CAPTION_PROC, CAPTION_RMA,
+		    CAPTION_LMA, tmp, CAPTION_CPI, CAPTION_CPU);
+		break;
+
+	case SORT_KEY_XSOCKET:
+		(void) snprintf(tmp, sizeof (tmp), "*%s", CAPTION_XSOCKET);
+		(void) snprintf(buf, size,
+		    "%10s%15s%11s%11s%11s%11s%11s",
+		    CAPTION_PID, CAPTION_PROC, CAPTION_RMA,
+		    CAPTION_LMA, tmp, CAPTION_CPI, CAPTION_CPU);
+		break;
+
 	default:
 		(void) snprintf(buf, size,
 		    "%10s%15s%11s%11s%11s%11s%11s",
@@ -218,7 +273,8 @@ rawnum_data_build(char *buf, int size, topnproc_line_t *line)
 	(void) snprintf(buf, size,
 	    "%10d%15s%11.1f%11.1f%11.1f%11.2f%10.1f",
 	    line->pid, line->proc_name, value->rma, value->lma,
-	    value->rl, value->cpi, value->cpu * 100);
+	    rl_column_value(value),
+	    value->cpi, value->cpu * 100);
 }
 
 /*
@@ -335,6 +391,8 @@ win_countvalue_fill(win_countvalue_t *cv,
 	cv->rma = ratio(rma, 1000);
 	cv->lma = ratio(lma, 1000);
 	cv->rl = ratio(rma, lma);
+	cv->cost = node_access_cost(countval_arr, nid) / 1000.0;
+	cv->xsocket = node_xsocket_access(countval_arr, nid) / 1000.0;
 
 	d = (double)ms / MS_SEC;
 	all_clks = (uint64_t)(d * (double)g_clkofsec * (double)ncpus);
@@ -463,16 +521,19 @@ topnproc_data_show(dyn_win_t *win)
 
 	if (win->type == WIN_TYPE_TOPNPROC) {
 		reg_line_write(r, 1, ALIGN_LEFT,
-		    "<- Hotkey for sorting: 1(RPI), 2(LPI), 3(RMA/LMA), "
-		    "4(CPI), 5(CPU%%) ->");
+		    "<- Sort: 1(RPI), 2(LPI), 3(RMA/LMA), "
+		    "4(CPI), 5(CPU%%), 6(COST), 7(XSKT) ->");
 	} else {
 		reg_line_write(r, 1, ALIGN_LEFT,
-		    "<- Hotkey for sorting: 1(RMA), 2(LMA), 3(RMA/LMA), "
-		    "4(CPI), 5(CPU%%) ->");
+		    "<- Sort: 1(RMA), 2(LMA), 3(RMA/LMA), "
+		    "4(CPI), 5(CPU%%), 6(COST), 7(XSKT) ->");
 	}
 
 	reg_line_write(r, 2, ALIGN_LEFT,
-	    "CPU%% = system CPU utilization");
+	    "CPU%% = system CPU utilization, "
+	    "COST = accesses weighted by node distance");
+	reg_line_write(r, 3, ALIGN_LEFT,
+	    "XSKT = remote accesses leaving the socket");
 
 	reg_refresh_nout(r);
 }
@@ -1443,11 +1504,8 @@ nodeoverview_str_build(char *buf, int size, int idx, void *pv)
 {
 	nodeoverview_line_t *lines = (nodeoverview_line_t *)pv;
 	nodeoverview_line_t *line = &lines[idx];
-	node_t *node;
 
-	if ((node = node_valid_get(idx)) != NULL) {
-		os_nodeoverview_data_build(buf, size, line, node);
-	}
+	os_nodeoverview_data_build(buf, size, line);
 }
 
 /*
@@ -1472,10 +1530,15 @@ nodeoverview_dyn_create(void)
 {
 	dyn_nodeoverview_t *dyn;
 	void *buf_cur;
-	int i, nnodes;
+	int i, nlines_max;
 
-	nnodes = node_num();
-	if ((buf_cur = zalloc(sizeof (nodeoverview_line_t) * nnodes)) == NULL) {
+	/*
+	 * The number of lines is bounded by the nodes plus the CPUs at
+	 * any level of the topology.
+	 */
+	nlines_max = nnodes_max + ncpus_max;
+	if ((buf_cur = zalloc(sizeof (nodeoverview_line_t) *
+	    nlines_max)) == NULL) {
 		return (NULL);
 	}
 	if ((dyn = zalloc(sizeof (dyn_nodeoverview_t))) == NULL) {
@@ -1483,12 +1546,23 @@ nodeoverview_dyn_create(void)
 		return (NULL);
 	}
 
+	if ((dyn->domains = zalloc(sizeof (topo_domain_t) *
+	    nlines_max)) == NULL) {
+		free(dyn);
+		free(buf_cur);
+		return (NULL);
+	}
+
+	dyn->level = TOPO_LEVEL_NODE;
+	dyn->nlines_max = nlines_max;
+
 	if ((i = reg_init(&dyn->msg, 0, 1, g_scr_width, 2, A_BOLD)) < 0)
 		goto L_EXIT;
 	if ((i = reg_init(&dyn->caption_cur, 0, i, g_scr_width, 2,
 	    A_BOLD | A_UNDERLINE)) < 0)
 		goto L_EXIT;
-	if ((i = reg_init(&dyn->data_cur, 0, i, g_scr_width, nnodes, 0)) < 0)
+	if ((i = reg_init(&dyn->data_cur, 0, i, g_scr_width,
+	    MIN(nlines_max, g_scr_height - i - 4), 0)) < 0)
 		goto L_EXIT;
 
 	reg_buf_init(&dyn->data_cur, buf_cur, nodeoverview_line_get);
@@ -1498,6 +1572,7 @@ nodeoverview_dyn_create(void)
 	    g_scr_height - i - 1, A_BOLD);
 	return (dyn);
 L_EXIT:
+	free(dyn->domains);
 	free(dyn);
 	free(buf_cur);
 	return (NULL);
@@ -1517,6 +1592,7 @@ nodeoverview_win_destroy(dyn_win_t *win)
 			free(dyn->data_cur.buf);
 		}
 
+		free(dyn->domains);
 		reg_win_destroy(&dyn->msg);
 		reg_win_destroy(&dyn->caption_cur);
 		reg_win_destroy(&dyn->data_cur);
@@ -1525,16 +1601,21 @@ nodeoverview_win_destroy(dyn_win_t *win)
 	}
 }
 
-void
-win_node_countvalue(node_t *node, win_countvalue_t *cv)
+/*
+ * Convert the perf data summed up on "ncpus" CPUs of a node, a socket
+ * or an LLC domain.
+ */
+static void
+win_domain_countvalue(count_value_t *countval, int ncpus,
+	win_countvalue_t *cv)
 {
 	double d;
 	uint64_t rma, lma, clk, ir, all_clks;
 
-	rma = node_countval_get(node, UI_COUNT_RMA);
-	lma = node_countval_get(node, UI_COUNT_LMA);
-	clk = node_countval_get(node, UI_COUNT_CLK);
-	ir = node_countval_get(node, UI_COUNT_IR);
+	rma = ui_perf_count_aggr(UI_COUNT_RMA, countval->counts);
+	lma = ui_perf_count_aggr(UI_COUNT_LMA, countval->counts);
+	clk = ui_perf_count_aggr(UI_COUNT_CLK, countval->counts);
+	ir = ui_perf_count_aggr(UI_COUNT_IR, countval->counts);
 
 	cv->rpi = ratio(rma * 1000, ir);
 	cv->lpi = ratio(lma * 1000, ir);
@@ -1544,11 +1625,16 @@ win_node_countvalue(node_t *node, win_countvalue_t *cv)
 	cv->rl = ratio(rma, lma);
 
 	d = (double)node_intval_get() / MS_SEC;
-	all_clks = (uint64_t)(d * (double)g_clkofsec *
-	    (double)node_ncpus(node));
+	all_clks = (uint64_t)(d * (double)g_clkofsec * (double)ncpus);
 	cv->cpu = ratio(clk, all_clks);
 }
 
+void
+win_node_countvalue(node_t *node, win_countvalue_t *cv)
+{
+	win_domain_countvalue(&node->countval, node_ncpus(node), cv);
+}
+
 /*
  * Convert the perf data to the required format and copy
  * the converted result out via "line".
@@ -1571,6 +1657,8 @@ nodeoverview_data_save(int nid_idx,
 	node_meminfo(node->nid, &meminfo);
 
 	win_node_countvalue(node, &line->value);
+	line->level = TOPO_LEVEL_NODE;
+	line->id = node->nid;
 	line->nid = node->nid;
 	line->mem_all = (double)((double)(meminfo.mem_total) /
 	    (double)(GB_BYTES));
@@ -1578,6 +1666,24 @@ nodeoverview_data_save(int nid_idx,
 	    (double)(GB_BYTES));
 }
 
+/*
+ * Convert the perf data of a socket or an LLC domain.
+ * (window type: "WIN_TYPE_NODE_OVERVIEW")
+ */
+static void
+nodeoverview_domain_save(topo_domain_t *domain, topo_level_t level,
+	nodeoverview_line_t *line)
+{
+	(void) memset(line, 0, sizeof (nodeoverview_line_t));
+	win_domain_countvalue(&domain->countval, domain->ncpus, &line->value);
+	line->level = level;
+	line->id = domain->id;
+	line->nid = domain->nid;
+	line->ncpus = domain->ncpus;
+	line->mem_all = (double)domain->mem_total / (double)(GB_BYTES);
+	line->mem_free = (double)domain->mem_free / (double)(GB_BYTES);
+}
+
 static boolean_t
 nodeoverview_data_show(dyn_win_t *win, boolean_t *note_out)
 {
@@ -1603,26 +1709,37 @@ nodeoverview_data_show(dyn_win_t *win, boolean_t *note_out)
 	/*
 	 * Display the caption of table:
 	 */
-	os_nodeoverview_caption_build(content, sizeof (content));
+	os_nodeoverview_caption_build(content, sizeof (content), dyn->level);
 	r = &dyn->caption_cur;
 	reg_erase(r);
 	reg_line_write(r, 1, ALIGN_LEFT, content);
 	dump_write("%s\n", content);
 	reg_refresh_nout(r);
 
-	nnodes = node_num();
 	r = &dyn->data_cur;
 	reg_erase(r);
 	lines = (nodeoverview_line_t *)(r->buf);
-	r->nlines_total = nnodes;
 
 	/*
-	 * Save the per-node data with metrics in scrolling buffer.
+	 * Save the per-node (or per-socket, per-LLC) data with metrics
+	 * in scrolling buffer.
 	 */
-	for (i = 0; i < nnodes; i++) {
-		nodeoverview_data_save(i, nnodes, &lines[i]);
+	if (dyn->level == TOPO_LEVEL_NODE) {
+		nnodes = MIN(node_num(), dyn->nlines_max);
+		for (i = 0; i < nnodes; i++) {
+			nodeoverview_data_save(i, nnodes, &lines[i]);
+		}
+	} else {
+		nnodes = node_topo_domains(dyn->level, dyn->domains,
+		    dyn->nlines_max);
+		for (i = 0; i < nnodes; i++) {
+			nodeoverview_domain_save(&dyn->domains[i], dyn->level,
+			    &lines[i]);
+		}
 	}
 
+	r->nlines_total = nnodes;
+
 	/*
 	 * Display the per-node data in scrolling buffer
 	 */
@@ -1635,7 +1752,7 @@ nodeoverview_data_show(dyn_win_t *win, boolean_t *note_out)
 	r = &dyn->hint;
 	reg_erase(r);
 	reg_line_write(r, r->nlines_scr - 2, ALIGN_LEFT,
-	    "CPU%% = per-node CPU utilization");
+	    "CPU%% = CPU utilization of the node, socket or LLC domain");
 	reg_refresh_nout(r);
 
 	return (B_TRUE);
@@ -1691,7 +1808,9 @@ nodeoverview_win_scrollenter(dyn_win_t *win)
 	cmd_node_detail_t cmd;
 	boolean_t badcmd;
 
-	if (scroll->highlight == -1) {
+	lines = (nodeoverview_line_t *)(r->buf);
+	if ((scroll->highlight == -1) ||
+	    (lines[scroll->highlight].nid == INVALID_NID)) {
 		return;
 	}
 
@@ -1699,7 +1818,6 @@ nodeoverview_win_scrollenter(dyn_win_t *win)
 	 * Construct a command to switch to next window
 	 * "WIN_TYPE_NODE_DETAIL".
 	 */
-	lines = (nodeoverview_line_t *)(r->buf);
 	cmd.id = CMD_NODE_DETAIL_ID;
 	cmd.nid = lines[scroll->highlight].nid;
 
@@ -1735,6 +1853,8 @@ nodedetail_dyn_create(page_t *page)
 	    g_scr_height - i - 4, 0)) < 0)
 		goto L_EXIT;
 	(void) reg_init(&dyn->hint, 0, i, g_scr_width, 3, A_BOLD);
+	reg_buf_init(&dyn->node_data, NULL, win_callchain_line_get);
+	reg_scroll_init(&dyn->node_data, B_TRUE);
 	return (dyn);
 L_EXIT:
 	free(dyn);
@@ -1806,6 +1926,10 @@ nodedetail_win_destroy(dyn_win_t *win)
 	dyn_nodedetail_t *dyn;
 
 	if ((dyn = win->dyn) != NULL) {
+		if (dyn->node_data.buf != NULL) {
+			free(dyn->node_data.buf);
+		}
+
 		reg_win_destroy(&dyn->msg);
 		reg_win_destroy(&dyn->node_data);
 		reg_win_destroy(&dyn->hint);
@@ -1813,6 +1937,18 @@ nodedetail_win_destroy(dyn_win_t *win)
 	}
 }
 
+/*
+ * The callback function for "WIN_TYPE_NODE_DETAIL" would be called
+ * when user hits the <UP>/<DOWN> key to scroll data line.
+ */
+static void
+nodedetail_win_scroll(dyn_win_t *win, int scroll_type)
+{
+	dyn_nodedetail_t *dyn = (dyn_nodedetail_t *)(win->dyn);
+
+	reg_line_scroll(&dyn->node_data, scroll_type);
+}
+
 void
 win_callchain_str_build(char *buf, int size, int idx, void *pv)
 {
@@ -2050,9 +2186,49 @@ win_size2str(uint64_t size, char *buf, int bufsize)
 	}
 }
 
+/*
+ * Build the string of latency percentiles (nanosecond) which is
+ * displayed under the captions "P50(ns) P90(ns) P99(ns) MAX(ns)".
+ */
+void
+win_lathist_str_build(char *buf, int size, const lat_hist_t *hist)
+{
+	(void) snprintf(buf, size, "%10"PRIu64"%10"PRIu64"%10"PRIu64
+	    "%10"PRIu64,
+	    cyc2ns(lat_hist_percentile(hist, 50)),
+	    cyc2ns(lat_hist_percentile(hist, 90)),
+	    cyc2ns(lat_hist_percentile(hist, 99)),
+	    cyc2ns(hist->max));
+}
+
+/*
+ * Build the string of data source breakdown which is displayed under
+ * the captions "L3% LDRAM% RDRAM% RCACHE% CXL% HITM%". The loads served by
+ * L1/L2 are only counted in the total.
+ */
+void
+win_memsrc_str_build(char *buf, int size, const memsrc_count_t *memsrc)
+{
+	uint64_t total = 0;
+	int i;
+
+	for (i = 0; i < MEM_SRC_NUM; i++) {
+		total += memsrc->count[i];
+	}
+
+	(void) snprintf(buf, size, "%8.1f%8.1f%8.1f%8.1f%8.1f%8.1f",
+	    ratio(memsrc->count[MEM_SRC_L3], total) * 100.0,
+	    ratio(memsrc->count[MEM_SRC_LOC_DRAM], total) * 100.0,
+	    ratio(memsrc->count[MEM_SRC_REM_DRAM], total) * 100.0,
+	    ratio(memsrc->count[MEM_SRC_REM_CACHE], total) * 100.0,
+	    ratio(memsrc->count[MEM_SRC_CXL], total) * 100.0,
+	    ratio(memsrc->count[MEM_SRC_HITM], total) * 100.0);
+}
+
 /*
  * Build the readable string of data line which contains buffer address,
- * buffer size, access%, latency (nanosecond) and buffer description.
+ * buffer size, access%, latency (nanosecond), latency percentiles,
+ * buffer description and data source breakdown.
  */
 void
 win_lat_str_build(char *buf, int size, int idx, void *pv)
@@ -2061,7 +2237,7 @@ win_lat_str_build(char *buf, int size, int idx, void *pv)
 	lat_line_t *line = &lines[idx];
 	float hit = 0.0;
 	int lat = 0;
-	char size_str[32];
+	char size_str[32], hist_str[64], src_str[64];
 
 	if (line->nsamples > 0) {
 		hit = (float)(line->naccess) / (float)(line->nsamples);
@@ -2072,20 +2248,25 @@ win_lat_str_build(char *buf, int size, int idx, void *pv)
 	}
 
 	win_size2str(line->bufaddr.size, size_str, sizeof (size_str));
+	win_lathist_str_build(hist_str, sizeof (hist_str), &line->hist);
+	win_memsrc_str_build(src_str, sizeof (src_str), &line->memsrc);
 
 	if (!line->nid_show) {
-		(void) snprintf(buf, size, "%16"PRIX64"%8s%10.1f%11"PRIu64"%34s",
+		(void) snprintf(buf, size,
+		    "%16"PRIX64"%8s%10.1f%11"PRIu64"%s%34s%s",
 		    line->bufaddr.addr, size_str, hit * 100.0, cyc2ns(lat),
-		    line->desc);
+		    hist_str, line->desc, src_str);
 	} else {
 		if (line->nid < 0) {
-			(void) snprintf(buf, size, "%16"PRIX64"%8s%8s%10.1f%11"PRIu64,
+			(void) snprintf(buf, size,
+			    "%16"PRIX64"%8s%8s%10.1f%11"PRIu64"%s%s",
 			    line->bufaddr.addr, size_str, "-", hit * 100.0,
-			    cyc2ns(lat));
+			    cyc2ns(lat), hist_str, src_str);
 		} else {
-			(void) snprintf(buf, size, "%16"PRIX64"%8s%8d%10.1f%11"PRIu64,
+			(void) snprintf(buf, size,
+			    "%16"PRIX64"%8s%8d%10.1f%11"PRIu64"%s%s",
 			    line->bufaddr.addr, size_str, line->nid,
-			    hit * 100.0, cyc2ns(lat));
+			    hit * 100.0, cyc2ns(lat), hist_str, src_str);
 		}
 	}
 }
@@ -2114,7 +2295,7 @@ lat_dyn_create(page_t *page, win_type_t *type)
 		return (NULL);
 	}
 
-	if ((i = reg_init(&dyn->msg, 0, 1, g_scr_width, 2, A_BOLD)) < 0)
+	if ((i = reg_init(&dyn->msg, 0, 1, g_scr_width, 3, A_BOLD)) < 0)
 		goto L_EXIT;
 	if ((i = reg_init(&dyn->caption, 0, i, g_scr_width, 2, A_BOLD | A_UNDERLINE)) < 0)
 		goto L_EXIT;
@@ -2164,11 +2345,11 @@ lat_win_destroy(dyn_win_t *win)
  * probably is cut to:
  * ../usr/src/cmd/numatop/amd64/numatop
  */
-static void
-bufdesc_cut(char *dst_desc, int dst_size, char *src_desc)
+void
+bufdesc_cut(char *dst_desc, int dst_size, const char *src_desc)
 {
 	int src_len;
-	char *start, *end;
+	const char *start, *end;
 
 	if ((src_len = strlen(src_desc)) < dst_size) {
 		(void) strcpy(dst_desc, src_desc);
@@ -2225,11 +2406,13 @@ win_lat_buf_create(track_proc_t *proc, int lwpid, int *nlines)
 /*
  * Get the LL sampling data, check if the record hits one buffer in
  * process address space. If so, update the accessing statistics for
- * this buffer.
+ * this buffer. The latency histograms of all buffers are merged into
+ * "hist" and the data sources of all records are counted in "memsrc"
+ * if they are not NULL.
  */
 void
 win_lat_buf_fill(lat_line_t *lat_buf, int nlines, track_proc_t *proc,
-    track_lwp_t *lwp, int *lat)
+    track_lwp_t *lwp, int *lat, lat_hist_t *hist, memsrc_count_t *memsrc)
 {
 	perf_llrecgrp_t *grp;
 	os_perf_llrec_t *rec;
@@ -2244,14 +2427,20 @@ win_lat_buf_fill(lat_line_t *lat_buf, int nlines, track_proc_t *proc,
 	}
 
 	for (i = 0; i < grp->nrec_cur; i++) {
-		rec = &grp->rec_arr[i];
+		rec = grp->rec_arr[i];
 		os_lat_buf_hit(lat_buf, nlines, rec, &total_lat, &total_sample);
+		if (memsrc != NULL) {
+			memsrc->count[rec->mem_src]++;
+		}
 	}
 
 	(void) pthread_mutex_unlock(&proc->mutex);
 
 	for (i = 0; i < nlines; i++) {
 		lat_buf[i].nsamples = total_sample;
+		if (hist != NULL) {
+			lat_hist_merge(hist, &lat_buf[i].hist);
+		}
 	}
 
 	*lat = (total_sample > 0) ? (total_lat / total_sample) : 0;
@@ -2282,7 +2471,8 @@ win_lat_cmp(const void *p1, const void *p2)
  * Get and display the process/thread latency related information.
  */
 static int
-lat_data_get(track_proc_t *proc, track_lwp_t *lwp, dyn_lat_t *dyn, int *lat)
+lat_data_get(track_proc_t *proc, track_lwp_t *lwp, dyn_lat_t *dyn, int *lat,
+    lat_hist_t *hist, memsrc_count_t *memsrc)
 {
 	lat_line_t *lat_buf;
 	int nlines, lwpid = 0;
@@ -2306,7 +2496,7 @@ lat_data_get(track_proc_t *proc, track_lwp_t *lwp, dyn_lat_t *dyn, int *lat)
 	/*
 	 * Fill in the memory access information.
 	 */
-	win_lat_buf_fill(lat_buf, nlines, proc, lwp, lat);
+	win_lat_buf_fill(lat_buf, nlines, proc, lwp, lat, hist, memsrc);
 
 	/*
 	 * Sort the "lat_buf" according to the number of buffer accessing.
@@ -2315,12 +2505,16 @@ lat_data_get(track_proc_t *proc, track_lwp_t *lwp, dyn_lat_t *dyn, int *lat)
 
 	/*
 	 * Display the caption of data table:
-	 * "ADDR SIZE ACCESS% LAT(ns) DESC"
+	 * "ADDR SIZE ACCESS% LAT(ns) P50(ns) P90(ns) P99(ns) MAX(ns) DESC
+	 *  L3% LDRAM% RDRAM% RCACHE% CXL% HITM%"
 	 */
 	(void) snprintf(content, sizeof (content),
-	    "%16s%8s%11s%11s%34s",
+	    "%16s%8s%11s%11s%10s%10s%10s%10s%34s%9s%9s%9s%9s%9s%9s",
 	    CAPTION_ADDR, CAPTION_SIZE, CAPTION_BUFHIT,
-	    CAPTION_AVGLAT, CAPTION_DESC);
+	    CAPTION_AVGLAT, CAPTION_P50LAT, CAPTION_P90LAT,
+	    CAPTION_P99LAT, CAPTION_MAXLAT, CAPTION_DESC, CAPTION_L3,
+	    CAPTION_LDRAM, CAPTION_RDRAM, CAPTION_RCACHE, CAPTION_CXL,
+	    CAPTION_HITM);
 
 	reg_line_write(&dyn->caption, 1, ALIGN_LEFT, content);
 	dump_write("%s\n", content);
@@ -2351,7 +2545,11 @@ win_lat_data_show(track_proc_t *proc, dyn_lat_t *dyn, boolean_t *note_out)
 	win_reg_t *r;
 	int lat;
 	track_lwp_t *lwp = NULL;
-	char content[WIN_LINECHAR_MAX], intval_buf[16], lat_buf[32];
+	lat_hist_t hist;
+	memsrc_count_t memsrc;
+	uint64_t total = 0;
+	char content[WIN_LINECHAR_MAX], intval_buf[16], lat_buf[64];
+	int i;
 
 	*note_out = B_FALSE;
 
@@ -2365,10 +2563,14 @@ win_lat_data_show(track_proc_t *proc, dyn_lat_t *dyn, boolean_t *note_out)
 	}
 
 	dump_cache_enable();
-	if (lat_data_get(proc, lwp, dyn, &lat) < 0) {
+	(void) memset(&hist, 0, sizeof (hist));
+	(void) memset(&memsrc, 0, sizeof (memsrc));
+	if (lat_data_get(proc, lwp, dyn, &lat, &hist, &memsrc) < 0) {
 		strcpy(lat_buf, "unknown");
 	} else {
-		snprintf(lat_buf, sizeof(lat_buf), "%"PRIu64"ns", cyc2ns(lat));
+		snprintf(lat_buf, sizeof(lat_buf), "%"PRIu64"ns, P99.LAT: %"
+		    PRIu64"ns", cyc2ns(lat),
+		    cyc2ns(lat_hist_percentile(&hist, 99)));
 	}
 	dump_cache_disable();
 
@@ -2390,6 +2592,25 @@ win_lat_data_show(track_proc_t *proc, dyn_lat_t *dyn, boolean_t *note_out)
 	reg_erase(r);
 	reg_line_write(r, 1, ALIGN_LEFT, content);
 	dump_write("\n*** %s\n", content);
+
+	/*
+	 * The data source breakdown of all sampled loads.
+	 */
+	for (i = 0; i < MEM_SRC_NUM; i++) {
+		total += memsrc.count[i];
+	}
+
+	(void) snprintf(content, sizeof (content),
+	    "Data source: L3 %.1f%%, local DRAM %.1f%%, remote DRAM %.1f%%, "
+	    "remote cache %.1f%%, CXL/PMEM %.1f%%, local HITM %.1f%%",
+	    ratio(memsrc.count[MEM_SRC_L3], total) * 100.0,
+	    ratio(memsrc.count[MEM_SRC_LOC_DRAM], total) * 100.0,
+	    ratio(memsrc.count[MEM_SRC_REM_DRAM], total) * 100.0,
+	    ratio(memsrc.count[MEM_SRC_REM_CACHE], total) * 100.0,
+	    ratio(memsrc.count[MEM_SRC_CXL], total) * 100.0,
+	    ratio(memsrc.count[MEM_SRC_HITM], total) * 100.0);
+	reg_line_write(r, 2, ALIGN_LEFT, content);
+	dump_write("*** %s\n", content);
 	reg_refresh_nout(r);
 
 	dump_cache_flush();
@@ -2479,7 +2700,9 @@ latnode_dyn_create(page_t *page, win_type_t *type)
 		goto L_EXIT;
 	if ((i = reg_init(&dyn->caption, 0, i, g_scr_width, 2, A_BOLD | A_UNDERLINE)) <  0)
 		goto L_EXIT;
-	(void) reg_init(&dyn->data, 0, i, g_scr_width, g_scr_height - i - 2, 0);
+	if ((i = reg_init(&dyn->data, 0, i, g_scr_width, g_scr_height - i - 3, 0)) < 0)
+		goto L_EXIT;
+	(void) reg_init(&dyn->hint, 0, i, g_scr_width, 1, A_BOLD);
 
 	reg_buf_init(&dyn->data, NULL, lat_line_get);
 	reg_scroll_init(&dyn->data, B_TRUE);
@@ -2513,10 +2736,12 @@ latnode_win_destroy(dyn_win_t *win)
 			free(dyn->data.buf);
 		}
 
+		map_migrate_free(&dyn->migrate);
 		reg_win_destroy(&dyn->msg);
 		reg_win_destroy(&dyn->note);
 		reg_win_destroy(&dyn->caption);
 		reg_win_destroy(&dyn->data);
+		reg_win_destroy(&dyn->hint);
 		free(dyn);
 	}
 }
@@ -2530,9 +2755,13 @@ accdst_str_build(char *buf, int size, int idx, void *pv)
 {
 	accdst_line_t *lines = (accdst_line_t *)pv;
 	accdst_line_t *line = &lines[idx];
+	char hist_str[64], src_str[64];
 
-	(void) snprintf(buf, size, "%5d%14.1f%15"PRIu64,
-	    line->nid, line->access_ratio * 100.0, cyc2ns(line->latency));
+	win_lathist_str_build(hist_str, sizeof (hist_str), &line->hist);
+	win_memsrc_str_build(src_str, sizeof (src_str), &line->memsrc);
+	(void) snprintf(buf, size, "%5d%14.1f%15"PRIu64"%s%s",
+	    line->nid, line->access_ratio * 100.0, cyc2ns(line->latency),
+	    hist_str, src_str);
 }
 
 /*
@@ -2621,6 +2850,7 @@ accdst_win_destroy(dyn_win_t *win)
 			free(dyn->data.buf);
 		}
 
+		map_migrate_free(&dyn->migrate);
 		reg_win_destroy(&dyn->msg);
 		reg_win_destroy(&dyn->caption);
 		reg_win_destroy(&dyn->data);
@@ -2631,11 +2861,12 @@ accdst_win_destroy(dyn_win_t *win)
 
 static int
 llrec2addr(track_proc_t *proc, track_lwp_t *lwp, void ***addr_arr,
-	int **lat_arr, int *addr_num)
+	int **lat_arr, mem_src_t **src_arr, int *addr_num)
 {
 	perf_llrecgrp_t *grp;
 	void **addr_buf;
 	int *lat_buf;
+	mem_src_t *src_buf;
 	int i, ret = -1;
 
 	(void) pthread_mutex_lock(&proc->mutex);
@@ -2649,6 +2880,7 @@ llrec2addr(track_proc_t *proc, track_lwp_t *lwp, void ***addr_arr,
 	if (grp->nrec_cur == 0) {
 		*addr_arr = NULL;
 		*lat_arr = NULL;
+		*src_arr = NULL;
 		*addr_num = 0;
 		ret = 0;
 		goto L_EXIT;
@@ -2663,13 +2895,21 @@ llrec2addr(track_proc_t *proc, track_lwp_t *lwp, void ***addr_arr,
 		goto L_EXIT;
 	}
 
+	if ((src_buf = zalloc(sizeof (mem_src_t) * grp->nrec_cur)) == NULL) {
+		free(addr_buf);
+		free(lat_buf);
+		goto L_EXIT;
+	}
+
 	for (i = 0; i < grp->nrec_cur; i++) {
-		addr_buf[i] = (void *)(uintptr_t)(grp->rec_arr[i].addr);
-		lat_buf[i] = grp->rec_arr[i].latency;
+		addr_buf[i] = (void *)(uintptr_t)(grp->rec_arr[i]->addr);
+		lat_buf[i] = grp->rec_arr[i]->latency;
+		src_buf[i] = grp->rec_arr[i]->mem_src;
 	}
 
 	*addr_arr = addr_buf;
 	*lat_arr = lat_buf;
+	*src_arr = src_buf;
 	*addr_num = grp->nrec_cur;
 	ret = 0;
 
@@ -2703,6 +2943,8 @@ accdst_data_save(map_nodedst_t *nodedst_arr, int nnodes_max, int naccess_total,
 
 	if (naccess > 0) {
 		line->latency = nodedst_arr[node->nid].total_lat / naccess;
+		line->hist = nodedst_arr[node->nid].hist;
+		line->memsrc = nodedst_arr[node->nid].memsrc;
 	}
 }
 
@@ -2713,9 +2955,13 @@ accdst_data_show(track_proc_t *proc, dyn_accdst_t *dyn, boolean_t *note_out)
 	track_lwp_t *lwp = NULL;
 	void **addr_arr = NULL;
 	int *lat_arr = NULL;
-	int addr_num, i, nnodes, naccess_total = 0;
+	mem_src_t *src_arr = NULL;
+	int addr_num, i, j, nnodes, naccess_total = 0;
 	map_nodedst_t *nodedst_arr;
 	accdst_line_t *lines;
+	lat_hist_t hist;
+	memsrc_count_t memsrc;
+	uint64_t total_lat = 0;
 	char content[WIN_LINECHAR_MAX], intval_buf[16];
 	boolean_t ret = B_FALSE;
 
@@ -2733,18 +2979,34 @@ accdst_data_show(track_proc_t *proc, dyn_accdst_t *dyn, boolean_t *note_out)
 		goto L_EXIT;
 	}
 
-	if (llrec2addr(proc, lwp, &addr_arr, &lat_arr, &addr_num) != 0) {
+	if (llrec2addr(proc, lwp, &addr_arr, &lat_arr, &src_arr,
+	    &addr_num) != 0) {
 		goto L_EXIT;
 	}
 
 	(void) memset(nodedst_arr, 0, sizeof (map_nodedst_t) * nnodes_max);
 	if (addr_num > 0) {
-		if (map_addr2nodedst(proc->pid, addr_arr, lat_arr, addr_num,
+		if (map_addr2nodedst(proc, addr_arr, lat_arr, src_arr, addr_num,
 		    nodedst_arr, nnodes_max, &naccess_total) != 0) {
 			goto L_EXIT;
 		}
 	}
 
+	/*
+	 * The latency percentiles of all nodes.
+	 */
+	(void) memset(&hist, 0, sizeof (hist));
+	(void) memset(&memsrc, 0, sizeof (memsrc));
+	for (i = 0; i < nnodes_max; i++) {
+		lat_hist_merge(&hist, &nodedst_arr[i].hist);
+		total_lat += nodedst_arr[i].total_lat;
+		for (j = 0; j < MEM_SRC_NUM; j++) {
+			memsrc.count[j] += nodedst_arr[i].memsrc.count[j];
+		}
+	}
+
+	os_migrate_update(&dyn->migrate, proc, naccess_total, total_lat, &memsrc);
+
 	r = &dyn->msg;
 	reg_erase(r);
 	disp_intval(intval_buf, 16);
@@ -2752,13 +3014,15 @@ accdst_data_show(track_proc_t *proc, dyn_accdst_t *dyn, boolean_t *note_out)
 	if (lwp == NULL) {
 		(void) snprintf(content, sizeof (content),
 		    "Memory access node distribution overview "
-		    "(pid: %d, interval: %s)",
-		    proc->pid, intval_buf);
+		    "(pid: %d, P99.LAT: %"PRIu64"ns, interval: %s)",
+		    proc->pid, cyc2ns(lat_hist_percentile(&hist, 99)),
+		    intval_buf);
 	} else {
 		(void) snprintf(content, sizeof (content),
 		    "Memory access node distribution overview "
-		    "(lwpid: %d, interval: %s)",
-		    lwp->id, intval_buf);
+		    "(lwpid: %d, P99.LAT: %"PRIu64"ns, interval: %s)",
+		    lwp->id, cyc2ns(lat_hist_percentile(&hist, 99)),
+		    intval_buf);
 	}
 
 	reg_line_write(r, 1, ALIGN_LEFT, content);
@@ -2770,10 +3034,15 @@ accdst_data_show(track_proc_t *proc, dyn_accdst_t *dyn, boolean_t *note_out)
 
 	/*
 	 * Display the caption of table:
-	 * "NODE	ACCESS%		LAT(ns)"
+	 * "NODE	ACCESS%		LAT(ns)	P50(ns)	P90(ns)	P99(ns)	MAX(ns)
+	 *  L3%	LDRAM%	RDRAM%	RCACHE%	CXL%	HITM%"
 	 */
-	(void) snprintf(content, sizeof (content), "%5s%15s%15s",
-	    CAPTION_NID, CAPTION_BUFHIT, CAPTION_AVGLAT);
+	(void) snprintf(content, sizeof (content),
+	    "%5s%15s%15s%10s%10s%10s%10s%9s%9s%9s%9s%9s%9s",
+	    CAPTION_NID, CAPTION_BUFHIT, CAPTION_AVGLAT, CAPTION_P50LAT,
+	    CAPTION_P90LAT, CAPTION_P99LAT, CAPTION_MAXLAT, CAPTION_L3,
+	    CAPTION_LDRAM, CAPTION_RDRAM, CAPTION_RCACHE, CAPTION_CXL,
+	    CAPTION_HITM);
 
 	reg_line_write(r, 1, ALIGN_LEFT, content);
 	dump_write("%s\n", content);
@@ -2799,9 +3068,7 @@ accdst_data_show(track_proc_t *proc, dyn_accdst_t *dyn, boolean_t *note_out)
 	reg_scroll_show(r, (void *)lines, nnodes, accdst_str_build);
 	reg_refresh_nout(r);
 
-	r = &dyn->hint;
-	reg_erase(r);
-	reg_refresh_nout(r);
+	os_migrate_show(&dyn->hint, &dyn->migrate);
 
 L_EXIT:
 	free(nodedst_arr);
@@ -2818,6 +3085,10 @@ L_EXIT:
 		free(lat_arr);
 	}
 
+	if (src_arr != NULL) {
+		free(src_arr);
+	}
+
 	return (ret);
 }
 
@@ -2860,7 +3131,7 @@ pqos_cmt_proc_data_build(char *buf, int size,
 	else
 		snprintf(id, sizeof(id), "%d", line->lwpid);
 
-	if (line->fd == INVALID_FD)
+	if (!line->monitored)
 		snprintf(tmp, sizeof(tmp), "%s", id);
 	else
 		snprintf(tmp, sizeof(tmp), "*%s", id);
@@ -2904,11 +3175,13 @@ pqos_cmt_proc_data_save(track_proc_t *proc, track_lwp_t *lwp, int intval,
 
 	if (lwp == NULL) {
 		line->llc_occupancy = proc->pqos.occupancy_scaled;
+		line->monitored = (proc->pqos.task_id != 0);
 		win_countvalue_fill(&line->value, proc->countval_arr,
 			NODE_ALL, intval, g_ncpus);
 
 	} else {
 		line->llc_occupancy = lwp->pqos.occupancy_scaled;
+		line->monitored = (lwp->pqos.task_id != 0);
 		line->lwpid = lwp->id;
 		win_countvalue_fill(&line->value, lwp->countval_arr,
 			NODE_ALL, intval, g_ncpus);
@@ -3109,8 +3382,9 @@ pqos_cmt_data_show(dyn_win_t *win, boolean_t *note_out)
 
 	if (dyn->pid == 0) {
 		snprintf(content, sizeof (content),
-		    "-- Track %d active processes's LLC occupancy (marked with *) --",
-		    PERF_PQOS_CMT_MAX);
+		    "-- Track top %d processes with %d monitor groups "
+		    "(monitored now marked with *) --",
+		    PERF_PQOS_TOPN, os_perf_pqos_size());
 		reg_line_write(r, 1, ALIGN_LEFT, content);
 	}
 
@@ -3176,13 +3450,18 @@ pqos_mbm_proc_data_build(char *buf, int size,
 	pqos_mbm_proc_line_t *line)
 {
 	win_countvalue_t *value = &line->value;
-	char id[16], total_bw[16], local_bw[16];
+	char tmp[32], id[16], total_bw[16], local_bw[16];
 
 	if (line->lwpid == 0)
 		snprintf(id, sizeof(id), "%d", line->pid);
 	else
 		snprintf(id, sizeof(id), "%d", line->lwpid);
 
+	if (!line->monitored)
+		snprintf(tmp, sizeof(tmp), "%s", id);
+	else
+		snprintf(tmp, sizeof(tmp), "*%s", id);
+
 	snprintf(total_bw, sizeof(total_bw), "%.1fMB",
 		ratio(line->totalbw_scaled, 1048576));
 
@@ -3191,7 +3470,7 @@ pqos_mbm_proc_data_build(char *buf, int size,
 
 	snprintf(buf, size,
 	    "%10s%15s%10.1f%10.1f%14s%14s%9.1f",
-	    id, line->proc_name,
+	    tmp, line->proc_name,
 	    value->rma, value->lma,
 	    total_bw, local_bw,
 	    value->cpu * 100);
@@ -3228,12 +3507,15 @@ pqos_mbm_proc_data_save(track_proc_t *proc, track_lwp_t *lwp, int intval,
 	if (lwp == NULL) {
 		line->totalbw_scaled = proc->pqos.totalbw_scaled;
 		line->localbw_scaled = proc->pqos.localbw_scaled;
+		line->monitored = (proc->pqos.task_id != 0);
 		win_countvalue_fill(&line->value, proc->countval_arr,
 			NODE_ALL, intval, g_ncpus);
 
 	} else {
 		line->totalbw_scaled = lwp->pqos.totalbw_scaled;
 		line->localbw_scaled = lwp->pqos.localbw_scaled;
+		line->monitored = (lwp->pqos.task_id != 0);
+		line->lwpid = lwp->id;
 		win_countvalue_fill(&line->value, lwp->countval_arr,
 			NODE_ALL, intval, g_ncpus);
 	}
@@ -3270,9 +3552,9 @@ pqos_mbm_dyn_create_proc(page_t *page __attribute__((unused)),
 	(void) reg_init(&dyn->hint, 0, i, g_scr_width,
 	    g_scr_height - i - 1, A_BOLD);
 
-	if (pid == 0) {
-		/* TODO */
-	} else if (lwpid == 0)
+	if (pid == 0)
+		*type = WIN_TYPE_PQOS_MBM_TOPNPROC;
+	else if (lwpid == 0)
 		*type = WIN_TYPE_PQOS_MBM_MONIPROC;
 	else
 		*type = WIN_TYPE_PQOS_MBM_MONILWP;
@@ -3318,7 +3600,7 @@ pqos_mbm_data_show(dyn_win_t *win, boolean_t *note_out)
 	dyn_pqos_mbm_proc_t *dyn;
 	win_reg_t *r, *data_reg;
 	char content[WIN_LINECHAR_MAX], intval_buf[16];
-	int nprocs = 0;
+	int nprocs = 0, nlwps, i;
 	track_proc_t *proc = NULL;
 	track_lwp_t *lwp = NULL;
 	int intval;
@@ -3330,8 +3612,13 @@ pqos_mbm_data_show(dyn_win_t *win, boolean_t *note_out)
 	disp_intval(intval_buf, 16);
 
 	if (dyn->pid == 0) {
-		/* TODO */
-		*content = '\0';
+		proc_lwp_count(&nprocs, &nlwps);
+		nprocs = MIN(nprocs, WIN_NLINES_MAX);
+		data_reg->nlines_total = nprocs;
+
+		snprintf(content, sizeof (content),
+		    "Monitoring processes with memory bandwidth (interval: %s)",
+		    intval_buf);
 	} else if (dyn->lwpid == 0) {
 		nprocs = 1;
 		data_reg->nlines_total = 1;
@@ -3366,7 +3653,20 @@ pqos_mbm_data_show(dyn_win_t *win, boolean_t *note_out)
 	lines = (pqos_mbm_proc_line_t *)(data_reg->buf);
 
 	if (dyn->pid == 0) {
-		/* TODO */
+		proc_group_lock();
+		proc_resort(SORT_KEY_CPU);
+
+		for (i = 0; i < nprocs; i++) {
+			if ((proc = proc_sort_next()) == NULL) {
+				break;
+			}
+
+			intval = proc_intval_get(proc);
+			pqos_mbm_proc_data_save(proc, NULL, intval, &lines[i]);
+		}
+
+		proc_group_unlock();
+
 	} else if (dyn->lwpid == 0) {
 		if ((proc = proc_find(dyn->pid)) == NULL) {
 			win_invalid_proc();
@@ -3407,8 +3707,9 @@ pqos_mbm_data_show(dyn_win_t *win, boolean_t *note_out)
 
 	if (dyn->pid == 0) {
 		snprintf(content, sizeof (content),
-		    "-- Track %d active processes's LLC occupancy (marked with *) --",
-		    PERF_PQOS_CMT_MAX);
+		    "-- Track top %d processes with %d monitor groups "
+		    "(monitored now marked with *) --",
+		    PERF_PQOS_TOPN, os_perf_pqos_size());
 		reg_line_write(r, 1, ALIGN_LEFT, content);
 	}
 
@@ -3677,6 +3978,7 @@ win_dyn_init(void *p)
 
 		win->type = WIN_TYPE_NODE_DETAIL;
 		win->draw = nodedetail_win_draw;
+		win->scroll = nodedetail_win_scroll;
 		win->destroy = nodedetail_win_destroy;
 		break;
 
@@ -3722,6 +4024,93 @@ win_dyn_init(void *p)
 		win->scroll = accdst_win_scroll;
 		break;
 		
+	case CMD_HEATMAP_ID:
+		if ((win->dyn = os_heatmap_dyn_create(page)) == NULL) {
+			goto L_EXIT;
+		}
+
+		if (CMD_HEATMAP(&page->cmd)->lwpid != 0) {
+			win->type = WIN_TYPE_HEATMAP_LWP;
+		} else {
+			win->type = WIN_TYPE_HEATMAP_PROC;
+		}
+
+		win->draw = os_heatmap_win_draw;
+		win->destroy = os_heatmap_win_destroy;
+		win->scroll = os_heatmap_win_scroll;
+		break;
+
+	case CMD_CONTEND_ID:
+		if ((win->dyn = os_contend_dyn_create(page)) == NULL) {
+			goto L_EXIT;
+		}
+
+		if (CMD_CONTEND(&page->cmd)->lwpid != 0) {
+			win->type = WIN_TYPE_CONTEND_LWP;
+		} else {
+			win->type = WIN_TYPE_CONTEND_PROC;
+		}
+
+		win->draw = os_contend_win_draw;
+		win->destroy = os_contend_win_destroy;
+		win->scroll = os_contend_win_scroll;
+		break;
+
+	case CMD_DAMON_ID:
+		if ((win->dyn = os_damon_dyn_create(page)) == NULL) {
+			goto L_EXIT;
+		}
+
+		win->type = WIN_TYPE_DAMON;
+		win->draw = os_damon_win_draw;
+		win->destroy = os_damon_win_destroy;
+		win->scroll = os_damon_win_scroll;
+		break;
+
+	case CMD_UNCORE_ID:
+		if ((win->dyn = os_uncore_dyn_create(page)) == NULL) {
+			goto L_EXIT;
+		}
+
+		win->type = WIN_TYPE_UNCORE;
+		win->draw = os_uncore_win_draw;
+		win->destroy = os_uncore_win_destroy;
+		win->scroll = os_uncore_win_scroll;
+		break;
+
+	case CMD_CGROUP_ID:
+		if ((win->dyn = os_cgroup_dyn_create(page)) == NULL) {
+			goto L_EXIT;
+		}
+
+		win->type = WIN_TYPE_CGROUP;
+		win->draw = os_cgroup_win_draw;
+		win->destroy = os_cgroup_win_destroy;
+		win->scroll = os_cgroup_win_scroll;
+		break;
+
+	case CMD_NUMASTAT_ID:
+		if ((win->dyn = os_numastat_dyn_create(page)) == NULL) {
+			goto L_EXIT;
+		}
+
+		win->type = WIN_TYPE_NUMASTAT;
+		win->draw = os_numastat_win_draw;
+		win->destroy = os_numastat_win_destroy;
+		win->scroll = os_numastat_win_scroll;
+		break;
+
+	case CMD_ADVISOR_ID:
+		if ((win->dyn = os_advisor_dyn_create(page)) == NULL) {
+			goto L_EXIT;
+		}
+
+		win->type = WIN_TYPE_ADVISOR;
+		win->draw = os_advisor_win_draw;
+		win->destroy = os_advisor_win_destroy;
+		win->scroll = os_advisor_win_scroll;
+		break;
+
 	case CMD_LLCALLCHAIN_ID:
 		if ((win->dyn = os_llcallchain_dyn_create(page)) == NULL) {
 			goto L_EXIT;